@@ -24,6 +24,8 @@
 #include <libs/config/config.h>
 #include <libs/config/config-voicestreams.h>
 #include <libs/config/config-aprsobjs.h>
+#include <libs/config/config-reload.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/comm/comm.h>
 #include <libs/remotedb/remotedb.h>
 #include <libs/coding/coding.h>
@@ -96,6 +98,7 @@ int main(int argc, char *argv[]) {
 			return 0;
 		case DAEMON_INIT_RESULT_FORK_ERROR:
 		case DAEMON_INIT_RESULT_CONSOLECLIENT_ERROR:
+		case DAEMON_INIT_RESULT_POLL_ERROR:
 			return 1;
 		default:
 			break;
@@ -120,6 +123,8 @@ int main(int argc, char *argv[]) {
 
 	while (daemon_process()) {
 		if (!daemon_is_consoleclient()) {
+			config_reload_process();
+			config_snapshot_process();
 			base_process();
 			comm_process();
 		}
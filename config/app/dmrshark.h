@@ -11,5 +11,6 @@
 #define DATA_PACKET_SEND_MAX_SELECTIVE_ACK_TRIES	25
 
 #define IPSC_PACKET_SEND_INTERVAL_IN_MS				30
+#define COMM_PCAP_STATS_CHECK_INTERVAL_IN_SEC		10
 
 #endif
@@ -61,7 +61,10 @@ typedef struct aprs_obj_st {
 	struct aprs_obj_st *next;
 } aprs_obj_t;
 
+// The object list is replaced on config reload, so the thread accesses it under this mutex.
+static pthread_mutex_t aprs_mutex_objs = PTHREAD_MUTEX_INITIALIZER;
 static aprs_obj_t *aprs_objs_first_entry = NULL;
+static flag_t aprs_objs_changed = 0;
 
 #define APRS_QUEUE_ENTRY_TYPE_UNKNOWN	0
 #define APRS_QUEUE_ENTRY_TYPE_GPSPOS	1
@@ -435,7 +438,9 @@ static void aprs_thread_process(void) {
 	pthread_mutex_unlock(&aprs_mutex_queue);
 
 	// Sending objects if needed.
-	if (time(NULL)-last_obj_send_at > 1800) {
+	pthread_mutex_lock(&aprs_mutex_objs);
+	if (aprs_objs_changed || time(NULL)-last_obj_send_at > 1800) {
+		aprs_objs_changed = 0;
 		obj = aprs_objs_first_entry;
 		if (obj != NULL) {
 			console_log(LOGLEVEL_APRS "aprs: sending objects\n");
@@ -452,6 +457,7 @@ static void aprs_thread_process(void) {
 		}
 		last_obj_send_at = time(NULL);
 	}
+	pthread_mutex_unlock(&aprs_mutex_objs);
 
 	// Receiving messages.
 	pollfd.fd = aprs_sockfd;
@@ -539,50 +545,93 @@ static void *aprs_thread_init(void *arg) {
 	pthread_exit((void*) 0);
 }
 
-void aprs_init(void) {
+static void aprs_objs_free(aprs_obj_t *objs) {
+	aprs_obj_t *next_obj;
+
+	while (objs) {
+		next_obj = objs->next;
+		free(objs->callsign);
+		free(objs->description);
+		free(objs);
+		objs = next_obj;
+	}
+}
+
+// Creates the object list from the config.
+static aprs_obj_t *aprs_objs_load(void) {
 	char **objnames = config_aprsobjs_get_objnames();
 	char **objnames_i = objnames;
-	pthread_attr_t attr;
-	char *host = NULL;
+	aprs_obj_t *objs = NULL;
 	aprs_obj_t *newobj;
 	uint8_t i;
 	uint8_t length;
 
+	if (objnames == NULL)
+		return NULL;
+
+	while (*objnames_i != NULL) {
+		if (config_aprsobjs_get_enabled(*objnames_i)) {
+			console_log("  initializing %s...\n", *objnames_i);
+
+			newobj = (aprs_obj_t *)calloc(1, sizeof(aprs_obj_t));
+			if (newobj == NULL) {
+				console_log("aprs error: can't allocate memory for object %s\n", *objnames_i);
+				objnames_i++;
+				continue;
+			}
+
+			newobj->callsign = strdup(*(objnames_i)+8); // +8 - cutting out string "aprsobj-"
+			length = strlen(newobj->callsign);
+			for (i = 0; i < length; i++)
+				newobj->callsign[i] = toupper(newobj->callsign[i]);
+			newobj->latitude = config_aprsobjs_get_latitude(*objnames_i);
+			newobj->latitude_ch = config_aprsobjs_get_latitude_ch(*objnames_i);
+			newobj->longitude = config_aprsobjs_get_longitude(*objnames_i);
+			newobj->longitude_ch = config_aprsobjs_get_longitude_ch(*objnames_i);
+			newobj->description = config_aprsobjs_get_description(*objnames_i);
+			newobj->table_ch = config_aprsobjs_get_table_ch(*objnames_i);
+			newobj->symbol_ch = config_aprsobjs_get_symbol_ch(*objnames_i);
+
+			newobj->next = objs;
+			objs = newobj;
+		}
+
+		objnames_i++;
+	}
+	config_aprsobjs_free_objnames(objnames);
+
+	return objs;
+}
+
+// Replaces the object list with the one in the reloaded config. The new objects are sent
+// to the server at the next thread loop.
+void aprs_reload_objs(void) {
+	aprs_obj_t *objs;
+
+	if (!aprs_enabled)
+		return;
+
+	console_log("aprs: reloading objects\n");
+	objs = aprs_objs_load();
+
+	pthread_mutex_lock(&aprs_mutex_objs);
+	aprs_objs_free(aprs_objs_first_entry);
+	aprs_objs_first_entry = objs;
+	aprs_objs_changed = 1;
+	pthread_mutex_unlock(&aprs_mutex_objs);
+}
+
+void aprs_init(void) {
+	pthread_attr_t attr;
+	char *host = NULL;
+
 	console_log("aprs: init\n");
 
 	host = config_get_aprsserverhost();
 	if (strlen(host) != 0) {
 		aprs_enabled = 1;
 
-		while (*objnames_i != NULL) {
-			if (config_aprsobjs_get_enabled(*objnames_i)) {
-				console_log("  initializing %s...\n", *objnames_i);
-
-				newobj = (aprs_obj_t *)calloc(1, sizeof(aprs_obj_t));
-
-				newobj->callsign = strdup(*(objnames_i)+8); // +8 - cutting out string "aprsobj-"
-				length = strlen(newobj->callsign);
-				for (i = 0; i < length; i++)
-					newobj->callsign[i] = toupper(newobj->callsign[i]);
-				newobj->latitude = config_aprsobjs_get_latitude(*objnames_i);
-				newobj->latitude_ch = config_aprsobjs_get_latitude_ch(*objnames_i);
-				newobj->longitude = config_aprsobjs_get_longitude(*objnames_i);
-				newobj->longitude_ch = config_aprsobjs_get_longitude_ch(*objnames_i);
-				newobj->description = config_aprsobjs_get_description(*objnames_i);
-				newobj->table_ch = config_aprsobjs_get_table_ch(*objnames_i);
-				newobj->symbol_ch = config_aprsobjs_get_symbol_ch(*objnames_i);
-
-				if (aprs_objs_first_entry == NULL)
-					aprs_objs_first_entry = newobj;
-				else {
-					newobj->next = aprs_objs_first_entry;
-					aprs_objs_first_entry = newobj;
-				}
-			}
-
-			objnames_i++;
-		}
-		config_aprsobjs_free_objnames(objnames);
+		aprs_objs_first_entry = aprs_objs_load();
 
 		console_log("aprs: starting thread for aprs\n");
 
@@ -597,7 +646,6 @@ void aprs_init(void) {
 
 void aprs_deinit(void) {
 	void *status = NULL;
-	aprs_obj_t *next_obj;
 
 	console_log("aprs: deinit\n");
 	aprs_enabled = 0;
@@ -613,15 +661,11 @@ void aprs_deinit(void) {
 	console_log("aprs: waiting for aprs thread to exit\n");
 	pthread_join(aprs_thread, &status);
 
-	while (aprs_objs_first_entry) {
-		next_obj = aprs_objs_first_entry->next;
-		free(aprs_objs_first_entry->callsign);
-		free(aprs_objs_first_entry->description);
-		free(aprs_objs_first_entry);
-		aprs_objs_first_entry = next_obj;
-	}
+	aprs_objs_free(aprs_objs_first_entry);
+	aprs_objs_first_entry = NULL;
 
 	pthread_mutex_destroy(&aprs_mutex_thread_should_stop);
 	pthread_mutex_destroy(&aprs_mutex_wakeup);
 	pthread_mutex_destroy(&aprs_mutex_queue);
+	pthread_mutex_destroy(&aprs_mutex_objs);
 }
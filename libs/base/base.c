@@ -31,8 +31,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <signal.h>
 
 volatile base_flags_t base_flags;
+// Not in base_flags, as the main loop clears it while signals can set the other flags.
+volatile sig_atomic_t base_sighup_received = 0;
 static base_id_t base_id;
 
 static void base_getorigid(base_id_t *id) {
@@ -99,6 +102,40 @@ void base_bytestobits(uint8_t *bytes, uint16_t bytes_length, flag_t *bits, uint1
 		base_bytetobits(bytes[i], &bits[i*8]);
 }
 
+// Converts the given bytes to a hex string, with the given separator char after each byte
+// if it's not 0. The string is truncated if it doesn't fit into hexstr. Returns hexstr.
+char *base_datatohexstr(uint8_t *data, uint16_t data_length, char separator, char *hexstr, uint16_t hexstr_size) {
+	static const char hexchars[] = "0123456789abcdef";
+	uint16_t charsperbyte = (separator ? 3 : 2);
+	uint16_t pos = 0;
+	uint16_t i;
+
+	if (hexstr_size == 0)
+		return hexstr;
+
+	for (i = 0; i < data_length && pos+charsperbyte < hexstr_size; i++) {
+		hexstr[pos++] = hexchars[data[i] >> 4];
+		hexstr[pos++] = hexchars[data[i] & 0x0f];
+		if (separator)
+			hexstr[pos++] = separator;
+	}
+	hexstr[pos] = 0;
+	return hexstr;
+}
+
+// Converts the given bits to a string of 0 and 1 chars. Returns str.
+char *base_bitstostr(flag_t *bits, uint16_t bits_length, char *str, uint16_t str_size) {
+	uint16_t i;
+
+	if (str_size == 0)
+		return str;
+
+	for (i = 0; i < bits_length && i+1 < str_size; i++)
+		str[i] = (bits[i] ? '1' : '0');
+	str[i] = 0;
+	return str;
+}
+
 void base_process(void) {
 	smsrtbuf_process();
 	smstxbuf_process();
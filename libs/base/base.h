@@ -28,6 +28,9 @@ void base_bitstobytes(flag_t *bits, uint16_t bits_length, uint8_t *bytes, uint16
 void base_bytetobits(uint8_t byte, flag_t *bits);
 void base_bytestobits(uint8_t *bytes, uint16_t bytes_length, flag_t *bits, uint16_t bits_length);
 
+char *base_datatohexstr(uint8_t *data, uint16_t data_length, char separator, char *hexstr, uint16_t hexstr_size);
+char *base_bitstostr(flag_t *bits, uint16_t bits_length, char *str, uint16_t str_size);
+
 void base_process(void);
 
 void base_init(void);
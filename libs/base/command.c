@@ -28,9 +28,12 @@
 #include "data-packet-txbuf.h"
 
 #include <libs/daemon/console.h>
+#include <libs/daemon/console-logfile.h>
 #include <libs/config/config.h>
+#include <libs/config/config-reload.h>
 #include <libs/comm/snmp.h>
 #include <libs/comm/repeaters.h>
+#include <libs/comm/ipsc-trace.h>
 #include <libs/remotedb/remotedb.h>
 #include <libs/remotedb/userdb.h>
 #include <libs/remotedb/callsignbookdb.h>
@@ -77,6 +80,9 @@ void command_process(char *input_buffer) {
 			char *repeater_callsign;
 			dmr_data_gpspos_t gpspos;
 		} aprspos;
+		struct {
+			flag_t format_pcap;
+		} ipsctrace;
 	} d;
 	char *endptr = NULL;
 	char *tok = strtok(input_buffer, " ");
@@ -88,15 +94,22 @@ void command_process(char *input_buffer) {
 		console_log("  ver                                                              - version\n");
 		console_log("  log (loglevel)                                                   - get/set loglevel\n");
 		console_log("  exit                                                             - exits the application\n");
+		console_log("  reload                                                           - reload the config file\n");
 		console_log("  repstat [host]                                                   - reads repeater status from host using snmp\n");
 		console_log("  repinfo [host]                                                   - reads repeater info from host using snmp\n");
 		console_log("  replist                                                          - list repeaters\n");
+		console_log("  reptxstats                                                       - print repeater ipsc tx statistics\n");
+		console_log("  replinkstats                                                     - print repeater link quality statistics\n");
 		console_log("  userlist                                                         - list users got from remote db\n");
 		console_log("  csblist                                                          - print callsign book from remote db\n");
 		console_log("  streamlist                                                       - list voice streams\n");
 		console_log("  remotedbmaintain                                                 - start db maintenance\n");
 		console_log("  remotedbreplistmaintain                                          - start repeater list db maintenance\n");
 		console_log("  loadpcap [pcapfile]                                              - reads and processes packets from pcap file\n");
+		console_log("  commstats                                                        - print packet capture statistics\n");
+		console_log("  commfilter                                                       - print the packet capture filter\n");
+		console_log("  ipsctrace [pcap/bin] [file]                                      - dump the last captured ipsc packets to file\n");
+		console_log("  logstats                                                         - print log file writer statistics\n");
 		console_log("  httplist                                                         - list http clients\n");
 		console_log("  streamenable [name]                                              - enable stream\n");
 		console_log("  streamdisable [name]                                             - disable stream\n");
@@ -202,6 +215,16 @@ void command_process(char *input_buffer) {
 		return;
 	}
 
+	if (strcmp(tok, "reptxstats") == 0) {
+		repeaters_print_tx_stats();
+		return;
+	}
+
+	if (strcmp(tok, "replinkstats") == 0) {
+		repeaters_print_link_stats();
+		return;
+	}
+
 	if (strcmp(tok, "userlist") == 0) {
 		userdb_print();
 		return;
@@ -237,6 +260,52 @@ void command_process(char *input_buffer) {
 		return;
 	}
 
+	if (strcmp(tok, "commstats") == 0) {
+		comm_print_stats();
+		return;
+	}
+
+	if (strcmp(tok, "ipsctrace") == 0) {
+		tok = strtok(NULL, " ");
+		if (tok == NULL) {
+			ipsc_trace_print_stats();
+			return;
+		}
+		if (strcmp(tok, "pcap") == 0)
+			d.ipsctrace.format_pcap = 1;
+		else if (strcmp(tok, "bin") == 0)
+			d.ipsctrace.format_pcap = 0;
+		else {
+			console_log("error: invalid dump format, it should be pcap or bin\n");
+			return;
+		}
+		tok = strtok(NULL, " ");
+		if (tok == NULL) {
+			log_cmdmissingparam();
+			return;
+		}
+		if (d.ipsctrace.format_pcap)
+			ipsc_trace_dump_pcap(tok);
+		else
+			ipsc_trace_dump_bin(tok);
+		return;
+	}
+
+	if (strcmp(tok, "logstats") == 0) {
+		console_logfile_print_stats();
+		return;
+	}
+
+	if (strcmp(tok, "reload") == 0) {
+		config_reload();
+		return;
+	}
+
+	if (strcmp(tok, "commfilter") == 0) {
+		comm_print_capture_filter();
+		return;
+	}
+
 	if (strcmp(tok, "httplist") == 0) {
 		httpserver_print_client_list();
 		return;
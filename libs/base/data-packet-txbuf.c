@@ -22,7 +22,7 @@
 #include <libs/daemon/console.h>
 #include <libs/daemon/daemon-poll.h>
 #include <libs/comm/repeaters.h>
-#include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 
 #include <stdlib.h>
 #include <string.h>
@@ -126,20 +126,21 @@ void data_packet_txbuf_reset_last_send_try_time(void) {
 
 void data_packet_txbuf_process(void) {
 	uint16_t timeout;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (data_packet_txbuf_first_entry == NULL)
+	if (data_packet_txbuf_first_entry == NULL || config_snapshot == NULL)
 		return;
 
 	if (repeaters_is_there_a_call_not_for_us_or_by_us(data_packet_txbuf_first_entry->repeater, data_packet_txbuf_first_entry->ts))
 		return;
 
-	timeout = config_get_mindatapacketsendretryintervalinsec()+ceil(dmrpacket_data_get_time_in_ms_needed_to_send(&data_packet_txbuf_first_entry->data_packet)/1000.0);
+	timeout = config_snapshot->mindatapacketsendretryintervalinsec+ceil(dmrpacket_data_get_time_in_ms_needed_to_send(&data_packet_txbuf_first_entry->data_packet)/1000.0);
 	if (time(NULL)-data_packet_txbuf_last_send_try_at < timeout) {
 		daemon_poll_setmaxtimeout(timeout-(time(NULL)-data_packet_txbuf_last_send_try_at));
 		return;
 	}
 
-	if (data_packet_txbuf_first_entry->send_tries >= config_get_datapacketsendmaxretrycount()) {
+	if (data_packet_txbuf_first_entry->send_tries >= config_snapshot->datapacketsendmaxretrycount) {
 		console_log(LOGLEVEL_DATAQ "data packet txbuf: all tries of sending the first entry has failed, removing:\n");
 		data_packet_txbuf_print_entry(data_packet_txbuf_first_entry);
 		data_packet_txbuf_remove_first_entry();
@@ -46,6 +46,40 @@
 #include <errno.h>
 #include <stdio.h>
 
+// Decodes the slot type of the packet, and updates the link quality statistics of the repeater slot.
+static dmrpacket_slot_type_t *dmr_handle_decode_slot_type(ipscpacket_t *ipscpacket, repeater_t *repeater, dmrpacket_slot_type_t *slot_type) {
+	dmrpacket_slot_type_t *result;
+
+	result = dmrpacket_slot_type_decode_word_r(dmrpacket_slot_type_extract_word(&ipscpacket->payload_packed_bits), slot_type);
+	if (repeater == NULL)
+		return result;
+
+	repeater->slot[ipscpacket->timeslot-1].slot_type_received++;
+	if (result != NULL)
+		repeater->slot[ipscpacket->timeslot-1].slot_type_corrected_bits += result->corrected_bits;
+	else
+		repeater->slot[ipscpacket->timeslot-1].slot_type_uncorrectable++;
+
+	return result;
+}
+
+// Decodes the EMB of the voice frame, and updates the link quality statistics of the repeater slot.
+static dmrpacket_emb_t *dmr_handle_decode_emb(ipscpacket_t *ipscpacket, repeater_t *repeater, dmrpacket_emb_t *emb) {
+	dmrpacket_emb_t *result;
+
+	result = dmrpacket_emb_decode_word_r(dmrpacket_emb_extract_word(&ipscpacket->payload_packed_bits), emb);
+	if (repeater == NULL)
+		return result;
+
+	repeater->slot[ipscpacket->timeslot-1].emb_received++;
+	if (result == NULL)
+		repeater->slot[ipscpacket->timeslot-1].emb_uncorrectable++;
+	else if (result->corrected_bits > 0)
+		repeater->slot[ipscpacket->timeslot-1].emb_corrected++;
+
+	return result;
+}
+
 void dmr_handle_voice_call_end(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
 	if (ip_packet == NULL || ipscpacket == NULL || repeater == NULL)
 		return;
@@ -84,9 +118,7 @@ void dmr_handle_voice_call_start(struct ip *ip_packet, ipscpacket_t *ipscpacket,
 	repeaters_state_change(repeater, ipscpacket->timeslot-1, REPEATER_SLOT_STATE_VOICE_CALL_RUNNING);
 	repeater->slot[ipscpacket->timeslot-1].call_started_at = time(NULL);
 	repeater->slot[ipscpacket->timeslot-1].call_ended_at = 0;
-	repeater->slot[ipscpacket->timeslot-1].call_type = ipscpacket->call_type;
-	repeater->slot[ipscpacket->timeslot-1].dst_id = ipscpacket->dst_id;
-	repeater->slot[ipscpacket->timeslot-1].src_id = ipscpacket->src_id;
+	repeaters_set_call(repeater, ipscpacket->timeslot-1, ipscpacket->call_type, ipscpacket->dst_id, ipscpacket->src_id);
 	repeater->slot[ipscpacket->timeslot-1].rssi = repeater->slot[ipscpacket->timeslot-1].avg_rssi = 0;
 
 	if (repeater->auto_rssi_update_enabled_at == 0 && !repeater->snmpignored) {
@@ -123,7 +155,7 @@ void dmr_handle_voice_call_timeout(repeater_t *repeater, dmr_timeslot_t ts) {
 }
 
 void dmr_handle_voice_lc_header(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
-	dmrpacket_payload_info_bits_t *packet_payload_info_bits = NULL;
+	dmrpacket_slot_type_t slot_type;
 
 	if (ipscpacket == NULL)
 		return;
@@ -131,15 +163,13 @@ void dmr_handle_voice_lc_header(struct ip *ip_packet, ipscpacket_t *ipscpacket,
 	console_log(LOGLEVEL_DMRLC "dmr [%s", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 	console_log(LOGLEVEL_DMRLC "->%s]: ts%u got voice lc header: ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst), ipscpacket->timeslot);
 
-	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
-	packet_payload_info_bits = dmrpacket_extract_info_bits(&ipscpacket->payload_bits);
-	packet_payload_info_bits = dmrpacket_data_bptc_deinterleave(packet_payload_info_bits);
-	dmrpacket_lc_decode_voice_lc_header(bptc_196_96_extractdata(packet_payload_info_bits->bits));
+	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
+	dmrpacket_lc_decode_voice_lc_header(bptc_196_96_extractdata_from_matrix(dmrpacket_data_bptc_deinterleave_packed(&ipscpacket->payload_packed_bits)));
 }
 
 void dmr_handle_terminator_with_lc(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
-	dmrpacket_payload_info_bits_t *packet_payload_info_bits = NULL;
+	dmrpacket_slot_type_t slot_type;
 
 	if (ipscpacket == NULL)
 		return;
@@ -147,15 +177,13 @@ void dmr_handle_terminator_with_lc(struct ip *ip_packet, ipscpacket_t *ipscpacke
 	console_log(LOGLEVEL_DMRLC "dmr [%s", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 	console_log(LOGLEVEL_DMRLC "->%s]: ts%u got terminator with lc: ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst), ipscpacket->timeslot);
 
-	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
-	packet_payload_info_bits = dmrpacket_extract_info_bits(&ipscpacket->payload_bits);
-	packet_payload_info_bits = dmrpacket_data_bptc_deinterleave(packet_payload_info_bits);
-	dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_extractdata(packet_payload_info_bits->bits));
+	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
+	dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_extractdata_from_matrix(dmrpacket_data_bptc_deinterleave_packed(&ipscpacket->payload_packed_bits)));
 }
 
 void dmr_handle_csbk(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
-	dmrpacket_payload_info_bits_t *packet_payload_info_bits = NULL;
+	dmrpacket_slot_type_t slot_type;
 
 	if (ipscpacket == NULL)
 		return;
@@ -163,17 +191,15 @@ void dmr_handle_csbk(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t
 	console_log(LOGLEVEL_DMRLC "dmr [%s", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 	console_log(LOGLEVEL_DMRLC "->%s]: ts%u got csbk: ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst), ipscpacket->timeslot);
 
-	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
-	packet_payload_info_bits = dmrpacket_extract_info_bits(&ipscpacket->payload_bits);
-	packet_payload_info_bits = dmrpacket_data_bptc_deinterleave(packet_payload_info_bits);
-	dmrpacket_csbk_decode(bptc_196_96_extractdata(packet_payload_info_bits->bits));
+	console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
+	dmrpacket_csbk_decode(bptc_196_96_extractdata_from_matrix(dmrpacket_data_bptc_deinterleave_packed(&ipscpacket->payload_packed_bits)));
 }
 
 void dmr_handle_voice_frame(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
-	dmrpacket_sync_bits_t *sync_bits;
 	dmrpacket_sync_pattern_type_t sync_pattern_type;
-	dmrpacket_emb_t *emb;
+	dmrpacket_emb_t emb;
+	dmrpacket_emb_signalling_lc_fragment_bits_t emb_signalling_lc_fragment_bits;
 	dmrpacket_emb_signalling_lc_bits_t emb_signalling_lc_bits;
 
 	if (ipscpacket == NULL)
@@ -186,8 +212,7 @@ void dmr_handle_voice_frame(struct ip *ip_packet, ipscpacket_t *ipscpacket, repe
 		repeaters_store_voice_frame_to_echo_buf(repeater, ipscpacket);
 
 	// Is this frame a sync frame?
-	sync_bits = dmrpacket_sync_extract_bits(&ipscpacket->payload_bits);
-	sync_pattern_type = dmrpacket_sync_get_sync_pattern_type(sync_bits);
+	sync_pattern_type = dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits));
 	if (sync_pattern_type != DMRPACKET_SYNC_PATTERN_TYPE_UNKNOWN) {
 		console_log(LOGLEVEL_DMRLC "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(sync_pattern_type));
 		repeater->slot[ipscpacket->timeslot-1].voice_frame_num = 0;
@@ -212,35 +237,35 @@ void dmr_handle_voice_frame(struct ip *ip_packet, ipscpacket_t *ipscpacket, repe
 	}
 
 	// If it's not a sync frame, then it should have an EMB inside the sync field.
-	emb = dmrpacket_emb_decode(dmrpacket_emb_extract_from_sync(sync_bits));
-	if (emb == NULL)
+	if (dmr_handle_decode_emb(ipscpacket, repeater, &emb) == NULL)
 		return;
 
 	// Handling embedded signalling LC.
-	if (emb->lcss == DMRPACKET_EMB_LCSS_SINGLE_FRAGMENT) {
-		if (dmrpacket_emb_is_null_fragment(dmrpacket_emb_signalling_lc_fragment_extract_from_sync(sync_bits)))
+	if (emb.lcss == DMRPACKET_EMB_LCSS_SINGLE_FRAGMENT) {
+		if (dmrpacket_emb_signalling_lc_fragment_extract_word(&ipscpacket->payload_packed_bits) == 0)
 			console_log(LOGLEVEL_DMRLC "  received null fragment\n");
 		else
 			console_log(LOGLEVEL_DMRLC "  received unknown single fragment\n");
 		return;
 	}
 
-	if (emb->lcss == DMRPACKET_EMB_LCSS_FIRST_FRAGMENT) {
+	if (emb.lcss == DMRPACKET_EMB_LCSS_FIRST_FRAGMENT) {
 		console_log(LOGLEVEL_DMRLC "  got first lc fragment\n");
 		vbptc_16_11_clear(&repeater->slot[ipscpacket->timeslot-1].emb_sig_lc_vbptc_storage);
 	}
 
-	if (emb->lcss == DMRPACKET_EMB_LCSS_FIRST_FRAGMENT ||
-		emb->lcss == DMRPACKET_EMB_LCSS_CONTINUATION ||
-		emb->lcss == DMRPACKET_EMB_LCSS_LAST_FRAGMENT) {
+	if (emb.lcss == DMRPACKET_EMB_LCSS_FIRST_FRAGMENT ||
+		emb.lcss == DMRPACKET_EMB_LCSS_CONTINUATION ||
+		emb.lcss == DMRPACKET_EMB_LCSS_LAST_FRAGMENT) {
+			dmrpacket_emb_signalling_lc_fragment_extract_from_packed_r(&ipscpacket->payload_packed_bits, &emb_signalling_lc_fragment_bits);
 			if (vbptc_16_11_add_burst(&repeater->slot[ipscpacket->timeslot-1].emb_sig_lc_vbptc_storage,
-				(flag_t *)dmrpacket_emb_signalling_lc_fragment_extract_from_sync(sync_bits), sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t))) {
+				emb_signalling_lc_fragment_bits.bits, sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t))) {
 					console_log(LOGLEVEL_DMRLC "  added lc fragment to the storage\n");
 			} else
 				console_log(LOGLEVEL_DMRLC "  storage full, can't add lc fragment\n");
 	}
 
-	if (emb->lcss == DMRPACKET_EMB_LCSS_LAST_FRAGMENT) {
+	if (emb.lcss == DMRPACKET_EMB_LCSS_LAST_FRAGMENT) {
 		console_log(LOGLEVEL_DMRLC "  got last lc fragment\n");
 		if (vbptc_16_11_check_and_repair(&repeater->slot[ipscpacket->timeslot-1].emb_sig_lc_vbptc_storage)) {
 			vbptc_16_11_get_data_bits(&repeater->slot[ipscpacket->timeslot-1].emb_sig_lc_vbptc_storage, (flag_t *)&emb_signalling_lc_bits, sizeof(dmrpacket_emb_signalling_lc_bits_t));
@@ -267,9 +292,7 @@ static void dmr_handle_data_call_start(struct ip *ip_packet, repeater_t *repeate
 	repeater->slot[ipscpacket->timeslot-1].data_packet_header_valid = 0;
 	repeater->slot[ipscpacket->timeslot-1].call_started_at = time(NULL);
 	repeater->slot[ipscpacket->timeslot-1].call_ended_at = 0;
-	repeater->slot[ipscpacket->timeslot-1].call_type = ipscpacket->call_type;
-	repeater->slot[ipscpacket->timeslot-1].dst_id = ipscpacket->dst_id;
-	repeater->slot[ipscpacket->timeslot-1].src_id = ipscpacket->src_id;
+	repeaters_set_call(repeater, ipscpacket->timeslot-1, ipscpacket->call_type, ipscpacket->dst_id, ipscpacket->src_id);
 	repeater->slot[ipscpacket->timeslot-1].rssi = repeater->slot[ipscpacket->timeslot-1].avg_rssi = 0;
 	if (repeater->slot[ipscpacket->timeslot-1].voicestream)
 		repeater->slot[ipscpacket->timeslot-1].voicestream->avg_rms_vol = repeater->slot[ipscpacket->timeslot-1].voicestream->rms_vol = VOICESTREAMS_INVALID_RMS_VALUE;
@@ -315,6 +338,7 @@ void dmr_handle_data_call_timeout(repeater_t *repeater, dmr_timeslot_t ts) {
 }
 
 void dmr_handle_data_header(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
+	dmrpacket_slot_type_t slot_type;
 	dmrpacket_data_header_t *data_packet_header = NULL;
 	dmrpacket_data_header_responsetype_t data_response_type = DMRPACKET_DATA_HEADER_RESPONSETYPE_ILLEGAL_FORMAT;
 	smstxbuf_t *smstxbuf_first_entry;
@@ -327,10 +351,10 @@ void dmr_handle_data_header(struct ip *ip_packet, ipscpacket_t *ipscpacket, repe
 	console_log(LOGLEVEL_DMR "dmr data [%s", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 	console_log(LOGLEVEL_DMR "->%s]: got header, ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst));
 
-	console_log(LOGLEVEL_DMR "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
+	console_log(LOGLEVEL_DMR "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
 
-	data_packet_header = dmrpacket_data_header_decode(dmrpacket_data_extract_and_repair_bptc_data(&ipscpacket->payload_bits), 0);
+	data_packet_header = dmrpacket_data_header_decode(dmrpacket_data_extract_and_repair_bptc_data(&ipscpacket->payload_packed_bits), 0);
 	if (data_packet_header == NULL)
 		return;
 
@@ -1000,11 +1024,10 @@ static void dmr_handle_data_received_block(ipscpacket_t *ipscpacket, repeater_t
 }
 
 void dmr_handle_data_34rate(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
-	dmrpacket_payload_info_bits_t *packet_payload_info_bits = NULL;
-	trellis_dibits_t *packet_payload_dibits = NULL;
+	dmrpacket_slot_type_t slot_type;
 	trellis_constellationpoints_t *packet_payload_constellationpoints = NULL;
-	trellis_tribits_t *packet_payload_tribits = NULL;
-	dmrpacket_data_binary_t *data_binary = NULL;
+	trellis_tribits_t packet_payload_tribits;
+	uint16_t trellis_path_metric = 0;
 	dmrpacket_data_block_bytes_t *data_block_bytes = NULL;
 	dmrpacket_data_block_t *data_block = NULL;
 
@@ -1017,22 +1040,26 @@ void dmr_handle_data_34rate(struct ip *ip_packet, ipscpacket_t *ipscpacket, repe
 	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "->%s]: got 3/4 rate block #%u/%u, ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst),
 		repeater->slot[ipscpacket->timeslot-1].data_blocks_received+1, repeater->slot[ipscpacket->timeslot-1].data_blocks_expected);
 
-	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
+	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
 
-	packet_payload_info_bits = dmrpacket_extract_info_bits(&ipscpacket->payload_bits);
-	packet_payload_dibits = trellis_extract_dibits(packet_payload_info_bits);
-	packet_payload_dibits = trellis_deinterleave_dibits(packet_payload_dibits);
-	packet_payload_constellationpoints = trellis_getconstellationpoints(packet_payload_dibits);
-	packet_payload_tribits = trellis_extract_tribits(packet_payload_constellationpoints);
-	data_binary = trellis_extract_binary(packet_payload_tribits);
-	data_block_bytes = dmrpacket_data_convert_binary_to_block_bytes(data_binary);
+	packet_payload_constellationpoints = trellis_getconstellationpoints_from_packed(&ipscpacket->payload_packed_bits);
+	if (trellis_decode_tribits_r(packet_payload_constellationpoints, &packet_payload_tribits, &trellis_path_metric) == NULL) {
+		console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "  trellis decode failed\n");
+		dmr_handle_data_received_block(ipscpacket, repeater, NULL);
+		return;
+	}
+	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "  trellis path metric: %u\n", trellis_path_metric);
+	data_block_bytes = trellis_extract_block_bytes(&packet_payload_tribits);
 	data_block = dmrpacket_data_decode_block(data_block_bytes, DMRPACKET_DATA_TYPE_RATE_34_DATA, repeater->slot[ipscpacket->timeslot-1].data_packet_header.common.response_requested);
+	if (data_block != NULL)
+		data_block->trellis_path_metric = trellis_path_metric;
 
 	dmr_handle_data_received_block(ipscpacket, repeater, data_block);
 }
 
 void dmr_handle_data_12rate(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t *repeater) {
+	dmrpacket_slot_type_t slot_type;
 	dmrpacket_data_block_bytes_t *data_block_bytes = NULL;
 	dmrpacket_data_block_t *data_block = NULL;
 
@@ -1045,10 +1072,10 @@ void dmr_handle_data_12rate(struct ip *ip_packet, ipscpacket_t *ipscpacket, repe
 	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "->%s]: got 1/2 rate block #%u/%u, ", repeaters_get_display_string_for_ip(&ip_packet->ip_dst),
 		repeater->slot[ipscpacket->timeslot-1].data_blocks_received+1, repeater->slot[ipscpacket->timeslot-1].data_blocks_expected);
 
-	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type(dmrpacket_sync_extract_bits(&ipscpacket->payload_bits))));
-	dmrpacket_slot_type_decode(dmrpacket_slot_type_extract_bits(&ipscpacket->payload_bits));
+	console_log(LOGLEVEL_DMR LOGLEVEL_DEBUG "sync pattern: %s\n", dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_get_sync_pattern_type_word(dmrpacket_sync_extract_word(&ipscpacket->payload_packed_bits))));
+	dmr_handle_decode_slot_type(ipscpacket, repeater, &slot_type);
 
-	data_block_bytes = dmrpacket_data_convert_payload_bptc_data_bits_to_block_bytes(dmrpacket_data_extract_and_repair_bptc_data(&ipscpacket->payload_bits));
+	data_block_bytes = dmrpacket_data_convert_payload_bptc_data_bits_to_block_bytes(dmrpacket_data_extract_and_repair_bptc_data(&ipscpacket->payload_packed_bits));
 	data_block = dmrpacket_data_decode_block(data_block_bytes, DMRPACKET_DATA_TYPE_RATE_12_DATA, repeater->slot[ipscpacket->timeslot-1].data_packet_header.common.response_requested);
 
 	dmr_handle_data_received_block(ipscpacket, repeater, data_block);
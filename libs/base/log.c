@@ -28,10 +28,14 @@ void log_loglevel(loglevel_t *loglevel) {
 	console_log("loglevel:\n");
 
 	console_log("  debug ");
+#ifdef NODEBUGLOG
+	console_log("compiled out\n");
+#else
 	if (loglevel->flags.debug)
 		console_log("on\n");
 	else
 		console_log("off\n");
+#endif
 
 	console_log("  ipsc ");
 	if (loglevel->flags.ipsc)
@@ -25,7 +25,7 @@
 #include "smsackbuf.h"
 #include "smsrtbuf.h"
 
-#include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/daemon/console.h>
 #include <libs/remotedb/remotedb.h>
 
@@ -123,6 +123,7 @@ void smsackbuf_ack_received(dmr_id_t ack_dstid, dmr_id_t ack_srcid, dmr_call_typ
 void smsackbuf_call_ended(repeater_t *repeater, dmr_timeslot_t ts) {
 	smsackbuf_t *entry = smsackbuf_first_entry;
 	loglevel_t loglevel = console_get_loglevel();
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
 	while (entry) {
 		if (((entry->dstid == repeater->slot[ts].src_id && entry->srcid == repeater->slot[ts].dst_id) || (entry->dstid == repeater->slot[ts].dst_id && entry->srcid == repeater->slot[ts].src_id)) && entry->calltype == repeater->slot[ts].call_type) {
@@ -134,7 +135,7 @@ void smsackbuf_call_ended(repeater_t *repeater, dmr_timeslot_t ts) {
 			if (entry->acked && entry->datatype != DMR_DATA_TYPE_UNKNOWN)
 				remotedb_add_data_to_log(repeater, ts, entry->dstid, entry->srcid, entry->calltype, entry->datatype, entry->msg);
 			else {
-				if (config_get_smsretransmitenabled()) {
+				if (config_snapshot != NULL && config_snapshot->smsretransmitenabled) {
 					if (entry->dstid != DMRSHARK_DEFAULT_DMR_ID && entry->srcid != DMRSHARK_DEFAULT_DMR_ID &&
 						(entry->datatype == DMR_DATA_TYPE_NORMAL_SMS || entry->datatype == DMR_DATA_TYPE_MOTOROLA_TMS_SMS))
 							smsrtbuf_add_decoded_message(repeater, ts, entry->datatype, entry->dstid, entry->srcid, entry->calltype, entry->msg);
@@ -23,7 +23,7 @@
 #include "smstxbuf.h"
 
 #include <libs/daemon/console.h>
-#include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/remotedb/userdb.h>
 
 #include <string.h>
@@ -34,11 +34,12 @@ static smsrtbuf_t *smsrtbuf_first_entry = NULL;
 
 static void smsrtbuf_print_entry(smsrtbuf_t *entry) {
 	time_t time_left;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (entry == NULL)
+	if (entry == NULL || config_snapshot == NULL)
 		return;
 
-	time_left = config_get_smsretransmittimeoutinsec()-(time(NULL)-entry->last_added_at);
+	time_left = config_snapshot->smsretransmittimeoutinsec-(time(NULL)-entry->last_added_at);
 	if (time_left < 0)
 		time_left = 0;
 	console_log("  time left: %u orig type: %s dst: %u src: %u msg: %s\n", time_left,
@@ -91,9 +92,11 @@ void smsrtbuf_add_decoded_message(repeater_t *repeater, dmr_timeslot_t ts, dmr_d
 	smsrtbuf_t *new_entry;
 	smsrtbuf_t *last_entry;
 	loglevel_t loglevel;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (repeater == NULL || msg == NULL || sms_type == DMR_DATA_TYPE_UNKNOWN || srcid == DMRSHARK_DEFAULT_DMR_ID || config_get_smsretransmittimeoutinsec() == 0)
-		return;
+	if (repeater == NULL || msg == NULL || sms_type == DMR_DATA_TYPE_UNKNOWN || srcid == DMRSHARK_DEFAULT_DMR_ID ||
+		config_snapshot == NULL || config_snapshot->smsretransmittimeoutinsec == 0)
+			return;
 
 	loglevel = console_get_loglevel();
 
@@ -223,9 +226,13 @@ void smsrtbuf_entry_send_unsuccessful(smsrtbuf_t *entry) {
 void smsrtbuf_process(void) {
 	smsrtbuf_t *entry = smsrtbuf_first_entry;
 	loglevel_t loglevel;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
+
+	if (config_snapshot == NULL)
+		return;
 
 	while (entry) {
-		if (!entry->currently_sending && time(NULL)-entry->last_added_at > config_get_smsretransmittimeoutinsec()) {
+		if (!entry->currently_sending && time(NULL)-entry->last_added_at > config_snapshot->smsretransmittimeoutinsec) {
 			loglevel = console_get_loglevel();
 			snprintf(entry->sent_msg, sizeof(entry->sent_msg), "%s: %s", userdb_get_display_str_for_id(entry->srcid), entry->orig_msg);
 
@@ -29,7 +29,7 @@
 #include <libs/daemon/console.h>
 #include <libs/daemon/daemon-poll.h>
 #include <libs/comm/repeaters.h>
-#include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/remotedb/remotedb.h>
 #include <libs/remotedb/userdb.h>
 
@@ -259,6 +259,10 @@ void smstxbuf_free_entry(smstxbuf_t *entry) {
 
 void smstxbuf_process(void) {
 	loglevel_t loglevel;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
+
+	if (config_snapshot == NULL)
+		return;
 
 	pthread_mutex_lock(&smstxbuf_mutex);
 	if (smstxbuf_first_entry == NULL) {
@@ -282,7 +286,7 @@ void smstxbuf_process(void) {
 		return;
 	}
 
-	if (smstxbuf_first_entry->send_tries >= config_get_smssendmaxretrycount()) {
+	if (smstxbuf_first_entry->send_tries >= config_snapshot->smssendmaxretrycount) {
 		console_log(LOGLEVEL_DATAQ "smstxbuf: all tries of sending the first entry has failed\n");
 		smstxbuf_print_entry(smstxbuf_first_entry);
 		pthread_mutex_unlock(&smstxbuf_mutex);
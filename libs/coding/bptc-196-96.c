@@ -28,6 +28,13 @@ typedef struct {
 	flag_t bits[4];
 } bptc_196_96_error_vector_t;
 
+// Bit n of syndrome mask i is set if row bit n is used to calculate error vector bit i.
+// These are the equations in bptc_196_96_hamming_15_11_3_get_parity_bits() with the parity bits.
+static const uint16_t bptc_196_96_hamming_15_11_3_syndrome_masks[4] = { 0x09af, 0x135e, 0x26bc, 0x44d7 };
+// Erroneous bit positions indexed by the syndrome, -1 if the error can't be located.
+static int8_t bptc_196_96_hamming_15_11_3_error_positions[16];
+static int8_t bptc_196_96_hamming_13_9_3_error_positions[16];
+
 // Hamming(15, 11, 3) checking of a matrix row (15 total bits, 11 data bits, min. distance: 3)
 // See page 135 of the DMR Air Interface protocol specification for the generator matrix.
 // A generator matrix looks like this: G = [Ik | P]. The parity check matrix is: H = [-P^T|In-k]
@@ -36,80 +43,23 @@ typedef struct {
 // of the parity check matrix, then xor each resulting row bits together with the corresponding
 // parity check bit. The xor result (error vector) should be 0, if it's not, it can be used
 // to determine the location of the erroneous bit using the generator matrix (P).
+// The error vectors (syndromes) are calculated on rows packed to words, and the location of the
+// erroneous bit is looked up by the syndrome in the tables built by bptc_196_96_init().
 static void bptc_196_96_hamming_15_11_3_get_parity_bits(flag_t *data_bits, bptc_196_96_error_vector_t *error_vector) {
-	if (data_bits == NULL || error_vector == NULL)
-		return;
-
 	error_vector->bits[0] = (data_bits[0] ^ data_bits[1] ^ data_bits[2] ^ data_bits[3] ^ data_bits[5] ^ data_bits[7] ^ data_bits[8]);
 	error_vector->bits[1] = (data_bits[1] ^ data_bits[2] ^ data_bits[3] ^ data_bits[4] ^ data_bits[6] ^ data_bits[8] ^ data_bits[9]);
 	error_vector->bits[2] = (data_bits[2] ^ data_bits[3] ^ data_bits[4] ^ data_bits[5] ^ data_bits[7] ^ data_bits[9] ^ data_bits[10]);
 	error_vector->bits[3] = (data_bits[0] ^ data_bits[1] ^ data_bits[2] ^ data_bits[4] ^ data_bits[6] ^ data_bits[7] ^ data_bits[10]);
 }
 
-static flag_t bptc_196_96_hamming_15_11_3_errorcheck(flag_t *data_bits, bptc_196_96_error_vector_t *error_vector) {
-	if (data_bits == NULL || error_vector == NULL)
-		return 0;
-
-	bptc_196_96_hamming_15_11_3_get_parity_bits(data_bits, error_vector);
-
-	error_vector->bits[0] ^= data_bits[11];
-	error_vector->bits[1] ^= data_bits[12];
-	error_vector->bits[2] ^= data_bits[13];
-	error_vector->bits[3] ^= data_bits[14];
-
-	if (error_vector->bits[0] == 0 &&
-		error_vector->bits[1] == 0 &&
-		error_vector->bits[2] == 0 &&
-		error_vector->bits[3] == 0)
-			return 1;
-
-	console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "    bptc (196,96): hamming(15,11) error vector: %u%u%u%u\n",
-		error_vector->bits[0],
-		error_vector->bits[1],
-		error_vector->bits[2],
-		error_vector->bits[3]);
-
-	return 0;
-}
-
 static void bptc_196_96_hamming_13_9_3_get_parity_bits(flag_t *data_bits, bptc_196_96_error_vector_t *error_vector) {
-	if (data_bits == NULL || error_vector == NULL)
-		return;
-
 	error_vector->bits[0] = (data_bits[0] ^ data_bits[1] ^ data_bits[3] ^ data_bits[5] ^ data_bits[6]);
 	error_vector->bits[1] = (data_bits[0] ^ data_bits[1] ^ data_bits[2] ^ data_bits[4] ^ data_bits[6] ^ data_bits[7]);
 	error_vector->bits[2] = (data_bits[0] ^ data_bits[1] ^ data_bits[2] ^ data_bits[3] ^ data_bits[5] ^ data_bits[7] ^ data_bits[8]);
 	error_vector->bits[3] = (data_bits[0] ^ data_bits[2] ^ data_bits[4] ^ data_bits[5] ^ data_bits[8]);
 }
 
-// Hamming(13, 9, 3) checking of a matrix column (13 total bits, 9 data bits, min. distance: 3)
-static flag_t bptc_196_96_hamming_13_9_3_errorcheck(flag_t *data_bits, bptc_196_96_error_vector_t *error_vector) {
-	if (data_bits == NULL || error_vector == NULL)
-		return 0;
-
-	bptc_196_96_hamming_13_9_3_get_parity_bits(data_bits, error_vector);
-
-	error_vector->bits[0] ^= data_bits[9];
-	error_vector->bits[1] ^= data_bits[10];
-	error_vector->bits[2] ^= data_bits[11];
-	error_vector->bits[3] ^= data_bits[12];
-
-	if (error_vector->bits[0] == 0 &&
-		error_vector->bits[1] == 0 &&
-		error_vector->bits[2] == 0 &&
-		error_vector->bits[3] == 0)
-			return 1;
-
-	console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "    bptc (196,96): hamming(13,9) error vector: %u%u%u%u\n",
-		error_vector->bits[0],
-		error_vector->bits[1],
-		error_vector->bits[2],
-		error_vector->bits[3]);
-
-	return 0;
-}
-
-static void bptc_196_96_display_data_matrix(flag_t deinterleaved_bits[196]) {
+static void bptc_196_96_display_data_matrix(bptc_196_96_matrix_t *matrix) {
 	loglevel_t loglevel = console_get_loglevel();
 	uint8_t row, col;
 
@@ -119,158 +69,122 @@ static void bptc_196_96_display_data_matrix(flag_t deinterleaved_bits[196]) {
 	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    bptc (196,96) matrix:\n");
 	for (row = 0; row < 13; row++) {
 		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "      #%.2u ", row);
-		for (col = 0; col < 11; col++) {
-			// +1 because the first bit is R(3) and it's not used so we can ignore that.
-			console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "%u", deinterleaved_bits[col+row*15+1]);
-		}
+		for (col = 0; col < 11; col++)
+			console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "%u", (matrix->rows[row] >> col) & 1);
 		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING " ");
-		for (; col < 15; col++) {
-			// +1 because the first bit is R(3) and it's not used so we can ignore that.
-			console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "%u", deinterleaved_bits[col+row*15+1]);
-		}
+		for (; col < 15; col++)
+			console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "%u", (matrix->rows[row] >> col) & 1);
 		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "\n");
 		if (row == 8)
 			console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "\n");
 	}
 }
 
-// Searches for the given error vector in the generator matrix.
-// Returns the erroneous bit number if the error vector is found, otherwise it returns -1.
-static int bptc_196_96_find_hamming_15_11_3_error_position(bptc_196_96_error_vector_t *error_vector) {
-	static flag_t hamming_15_11_generator_matrix[] = {
-		1, 0, 0, 1,
-		1, 1, 0, 1,
-		1, 1, 1, 1,
-		1, 1, 1, 0,
-		0, 1, 1, 1,
-		1, 0, 1, 0,
-		0, 1, 0, 1,
-		1, 0, 1, 1,
-		1, 1, 0, 0,
-		0, 1, 1, 0,
-		0, 0, 1, 1,
-
-		1, 0, 0, 0, // These are used to determine errors in the Hamming checksum bits.
-		0, 1, 0, 0,
-		0, 0, 1, 0,
-		0, 0, 0, 1
-	};
-	uint8_t row;
-
-	for (row = 0; row < 15; row++) {
-		if (hamming_15_11_generator_matrix[row*4] == error_vector->bits[0] &&
-			hamming_15_11_generator_matrix[row*4+1] == error_vector->bits[1] &&
-			hamming_15_11_generator_matrix[row*4+2] == error_vector->bits[2] &&
-			hamming_15_11_generator_matrix[row*4+3] == error_vector->bits[3])
-				return row;
-	}
-
-	return -1;
+// Packs 8 bits (all of them 0 or 1) to a byte, bits[n] will be at bit position n.
+static inline uint8_t bptc_196_96_get_byte(flag_t *bits) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t bits_word;
+
+	// The multiplication shifts bits[n] from bit position n*8 to bit position 56+n.
+	memcpy(&bits_word, bits, 8);
+	return (bits_word * 0x0102040810204080ULL) >> 56;
+#else
+	uint8_t byte = 0;
+	uint8_t i;
+
+	for (i = 0; i < 8; i++)
+		byte |= bits[i] << i;
+	return byte;
+#endif
 }
 
-// Searches for the given error vector in the generator matrix.
-// Returns the erroneous bit number if the error vector is found, otherwise it returns -1.
-static int bptc_196_96_find_hamming_13_9_3_error_position(bptc_196_96_error_vector_t *error_vector) {
-	static flag_t hamming_13_9_generator_matrix[] = {
-		1, 1, 1, 1,
-		1, 1, 1, 0,
-		0, 1, 1, 1,
-		0, 1, 1, 1,
-		0, 1, 0, 1,
-		1, 0, 1, 1,
-		1, 1, 0, 0,
-		0, 1, 1, 0,
-		0, 0, 1, 1,
-
-		1, 0, 0, 0, // These are used to determine errors in the Hamming checksum bits.
-		0, 1, 0, 0,
-		0, 0, 1, 0,
-		0, 0, 0, 1
-	};
-	uint8_t row;
-
-	if (error_vector == NULL)
-		return -1;
+// Packs a matrix row to a word, the bit of column n will be at bit position n.
+static uint16_t bptc_196_96_get_row_word(flag_t *row_bits) {
+	// The second byte is read from column 7, so we don't read past the end of the row.
+	return bptc_196_96_get_byte(row_bits) | (bptc_196_96_get_byte(&row_bits[7]) >> 1) << 8;
+}
 
-	for (row = 0; row < 13; row++) {
-		if (hamming_13_9_generator_matrix[row*4] == error_vector->bits[0] &&
-			hamming_13_9_generator_matrix[row*4+1] == error_vector->bits[1] &&
-			hamming_13_9_generator_matrix[row*4+2] == error_vector->bits[2] &&
-			hamming_13_9_generator_matrix[row*4+3] == error_vector->bits[3])
-				return row;
-	}
+// Returns the Hamming(15,11,3) syndrome of the given row word, the first error vector bit is the MSB.
+static uint8_t bptc_196_96_hamming_15_11_3_get_syndrome(uint16_t row_word) {
+	return (__builtin_parity(row_word & bptc_196_96_hamming_15_11_3_syndrome_masks[0]) << 3 |
+		__builtin_parity(row_word & bptc_196_96_hamming_15_11_3_syndrome_masks[1]) << 2 |
+		__builtin_parity(row_word & bptc_196_96_hamming_15_11_3_syndrome_masks[2]) << 1 |
+		__builtin_parity(row_word & bptc_196_96_hamming_15_11_3_syndrome_masks[3]));
+}
 
-	return -1;
+// Calculates the Hamming(13,9,3) syndromes of all 15 columns at once, using the equations of
+// bptc_196_96_hamming_13_9_3_get_parity_bits() on whole rows. Bit n of column_syndromes[i] will be
+// the error vector bit i of column n.
+static void bptc_196_96_hamming_13_9_3_get_column_syndromes(uint16_t row_words[13], uint16_t column_syndromes[4]) {
+	column_syndromes[0] = (row_words[0] ^ row_words[1] ^ row_words[3] ^ row_words[5] ^ row_words[6] ^ row_words[9]);
+	column_syndromes[1] = (row_words[0] ^ row_words[1] ^ row_words[2] ^ row_words[4] ^ row_words[6] ^ row_words[7] ^ row_words[10]);
+	column_syndromes[2] = (row_words[0] ^ row_words[1] ^ row_words[2] ^ row_words[3] ^ row_words[5] ^ row_words[7] ^ row_words[8] ^ row_words[11]);
+	column_syndromes[3] = (row_words[0] ^ row_words[2] ^ row_words[4] ^ row_words[5] ^ row_words[8] ^ row_words[12]);
 }
 
-// Checks data for errors and tries to repair them.
-flag_t bptc_196_96_check_and_repair(flag_t deinterleaved_bits[196]) {
-	bptc_196_96_error_vector_t bptc_196_96_error_vector;
-	flag_t column_bits[13] = {0,};
+// Checks the matrix for errors and tries to repair them. Only the row words are touched, so this
+// works directly on the matrix deinterleaved from the packed payload.
+flag_t bptc_196_96_check_and_repair_matrix(bptc_196_96_matrix_t *matrix) {
+	uint16_t column_syndromes[4];
+	uint16_t erroneous_columns;
+	uint8_t syndrome;
 	uint8_t row, col;
 	int8_t wrongbitnr = -1;
 	flag_t errors_found = 0;
 	flag_t result = 1;
 
-	if (deinterleaved_bits == NULL)
+	if (matrix == NULL)
 		return 0;
 
-	bptc_196_96_display_data_matrix(deinterleaved_bits);
+	bptc_196_96_display_data_matrix(matrix);
 
-	for (col = 0; col < 15; col++) {
-		for (row = 0; row < 13; row++) {
-			// +1 because the first bit is R(3) and it's not used so we can ignore that.
-			column_bits[row] = deinterleaved_bits[col+row*15+1];
-		}
+	bptc_196_96_hamming_13_9_3_get_column_syndromes(matrix->rows, column_syndromes);
+	erroneous_columns = column_syndromes[0] | column_syndromes[1] | column_syndromes[2] | column_syndromes[3];
 
-		if (!bptc_196_96_hamming_13_9_3_errorcheck(column_bits, &bptc_196_96_error_vector)) {
-			errors_found = 1;
-			// Error check failed, checking if we can determine the location of the bit error.
-			wrongbitnr = bptc_196_96_find_hamming_13_9_3_error_position(&bptc_196_96_error_vector);
-			if (wrongbitnr < 0) {
-				result = 0;
-				console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(13,9) check error, can't repair column #%u\n", col);
-			} else {
-				// +1 because the first bit is R(3) and it's not used so we can ignore that.
-				console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(13,9) check error, fixing bit row #%u col #%u\n", wrongbitnr, col);
-				deinterleaved_bits[col+wrongbitnr*15+1] = !deinterleaved_bits[col+wrongbitnr*15+1];
+	for (col = 0; erroneous_columns != 0 && col < 15; col++) {
+		if ((erroneous_columns & (1 << col)) == 0)
+			continue;
 
-				bptc_196_96_display_data_matrix(deinterleaved_bits);
+		errors_found = 1;
+		syndrome = ((column_syndromes[0] >> col) & 1) << 3 |
+			((column_syndromes[1] >> col) & 1) << 2 |
+			((column_syndromes[2] >> col) & 1) << 1 |
+			((column_syndromes[3] >> col) & 1);
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "    bptc (196,96): hamming(13,9) error vector: %u%u%u%u\n",
+			(syndrome >> 3) & 1, (syndrome >> 2) & 1, (syndrome >> 1) & 1, syndrome & 1);
 
-				for (row = 0; row < 13; row++) {
-					// +1 because the first bit is R(3) and it's not used so we can ignore that.
-					column_bits[row] = deinterleaved_bits[col+row*15+1];
-				}
+		// Error check failed, checking if we can determine the location of the bit error.
+		wrongbitnr = bptc_196_96_hamming_13_9_3_error_positions[syndrome];
+		if (wrongbitnr < 0) {
+			result = 0;
+			console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(13,9) check error, can't repair column #%u\n", col);
+		} else {
+			console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(13,9) check error, fixing bit row #%u col #%u\n", wrongbitnr, col);
+			matrix->rows[wrongbitnr] ^= (1 << col);
 
-				if (!bptc_196_96_hamming_13_9_3_errorcheck(column_bits, &bptc_196_96_error_vector)) {
-					result = 0;
-					console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(13,9) check error, couldn't repair column #%u\n", col);
-				}
-			}
+			bptc_196_96_display_data_matrix(matrix);
 		}
 	}
 
 	for (row = 0; row < 9; row++) {
-		// +1 because the first bit is R(3) and it's not used so we can ignore that.
-		if (!bptc_196_96_hamming_15_11_3_errorcheck(&deinterleaved_bits[row*15+1], &bptc_196_96_error_vector)) {
-			errors_found = 1;
-			// Error check failed, checking if we can determine the location of the bit error.
-			wrongbitnr = bptc_196_96_find_hamming_15_11_3_error_position(&bptc_196_96_error_vector);
-			if (wrongbitnr < 0) {
-				result = 0;
-				console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(15,11) check error in row %u, can't repair\n", row);
-			} else {
-				// +1 because the first bit is R(3) and it's not used so we can ignore that.
-				console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(15,11) check error, fixing bit row #%u col #%u\n", row, wrongbitnr);
-				deinterleaved_bits[row*15+wrongbitnr+1] = !deinterleaved_bits[row*15+wrongbitnr+1];
-
-				bptc_196_96_display_data_matrix(deinterleaved_bits);
+		syndrome = bptc_196_96_hamming_15_11_3_get_syndrome(matrix->rows[row]);
+		if (syndrome == 0)
+			continue;
+
+		errors_found = 1;
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "    bptc (196,96): hamming(15,11) error vector: %u%u%u%u\n",
+			(syndrome >> 3) & 1, (syndrome >> 2) & 1, (syndrome >> 1) & 1, syndrome & 1);
+
+		// Error check failed, checking if we can determine the location of the bit error.
+		wrongbitnr = bptc_196_96_hamming_15_11_3_error_positions[syndrome];
+		if (wrongbitnr < 0) {
+			result = 0;
+			console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(15,11) check error in row %u, can't repair\n", row);
+		} else {
+			console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(15,11) check error, fixing bit row #%u col #%u\n", row, wrongbitnr);
+			matrix->rows[row] ^= (1 << wrongbitnr);
 
-				if (!bptc_196_96_hamming_15_11_3_errorcheck(&deinterleaved_bits[row*15+1], &bptc_196_96_error_vector)) {
-					result = 0;
-					console_log(LOGLEVEL_CODING "    bptc (196,96): hamming(15,11) check error, couldn't repair row #%u\n", row);
-				}
-			}
+			bptc_196_96_display_data_matrix(matrix);
 		}
 	}
 
@@ -284,71 +198,166 @@ flag_t bptc_196_96_check_and_repair(flag_t deinterleaved_bits[196]) {
 	return result;
 }
 
+// Packs the deinterleaved info bits to a matrix.
+bptc_196_96_matrix_t *bptc_196_96_matrix_from_bits_r(flag_t deinterleaved_bits[196], bptc_196_96_matrix_t *matrix) {
+	uint8_t row;
+
+	if (deinterleaved_bits == NULL)
+		return NULL;
+
+	for (row = 0; row < 13; row++) {
+		// +1 because the first bit is R(3) and it's not used so we can ignore that.
+		matrix->rows[row] = bptc_196_96_get_row_word(&deinterleaved_bits[row*15+1]);
+	}
+	return matrix;
+}
+
+// Checks data for errors and tries to repair them.
+flag_t bptc_196_96_check_and_repair(flag_t deinterleaved_bits[196]) {
+	bptc_196_96_matrix_t matrix;
+	bptc_196_96_matrix_t received_matrix;
+	uint16_t repaired_bits;
+	flag_t result;
+	uint8_t row, col;
+
+	if (bptc_196_96_matrix_from_bits_r(deinterleaved_bits, &matrix) == NULL)
+		return 0;
+
+	received_matrix = matrix;
+	result = bptc_196_96_check_and_repair_matrix(&matrix);
+
+	// Writing back only the repaired bits.
+	for (row = 0; row < 13; row++) {
+		repaired_bits = matrix.rows[row] ^ received_matrix.rows[row];
+		while (repaired_bits) {
+			col = __builtin_ctz(repaired_bits);
+			repaired_bits &= repaired_bits-1;
+			// +1 because the first bit is R(3) and it's not used so we can ignore that.
+			deinterleaved_bits[row*15+col+1] = !deinterleaved_bits[row*15+col+1];
+		}
+	}
+	return result;
+}
+
 // Extracts the data bits from the given deinterleaved info bits array (discards BPTC bits).
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_r(flag_t deinterleaved_bits[196], bptc_196_96_data_bits_t *data_bits) {
+	if (deinterleaved_bits == NULL)
+		return NULL;
+
+	memcpy(&data_bits->bits[0], &deinterleaved_bits[4], 8);
+	memcpy(&data_bits->bits[8], &deinterleaved_bits[16], 11);
+	memcpy(&data_bits->bits[19], &deinterleaved_bits[31], 11);
+	memcpy(&data_bits->bits[30], &deinterleaved_bits[46], 11);
+	memcpy(&data_bits->bits[41], &deinterleaved_bits[61], 11);
+	memcpy(&data_bits->bits[52], &deinterleaved_bits[76], 11);
+	memcpy(&data_bits->bits[63], &deinterleaved_bits[91], 11);
+	memcpy(&data_bits->bits[74], &deinterleaved_bits[106], 11);
+	memcpy(&data_bits->bits[85], &deinterleaved_bits[121], 11);
+
+	return data_bits;
+}
+
 bptc_196_96_data_bits_t *bptc_196_96_extractdata(flag_t deinterleaved_bits[196]) {
 	static bptc_196_96_data_bits_t data_bits;
 
-	if (deinterleaved_bits == NULL)
+	return bptc_196_96_extractdata_r(deinterleaved_bits, &data_bits);
+}
+
+// Extracts the data bits from the given matrix (discards BPTC bits).
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_from_matrix_r(bptc_196_96_matrix_t *matrix, bptc_196_96_data_bits_t *data_bits) {
+	uint8_t row, col;
+	uint8_t dbp = 0;
+
+	if (matrix == NULL)
 		return NULL;
 
-	memcpy(&data_bits.bits[0], &deinterleaved_bits[4], 8);
-	memcpy(&data_bits.bits[8], &deinterleaved_bits[16], 11);
-	memcpy(&data_bits.bits[19], &deinterleaved_bits[31], 11);
-	memcpy(&data_bits.bits[30], &deinterleaved_bits[46], 11);
-	memcpy(&data_bits.bits[41], &deinterleaved_bits[61], 11);
-	memcpy(&data_bits.bits[52], &deinterleaved_bits[76], 11);
-	memcpy(&data_bits.bits[63], &deinterleaved_bits[91], 11);
-	memcpy(&data_bits.bits[74], &deinterleaved_bits[106], 11);
-	memcpy(&data_bits.bits[85], &deinterleaved_bits[121], 11);
-
-	return &data_bits;
+	// The first 3 columns of the first row are reserved.
+	for (row = 0, col = 3; row < 9; row++, col = 0) {
+		for (; col < 11; col++)
+			data_bits->bits[dbp++] = (matrix->rows[row] >> col) & 1;
+	}
+
+	return data_bits;
+}
+
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_from_matrix(bptc_196_96_matrix_t *matrix) {
+	static bptc_196_96_data_bits_t data_bits;
+
+	return bptc_196_96_extractdata_from_matrix_r(matrix, &data_bits);
 }
 
 // Generates 196 BPTC payload info bits from 96 data bits.
-dmrpacket_payload_info_bits_t *bptc_196_96_generate(bptc_196_96_data_bits_t *data_bits) {
-	static dmrpacket_payload_info_bits_t payload_info_bits;
+dmrpacket_payload_info_bits_t *bptc_196_96_generate_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_payload_info_bits_t *payload_info_bits) {
 	bptc_196_96_error_vector_t error_vector;
 	uint8_t col, row;
 	uint8_t dbp;
 	flag_t column_bits[9] = {0,};
 
-	memset(payload_info_bits.bits, 0, sizeof(dmrpacket_payload_info_bits_t));
+	memset(payload_info_bits->bits, 0, sizeof(dmrpacket_payload_info_bits_t));
 
 	dbp = 0;
 	for (row = 0; row < 9; row++) {
 		if (row == 0) {
 			for (col = 3; col < 11; col++) {
 				// +1 because the first bit is R(3) and it's not used so we can ignore that.
-				payload_info_bits.bits[col+1] = data_bits->bits[dbp++];
+				payload_info_bits->bits[col+1] = data_bits->bits[dbp++];
 			}
 		} else {
 			for (col = 0; col < 11; col++) {
 				// +1 because the first bit is R(3) and it's not used so we can ignore that.
-				payload_info_bits.bits[col+row*15+1] = data_bits->bits[dbp++];
+				payload_info_bits->bits[col+row*15+1] = data_bits->bits[dbp++];
 			}
 		}
 
 		// +1 because the first bit is R(3) and it's not used so we can ignore that.
-		bptc_196_96_hamming_15_11_3_get_parity_bits(&payload_info_bits.bits[row*15+1], &error_vector);
-		payload_info_bits.bits[row*15+11+1] = error_vector.bits[0];
-		payload_info_bits.bits[row*15+12+1] = error_vector.bits[1];
-		payload_info_bits.bits[row*15+13+1] = error_vector.bits[2];
-		payload_info_bits.bits[row*15+14+1] = error_vector.bits[3];
+		bptc_196_96_hamming_15_11_3_get_parity_bits(&payload_info_bits->bits[row*15+1], &error_vector);
+		payload_info_bits->bits[row*15+11+1] = error_vector.bits[0];
+		payload_info_bits->bits[row*15+12+1] = error_vector.bits[1];
+		payload_info_bits->bits[row*15+13+1] = error_vector.bits[2];
+		payload_info_bits->bits[row*15+14+1] = error_vector.bits[3];
 	}
 
 	for (col = 0; col < 15; col++) {
 		for (row = 0; row < 9; row++)
-			column_bits[row] = payload_info_bits.bits[col+row*15+1];
+			column_bits[row] = payload_info_bits->bits[col+row*15+1];
 
 		bptc_196_96_hamming_13_9_3_get_parity_bits(column_bits, &error_vector);
-		payload_info_bits.bits[col+135+1] = error_vector.bits[0];
-		payload_info_bits.bits[col+135+15+1] = error_vector.bits[1];
-		payload_info_bits.bits[col+135+30+1] = error_vector.bits[2];
-		payload_info_bits.bits[col+135+45+1] = error_vector.bits[3];
+		payload_info_bits->bits[col+135+1] = error_vector.bits[0];
+		payload_info_bits->bits[col+135+15+1] = error_vector.bits[1];
+		payload_info_bits->bits[col+135+30+1] = error_vector.bits[2];
+		payload_info_bits->bits[col+135+45+1] = error_vector.bits[3];
 	}
 
 	//console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "bptc (196,96): constructed matrix:\n");
-	//bptc_196_96_display_data_matrix(payload_info_bits.bits);
+	//bptc_196_96_display_data_matrix(payload_info_bits->bits);
+
+	return payload_info_bits;
+}
 
-	return &payload_info_bits;
+dmrpacket_payload_info_bits_t *bptc_196_96_generate(bptc_196_96_data_bits_t *data_bits) {
+	static dmrpacket_payload_info_bits_t payload_info_bits;
+
+	return bptc_196_96_generate_r(data_bits, &payload_info_bits);
+}
+
+// Builds the error position tables. A single bit error at a given position results in the syndrome
+// stored for that position.
+void bptc_196_96_init(void) {
+	uint16_t row_words[13];
+	uint16_t column_syndromes[4];
+	uint8_t bitnr;
+
+	memset(bptc_196_96_hamming_15_11_3_error_positions, -1, sizeof(bptc_196_96_hamming_15_11_3_error_positions));
+	memset(bptc_196_96_hamming_13_9_3_error_positions, -1, sizeof(bptc_196_96_hamming_13_9_3_error_positions));
+
+	for (bitnr = 0; bitnr < 15; bitnr++)
+		bptc_196_96_hamming_15_11_3_error_positions[bptc_196_96_hamming_15_11_3_get_syndrome(1 << bitnr)] = bitnr;
+
+	for (bitnr = 0; bitnr < 13; bitnr++) {
+		memset(row_words, 0, sizeof(row_words));
+		row_words[bitnr] = 1;
+		bptc_196_96_hamming_13_9_3_get_column_syndromes(row_words, column_syndromes);
+		bptc_196_96_hamming_13_9_3_error_positions[column_syndromes[0] << 3 | column_syndromes[1] << 2 |
+			column_syndromes[2] << 1 | column_syndromes[3]] = bitnr;
+	}
 }
@@ -25,9 +25,23 @@ typedef struct {
 	flag_t bits[96];
 } bptc_196_96_data_bits_t;
 
+// The deinterleaved 13x15 BPTC matrix without the unused R(3) bit, bit n of a row word is column n.
+typedef struct {
+	uint16_t rows[13];
+} bptc_196_96_matrix_t;
+
+void bptc_196_96_init(void);
+
+bptc_196_96_matrix_t *bptc_196_96_matrix_from_bits_r(flag_t deinterleaved_bits[196], bptc_196_96_matrix_t *matrix);
+
+flag_t bptc_196_96_check_and_repair_matrix(bptc_196_96_matrix_t *matrix);
 flag_t bptc_196_96_check_and_repair(flag_t deinterleaved_bits[196]);
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_from_matrix(bptc_196_96_matrix_t *matrix);
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_from_matrix_r(bptc_196_96_matrix_t *matrix, bptc_196_96_data_bits_t *data_bits);
 bptc_196_96_data_bits_t *bptc_196_96_extractdata(flag_t deinterleaved_bits[196]);
+bptc_196_96_data_bits_t *bptc_196_96_extractdata_r(flag_t deinterleaved_bits[196], bptc_196_96_data_bits_t *data_bits);
 
 dmrpacket_payload_info_bits_t *bptc_196_96_generate(bptc_196_96_data_bits_t *data_bits);
+dmrpacket_payload_info_bits_t *bptc_196_96_generate_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_payload_info_bits_t *payload_info_bits);
 
 #endif
@@ -17,14 +17,20 @@
 
 #include DEFAULTCONFIG
 
+#include "bptc-196-96.h"
+#include "crc.h"
 #include "golay-20-8.h"
 #include "quadres-16-7.h"
+#include "trellis.h"
 
 #include <libs/daemon/console.h>
 
 void coding_init(void) {
 	console_log("coding: init\n");
 
+	bptc_196_96_init();
+	crc_init();
 	golay_20_8_init();
 	quadres_16_7_init();
+	trellis_init();
 }
@@ -18,6 +18,11 @@
 #ifndef CODING_H_
 #define CODING_H_
 
+// Encoder/decoder functions returning a pointer store their result in a static buffer, which is
+// overwritten by the next call. Their _r variants write the result to a buffer given by the caller,
+// so these can be called from multiple threads at once. The lookup tables are only written by
+// coding_init().
+
 void coding_init(void);
 
 #endif
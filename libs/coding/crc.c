@@ -15,156 +15,188 @@
  * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+
 #include DEFAULTCONFIG
 
 #include "crc.h"
 
-// This algorithm uses the shift register logic to implement CRC calculation.
+#include <libs/daemon/console.h>
+
+// These CRCs use the shift register logic: input bits are shifted in to the rightmost shift register,
+// and if the bit which falls out from the last (leftmost) register is 1, all registers are xored with
+// the CRC poly. When there's no more data left, the registers are emptied out by the finish functions
+// by shifting in zeroes.
 // In the example we use the generator polynomial G(x)=x^16+x^12+x^5+1
-// We create 16 shift registers, as this is a 16-bit CRC.
-// We put the bits in from the input 8-bit value to the first (rightmost) shift register,
-// then we take the bit which falls out from the last (leftmost) shift register, and
-// xor it with every bit which go into a shift register which has x on a power in the
-// generator polynomial. To simplify this operation, we calculate a hex CRC poly value
-// and xor all shift register values with it 
 //
 // Here's how to calculate the CRC poly for a given generator polynomial:
 // Write 1 where there's an x coefficient and write 0 when there's no x for a given power:
 // 10001000000100001
 // Cut the leftmost bit and convert it to a 16 bit hex number: 0x1021
 // Algorithm source: http://srecord.sourceforge.net/crc16-ccitt.html
-// *crc initial value should be 0xffff.
 //
 // For other polynomials see: http://reveng.sourceforge.net/crc-catalogue/all.htm
-void crc_calc_crc16_ccitt(uint16_t *crc, uint8_t in) {
-	uint8_t v;
-	flag_t xor_flag;
-	uint8_t i;
+//
+// Instead of shifting the bits one by one, the register is advanced by a whole byte using tables.
+// Shifting the register by 8 bits with a byte shifted in is the same as xoring the register shifted left
+// by 8 bits with the input byte, and with the remainder of the 8 bits falling out from the register
+// (multiplied by x^n, where n is the CRC width). This remainder is in table[0]. table[k] contains the
+// remainders of x^(n+8*k) multiplied values, so the bytes falling out after 8 byte shifts can be looked
+// up in parallel (slicing-by-8).
 
-	v = 0x80;
-	for (i = 0; i < 8; i++) {
-		if ((*crc) & 0x8000)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
+#define CRC16_CCITT_POLY	0x1021
+#define CRC9_POLY			0x59
+#define CRC32_POLY			0x04c11db7
 
-		(*crc) <<= 1;
+static uint16_t crc_crc16_ccitt_table[8][256];
+static uint16_t crc_crc9_table[256];
+static uint32_t crc_crc32_table[8][256];
 
-		if (in & v)
-			(*crc)++;
+void crc_calc_crc16_ccitt(uint16_t *crc, uint8_t in) {
+	*crc = crc_crc16_ccitt_table[0][*crc >> 8] ^ (*crc << 8) ^ in;
+}
 
-		if (xor_flag)
-			(*crc) ^= 0x1021;
+// Feeds the given bytes in to the CRC, the same way as calling crc_calc_crc16_ccitt() for each byte.
+void crc_calc_crc16_ccitt_bytes(uint16_t *crc, uint8_t *bytes, uint16_t bytes_count) {
+	uint16_t c = *crc;
 
-		v >>= 1;
+	for (; bytes_count >= 8; bytes_count -= 8, bytes += 8) {
+		c = crc_crc16_ccitt_table[7][c >> 8] ^ crc_crc16_ccitt_table[6][c & 0xff] ^
+			crc_crc16_ccitt_table[5][bytes[0]] ^ crc_crc16_ccitt_table[4][bytes[1]] ^
+			crc_crc16_ccitt_table[3][bytes[2]] ^ crc_crc16_ccitt_table[2][bytes[3]] ^
+			crc_crc16_ccitt_table[1][bytes[4]] ^ crc_crc16_ccitt_table[0][bytes[5]] ^
+			(bytes[6] << 8 | bytes[7]);
 	}
+	for (; bytes_count > 0; bytes_count--, bytes++)
+		c = crc_crc16_ccitt_table[0][c >> 8] ^ (c << 8) ^ *bytes;
+
+	*crc = c;
 }
 
 // Empties out the shift registers for the CRC calculation. Call this function when there's no more data left.
 void crc_calc_crc16_ccitt_finish(uint16_t *crc) {
-	flag_t xor_flag;
-	uint8_t i;
-
-	for (i = 0; i < 16; i++) {
-		if ((*crc) & 0x8000)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
-
-		(*crc) <<= 1;
-
-		if (xor_flag)
-			(*crc) ^= 0x1021;
-	}
+	crc_calc_crc16_ccitt(crc, 0);
+	crc_calc_crc16_ccitt(crc, 0);
 }
 
 // G(x) = x^9+x^6+x^4+x^3+1 -> poly = 0b001011001 = 0x59
+// Only the lowest in_bitscount bits of in are used, they are followed by zero bits to fill a whole byte.
 void crc_calc_crc9(uint16_t *crc, uint8_t in, uint8_t in_bitscount) {
-	uint8_t v;
-	flag_t xor_flag;
-	uint8_t i;
-
-	v = 0x80;
-	for (i = 0; i < 8-in_bitscount; i++)
-		v >>= 1;
-	for (i = 0; i < 8; i++) {
-		if ((*crc) & 0x0100)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
-
-		(*crc) <<= 1;
+	uint8_t byte = (in_bitscount >= 8 ? in : (uint8_t)(in << (8-in_bitscount)));
 
-		// Limit the number of shift registers to 9.
-		*crc &= 0x01ff;
+	*crc = crc_crc9_table[(*crc >> 1) & 0xff] ^ ((*crc & 1) << 8) ^ byte;
+}
 
-		if (in & v)
-			(*crc)++;
+// Feeds the given whole bytes in to the CRC, the same way as calling crc_calc_crc9() for each byte.
+void crc_calc_crc9_bytes(uint16_t *crc, uint8_t *bytes, uint16_t bytes_count) {
+	uint16_t c = *crc;
 
-		if (xor_flag)
-			(*crc) ^= 0x59;
+	for (; bytes_count > 0; bytes_count--, bytes++)
+		c = crc_crc9_table[(c >> 1) & 0xff] ^ ((c & 1) << 8) ^ *bytes;
 
-		v >>= 1;
-	}
+	*crc = c;
 }
 
 void crc_calc_crc9_finish(uint16_t *crc, uint8_t out_bitscount) {
 	flag_t xor_flag;
-	uint8_t i;
 
-	for (i = 0; i < out_bitscount; i++) {
-		if ((*crc) & 0x0100)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
+	for (; out_bitscount >= 8; out_bitscount -= 8)
+		crc_calc_crc9(crc, 0, 8);
 
-		(*crc) <<= 1;
+	for (; out_bitscount > 0; out_bitscount--) {
+		xor_flag = ((*crc) & 0x0100) > 0;
 
 		// Limit the number of shift registers to 9.
-		*crc &= 0x01ff;
+		*crc = ((*crc) << 1) & 0x01ff;
 
 		if (xor_flag)
-			(*crc) ^= 0x59;
+			(*crc) ^= CRC9_POLY;
 	}
 }
 
 void crc_calc_crc32(uint32_t *crc, uint8_t in) {
-	uint8_t v;
-	flag_t xor_flag;
-	uint8_t i;
-
-	v = 0x80;
-	for (i = 0; i < 8; i++) {
-		if ((*crc) & 0x80000000)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
+	*crc = crc_crc32_table[0][*crc >> 24] ^ (*crc << 8) ^ in;
+}
 
-		(*crc) <<= 1;
+// Feeds the given bytes in to the CRC, the same way as calling crc_calc_crc32() for each byte.
+void crc_calc_crc32_bytes(uint32_t *crc, uint8_t *bytes, uint16_t bytes_count) {
+	uint32_t c = *crc;
 
-		if (in & v)
-			(*crc)++;
+	for (; bytes_count >= 8; bytes_count -= 8, bytes += 8) {
+		c = crc_crc32_table[7][c >> 24] ^ crc_crc32_table[6][(c >> 16) & 0xff] ^
+			crc_crc32_table[5][(c >> 8) & 0xff] ^ crc_crc32_table[4][c & 0xff] ^
+			crc_crc32_table[3][bytes[0]] ^ crc_crc32_table[2][bytes[1]] ^
+			crc_crc32_table[1][bytes[2]] ^ crc_crc32_table[0][bytes[3]] ^
+			((uint32_t)bytes[4] << 24 | bytes[5] << 16 | bytes[6] << 8 | bytes[7]);
+	}
+	for (; bytes_count > 0; bytes_count--, bytes++)
+		c = crc_crc32_table[0][c >> 24] ^ (c << 8) ^ *bytes;
 
-		if (xor_flag)
-			(*crc) ^= 0x04c11db7;
+	*crc = c;
+}
 
-		v >>= 1;
+// Same as crc_calc_crc32_bytes(), but the bytes are fed in as 16 bit little endian words (the second
+// byte of each byte pair goes first). Bytes_count should be even.
+void crc_calc_crc32_le16_bytes(uint32_t *crc, uint8_t *bytes, uint16_t bytes_count) {
+	uint32_t c = *crc;
+
+	for (; bytes_count >= 8; bytes_count -= 8, bytes += 8) {
+		c = crc_crc32_table[7][c >> 24] ^ crc_crc32_table[6][(c >> 16) & 0xff] ^
+			crc_crc32_table[5][(c >> 8) & 0xff] ^ crc_crc32_table[4][c & 0xff] ^
+			crc_crc32_table[3][bytes[1]] ^ crc_crc32_table[2][bytes[0]] ^
+			crc_crc32_table[1][bytes[3]] ^ crc_crc32_table[0][bytes[2]] ^
+			((uint32_t)bytes[5] << 24 | bytes[4] << 16 | bytes[7] << 8 | bytes[6]);
+	}
+	for (; bytes_count >= 2; bytes_count -= 2, bytes += 2) {
+		c = crc_crc32_table[0][c >> 24] ^ (c << 8) ^ bytes[1];
+		c = crc_crc32_table[0][c >> 24] ^ (c << 8) ^ bytes[0];
 	}
+
+	*crc = c;
 }
 
 void crc_calc_crc32_finish(uint32_t *crc) {
-	flag_t xor_flag;
 	uint8_t i;
 
-	for (i = 0; i < 32; i++) {
-		if ((*crc) & 0x80000000)
-			xor_flag = 1;
-		else
-			xor_flag = 0;
+	for (i = 0; i < 4; i++)
+		crc_calc_crc32(crc, 0);
+}
 
-		(*crc) <<= 1;
+static void crc_calculate_tables(void) {
+	uint16_t i;
+	uint8_t j;
+	uint16_t crc16;
+	uint16_t crc9;
+	uint32_t crc32;
+
+	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "crc: calculating tables\n");
+
+	for (i = 0; i < 256; i++) {
+		// Shifting out the byte value from the registers bit by bit gives the remainder of i*x^n.
+		crc16 = i << 8;
+		crc32 = (uint32_t)i << 24;
+		for (j = 0; j < 8; j++) {
+			crc16 = (crc16 & 0x8000 ? (crc16 << 1) ^ CRC16_CCITT_POLY : crc16 << 1);
+			crc32 = (crc32 & 0x80000000 ? (crc32 << 1) ^ CRC32_POLY : crc32 << 1);
+		}
+		crc_crc16_ccitt_table[0][i] = crc16;
+		crc_crc32_table[0][i] = crc32;
+
+		crc9 = i;
+		for (j = 0; j < 9; j++)
+			crc9 = (crc9 & 0x0100 ? ((crc9 << 1) & 0x01ff) ^ CRC9_POLY : (crc9 << 1) & 0x01ff);
+		crc_crc9_table[i] = crc9;
+	}
 
-		if (xor_flag)
-			(*crc) ^= 0x04c11db7;
+	for (j = 1; j < 8; j++) {
+		for (i = 0; i < 256; i++) {
+			crc16 = crc_crc16_ccitt_table[j-1][i];
+			crc_crc16_ccitt_table[j][i] = crc_crc16_ccitt_table[0][crc16 >> 8] ^ (crc16 << 8);
+			crc32 = crc_crc32_table[j-1][i];
+			crc_crc32_table[j][i] = crc_crc32_table[0][crc32 >> 24] ^ (crc32 << 8);
+		}
 	}
 }
+
+void crc_init(void) {
+	crc_calculate_tables();
+}
@@ -24,42 +24,56 @@
 
 #include <string.h>
 
+#define GOLAY_20_8_ERROR_PATTERN_UNCORRECTABLE	0xffffffff
+
 static golay_20_8_parity_bits_t golay_20_8_data_parity_syndromes[256];
+// The same parities packed into 12 bit words, the first parity bit is the MSB.
+static uint16_t golay_20_8_parity_words[256];
+// Error patterns with max. 3 bit errors indexed by their syndrome. The code has a min. distance of 8,
+// so these syndromes are all different.
+static uint32_t golay_20_8_error_patterns[4096];
 
 // Returns the Golay(20,8) parity bits for the given byte.
+golay_20_8_parity_bits_t *golay_20_8_get_parity_bits_r(flag_t bits[8], golay_20_8_parity_bits_t *parity) {
+	// Multiplying the generator matrix with the given data bits.
+	// See DMR AI spec. page 134.
+	parity->bits[0] = bits[1] ^ bits[4] ^ bits[5] ^ bits[6] ^ bits[7];
+	parity->bits[1] = bits[1] ^ bits[2] ^ bits[4];
+	parity->bits[2] = bits[0] ^ bits[2] ^ bits[3] ^ bits[5];
+	parity->bits[3] = bits[0] ^ bits[1] ^ bits[3] ^ bits[4] ^ bits[6];
+	parity->bits[4] = bits[0] ^ bits[1] ^ bits[2] ^ bits[4] ^ bits[5] ^ bits[7];
+	parity->bits[5] = bits[0] ^ bits[2] ^ bits[3] ^ bits[4] ^ bits[7];
+	parity->bits[6] = bits[3] ^ bits[6] ^ bits[7];
+	parity->bits[7] = bits[0] ^ bits[1] ^ bits[5] ^ bits[6];
+	parity->bits[8] = bits[0] ^ bits[1] ^ bits[2] ^ bits[6] ^ bits[7];
+	parity->bits[9] = bits[2] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6];
+	parity->bits[10] = bits[0] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6] ^ bits[7];
+	parity->bits[11] = bits[1] ^ bits[2] ^ bits[3] ^ bits[5] ^ bits[7];
+
+	return parity;
+}
+
 golay_20_8_parity_bits_t *golay_20_8_get_parity_bits(flag_t bits[8]) {
 	static golay_20_8_parity_bits_t parity;
 
-	// Multiplying the generator matrix with the given data bits.
-	// See DMR AI spec. page 134.
-	parity.bits[0] = bits[1] ^ bits[4] ^ bits[5] ^ bits[6] ^ bits[7];
-	parity.bits[1] = bits[1] ^ bits[2] ^ bits[4];
-	parity.bits[2] = bits[0] ^ bits[2] ^ bits[3] ^ bits[5];
-	parity.bits[3] = bits[0] ^ bits[1] ^ bits[3] ^ bits[4] ^ bits[6];
-	parity.bits[4] = bits[0] ^ bits[1] ^ bits[2] ^ bits[4] ^ bits[5] ^ bits[7];
-	parity.bits[5] = bits[0] ^ bits[2] ^ bits[3] ^ bits[4] ^ bits[7];
-	parity.bits[6] = bits[3] ^ bits[6] ^ bits[7];
-	parity.bits[7] = bits[0] ^ bits[1] ^ bits[5] ^ bits[6];
-	parity.bits[8] = bits[0] ^ bits[1] ^ bits[2] ^ bits[6] ^ bits[7];
-	parity.bits[9] = bits[2] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6];
-	parity.bits[10] = bits[0] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6] ^ bits[7];
-	parity.bits[11] = bits[1] ^ bits[2] ^ bits[3] ^ bits[5] ^ bits[7];
-
-	return &parity;
+	return golay_20_8_get_parity_bits_r(bits, &parity);
 }
 
 // Prefills the static data parity syndrome buffer with precalculated parities for each byte value.
 static void golay_20_8_calculate_data_parity_syndromes(void) {
 	uint16_t i;
-	golay_20_8_parity_bits_t *parity_bits = NULL;
+	uint8_t j;
 	flag_t bits[8];
 
 	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "golay: calculating data parity syndromes\n");
 
 	for (i = 0; i < 256; i++) {
 		base_bytetobits(i, bits);
-		parity_bits = golay_20_8_get_parity_bits(bits);
-		memcpy(golay_20_8_data_parity_syndromes[i].bits, parity_bits->bits, 12);
+		golay_20_8_get_parity_bits_r(bits, &golay_20_8_data_parity_syndromes[i]);
+
+		golay_20_8_parity_words[i] = 0;
+		for (j = 0; j < 12; j++)
+			golay_20_8_parity_words[i] = golay_20_8_parity_words[i] << 1 | golay_20_8_data_parity_syndromes[i].bits[j];
 	}
 }
 
@@ -78,141 +92,87 @@ static void golay_20_8_print_bits(flag_t *bits, uint8_t count, flag_t leave_spac
 	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "\n");
 }
 
-// Repairs the 8 data bits using a precalculated parity syndrome table.
-// Returns 1 if repair was successful or there were no erroneous bits detected.
-/*static flag_t golay_20_8_check_and_repair_data(flag_t bits[20]) {
-	uint16_t col;
-	int16_t syndrome_location = -1;
-	golay_20_8_parity_bits_t *parity_bits = NULL;
-	flag_t error_vector_bits[8] = {0,};
-	golay_20_8_parity_bits_t syndrome;
-
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay: checking data bits\n");
-
-	// Calculating the parity bits for the 8 bit data section.
-	parity_bits = golay_20_8_get_parity_bits(bits);
-	// Calculating the syndrome.
-	for (col = 0; col < 12; col++)
-		syndrome.bits[col] = (parity_bits->bits[col] + bits[col+8]) % 2;
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                     syndrome:          ");
-	golay_20_8_print_bits(syndrome.bits, 12, 0);
-
-	// Searching for the given syndrome in the precalculated data parity syndrome buffer.
-	for (col = 0; col < 256; col++) {
-		if (memcmp(golay_20_8_data_parity_syndromes[col].bits, syndrome.bits, 12) == 0) {
-			syndrome_location = col;
-			break;
-		}
-	}
-
-	if (syndrome_location == 0) {
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "      no data errors found\n");
-		return 1;
-	} else if (syndrome_location > 0 && syndrome_location < 256) {
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay: trying to repair data\n");
-
-		base_bytetobits(syndrome_location, error_vector_bits); // Error vector is the location of the found syndrome.
-
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "      error vector (pos. %.3u): ", syndrome_location);
-		golay_20_8_print_bits(error_vector_bits, 8, 1);
+// Returns the 12 bit syndrome of the given codeword (8 data bits followed by 12 parity bits).
+static uint16_t golay_20_8_get_syndrome(uint32_t codeword) {
+	return golay_20_8_parity_words[(codeword >> 12) & 0xff] ^ (codeword & 0xfff);
+}
 
-		for (col = 0; col < 8; col++) {
-			if (error_vector_bits[col]) // Flipping the bits in the input data which are set in the error vector.
-				bits[col] = !bits[col];
-		}
+// Checks the given 20 bit codeword (8 data bits followed by 12 parity bits), and corrects max. 3 bit errors
+// in it. The number of corrected bits is stored to corrected_bits if it's not NULL.
+// Returns 1 if the codeword had no errors, or they were corrected.
+flag_t golay_20_8_check_and_repair_word(uint32_t *codeword, uint8_t *corrected_bits) {
+	uint32_t error_pattern;
 
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "         error corrected bits: ");
-		golay_20_8_print_bits(bits, 20, 1);
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay: data errors found and repaired\n");
-		return 1;
-	} else {
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                               couldn't determine syndrome location, can't repair data errors\n");
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay: data errors found, but couldn't repair\n");
+	if (codeword == NULL)
 		return 0;
-	}
-}
 
-static void golay_20_8_check_and_repair_parity(flag_t bits[20]) {
-	uint16_t row;
-	uint8_t col;
-	uint8_t weight = 0;
-	uint8_t minweight = 0xff;
-	uint16_t minweightrow = 0;
-	golay_20_8_parity_bits_t syndrome;
-	golay_20_8_parity_bits_t error_vector;
-	golay_20_8_parity_bits_t *parity_bits;
-
-	// Calculating the syndrome
-	parity_bits = golay_20_8_get_parity_bits(bits);
-	for (col = 0; col < 12; col++) {
-		syndrome.bits[col] = (parity_bits->bits[col] + bits[col+8]) % 2;
-		if (syndrome.bits[col])
-			weight++;
+	error_pattern = golay_20_8_error_patterns[golay_20_8_get_syndrome(*codeword)];
+	if (error_pattern == GOLAY_20_8_ERROR_PATTERN_UNCORRECTABLE) {
+		console_log(LOGLEVEL_CODING "    golay: more than 3 bit errors, can't repair\n");
+		return 0;
 	}
 
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay: trying to repair parity bits\n");
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                     syndrome: ");
-	golay_20_8_print_bits(syndrome.bits, 12, 0);
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                       weight: %u\n", weight);
+	if (corrected_bits != NULL)
+		*corrected_bits = __builtin_popcount(error_pattern);
 
-	if (weight == 0) {
-		console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "      no errors found\n");
-		return;
+	if (error_pattern != 0) {
+		console_log(LOGLEVEL_CODING "    golay: %u bit errors found and repaired\n", __builtin_popcount(error_pattern));
+		*codeword ^= error_pattern;
 	}
+	return 1;
+}
 
-	for (col = 0; col < 12; col++)
-		error_vector.bits[col] = (bits[col+8] + syndrome.bits[col]) % 2;
+flag_t golay_20_8_check_and_repair(flag_t bits[20], uint8_t *corrected_bits) {
+	uint32_t codeword = 0;
+	uint8_t i;
 
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                 error vector: ");
-	golay_20_8_print_bits(error_vector.bits, 12, 0);
+	if (bits == NULL)
+		return 0;
 
-	// Searching for the minimum weight data parity syndrome in the precalculated data parity syndrome list.
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                               searching for minimum weight\n");
-	for (row = 0; row < 256; row++) {
-		weight = 0;
-		for (col = 0; col < 12; col++) {
-			if (golay_20_8_data_parity_syndromes[row].bits[col] != error_vector.bits[col])
-				weight++;
-		}
+	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay:         input bits: ");
+	golay_20_8_print_bits(bits, 20, 1);
 
-		if (weight < minweight) {
-			minweight = weight;
-			minweightrow = row;
-		}
-	}
+	for (i = 0; i < 20; i++)
+		codeword = codeword << 1 | (bits[i] & 1);
 
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                               minimum weight %u found in row %u\n", minweight, minweightrow);
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "        minimum weight parity: ");
-	golay_20_8_print_bits(error_vector.bits, 12, 0);
+	if (!golay_20_8_check_and_repair_word(&codeword, corrected_bits))
+		return 0;
 
-	memcpy(bits+8, golay_20_8_data_parity_syndromes[minweightrow].bits, 12);
+	for (i = 0; i < 20; i++)
+		bits[i] = (codeword >> (19-i)) & 1;
 
-	console_log(LOGLEVEL_CODING "    golay: parity errors found and repaired\n");
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "                        final: ");
-	golay_20_8_print_bits(bits, 20, 1);
-}*/
+	return 1;
+}
 
-flag_t golay_20_8_check_and_repair(flag_t bits[20]) {
-	golay_20_8_parity_bits_t *parity_bits = NULL;
+uint16_t golay_20_8_get_parity_word(uint8_t data) {
+	return golay_20_8_parity_words[data];
+}
 
-	if (bits == NULL)
-		return 0;
+// Returns 1 if the given 20 bit codeword (8 data bits followed by 12 parity bits) is valid.
+flag_t golay_20_8_check_word(uint32_t codeword) {
+	return (golay_20_8_parity_words[(codeword >> 12) & 0xff] == (codeword & 0xfff));
+}
 
-	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "    golay:         input bits: ");
-	golay_20_8_print_bits(bits, 20, 1);
+// Fills the error pattern table with all patterns of max. 3 bit errors.
+static void golay_20_8_calculate_error_patterns(void) {
+	uint8_t i, j, k;
+
+	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "golay: calculating error patterns\n");
 
-	parity_bits = golay_20_8_get_parity_bits(bits);
-	return (memcmp(parity_bits, bits+8, 12) == 0);
+	memset(golay_20_8_error_patterns, 0xff, sizeof(golay_20_8_error_patterns));
+	golay_20_8_error_patterns[0] = 0;
 
-/*	if (!golay_20_8_check_and_repair_data(bits)) {
-		golay_20_8_check_and_repair_parity(bits);
-		if (golay_20_8_check_and_repair_data(bits))
-			return 1;
-	} else
-		return 1;
-	return 0;*/
+	for (i = 0; i < 20; i++) {
+		golay_20_8_error_patterns[golay_20_8_get_syndrome(1 << i)] = 1 << i;
+		for (j = i+1; j < 20; j++) {
+			golay_20_8_error_patterns[golay_20_8_get_syndrome(1 << i | 1 << j)] = 1 << i | 1 << j;
+			for (k = j+1; k < 20; k++)
+				golay_20_8_error_patterns[golay_20_8_get_syndrome(1 << i | 1 << j | 1 << k)] = 1 << i | 1 << j | 1 << k;
+		}
+	}
 }
 
 void golay_20_8_init(void) {
 	golay_20_8_calculate_data_parity_syndromes();
+	golay_20_8_calculate_error_patterns();
 }
@@ -25,8 +25,14 @@ typedef struct {
 } golay_20_8_parity_bits_t;
 
 golay_20_8_parity_bits_t *golay_20_8_get_parity_bits(flag_t bits[8]);
+golay_20_8_parity_bits_t *golay_20_8_get_parity_bits_r(flag_t bits[8], golay_20_8_parity_bits_t *parity);
+
+flag_t golay_20_8_check_and_repair(flag_t bits[20], uint8_t *corrected_bits);
+
+uint16_t golay_20_8_get_parity_word(uint8_t data);
+flag_t golay_20_8_check_word(uint32_t codeword);
+flag_t golay_20_8_check_and_repair_word(uint32_t *codeword, uint8_t *corrected_bits);
 
-flag_t golay_20_8_check_and_repair(flag_t bits[20]);
 void golay_20_8_init(void);
 
 #endif
@@ -24,61 +24,134 @@
 
 #include <string.h>
 
-static quadres_16_7_parity_bits_t quadres_16_7_valid_data_paritys[128];
+#define QUADRES_16_7_ERROR_PATTERN_UNCORRECTABLE	0xffff
+
+// Parities for each 7 bit data value packed into 9 bit words, the first parity bit is the MSB.
+static uint16_t quadres_16_7_parity_words[128];
+// Error patterns with max. 2 bit errors indexed by their syndrome. The code has a min. distance of 6,
+// so these syndromes are all different.
+static uint16_t quadres_16_7_error_patterns[512];
 
 // Returns the quadratic residue (16,7,6) parity bits for the given byte.
+quadres_16_7_parity_bits_t *quadres_16_7_get_parity_bits_r(flag_t bits[7], quadres_16_7_parity_bits_t *parity) {
+	// Multiplying the generator matrix with the given data bits.
+	// See DMR AI spec. page 134.
+	parity->bits[0] = bits[1] ^ bits[2] ^ bits[3] ^ bits[4];
+	parity->bits[1] = bits[2] ^ bits[3] ^ bits[4] ^ bits[5];
+	parity->bits[2] = bits[0] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6];
+	parity->bits[3] = bits[2] ^ bits[3] ^ bits[5] ^ bits[6];
+	parity->bits[4] = bits[1] ^ bits[2] ^ bits[6];
+ 	parity->bits[5] = bits[0] ^ bits[1] ^ bits[4];
+	parity->bits[6] = bits[0] ^ bits[1] ^ bits[2] ^ bits[5];
+	parity->bits[7] = bits[0] ^ bits[1] ^ bits[2] ^ bits[3] ^ bits[6];
+	parity->bits[8] = bits[0] ^ bits[2] ^ bits[4] ^ bits[5] ^ bits[6];
+
+	return parity;
+}
+
 quadres_16_7_parity_bits_t *quadres_16_7_get_parity_bits(flag_t bits[7]) {
 	static quadres_16_7_parity_bits_t parity;
 
-	// Multiplying the generator matrix with the given data bits.
-	// See DMR AI spec. page 134.
-	parity.bits[0] = bits[1] ^ bits[2] ^ bits[3] ^ bits[4];
-	parity.bits[1] = bits[2] ^ bits[3] ^ bits[4] ^ bits[5];
-	parity.bits[2] = bits[0] ^ bits[3] ^ bits[4] ^ bits[5] ^ bits[6];
-	parity.bits[3] = bits[2] ^ bits[3] ^ bits[5] ^ bits[6];
-	parity.bits[4] = bits[1] ^ bits[2] ^ bits[6];
- 	parity.bits[5] = bits[0] ^ bits[1] ^ bits[4];
-	parity.bits[6] = bits[0] ^ bits[1] ^ bits[2] ^ bits[5];
-	parity.bits[7] = bits[0] ^ bits[1] ^ bits[2] ^ bits[3] ^ bits[6];
-	parity.bits[8] = bits[0] ^ bits[2] ^ bits[4] ^ bits[5] ^ bits[6];
-
-	return &parity;
+	return quadres_16_7_get_parity_bits_r(bits, &parity);
 }
 
-static void quadres_16_7_calculate_valid_data_paritys(void) {
+static void quadres_16_7_calculate_parity_words(void) {
 	uint16_t i;
-	quadres_16_7_parity_bits_t *parity_bits = NULL;
-	flag_t bits[9];
+	uint8_t j;
+	flag_t bits[8];
+	quadres_16_7_parity_bits_t parity_bits;
 
-	console_log("quadres: calculating valid data paritys\n");
+	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "quadres: calculating parity words\n");
 
 	for (i = 0; i < 128; i++) {
-		base_bytetobits(i, bits);
-		parity_bits = quadres_16_7_get_parity_bits(bits);
-		memcpy(quadres_16_7_valid_data_paritys[i].bits, parity_bits->bits, 9);
+		base_bytetobits(i << 1, bits);
+		quadres_16_7_get_parity_bits_r(bits, &parity_bits);
+		quadres_16_7_parity_words[i] = 0;
+		for (j = 0; j < 9; j++)
+			quadres_16_7_parity_words[i] = quadres_16_7_parity_words[i] << 1 | parity_bits.bits[j];
 	}
 }
 
-// Returns 1 if the codeword is valid.
-flag_t quadres_16_7_check(quadres_16_7_codeword_t *codeword) {
-	uint16_t col;
-	uint8_t dataval = 0;
+// Returns the 9 bit syndrome of the given codeword (7 data bits followed by 9 parity bits).
+static uint16_t quadres_16_7_get_syndrome(uint16_t codeword) {
+	return quadres_16_7_parity_words[codeword >> 9] ^ (codeword & 0x1ff);
+}
+
+// Checks the given 16 bit codeword (7 data bits followed by 9 parity bits), and corrects max. 2 bit errors
+// in it. The number of corrected bits is stored to corrected_bits if it's not NULL.
+// Returns 1 if the codeword had no errors, or they were corrected.
+flag_t quadres_16_7_check_and_repair_word(uint16_t *codeword, uint8_t *corrected_bits) {
+	uint16_t error_pattern;
 
 	if (codeword == NULL)
 		return 0;
 
-	for (col = 0; col < 7; col++) {
-		if (codeword->data[col] == 1)
-			dataval |= (1 << (7-col));
+	error_pattern = quadres_16_7_error_patterns[quadres_16_7_get_syndrome(*codeword)];
+	if (error_pattern == QUADRES_16_7_ERROR_PATTERN_UNCORRECTABLE) {
+		console_log(LOGLEVEL_CODING "    quadres: more than 2 bit errors, can't repair\n");
+		return 0;
+	}
+
+	if (corrected_bits != NULL)
+		*corrected_bits = __builtin_popcount(error_pattern);
+
+	if (error_pattern != 0) {
+		console_log(LOGLEVEL_CODING "    quadres: %u bit errors found and repaired\n", __builtin_popcount(error_pattern));
+		*codeword ^= error_pattern;
 	}
+	return 1;
+}
 
-	if (memcmp(quadres_16_7_valid_data_paritys[dataval].bits, codeword->parity, 9) == 0)
-		return 1;
+flag_t quadres_16_7_check_and_repair(quadres_16_7_codeword_t *codeword, uint8_t *corrected_bits) {
+	uint16_t codeword_word = 0;
+	uint8_t i;
 
-	return 0;
+	if (codeword == NULL)
+		return 0;
+
+	for (i = 0; i < 7; i++)
+		codeword_word = codeword_word << 1 | (codeword->data[i] & 1);
+	for (i = 0; i < 9; i++)
+		codeword_word = codeword_word << 1 | (codeword->parity[i] & 1);
+
+	if (!quadres_16_7_check_and_repair_word(&codeword_word, corrected_bits))
+		return 0;
+
+	for (i = 0; i < 7; i++)
+		codeword->data[i] = (codeword_word >> (15-i)) & 1;
+	for (i = 0; i < 9; i++)
+		codeword->parity[i] = (codeword_word >> (8-i)) & 1;
+
+	return 1;
+}
+
+uint16_t quadres_16_7_get_parity_word(uint8_t data) {
+	return quadres_16_7_parity_words[data & 0x7f];
+}
+
+// Returns 1 if the given 16 bit codeword (7 data bits followed by 9 parity bits) is valid.
+flag_t quadres_16_7_check_word(uint16_t codeword) {
+	return (quadres_16_7_parity_words[codeword >> 9] == (codeword & 0x1ff));
+}
+
+// Fills the error pattern table with all patterns of max. 2 bit errors.
+static void quadres_16_7_calculate_error_patterns(void) {
+	uint8_t i, j;
+
+	console_log(LOGLEVEL_DEBUG LOGLEVEL_CODING "quadres: calculating error patterns\n");
+
+	memset(quadres_16_7_error_patterns, 0xff, sizeof(quadres_16_7_error_patterns));
+	quadres_16_7_error_patterns[0] = 0;
+
+	for (i = 0; i < 16; i++) {
+		quadres_16_7_error_patterns[quadres_16_7_get_syndrome(1 << i)] = 1 << i;
+		for (j = i+1; j < 16; j++)
+			quadres_16_7_error_patterns[quadres_16_7_get_syndrome(1 << i | 1 << j)] = 1 << i | 1 << j;
+	}
 }
 
-// Prefills the static data parity syndrome buffer with precalculated parities for each byte value.
+// Prefills the static parity and error pattern buffers.
 void quadres_16_7_init(void) {
-	quadres_16_7_calculate_valid_data_paritys();
+	quadres_16_7_calculate_parity_words();
+	quadres_16_7_calculate_error_patterns();
 }
@@ -30,8 +30,13 @@ typedef struct {
 } quadres_16_7_parity_bits_t;
 
 quadres_16_7_parity_bits_t *quadres_16_7_get_parity_bits(flag_t bits[7]);
+quadres_16_7_parity_bits_t *quadres_16_7_get_parity_bits_r(flag_t bits[7], quadres_16_7_parity_bits_t *parity);
 
-flag_t quadres_16_7_check(quadres_16_7_codeword_t *codeword);
+flag_t quadres_16_7_check_and_repair(quadres_16_7_codeword_t *codeword, uint8_t *corrected_bits);
+
+uint16_t quadres_16_7_get_parity_word(uint8_t data);
+flag_t quadres_16_7_check_word(uint16_t codeword);
+flag_t quadres_16_7_check_and_repair_word(uint16_t *codeword, uint8_t *corrected_bits);
 
 void quadres_16_7_init(void);
 
@@ -200,13 +200,12 @@ static void rs_12_9_calculate(rs_12_9_poly_t *syndrome, rs_12_9_poly_t *error_lo
 // The error-locator polynomial's roots are found by looking for the values of a^n where
 // evaluating the polynomial yields zero (evaluating rs_12_9_error_locator_poly at
 // successive values of alpha (Chien's search)).
-static rs_12_9_roots_t *rs_12_9_find_roots(rs_12_9_poly_t *error_locator_poly) {
-	static rs_12_9_roots_t roots;
+static void rs_12_9_find_roots(rs_12_9_poly_t *error_locator_poly, rs_12_9_roots_t *roots) {
 	uint8_t sum;
 	uint16_t r;
 	uint8_t k;
 
-	memset(&roots, 0, sizeof(rs_12_9_roots_t));
+	memset(roots, 0, sizeof(rs_12_9_roots_t));
 
 	for (r = 1; r < 256; r++) {
 		sum = 0;
@@ -215,9 +214,8 @@ static rs_12_9_roots_t *rs_12_9_find_roots(rs_12_9_poly_t *error_locator_poly) {
 			sum ^= rs_12_9_galois_multiplication(rs_12_9_galois_exp_table_get((k*r) % 255), error_locator_poly->data[k]);
 
 		if (sum == 0)
-			roots.error_locations[roots.errors_num++] = (255-r);
+			roots->error_locations[roots->errors_num++] = (255-r);
 	}
-	return &roots;
 }
 
 void rs_12_9_calc_syndrome(rs_12_9_codeword_t *codeword, rs_12_9_poly_t *syndrome) {
@@ -251,28 +249,28 @@ rs_12_9_correct_errors_result_t rs_12_9_correct_errors(rs_12_9_codeword_t *codew
 	uint8_t err;
 	rs_12_9_poly_t error_locator_poly;
 	rs_12_9_poly_t error_evaluator_poly;
-	rs_12_9_roots_t *roots;
+	rs_12_9_roots_t roots;
 	uint8_t num, denom;
 
 	rs_12_9_calculate(syndrome, &error_locator_poly, &error_evaluator_poly);
-	roots = rs_12_9_find_roots(&error_locator_poly);
-	*errors_found = roots->errors_num;
+	rs_12_9_find_roots(&error_locator_poly, &roots);
+	*errors_found = roots.errors_num;
 
-	if (roots->errors_num == 0)
+	if (roots.errors_num == 0)
 		return RS_12_9_CORRECT_ERRORS_RESULT_NO_ERRORS_FOUND;
 
 	// Error correction is done using the error-evaluator equation on pp 207.
-	if (roots->errors_num > 0 && roots->errors_num <= RS_12_9_CHECKSUMSIZE) {
+	if (roots.errors_num > 0 && roots.errors_num <= RS_12_9_CHECKSUMSIZE) {
 		// First check for illegal error locations.
-		for (r = 0; r < roots->errors_num; r++) {
-			if (roots->error_locations[r] >= RS_12_9_DATASIZE+RS_12_9_CHECKSUMSIZE)
+		for (r = 0; r < roots.errors_num; r++) {
+			if (roots.error_locations[r] >= RS_12_9_DATASIZE+RS_12_9_CHECKSUMSIZE)
 				return RS_12_9_CORRECT_ERRORS_RESULT_ERRORS_CANT_BE_CORRECTED;
 		}
 
 		// Evaluates rs_12_9_error_evaluator_poly/rs_12_9_error_locator_poly' at the roots
 		// alpha^(-i) for error locs i.
-		for (r = 0; r < roots->errors_num; r++) {
-			i = roots->error_locations[r];
+		for (r = 0; r < roots.errors_num; r++) {
+			i = roots.error_locations[r];
 
 			// Evaluate rs_12_9_error_evaluator_poly at alpha^(-i)
 			num = 0;
@@ -296,21 +294,26 @@ rs_12_9_correct_errors_result_t rs_12_9_correct_errors(rs_12_9_codeword_t *codew
 }
 
 // Simulates an LFSR with the generator polynomial and calculates checksum bytes for the given data.
-rs_12_9_checksum_t *rs_12_9_calc_checksum(rs_12_9_codeword_t *codeword) {
+rs_12_9_checksum_t *rs_12_9_calc_checksum_r(rs_12_9_codeword_t *codeword, rs_12_9_checksum_t *rs_12_9_checksum) {
 	// See DMR AI. spec. page 136 for these coefficients.
 	static uint8_t genpoly[] = { 0x40, 0x38, 0x0e, 0x01 };
-	static rs_12_9_checksum_t rs_12_9_checksum;
 	uint8_t i;
 	uint8_t feedback;
 
-	rs_12_9_checksum.bytes[0] = rs_12_9_checksum.bytes[1] = rs_12_9_checksum.bytes[2] = 0;
+	rs_12_9_checksum->bytes[0] = rs_12_9_checksum->bytes[1] = rs_12_9_checksum->bytes[2] = 0;
 
 	for (i = 0; i < 9; i++) {
-		feedback = codeword->data[i] ^ rs_12_9_checksum.bytes[0];
+		feedback = codeword->data[i] ^ rs_12_9_checksum->bytes[0];
 
-		rs_12_9_checksum.bytes[0] = rs_12_9_checksum.bytes[1] ^ rs_12_9_galois_multiplication(genpoly[2], feedback);
-		rs_12_9_checksum.bytes[1] = rs_12_9_checksum.bytes[2] ^ rs_12_9_galois_multiplication(genpoly[1], feedback);
-		rs_12_9_checksum.bytes[2] = rs_12_9_galois_multiplication(genpoly[0], feedback);
+		rs_12_9_checksum->bytes[0] = rs_12_9_checksum->bytes[1] ^ rs_12_9_galois_multiplication(genpoly[2], feedback);
+		rs_12_9_checksum->bytes[1] = rs_12_9_checksum->bytes[2] ^ rs_12_9_galois_multiplication(genpoly[1], feedback);
+		rs_12_9_checksum->bytes[2] = rs_12_9_galois_multiplication(genpoly[0], feedback);
 	}
-	return &rs_12_9_checksum;
+	return rs_12_9_checksum;
+}
+
+rs_12_9_checksum_t *rs_12_9_calc_checksum(rs_12_9_codeword_t *codeword) {
+	static rs_12_9_checksum_t rs_12_9_checksum;
+
+	return rs_12_9_calc_checksum_r(codeword, &rs_12_9_checksum);
 }
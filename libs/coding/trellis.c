@@ -19,9 +19,14 @@
 
 #include "trellis.h"
 
+#include <libs/dmrpacket/dmrpacket.h>
 #include <libs/daemon/console.h>
 
 #include <stdlib.h>
+#include <string.h>
+
+// Metric of unreachable trellis states in the Viterbi decoder.
+#define TRELLIS_METRIC_UNREACHABLE		0xffff
 
 static uint8_t trellis_dibit_interleave_matrix[] = { // See DMR AI protocol spec. page 130.
 	0,	1,	8,	9,	16,	17,	24,	25,	32,	33,	40,	41,	48,	49,	56,	57,	64,	65,	72,	73,	80,	81,	88,	89,	96,	97,
@@ -41,8 +46,27 @@ static uint8_t trellis_trellis_encoder_state_transition_table[] = { // See DMR A
 	6,	14,	0,	8,	4,	12,	2,	10
 };
 
-trellis_dibits_t *trellis_extract_dibits(dmrpacket_payload_info_bits_t *info_bits) {
-	static trellis_dibits_t dibits;
+// 4FSK symbol mapping indexed by the two bits of a dibit, see DMR AI protocol spec. page 111.
+static const trellis_dibit_t trellis_bits_to_dibit[4] = { +1, +3, -1, -3 };
+
+// Dibit pairs of the constellation points, see DMR AI protocol spec. page 129.
+static const trellis_dibit_t trellis_constellationpoint_dibits[16][2] = {
+	{ +1, -1 }, { -1, -1 }, { +3, -3 }, { -3, -3 }, { -3, -1 }, { +3, -1 }, { -1, -3 }, { +1, -3 },
+	{ -3, +3 }, { +3, +3 }, { -1, +1 }, { +1, +1 }, { +1, +3 }, { -1, +3 }, { +3, +1 }, { -3, +1 }
+};
+
+// These are built by trellis_init().
+// Constellation points indexed by the dibit pair, dibit -3 is at index 0, dibit +3 at index 3.
+static uint8_t trellis_dibits_to_constellationpoint[4][4];
+// Constellation points indexed by the two transmitted bits of both dibits.
+static uint8_t trellis_dibit_bits_to_constellationpoint[4][4];
+// Payload bit positions of the deinterleaved dibits.
+static uint16_t trellis_deinterleaved_dibit_payload_positions[98];
+// Number of different bits in the dibits of two constellation points, used as the Viterbi branch metric.
+// As the 4FSK symbol mapping is Gray coded, an error to an adjacent symbol level is one bit.
+static uint8_t trellis_constellationpoint_distances[16][16];
+
+trellis_dibits_t *trellis_extract_dibits_r(dmrpacket_payload_info_bits_t *info_bits, trellis_dibits_t *dibits) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -57,30 +81,26 @@ trellis_dibits_t *trellis_extract_dibits(dmrpacket_payload_info_bits_t *info_bit
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	for (i = 0; i < 196; i += 2) {
-		// Calculate the dibits from the 4FSK symbol mapping, see DMR AI protocol spec. page 111.
-		if (info_bits->bits[i] == 0 && info_bits->bits[i+1] == 1)
-			dibits.dibits[i/2] = 3;
-		else if (info_bits->bits[i] == 0 && info_bits->bits[i+1] == 0)
-			dibits.dibits[i/2] = 1;
-		else if (info_bits->bits[i] == 1 && info_bits->bits[i+1] == 0)
-			dibits.dibits[i/2] = -1;
-		else if (info_bits->bits[i] == 1 && info_bits->bits[i+1] == 1)
-			dibits.dibits[i/2] = -3;
-	}
+	for (i = 0; i < 196; i += 2)
+		dibits->dibits[i/2] = trellis_bits_to_dibit[(info_bits->bits[i] & 1) << 1 | (info_bits->bits[i+1] & 1)];
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < 98; i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", dibits.dibits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", dibits->dibits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &dibits;
+	return dibits;
 }
 
-dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits(trellis_dibits_t *dibits) {
-	static dmrpacket_payload_info_bits_t info_bits;
+trellis_dibits_t *trellis_extract_dibits(dmrpacket_payload_info_bits_t *info_bits) {
+	static trellis_dibits_t dibits;
+
+	return trellis_extract_dibits_r(info_bits, &dibits);
+}
+
+dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits_r(trellis_dibits_t *dibits, dmrpacket_payload_info_bits_t *info_bits) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -97,10 +117,10 @@ dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits(trellis_dibit
 
 	for (i = 0; i < sizeof(trellis_dibits_t); i++) {
 		switch (dibits->dibits[i]) {
-			case +3: info_bits.bits[i*2] = 0; info_bits.bits[i*2+1] = 1; break;
-			case +1: info_bits.bits[i*2] = 0; info_bits.bits[i*2+1] = 0; break;
-			case -1: info_bits.bits[i*2] = 1; info_bits.bits[i*2+1] = 0; break;
-			case -3: info_bits.bits[i*2] = 1; info_bits.bits[i*2+1] = 1; break;
+			case +3: info_bits->bits[i*2] = 0; info_bits->bits[i*2+1] = 1; break;
+			case +1: info_bits->bits[i*2] = 0; info_bits->bits[i*2+1] = 0; break;
+			case -1: info_bits->bits[i*2] = 1; info_bits->bits[i*2+1] = 0; break;
+			case -3: info_bits->bits[i*2] = 1; info_bits->bits[i*2+1] = 1; break;
 			default: break;
 		}
 	}
@@ -108,15 +128,20 @@ dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits(trellis_dibit
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < sizeof(dmrpacket_payload_info_bits_t); i += 2)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u%u ", info_bits.bits[i], info_bits.bits[i+1]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u%u ", info_bits->bits[i], info_bits->bits[i+1]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &info_bits;
+	return info_bits;
 }
 
-trellis_dibits_t *trellis_deinterleave_dibits(trellis_dibits_t *dibits) {
-	static trellis_dibits_t deinterleaved_dibits;
+dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits(trellis_dibits_t *dibits) {
+	static dmrpacket_payload_info_bits_t info_bits;
+
+	return trellis_construct_payload_info_bits_r(dibits, &info_bits);
+}
+
+trellis_dibits_t *trellis_deinterleave_dibits_r(trellis_dibits_t *dibits, trellis_dibits_t *deinterleaved_dibits) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -132,20 +157,25 @@ trellis_dibits_t *trellis_deinterleave_dibits(trellis_dibits_t *dibits) {
 	}
 
 	for (i = 0; i < 98; i++)
-		deinterleaved_dibits.dibits[trellis_dibit_interleave_matrix[i]] = dibits->dibits[i];
+		deinterleaved_dibits->dibits[trellis_dibit_interleave_matrix[i]] = dibits->dibits[i];
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < 98; i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", deinterleaved_dibits.dibits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", deinterleaved_dibits->dibits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &deinterleaved_dibits;
+	return deinterleaved_dibits;
 }
 
-trellis_dibits_t *trellis_interleave_dibits(trellis_dibits_t *dibits) {
-	static trellis_dibits_t interleaved_dibits;
+trellis_dibits_t *trellis_deinterleave_dibits(trellis_dibits_t *dibits) {
+	static trellis_dibits_t deinterleaved_dibits;
+
+	return trellis_deinterleave_dibits_r(dibits, &deinterleaved_dibits);
+}
+
+trellis_dibits_t *trellis_interleave_dibits_r(trellis_dibits_t *dibits, trellis_dibits_t *interleaved_dibits) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -161,20 +191,25 @@ trellis_dibits_t *trellis_interleave_dibits(trellis_dibits_t *dibits) {
 	}
 
 	for (i = 0; i < 98; i++)
-		interleaved_dibits.dibits[i] = dibits->dibits[trellis_dibit_interleave_matrix[i]];
+		interleaved_dibits->dibits[i] = dibits->dibits[trellis_dibit_interleave_matrix[i]];
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < sizeof(trellis_dibits_t); i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", interleaved_dibits.dibits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", interleaved_dibits->dibits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &interleaved_dibits;
+	return interleaved_dibits;
 }
 
-trellis_constellationpoints_t *trellis_getconstellationpoints(trellis_dibits_t *deinterleaved_dibits) {
-	static trellis_constellationpoints_t constellationpoints;
+trellis_dibits_t *trellis_interleave_dibits(trellis_dibits_t *dibits) {
+	static trellis_dibits_t interleaved_dibits;
+
+	return trellis_interleave_dibits_r(dibits, &interleaved_dibits);
+}
+
+trellis_constellationpoints_t *trellis_getconstellationpoints_r(trellis_dibits_t *deinterleaved_dibits, trellis_constellationpoints_t *constellationpoints) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -190,36 +225,59 @@ trellis_constellationpoints_t *trellis_getconstellationpoints(trellis_dibits_t *
 	}
 
 	for (i = 0; i < 98; i += 2) {
-		if		(deinterleaved_dibits->dibits[i] == +1 && deinterleaved_dibits->dibits[i+1] == -1) constellationpoints.points[i/2] = 0;
-		else if	(deinterleaved_dibits->dibits[i] == -1 && deinterleaved_dibits->dibits[i+1] == -1) constellationpoints.points[i/2] = 1;
-		else if	(deinterleaved_dibits->dibits[i] == +3 && deinterleaved_dibits->dibits[i+1] == -3) constellationpoints.points[i/2] = 2;
-		else if	(deinterleaved_dibits->dibits[i] == -3 && deinterleaved_dibits->dibits[i+1] == -3) constellationpoints.points[i/2] = 3;
-		else if	(deinterleaved_dibits->dibits[i] == -3 && deinterleaved_dibits->dibits[i+1] == -1) constellationpoints.points[i/2] = 4;
-		else if	(deinterleaved_dibits->dibits[i] == +3 && deinterleaved_dibits->dibits[i+1] == -1) constellationpoints.points[i/2] = 5;
-		else if	(deinterleaved_dibits->dibits[i] == -1 && deinterleaved_dibits->dibits[i+1] == -3) constellationpoints.points[i/2] = 6;
-		else if	(deinterleaved_dibits->dibits[i] == +1 && deinterleaved_dibits->dibits[i+1] == -3) constellationpoints.points[i/2] = 7;
-		else if	(deinterleaved_dibits->dibits[i] == -3 && deinterleaved_dibits->dibits[i+1] == +3) constellationpoints.points[i/2] = 8;
-		else if	(deinterleaved_dibits->dibits[i] == +3 && deinterleaved_dibits->dibits[i+1] == +3) constellationpoints.points[i/2] = 9;
-		else if	(deinterleaved_dibits->dibits[i] == -1 && deinterleaved_dibits->dibits[i+1] == +1) constellationpoints.points[i/2] = 10;
-		else if	(deinterleaved_dibits->dibits[i] == +1 && deinterleaved_dibits->dibits[i+1] == +1) constellationpoints.points[i/2] = 11;
-		else if	(deinterleaved_dibits->dibits[i] == +1 && deinterleaved_dibits->dibits[i+1] == +3) constellationpoints.points[i/2] = 12;
-		else if	(deinterleaved_dibits->dibits[i] == -1 && deinterleaved_dibits->dibits[i+1] == +3) constellationpoints.points[i/2] = 13;
-		else if	(deinterleaved_dibits->dibits[i] == +3 && deinterleaved_dibits->dibits[i+1] == +1) constellationpoints.points[i/2] = 14;
-		else if	(deinterleaved_dibits->dibits[i] == -3 && deinterleaved_dibits->dibits[i+1] == +1) constellationpoints.points[i/2] = 15;
+		constellationpoints->points[i/2] = trellis_dibits_to_constellationpoint[((deinterleaved_dibits->dibits[i]+3) >> 1) & 3]
+			[((deinterleaved_dibits->dibits[i+1]+3) >> 1) & 3];
 	}
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < 49; i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints.points[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints->points[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &constellationpoints;
+	return constellationpoints;
 }
 
-trellis_dibits_t *trellis_construct_deinterleaved_dibits(trellis_constellationpoints_t *constellationpoints) {
-	static trellis_dibits_t deinterleaved_dibits;
+trellis_constellationpoints_t *trellis_getconstellationpoints(trellis_dibits_t *deinterleaved_dibits) {
+	static trellis_constellationpoints_t constellationpoints;
+
+	return trellis_getconstellationpoints_r(deinterleaved_dibits, &constellationpoints);
+}
+
+// Same as trellis_extract_dibits_r(), trellis_deinterleave_dibits_r() and trellis_getconstellationpoints_r()
+// in one go, but the dibits are read from the packed payload with the positions and lookup tables
+// built by trellis_init(), so the info bits don't have to be unpacked.
+trellis_constellationpoints_t *trellis_getconstellationpoints_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, trellis_constellationpoints_t *constellationpoints) {
+	loglevel_t loglevel = console_get_loglevel();
+	int i;
+
+	if (packed_bits == NULL)
+		return NULL;
+
+	for (i = 0; i < 49; i++) {
+		constellationpoints->points[i] = trellis_dibit_bits_to_constellationpoint
+			[dmrpacket_packed_get_bits(packed_bits, trellis_deinterleaved_dibit_payload_positions[i*2], 2)]
+			[dmrpacket_packed_get_bits(packed_bits, trellis_deinterleaved_dibit_payload_positions[i*2+1], 2)];
+	}
+
+	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "trellis: calculated constellation points from packed payload: ");
+		for (i = 0; i < 49; i++)
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints->points[i]);
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
+	}
+
+	return constellationpoints;
+}
+
+trellis_constellationpoints_t *trellis_getconstellationpoints_from_packed(dmrpacket_payload_packed_bits_t *packed_bits) {
+	static trellis_constellationpoints_t constellationpoints;
+
+	return trellis_getconstellationpoints_from_packed_r(packed_bits, &constellationpoints);
+}
+
+trellis_dibits_t *trellis_construct_deinterleaved_dibits_r(trellis_constellationpoints_t *constellationpoints, trellis_dibits_t *deinterleaved_dibits) {
 	loglevel_t loglevel = console_get_loglevel();
 	int i;
 
@@ -235,39 +293,30 @@ trellis_dibits_t *trellis_construct_deinterleaved_dibits(trellis_constellationpo
 	}
 
 	for (i = 0; i < sizeof(trellis_constellationpoints_t); i++) {
-		switch (constellationpoints->points[i]) {
-			case 0: deinterleaved_dibits.dibits[i*2]  = +1; deinterleaved_dibits.dibits[i*2+1] = -1; break;
-			case 1: deinterleaved_dibits.dibits[i*2]  = -1; deinterleaved_dibits.dibits[i*2+1] = -1; break;
-			case 2: deinterleaved_dibits.dibits[i*2]  = +3; deinterleaved_dibits.dibits[i*2+1] = -3; break;
-			case 3: deinterleaved_dibits.dibits[i*2]  = -3; deinterleaved_dibits.dibits[i*2+1] = -3; break;
-			case 4: deinterleaved_dibits.dibits[i*2]  = -3; deinterleaved_dibits.dibits[i*2+1] = -1; break;
-			case 5: deinterleaved_dibits.dibits[i*2]  = +3; deinterleaved_dibits.dibits[i*2+1] = -1; break;
-			case 6: deinterleaved_dibits.dibits[i*2]  = -1; deinterleaved_dibits.dibits[i*2+1] = -3; break;
-			case 7: deinterleaved_dibits.dibits[i*2]  = +1; deinterleaved_dibits.dibits[i*2+1] = -3; break;
-			case 8: deinterleaved_dibits.dibits[i*2]  = -3; deinterleaved_dibits.dibits[i*2+1] = +3; break;
-			case 9: deinterleaved_dibits.dibits[i*2]  = +3; deinterleaved_dibits.dibits[i*2+1] = +3; break;
-			case 10: deinterleaved_dibits.dibits[i*2] = -1; deinterleaved_dibits.dibits[i*2+1] = +1; break;
-			case 11: deinterleaved_dibits.dibits[i*2] = +1; deinterleaved_dibits.dibits[i*2+1] = +1; break;
-			case 12: deinterleaved_dibits.dibits[i*2] = +1; deinterleaved_dibits.dibits[i*2+1] = +3; break;
-			case 13: deinterleaved_dibits.dibits[i*2] = -1; deinterleaved_dibits.dibits[i*2+1] = +3; break;
-			case 14: deinterleaved_dibits.dibits[i*2] = +3; deinterleaved_dibits.dibits[i*2+1] = +1; break;
-			case 15: deinterleaved_dibits.dibits[i*2] = -3; deinterleaved_dibits.dibits[i*2+1] = +1; break;
-			default: break;
-		}
+		if (constellationpoints->points[i] > 15)
+			continue;
+
+		deinterleaved_dibits->dibits[i*2] = trellis_constellationpoint_dibits[constellationpoints->points[i]][0];
+		deinterleaved_dibits->dibits[i*2+1] = trellis_constellationpoint_dibits[constellationpoints->points[i]][1];
 	}
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < sizeof(trellis_dibits_t); i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", deinterleaved_dibits.dibits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%d ", deinterleaved_dibits->dibits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &deinterleaved_dibits;
+	return deinterleaved_dibits;
 }
 
-trellis_tribits_t *trellis_extract_tribits(trellis_constellationpoints_t *constellationpoints) {
-	static trellis_tribits_t tribits;
+trellis_dibits_t *trellis_construct_deinterleaved_dibits(trellis_constellationpoints_t *constellationpoints) {
+	static trellis_dibits_t deinterleaved_dibits;
+
+	return trellis_construct_deinterleaved_dibits_r(constellationpoints, &deinterleaved_dibits);
+}
+
+trellis_tribits_t *trellis_extract_tribits_r(trellis_constellationpoints_t *constellationpoints, trellis_tribits_t *tribits) {
 	int i, j, row_start;
 	flag_t match;
 	trellis_tribit_t last_state = 0;
@@ -292,7 +341,7 @@ trellis_tribits_t *trellis_extract_tribits(trellis_constellationpoints_t *conste
 			if (constellationpoints->points[i] == trellis_trellis_encoder_state_transition_table[j]) {
 				match = 1;
 				last_state = j-row_start;
-				tribits.tribits[i] = last_state;
+				tribits->tribits[i] = last_state;
 			}
 		}
 
@@ -306,15 +355,92 @@ trellis_tribits_t *trellis_extract_tribits(trellis_constellationpoints_t *conste
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < 48; i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", tribits.tribits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", tribits->tribits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &tribits;
+	return tribits;
 }
 
-trellis_constellationpoints_t *trellis_construct_constellationpoints(trellis_tribits_t *tribits) {
-	static trellis_constellationpoints_t constellationpoints;
+trellis_tribits_t *trellis_extract_tribits(trellis_constellationpoints_t *constellationpoints) {
+	static trellis_tribits_t tribits;
+
+	return trellis_extract_tribits_r(constellationpoints, &tribits);
+}
+
+// Maximum likelihood decoding of the constellation points with the Viterbi algorithm. The encoder state
+// is the last tribit, so there are 8 states, and the last constellation point always encodes a 0 tribit.
+// The branch metric is the number of different bits between the received and the expected constellation
+// point. Path_metric will be the sum of these on the decoded path, so it's the number of corrected bit
+// errors, 0 if there were no errors.
+trellis_tribits_t *trellis_decode_tribits_r(trellis_constellationpoints_t *constellationpoints, trellis_tribits_t *tribits, uint16_t *path_metric) {
+	uint16_t metrics[8];
+	uint16_t new_metrics[8];
+	uint8_t survivors[49][8]; // The previous state of the best path ending in the given state.
+	uint16_t metric;
+	uint8_t state, prev_state, point, expected_point;
+	int i;
+	loglevel_t loglevel = console_get_loglevel();
+
+	if (constellationpoints == NULL || path_metric == NULL)
+		return NULL;
+
+	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "trellis: decoding tribits from constellation points\n");
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  input: ");
+		for (i = 0; i < 49; i++)
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints->points[i]);
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
+	}
+
+	// The encoder starts from state 0.
+	metrics[0] = 0;
+	for (state = 1; state < 8; state++)
+		metrics[state] = TRELLIS_METRIC_UNREACHABLE;
+
+	for (i = 0; i < 49; i++) {
+		point = constellationpoints->points[i] & 0x0f;
+
+		for (state = 0; state < 8; state++) {
+			new_metrics[state] = TRELLIS_METRIC_UNREACHABLE;
+			// The tribit is the new state, the last point can only lead to state 0.
+			if (i == 48 && state != 0)
+				continue;
+
+			for (prev_state = 0; prev_state < 8; prev_state++) {
+				if (metrics[prev_state] == TRELLIS_METRIC_UNREACHABLE)
+					continue;
+
+				expected_point = trellis_trellis_encoder_state_transition_table[prev_state*8+state];
+				metric = metrics[prev_state] + trellis_constellationpoint_distances[point][expected_point];
+				if (metric < new_metrics[state]) {
+					new_metrics[state] = metric;
+					survivors[i][state] = prev_state;
+				}
+			}
+		}
+		memcpy(metrics, new_metrics, sizeof(metrics));
+	}
+
+	// Tracing back the best path from the final state 0.
+	state = 0;
+	for (i = 48; i > 0; i--) {
+		state = survivors[i][state];
+		tribits->tribits[i-1] = state;
+	}
+	*path_metric = metrics[0];
+
+	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
+		for (i = 0; i < 48; i++)
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", tribits->tribits[i]);
+		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n  path metric: %u\n", *path_metric);
+	}
+
+	return tribits;
+}
+
+trellis_constellationpoints_t *trellis_construct_constellationpoints_r(trellis_tribits_t *tribits, trellis_constellationpoints_t *constellationpoints) {
 	int i, row_start;
 	trellis_tribit_t last_state = 0;
 	loglevel_t loglevel = console_get_loglevel();
@@ -332,23 +458,28 @@ trellis_constellationpoints_t *trellis_construct_constellationpoints(trellis_tri
 
 	for (i = 0; i < sizeof(trellis_tribits_t); i++) {
 		row_start = last_state*8;
-		constellationpoints.points[i] = trellis_trellis_encoder_state_transition_table[row_start+tribits->tribits[i]];
+		constellationpoints->points[i] = trellis_trellis_encoder_state_transition_table[row_start+tribits->tribits[i]];
 		last_state = tribits->tribits[i];
 	}
-	constellationpoints.points[i] = trellis_trellis_encoder_state_transition_table[last_state*8];
+	constellationpoints->points[i] = trellis_trellis_encoder_state_transition_table[last_state*8];
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < sizeof(trellis_constellationpoints_t); i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints.points[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", constellationpoints->points[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &constellationpoints;
+	return constellationpoints;
 }
 
-dmrpacket_data_binary_t *trellis_extract_binary(trellis_tribits_t *tribits) {
-	static dmrpacket_data_binary_t binary;
+trellis_constellationpoints_t *trellis_construct_constellationpoints(trellis_tribits_t *tribits) {
+	static trellis_constellationpoints_t constellationpoints;
+
+	return trellis_construct_constellationpoints_r(tribits, &constellationpoints);
+}
+
+dmrpacket_data_binary_t *trellis_extract_binary_r(trellis_tribits_t *tribits, dmrpacket_data_binary_t *binary) {
 	int i;
 	loglevel_t loglevel = console_get_loglevel();
 
@@ -364,23 +495,56 @@ dmrpacket_data_binary_t *trellis_extract_binary(trellis_tribits_t *tribits) {
 	}
 
 	for (i = 0; i < 144; i += 3) {
-		binary.bits[i] =	((tribits->tribits[i/3] & 0b100) > 0);
-		binary.bits[i+1] =	((tribits->tribits[i/3] & 0b010) > 0);
-		binary.bits[i+2] =	((tribits->tribits[i/3] & 0b001) > 0);
+		binary->bits[i] =	((tribits->tribits[i/3] & 0b100) > 0);
+		binary->bits[i+1] =	((tribits->tribits[i/3] & 0b010) > 0);
+		binary->bits[i+2] =	((tribits->tribits[i/3] & 0b001) > 0);
 	}
 
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < 144; i += 3)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u%u%u ", binary.bits[i], binary.bits[i+1], binary.bits[i+2]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u%u%u ", binary->bits[i], binary->bits[i+1], binary->bits[i+2]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &binary;
+	return binary;
 }
 
-trellis_tribits_t *trellis_construct_tribits(dmrpacket_data_binary_t *binary) {
-	static trellis_tribits_t tribits;
+dmrpacket_data_binary_t *trellis_extract_binary(trellis_tribits_t *tribits) {
+	static dmrpacket_data_binary_t binary;
+
+	return trellis_extract_binary_r(tribits, &binary);
+}
+
+// Same as trellis_extract_binary_r() followed by dmrpacket_data_convert_binary_to_block_bytes_r(), but
+// 8 tribits are packed to 3 bytes at once.
+dmrpacket_data_block_bytes_t *trellis_extract_block_bytes_r(trellis_tribits_t *tribits, dmrpacket_data_block_bytes_t *bytes) {
+	uint32_t word;
+	uint8_t i, j;
+
+	if (tribits == NULL)
+		return NULL;
+
+	memset(bytes, 0, sizeof(dmrpacket_data_block_bytes_t));
+	for (i = 0; i < sizeof(trellis_tribits_t)/8; i++) {
+		for (j = 0, word = 0; j < 8; j++)
+			word = word << 3 | (tribits->tribits[i*8+j] & 0b111);
+
+		bytes->bytes[i*3] = word >> 16;
+		bytes->bytes[i*3+1] = word >> 8;
+		bytes->bytes[i*3+2] = word;
+	}
+
+	return bytes;
+}
+
+dmrpacket_data_block_bytes_t *trellis_extract_block_bytes(trellis_tribits_t *tribits) {
+	static dmrpacket_data_block_bytes_t bytes;
+
+	return trellis_extract_block_bytes_r(tribits, &bytes);
+}
+
+trellis_tribits_t *trellis_construct_tribits_r(dmrpacket_data_binary_t *binary, trellis_tribits_t *tribits) {
 	int i;
 	loglevel_t loglevel = console_get_loglevel();
 
@@ -390,13 +554,13 @@ trellis_tribits_t *trellis_construct_tribits(dmrpacket_data_binary_t *binary) {
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "trellis: constructing tribits from binary data\n");
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  input: ");
-		for (i = 0; i < sizeof(dmrpacket_data_binary_t); i += 3)
+		for (i = 0; i < sizeof(trellis_tribits_t)*3; i += 3)
 			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u%u%u ", binary->bits[i], binary->bits[i+1], binary->bits[i+2]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	for (i = 0; i < sizeof(dmrpacket_data_binary_t); i += 3) {
-		tribits.tribits[i/3] =	(binary->bits[i] == 1) << 2 |
+	for (i = 0; i < sizeof(trellis_tribits_t)*3; i += 3) {
+		tribits->tribits[i/3] =	(binary->bits[i] == 1) << 2 |
 								(binary->bits[i+1] == 1) << 1 |
 								(binary->bits[i+2] == 1);
 	}
@@ -404,9 +568,56 @@ trellis_tribits_t *trellis_construct_tribits(dmrpacket_data_binary_t *binary) {
 	if (loglevel.flags.dmrdata && loglevel.flags.debug) {
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "  output: ");
 		for (i = 0; i < sizeof(trellis_tribits_t); i++)
-			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", tribits.tribits[i]);
+			console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "%u ", tribits->tribits[i]);
 		console_log(LOGLEVEL_CODING LOGLEVEL_DEBUG "\n");
 	}
 
-	return &tribits;
+	return tribits;
+}
+
+trellis_tribits_t *trellis_construct_tribits(dmrpacket_data_binary_t *binary) {
+	static trellis_tribits_t tribits;
+
+	return trellis_construct_tribits_r(binary, &tribits);
+}
+
+// Returns the two bits of the given dibit as they are transmitted.
+static uint8_t trellis_get_dibit_bits(trellis_dibit_t dibit) {
+	uint8_t bits;
+
+	for (bits = 0; bits < 3; bits++) {
+		if (trellis_bits_to_dibit[bits] == dibit)
+			break;
+	}
+	return bits;
+}
+
+void trellis_init(void) {
+	uint8_t i, j;
+	uint16_t info_bit_pos;
+
+	for (i = 0; i < 16; i++) {
+		trellis_dibits_to_constellationpoint[(trellis_constellationpoint_dibits[i][0]+3) >> 1][(trellis_constellationpoint_dibits[i][1]+3) >> 1] = i;
+
+		for (j = 0; j < 16; j++) {
+			trellis_constellationpoint_distances[i][j] =
+				__builtin_popcount(trellis_get_dibit_bits(trellis_constellationpoint_dibits[i][0]) ^ trellis_get_dibit_bits(trellis_constellationpoint_dibits[j][0])) +
+				__builtin_popcount(trellis_get_dibit_bits(trellis_constellationpoint_dibits[i][1]) ^ trellis_get_dibit_bits(trellis_constellationpoint_dibits[j][1]));
+		}
+	}
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 4; j++) {
+			trellis_dibit_bits_to_constellationpoint[i][j] =
+				trellis_dibits_to_constellationpoint[(trellis_bits_to_dibit[i]+3) >> 1][(trellis_bits_to_dibit[j]+3) >> 1];
+		}
+	}
+
+	for (i = 0; i < 98; i++) {
+		info_bit_pos = i*2;
+		// The second half of the info bits comes after the slot type and sync fields (98+10+48+10 bits).
+		if (info_bit_pos >= sizeof(dmrpacket_payload_info_bits_t)/2)
+			info_bit_pos += 10+48+10;
+		trellis_deinterleaved_dibit_payload_positions[trellis_dibit_interleave_matrix[i]] = info_bit_pos;
+	}
 }
@@ -36,19 +36,36 @@ typedef struct {
 	trellis_tribit_t tribits[48];
 } trellis_tribits_t;
 
+void trellis_init(void);
+
 trellis_dibits_t *trellis_extract_dibits(dmrpacket_payload_info_bits_t *info_bits);
+trellis_dibits_t *trellis_extract_dibits_r(dmrpacket_payload_info_bits_t *info_bits, trellis_dibits_t *dibits);
 dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits(trellis_dibits_t *dibits);
+dmrpacket_payload_info_bits_t *trellis_construct_payload_info_bits_r(trellis_dibits_t *dibits, dmrpacket_payload_info_bits_t *info_bits);
 
 trellis_dibits_t *trellis_deinterleave_dibits(trellis_dibits_t *dibits);
+trellis_dibits_t *trellis_deinterleave_dibits_r(trellis_dibits_t *dibits, trellis_dibits_t *deinterleaved_dibits);
 trellis_dibits_t *trellis_interleave_dibits(trellis_dibits_t *dibits);
+trellis_dibits_t *trellis_interleave_dibits_r(trellis_dibits_t *dibits, trellis_dibits_t *interleaved_dibits);
 
 trellis_constellationpoints_t *trellis_getconstellationpoints(trellis_dibits_t *deinterleaved_dibits);
+trellis_constellationpoints_t *trellis_getconstellationpoints_r(trellis_dibits_t *deinterleaved_dibits, trellis_constellationpoints_t *constellationpoints);
+trellis_constellationpoints_t *trellis_getconstellationpoints_from_packed(dmrpacket_payload_packed_bits_t *packed_bits);
+trellis_constellationpoints_t *trellis_getconstellationpoints_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, trellis_constellationpoints_t *constellationpoints);
 trellis_dibits_t *trellis_construct_deinterleaved_dibits(trellis_constellationpoints_t *constellationpoints);
+trellis_dibits_t *trellis_construct_deinterleaved_dibits_r(trellis_constellationpoints_t *constellationpoints, trellis_dibits_t *deinterleaved_dibits);
 
 trellis_tribits_t *trellis_extract_tribits(trellis_constellationpoints_t *constellationpoints);
+trellis_tribits_t *trellis_extract_tribits_r(trellis_constellationpoints_t *constellationpoints, trellis_tribits_t *tribits);
+trellis_tribits_t *trellis_decode_tribits_r(trellis_constellationpoints_t *constellationpoints, trellis_tribits_t *tribits, uint16_t *path_metric);
 trellis_constellationpoints_t *trellis_construct_constellationpoints(trellis_tribits_t *tribits);
+trellis_constellationpoints_t *trellis_construct_constellationpoints_r(trellis_tribits_t *tribits, trellis_constellationpoints_t *constellationpoints);
 
 dmrpacket_data_binary_t *trellis_extract_binary(trellis_tribits_t *tribits);
+dmrpacket_data_binary_t *trellis_extract_binary_r(trellis_tribits_t *tribits, dmrpacket_data_binary_t *binary);
+dmrpacket_data_block_bytes_t *trellis_extract_block_bytes(trellis_tribits_t *tribits);
+dmrpacket_data_block_bytes_t *trellis_extract_block_bytes_r(trellis_tribits_t *tribits, dmrpacket_data_block_bytes_t *bytes);
 trellis_tribits_t *trellis_construct_tribits(dmrpacket_data_binary_t *binary);
+trellis_tribits_t *trellis_construct_tribits_r(dmrpacket_data_binary_t *binary, trellis_tribits_t *tribits);
 
 #endif
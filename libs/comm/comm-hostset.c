@@ -0,0 +1,419 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "comm-hostset.h"
+#include "comm.h"
+
+#include <libs/daemon/console.h>
+#include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Host lists from the config (like ignoredhosts) compiled into IPv4 hash sets, so checking an address
+// is only a hash probe. Host names are resolved by a background thread, which re-resolves them when
+// their TTL expires or when the host list in the config changes. New tables are handed over to the main
+// thread in comm_hostset_process().
+
+static comm_hostset_t *comm_hostsets = NULL;
+
+static pthread_t comm_hostset_thread;
+static flag_t comm_hostset_thread_started = 0;
+
+static pthread_mutex_t comm_hostset_mutex = PTHREAD_MUTEX_INITIALIZER; // Protects pending tables and the reload flag.
+static flag_t comm_hostset_reload_requested = 0;
+
+static pthread_mutex_t comm_hostset_mutex_thread_should_stop = PTHREAD_MUTEX_INITIALIZER;
+static flag_t comm_hostset_thread_should_stop = 0;
+
+static pthread_mutex_t comm_hostset_mutex_wakeup = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t comm_hostset_cond_wakeup;
+
+static uint32_t comm_hostset_hash(uint32_t addr, uint32_t size) {
+	return ((addr * 2654435761u) >> 8) & (size-1);
+}
+
+static void comm_hostset_table_free(comm_hostset_table_t *table) {
+	if (table == NULL)
+		return;
+
+	free(table->entries);
+	free(table);
+}
+
+static comm_hostset_table_t *comm_hostset_table_alloc(uint32_t size) {
+	comm_hostset_table_t *table;
+
+	table = (comm_hostset_table_t *)calloc(1, sizeof(comm_hostset_table_t));
+	if (table == NULL)
+		return NULL;
+
+	table->entries = (uint32_t *)calloc(size, sizeof(uint32_t));
+	if (table->entries == NULL) {
+		free(table);
+		return NULL;
+	}
+	table->size = size;
+	return table;
+}
+
+static void comm_hostset_table_insert(comm_hostset_table_t *table, uint32_t addr) {
+	uint32_t i = comm_hostset_hash(addr, table->size);
+
+	while (table->entries[i] != 0) {
+		if (table->entries[i] == addr)
+			return;
+		i = (i+1) & (table->size-1);
+	}
+	table->entries[i] = addr;
+	table->count++;
+}
+
+static flag_t comm_hostset_table_add(comm_hostset_table_t *table, uint32_t addr) {
+	uint32_t *old_entries;
+	uint32_t old_size;
+	uint32_t i;
+
+	if (addr == 0)
+		return 1;
+
+	// We keep the table at most half full to keep probe sequences short.
+	if (table->count >= table->size/2) {
+		old_entries = table->entries;
+		old_size = table->size;
+
+		table->entries = (uint32_t *)calloc(old_size*2, sizeof(uint32_t));
+		if (table->entries == NULL) {
+			table->entries = old_entries;
+			return 0;
+		}
+		table->size = old_size*2;
+		table->count = 0;
+		for (i = 0; i < old_size; i++) {
+			if (old_entries[i] != 0)
+				comm_hostset_table_insert(table, old_entries[i]);
+		}
+		free(old_entries);
+	}
+
+	comm_hostset_table_insert(table, addr);
+	return 1;
+}
+
+// Builds a table from the given comma separated host list. This may block on DNS lookups.
+static comm_hostset_table_t *comm_hostset_table_build(char *name, char *hosts, flag_t *has_hostnames) {
+	comm_hostset_table_t *table;
+	char *hosts_copy;
+	char *tok;
+	char *saveptr = NULL;
+	struct in_addr addr;
+	struct addrinfo hints;
+	struct addrinfo *result;
+	struct addrinfo *ai;
+
+	*has_hostnames = 0;
+
+	table = comm_hostset_table_alloc(COMM_HOSTSET_MIN_TABLE_SIZE);
+	if (table == NULL) {
+		console_log("comm hostset [%s] error: can't allocate table\n", name);
+		return NULL;
+	}
+
+	hosts_copy = strdup(hosts);
+	if (hosts_copy == NULL) {
+		console_log("comm hostset [%s] error: can't allocate host list\n", name);
+		comm_hostset_table_free(table);
+		return NULL;
+	}
+
+	memset(&hints, 0, sizeof(struct addrinfo));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	// strtok() is not thread safe, this runs in the resolver thread too.
+	for (tok = strtok_r(hosts_copy, ",", &saveptr); tok != NULL; tok = strtok_r(NULL, ",", &saveptr)) {
+		if (*tok == 0)
+			continue;
+
+		if (inet_pton(AF_INET, tok, &addr) == 1) {
+			if (!comm_hostset_table_add(table, addr.s_addr))
+				console_log("comm hostset [%s] error: can't add %s, out of memory\n", name, tok);
+			continue;
+		}
+
+		*has_hostnames = 1;
+		if (getaddrinfo(tok, NULL, &hints, &result) != 0) {
+			console_log(LOGLEVEL_DEBUG "comm hostset [%s]: can't resolve hostname %s\n", name, tok);
+			continue;
+		}
+		for (ai = result; ai != NULL; ai = ai->ai_next) {
+			if (!comm_hostset_table_add(table, ((struct sockaddr_in *)ai->ai_addr)->sin_addr.s_addr))
+				console_log("comm hostset [%s] error: can't add %s, out of memory\n", name, tok);
+		}
+		freeaddrinfo(result);
+	}
+	free(hosts_copy);
+
+	return table;
+}
+
+static void comm_hostset_free(comm_hostset_t *hostset) {
+	comm_hostset_table_free(hostset->table);
+	comm_hostset_table_free(hostset->pending_table);
+	free(hostset->resolved_hosts);
+	free(hostset->name);
+	free(hostset);
+}
+
+// Creates a host set, and builds its table synchronously. Host sets must be registered before comm_hostset_init().
+comm_hostset_t *comm_hostset_register(char *name, char *(*get_hosts)(void), void (*updated)(void)) {
+	comm_hostset_t *hostset;
+
+	if (name == NULL || get_hosts == NULL)
+		return NULL;
+
+	hostset = (comm_hostset_t *)calloc(1, sizeof(comm_hostset_t));
+	if (hostset == NULL) {
+		console_log("comm hostset error: can't allocate memory for host set %s\n", name);
+		return NULL;
+	}
+	hostset->name = strdup(name);
+	hostset->get_hosts = get_hosts;
+	hostset->updated = updated;
+	hostset->resolved_hosts = get_hosts();
+	if (hostset->name == NULL || hostset->resolved_hosts == NULL) {
+		console_log("comm hostset error: can't allocate memory for host set %s\n", name);
+		comm_hostset_free(hostset);
+		return NULL;
+	}
+
+	hostset->table = comm_hostset_table_build(hostset->name, hostset->resolved_hosts, &hostset->resolved_has_hostnames);
+	hostset->resolved_at = time(NULL);
+
+	hostset->next = comm_hostsets;
+	comm_hostsets = hostset;
+
+	return hostset;
+}
+
+flag_t comm_hostset_contains(comm_hostset_t *hostset, struct in_addr *ipaddr) {
+	comm_hostset_table_t *table;
+	uint32_t i;
+
+	if (hostset == NULL || ipaddr == NULL || ipaddr->s_addr == 0)
+		return 0;
+
+	table = hostset->table;
+	if (table == NULL || table->count == 0)
+		return 0;
+
+	i = comm_hostset_hash(ipaddr->s_addr, table->size);
+	while (table->entries[i] != 0) {
+		if (table->entries[i] == ipaddr->s_addr)
+			return 1;
+		i = (i+1) & (table->size-1);
+	}
+	return 0;
+}
+
+// Forces the resolver thread to rebuild all host sets.
+void comm_hostset_reload(void) {
+	pthread_mutex_lock(&comm_hostset_mutex);
+	comm_hostset_reload_requested = 1;
+	pthread_mutex_unlock(&comm_hostset_mutex);
+
+	// Waking up the thread if it's sleeping.
+	pthread_mutex_lock(&comm_hostset_mutex_wakeup);
+	pthread_cond_signal(&comm_hostset_cond_wakeup);
+	pthread_mutex_unlock(&comm_hostset_mutex_wakeup);
+}
+
+void comm_hostset_print(void) {
+	comm_hostset_t *hostset = comm_hostsets;
+	struct in_addr addr;
+	uint32_t i;
+
+	while (hostset) {
+		if (hostset->table == NULL)
+			console_log("host set %s: no table\n", hostset->name);
+		else {
+			console_log("host set %s (%u):\n", hostset->name, hostset->table->count);
+			for (i = 0; i < hostset->table->size; i++) {
+				if (hostset->table->entries[i] == 0)
+					continue;
+
+				addr.s_addr = hostset->table->entries[i];
+				console_log("  %s\n", comm_get_ip_str(&addr));
+			}
+		}
+		hostset = hostset->next;
+	}
+}
+
+// Swaps in the tables built by the resolver thread, and calls the update callbacks of the changed host sets.
+void comm_hostset_process(void) {
+	comm_hostset_t *hostset;
+	flag_t updated = 0;
+
+	pthread_mutex_lock(&comm_hostset_mutex);
+	for (hostset = comm_hostsets; hostset != NULL; hostset = hostset->next) {
+		hostset->swapped = 0;
+		if (hostset->pending_table == NULL)
+			continue;
+
+		comm_hostset_table_free(hostset->table);
+		hostset->table = hostset->pending_table;
+		hostset->pending_table = NULL;
+		hostset->swapped = updated = 1;
+		console_log(LOGLEVEL_COMM_IP "comm hostset [%s]: updated, %u addresses\n", hostset->name, hostset->table->count);
+	}
+	pthread_mutex_unlock(&comm_hostset_mutex);
+
+	if (!updated)
+		return;
+
+	// Callbacks are called without holding the mutex, as they may use comm_hostset_contains().
+	for (hostset = comm_hostsets; hostset != NULL; hostset = hostset->next) {
+		if (hostset->swapped && hostset->updated != NULL)
+			hostset->updated();
+	}
+}
+
+static void comm_hostset_thread_process(void) {
+	comm_hostset_t *hostset;
+	comm_hostset_table_t *table;
+	flag_t reload;
+	flag_t has_hostnames;
+	char *hosts;
+	int ttl = 0;
+	time_t now;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
+
+	pthread_mutex_lock(&comm_hostset_mutex);
+	reload = comm_hostset_reload_requested;
+	comm_hostset_reload_requested = 0;
+	pthread_mutex_unlock(&comm_hostset_mutex);
+
+	if (config_snapshot != NULL)
+		ttl = config_snapshot->hostsresolvettlinsec;
+
+	// The host set list is not modified while the thread is running.
+	for (hostset = comm_hostsets; hostset != NULL; hostset = hostset->next) {
+		hosts = hostset->get_hosts();
+		if (hosts == NULL)
+			continue;
+
+		now = time(NULL);
+		if (!reload && strcmp(hosts, hostset->resolved_hosts) == 0 &&
+			(!hostset->resolved_has_hostnames || ttl <= 0 || now-hostset->resolved_at < ttl)) {
+				free(hosts);
+				continue;
+		}
+
+		table = comm_hostset_table_build(hostset->name, hosts, &has_hostnames);
+		if (table == NULL) {
+			free(hosts);
+			continue;
+		}
+
+		free(hostset->resolved_hosts);
+		hostset->resolved_hosts = hosts;
+		hostset->resolved_has_hostnames = has_hostnames;
+		hostset->resolved_at = now;
+
+		pthread_mutex_lock(&comm_hostset_mutex);
+		comm_hostset_table_free(hostset->pending_table);
+		hostset->pending_table = table;
+		pthread_mutex_unlock(&comm_hostset_mutex);
+	}
+}
+
+static void *comm_hostset_thread_init(void *arg) {
+	struct timespec ts;
+	int config_snapshot_reader_id = config_snapshot_reader_register();
+
+	while (1) {
+		pthread_mutex_lock(&comm_hostset_mutex_thread_should_stop);
+		if (comm_hostset_thread_should_stop) {
+			pthread_mutex_unlock(&comm_hostset_mutex_thread_should_stop);
+			break;
+		}
+		pthread_mutex_unlock(&comm_hostset_mutex_thread_should_stop);
+
+		comm_hostset_thread_process();
+		config_snapshot_reader_quiescent(config_snapshot_reader_id);
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_sec += 1;
+
+		pthread_mutex_lock(&comm_hostset_mutex_wakeup);
+		pthread_cond_timedwait(&comm_hostset_cond_wakeup, &comm_hostset_mutex_wakeup, &ts);
+		pthread_mutex_unlock(&comm_hostset_mutex_wakeup);
+	}
+
+	config_snapshot_reader_unregister(config_snapshot_reader_id);
+	pthread_exit((void*) 0);
+}
+
+void comm_hostset_init(void) {
+	pthread_attr_t attr;
+
+	comm_hostset_thread_should_stop = 0;
+	pthread_cond_init(&comm_hostset_cond_wakeup, NULL);
+
+	// Explicitly creating the thread as joinable to be compatible with other systems.
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	if (pthread_create(&comm_hostset_thread, &attr, comm_hostset_thread_init, NULL) != 0)
+		console_log("comm hostset error: can't start resolver thread, host names won't be re-resolved\n");
+	else
+		comm_hostset_thread_started = 1;
+	pthread_attr_destroy(&attr);
+}
+
+void comm_hostset_deinit(void) {
+	comm_hostset_t *next;
+	void *status = NULL;
+
+	if (comm_hostset_thread_started) {
+		pthread_mutex_lock(&comm_hostset_mutex_thread_should_stop);
+		comm_hostset_thread_should_stop = 1;
+		pthread_mutex_unlock(&comm_hostset_mutex_thread_should_stop);
+
+		// Waking up the thread if it's sleeping.
+		pthread_mutex_lock(&comm_hostset_mutex_wakeup);
+		pthread_cond_signal(&comm_hostset_cond_wakeup);
+		pthread_mutex_unlock(&comm_hostset_mutex_wakeup);
+
+		pthread_join(comm_hostset_thread, &status);
+		comm_hostset_thread_started = 0;
+		pthread_cond_destroy(&comm_hostset_cond_wakeup);
+	}
+
+	while (comm_hostsets) {
+		next = comm_hostsets->next;
+		comm_hostset_free(comm_hostsets);
+		comm_hostsets = next;
+	}
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef COMM_HOSTSET_H_
+#define COMM_HOSTSET_H_
+
+#include <libs/base/types.h>
+
+#include <netinet/in.h>
+#include <time.h>
+
+// Must be a power of 2.
+#define COMM_HOSTSET_MIN_TABLE_SIZE		16
+
+typedef struct {
+	uint32_t *entries; // IPv4 addresses in network byte order, 0 means an empty entry.
+	uint32_t size;
+	uint32_t count;
+} comm_hostset_table_t;
+
+typedef struct comm_hostset_st {
+	char *name;
+	char *(*get_hosts)(void); // Config getter returning an allocated, comma separated host list.
+	void (*updated)(void); // Called by the main thread after a new table has been swapped in, can be NULL.
+
+	comm_hostset_table_t *table; // Only used by the main thread.
+	comm_hostset_table_t *pending_table; // Built by the resolver thread, protected by the hostset mutex.
+	flag_t swapped; // Set by comm_hostset_process() if the table has been swapped in its last run.
+
+	// These are only used by the resolver thread after comm_hostset_init().
+	char *resolved_hosts; // The host list the last table was built from.
+	flag_t resolved_has_hostnames; // If 0, all entries were IP addresses, so there's no need to re-resolve them.
+	time_t resolved_at;
+
+	struct comm_hostset_st *next;
+} comm_hostset_t;
+
+comm_hostset_t *comm_hostset_register(char *name, char *(*get_hosts)(void), void (*updated)(void));
+flag_t comm_hostset_contains(comm_hostset_t *hostset, struct in_addr *ipaddr);
+void comm_hostset_reload(void);
+void comm_hostset_print(void);
+
+void comm_hostset_process(void);
+void comm_hostset_init(void);
+void comm_hostset_deinit(void);
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "comm-localaddrs.h"
+#include "comm.h"
+
+#include <libs/daemon/console.h>
+#include <libs/daemon/daemon-poll.h>
+
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <ifaddrs.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// Cached set of the IPv4 addresses of the local interfaces. The set is rebuilt when the kernel
+// notifies us about an address change on the netlink socket, so lookups don't need syscalls.
+
+static uint32_t comm_localaddrs_table[COMM_LOCALADDRS_TABLE_SIZE]; // 0 means an empty entry.
+static uint16_t comm_localaddrs_count = 0;
+// If the table got full, we fall back to querying the interfaces.
+static flag_t comm_localaddrs_table_full = 0;
+static int comm_localaddrs_netlink_fd = -1;
+
+static uint16_t comm_localaddrs_hash(uint32_t addr) {
+	return ((addr * 2654435761u) >> 16) & (COMM_LOCALADDRS_TABLE_SIZE-1);
+}
+
+static void comm_localaddrs_add(uint32_t addr) {
+	uint16_t i = comm_localaddrs_hash(addr);
+
+	if (addr == 0)
+		return;
+
+	// We keep the table at most half full to keep probe sequences short.
+	if (comm_localaddrs_count >= COMM_LOCALADDRS_TABLE_SIZE/2) {
+		comm_localaddrs_table_full = 1;
+		return;
+	}
+
+	while (comm_localaddrs_table[i] != 0) {
+		if (comm_localaddrs_table[i] == addr)
+			return;
+		i = (i+1) & (COMM_LOCALADDRS_TABLE_SIZE-1);
+	}
+	comm_localaddrs_table[i] = addr;
+	comm_localaddrs_count++;
+}
+
+static void comm_localaddrs_rebuild(void) {
+	struct ifaddrs *ifaddr = NULL;
+	struct ifaddrs *ifa = NULL;
+
+	memset(comm_localaddrs_table, 0, sizeof(comm_localaddrs_table));
+	comm_localaddrs_count = 0;
+	comm_localaddrs_table_full = 0;
+
+	if (getifaddrs(&ifaddr) < 0) {
+		console_log("comm localaddrs error: can't get interface addresses: %s\n", strerror(errno));
+		comm_localaddrs_table_full = 1;
+		return;
+	}
+
+	for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+		if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET)
+			continue;
+
+		comm_localaddrs_add(((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr);
+	}
+	freeifaddrs(ifaddr);
+
+	if (comm_localaddrs_table_full)
+		console_log("comm localaddrs warning: address table is full, falling back to querying interfaces\n");
+
+	console_log(LOGLEVEL_COMM_IP "comm localaddrs: cached %u local addresses\n", comm_localaddrs_count);
+}
+
+static flag_t comm_localaddrs_contains_uncached(struct in_addr *ipaddr) {
+	struct ifaddrs *ifaddr = NULL;
+	struct ifaddrs *ifa = NULL;
+	flag_t result = 0;
+
+	if (getifaddrs(&ifaddr) < 0)
+		return 0;
+
+	for (ifa = ifaddr; ifa != NULL; ifa = ifa->ifa_next) {
+		if (ifa->ifa_addr == NULL || ifa->ifa_addr->sa_family != AF_INET)
+			continue;
+
+		if (((struct sockaddr_in *)ifa->ifa_addr)->sin_addr.s_addr == ipaddr->s_addr) {
+			result = 1;
+			break;
+		}
+	}
+	freeifaddrs(ifaddr);
+	return result;
+}
+
+flag_t comm_localaddrs_contains(struct in_addr *ipaddr) {
+	uint16_t i;
+
+	if (ipaddr == NULL || ipaddr->s_addr == 0)
+		return 0;
+
+	if (comm_localaddrs_table_full)
+		return comm_localaddrs_contains_uncached(ipaddr);
+
+	i = comm_localaddrs_hash(ipaddr->s_addr);
+	while (comm_localaddrs_table[i] != 0) {
+		if (comm_localaddrs_table[i] == ipaddr->s_addr)
+			return 1;
+		i = (i+1) & (COMM_LOCALADDRS_TABLE_SIZE-1);
+	}
+	return 0;
+}
+
+void comm_localaddrs_print(void) {
+	uint16_t i;
+	struct in_addr addr;
+
+	console_log("local addresses (%u):\n", comm_localaddrs_count);
+	for (i = 0; i < COMM_LOCALADDRS_TABLE_SIZE; i++) {
+		if (comm_localaddrs_table[i] == 0)
+			continue;
+
+		addr.s_addr = comm_localaddrs_table[i];
+		console_log("  %s\n", comm_get_ip_str(&addr));
+	}
+}
+
+// Reads netlink messages and rebuilds the address table if there was an address change.
+void comm_localaddrs_process(void) {
+	uint8_t buf[8192];
+	struct nlmsghdr *nlh;
+	int len;
+	flag_t changed = 0;
+
+	if (comm_localaddrs_netlink_fd < 0 || !daemon_poll_isfdreadable(comm_localaddrs_netlink_fd))
+		return;
+
+	while (1) {
+		len = recv(comm_localaddrs_netlink_fd, buf, sizeof(buf), MSG_DONTWAIT);
+		if (len < 0) {
+			// If the socket buffer overflowed, we may have lost some notifications.
+			if (errno == ENOBUFS)
+				changed = 1;
+			break;
+		}
+		if (len == 0)
+			break;
+
+		for (nlh = (struct nlmsghdr *)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+			if (nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_DELADDR)
+				changed = 1;
+		}
+	}
+
+	if (changed) {
+		console_log(LOGLEVEL_COMM_IP "comm localaddrs: interface addresses changed\n");
+		comm_localaddrs_rebuild();
+	}
+}
+
+void comm_localaddrs_init(void) {
+	struct sockaddr_nl addr;
+
+	// The netlink socket is bound before reading the addresses, so an address change between
+	// the two is not missed, it will trigger another rebuild in comm_localaddrs_process().
+	comm_localaddrs_netlink_fd = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+	if (comm_localaddrs_netlink_fd < 0)
+		console_log("comm localaddrs error: can't create netlink socket: %s\n", strerror(errno));
+	else {
+		memset(&addr, 0, sizeof(struct sockaddr_nl));
+		addr.nl_family = AF_NETLINK;
+		addr.nl_groups = RTMGRP_IPV4_IFADDR;
+		if (bind(comm_localaddrs_netlink_fd, (struct sockaddr *)&addr, sizeof(struct sockaddr_nl)) < 0) {
+			console_log("comm localaddrs error: can't bind netlink socket: %s\n", strerror(errno));
+			close(comm_localaddrs_netlink_fd);
+			comm_localaddrs_netlink_fd = -1;
+		}
+	}
+
+	comm_localaddrs_rebuild();
+
+	if (comm_localaddrs_netlink_fd < 0) {
+		// We won't get notified of changes, so we can't use the cache.
+		comm_localaddrs_table_full = 1;
+		return;
+	}
+
+	daemon_poll_addfd_read(comm_localaddrs_netlink_fd);
+}
+
+void comm_localaddrs_deinit(void) {
+	if (comm_localaddrs_netlink_fd >= 0) {
+		daemon_poll_removefd(comm_localaddrs_netlink_fd);
+		close(comm_localaddrs_netlink_fd);
+		comm_localaddrs_netlink_fd = -1;
+	}
+}
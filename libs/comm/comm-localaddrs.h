@@ -0,0 +1,35 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef COMM_LOCALADDRS_H_
+#define COMM_LOCALADDRS_H_
+
+#include <libs/base/types.h>
+
+#include <netinet/in.h>
+
+// Must be a power of 2.
+#define COMM_LOCALADDRS_TABLE_SIZE		256
+
+flag_t comm_localaddrs_contains(struct in_addr *ipaddr);
+void comm_localaddrs_print(void);
+
+void comm_localaddrs_process(void);
+void comm_localaddrs_init(void);
+void comm_localaddrs_deinit(void);
+
+#endif
@@ -0,0 +1,256 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "comm-mmap.h"
+#include "comm.h"
+
+#include <libs/daemon/console.h>
+#include <libs/daemon/daemon-poll.h>
+#include <libs/config/config.h>
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// Packet capture using a TPACKET_V3 memory mapped AF_PACKET ring. The kernel fills whole blocks of
+// frames, and we process them in place, so there's no copying and no syscall per packet.
+
+static int comm_mmap_fd = -1;
+static uint8_t *comm_mmap_ring = NULL;
+static size_t comm_mmap_ring_size = 0;
+static struct tpacket_req3 comm_mmap_req;
+static unsigned int comm_mmap_current_block = 0;
+static int comm_mmap_ifindex = 0;
+
+static struct {
+	uint32_t received;
+	uint32_t dropped;
+	uint32_t freezes;
+} comm_mmap_stats;
+
+flag_t comm_mmap_is_active(void) {
+	return (comm_mmap_ring != NULL);
+}
+
+int comm_mmap_get_fd(void) {
+	return comm_mmap_fd;
+}
+
+flag_t comm_mmap_setfilter(void *instructions, uint16_t instructions_count) {
+	struct sock_fprog filter;
+
+	if (comm_mmap_fd < 0 || instructions == NULL)
+		return 0;
+
+	filter.len = instructions_count;
+	filter.filter = (struct sock_filter *)instructions;
+	if (setsockopt(comm_mmap_fd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(struct sock_fprog)) < 0) {
+		console_log("comm mmap error: can't attach filter: %s\n", strerror(errno));
+		return 0;
+	}
+	return 1;
+}
+
+// Counters are cumulative since comm_mmap_init().
+flag_t comm_mmap_get_stats(uint32_t *received, uint32_t *dropped, uint32_t *freezes) {
+	struct tpacket_stats_v3 stats;
+	socklen_t len = sizeof(struct tpacket_stats_v3);
+
+	if (comm_mmap_fd < 0)
+		return 0;
+
+	// The kernel resets the counters after each read.
+	if (getsockopt(comm_mmap_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) < 0)
+		return 0;
+
+	// tp_packets includes the dropped packets.
+	comm_mmap_stats.received += stats.tp_packets;
+	comm_mmap_stats.dropped += stats.tp_drops;
+	comm_mmap_stats.freezes += stats.tp_freeze_q_cnt;
+
+	if (received)
+		*received = comm_mmap_stats.received;
+	if (dropped)
+		*dropped = comm_mmap_stats.dropped;
+	if (freezes)
+		*freezes = comm_mmap_stats.freezes;
+	return 1;
+}
+
+static void comm_mmap_process_block(struct tpacket_block_desc *block) {
+	struct tpacket3_hdr *frame;
+	uint32_t i;
+	uint8_t *packet;
+
+	frame = (struct tpacket3_hdr *)((uint8_t *)block + block->hdr.bh1.offset_to_first_pkt);
+	for (i = 0; i < block->hdr.bh1.num_pkts; i++) {
+		// We are using a SOCK_DGRAM socket, so the frame starts with the IP header.
+		packet = (uint8_t *)frame + frame->tp_net;
+
+		console_log(LOGLEVEL_COMM_IP "comm got packet: %u bytes\n", frame->tp_len);
+		comm_process_captured_packet(packet, frame->tp_snaplen);
+
+		frame = (struct tpacket3_hdr *)((uint8_t *)frame + frame->tp_next_offset);
+	}
+}
+
+// Processes the blocks which have been retired by the kernel. Processing stops at a block
+// boundary after max_packets has been reached. If max_packets is 0, all ready blocks are processed.
+// Returns the number of processed packets.
+int comm_mmap_process(int max_packets) {
+	struct tpacket_block_desc *block;
+	int processed = 0;
+
+	if (comm_mmap_ring == NULL)
+		return 0;
+
+	while (max_packets <= 0 || processed < max_packets) {
+		block = (struct tpacket_block_desc *)(comm_mmap_ring + comm_mmap_current_block*comm_mmap_req.tp_block_size);
+		// The acquire load makes sure we see the frames the kernel has written before retiring the block.
+		if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+			break;
+
+		comm_mmap_process_block(block);
+		processed += block->hdr.bh1.num_pkts;
+
+		// Giving the block back to the kernel.
+		__atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+		comm_mmap_current_block = (comm_mmap_current_block+1) % comm_mmap_req.tp_block_nr;
+	}
+	return processed;
+}
+
+// Sets up the socket and the rx ring. Packets are not captured until comm_mmap_start() is called, so
+// the capture filter can be attached before the first packet arrives.
+flag_t comm_mmap_init(char *netdevname) {
+	int version = TPACKET_V3;
+	int blocksize;
+	int blockcount;
+	int retiretimeout;
+	int pagesize;
+
+	blocksize = config_get_mmapblocksize();
+	blockcount = config_get_mmapblockcount();
+	retiretimeout = config_get_mmapblockretiretimeoutinms();
+
+	// Block size must be a multiple of the page size.
+	pagesize = getpagesize();
+	if (blocksize < pagesize)
+		blocksize = pagesize;
+	blocksize = ((blocksize+pagesize-1)/pagesize)*pagesize;
+	if (blockcount < 1)
+		blockcount = 1;
+	if (retiretimeout < 1)
+		retiretimeout = 1;
+
+	console_log("comm mmap: opening capture device %s, block size: %u, block count: %u, block retire timeout: %ums\n",
+		netdevname, blocksize, blockcount, retiretimeout);
+
+	memset(&comm_mmap_stats, 0, sizeof(comm_mmap_stats));
+	comm_mmap_current_block = 0;
+
+	// Protocol 0 means the socket does not receive anything until it's bound to a protocol.
+	comm_mmap_fd = socket(AF_PACKET, SOCK_DGRAM, 0);
+	if (comm_mmap_fd < 0) {
+		console_log("comm mmap error: can't create packet socket: %s\n", strerror(errno));
+		return 0;
+	}
+
+	if (setsockopt(comm_mmap_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+		console_log("comm mmap error: can't set TPACKET_V3: %s\n", strerror(errno));
+		comm_mmap_deinit();
+		return 0;
+	}
+
+	memset(&comm_mmap_req, 0, sizeof(struct tpacket_req3));
+	comm_mmap_req.tp_block_size = blocksize;
+	comm_mmap_req.tp_block_nr = blockcount;
+	comm_mmap_req.tp_frame_size = COMM_MMAP_FRAME_SIZE;
+	comm_mmap_req.tp_frame_nr = (blocksize/COMM_MMAP_FRAME_SIZE)*blockcount;
+	comm_mmap_req.tp_retire_blk_tov = retiretimeout;
+	if (setsockopt(comm_mmap_fd, SOL_PACKET, PACKET_RX_RING, &comm_mmap_req, sizeof(struct tpacket_req3)) < 0) {
+		console_log("comm mmap error: can't set up rx ring: %s\n", strerror(errno));
+		comm_mmap_deinit();
+		return 0;
+	}
+
+	comm_mmap_ring_size = (size_t)comm_mmap_req.tp_block_size*comm_mmap_req.tp_block_nr;
+	comm_mmap_ring = (uint8_t *)mmap(NULL, comm_mmap_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, comm_mmap_fd, 0);
+	if (comm_mmap_ring == MAP_FAILED) {
+		console_log("comm mmap error: can't map rx ring: %s\n", strerror(errno));
+		comm_mmap_ring = NULL;
+		comm_mmap_deinit();
+		return 0;
+	}
+
+	// Interface index 0 means all interfaces.
+	comm_mmap_ifindex = 0;
+	if (strcmp(netdevname, "any") != 0) {
+		comm_mmap_ifindex = if_nametoindex(netdevname);
+		if (comm_mmap_ifindex == 0) {
+			console_log("comm mmap error: unknown device %s\n", netdevname);
+			comm_mmap_deinit();
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+// Starts capturing by binding the socket to the IP protocol. Call this after the filter has been set.
+flag_t comm_mmap_start(void) {
+	struct sockaddr_ll sll;
+
+	if (comm_mmap_ring == NULL)
+		return 0;
+
+	memset(&sll, 0, sizeof(struct sockaddr_ll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_IP);
+	sll.sll_ifindex = comm_mmap_ifindex;
+	if (bind(comm_mmap_fd, (struct sockaddr *)&sll, sizeof(struct sockaddr_ll)) < 0) {
+		console_log("comm mmap error: can't bind to interface index %d: %s\n", comm_mmap_ifindex, strerror(errno));
+		comm_mmap_deinit();
+		return 0;
+	}
+
+	daemon_poll_addfd_read(comm_mmap_fd);
+
+	return 1;
+}
+
+void comm_mmap_deinit(void) {
+	if (comm_mmap_ring != NULL) {
+		munmap(comm_mmap_ring, comm_mmap_ring_size);
+		comm_mmap_ring = NULL;
+	}
+
+	if (comm_mmap_fd >= 0) {
+		daemon_poll_removefd(comm_mmap_fd);
+		close(comm_mmap_fd);
+		comm_mmap_fd = -1;
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef COMM_MMAP_H_
+#define COMM_MMAP_H_
+
+#include <libs/base/types.h>
+
+// Frames are variable sized in TPACKET_V3 blocks, this is only used for calculating the frame count for the kernel.
+#define COMM_MMAP_FRAME_SIZE	2048
+
+flag_t comm_mmap_is_active(void);
+int comm_mmap_get_fd(void);
+// Filter instructions are in classic BPF format (struct sock_filter, layout compatible with libpcap's struct bpf_insn).
+flag_t comm_mmap_setfilter(void *instructions, uint16_t instructions_count);
+flag_t comm_mmap_get_stats(uint32_t *received, uint32_t *dropped, uint32_t *freezes);
+
+int comm_mmap_process(int max_packets);
+flag_t comm_mmap_init(char *netdevname);
+flag_t comm_mmap_start(void);
+void comm_mmap_deinit(void);
+
+#endif
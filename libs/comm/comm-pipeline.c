@@ -0,0 +1,410 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "comm-pipeline.h"
+#include "ipsc.h"
+
+#include <libs/daemon/console.h>
+#include <libs/daemon/daemon-poll.h>
+#include <libs/config/config.h>
+
+#include <sys/eventfd.h>
+#include <netinet/ip.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+// Captured packets are processed in three stages: the capture thread copies them to the queue of a
+// decode worker, the worker validates and decodes them (checksums, IPSC decoding, payload bits), and the
+// main thread handles the decoded packets (repeater state, calls, voice streams, SMS, etc.).
+//
+// Repeaters are hashed to workers by their IP address, so packets of a repeater are always processed by
+// the same worker, in the order they were captured. Each worker has one ring, which is shared by the
+// stages: the capture thread adds entries at write_pos, the worker decodes them in place at decode_pos,
+// and the main thread handles them at handle_pos. Every position is only written by its own stage. If a
+// ring is full, the capture thread drops the packet and counts it, the capture is never blocked.
+
+#define COMM_PIPELINE_MINQUEUESIZE			16
+#define COMM_PIPELINE_MAXQUEUESIZE			65536
+#define COMM_PIPELINE_WORKER_WAKEUP_IN_MS	100
+
+typedef struct {
+	uint64_t captured_at; // Nanoseconds, CLOCK_MONOTONIC.
+	uint64_t decoded_at;
+	uint16_t length;
+	ipsc_decoderesult_t result;
+	union {
+		ipscpacket_raw_t raw;
+		uint8_t bytes[COMM_PIPELINE_MAXPACKETSIZE];
+	} packet __attribute__((aligned(8))); // Aligned for accessing the IP header.
+} comm_pipeline_entry_t;
+
+typedef struct {
+	uint32_t count;
+	uint64_t sum; // Nanoseconds.
+	uint64_t max;
+} comm_pipeline_latency_t;
+
+typedef struct {
+	uint8_t index;
+	pthread_t thread;
+	flag_t thread_started;
+	comm_pipeline_entry_t *entries;
+	uint32_t mask;
+
+	uint32_t write_pos __attribute__((aligned(64)));
+	uint32_t decode_pos __attribute__((aligned(64)));
+	uint32_t handle_pos __attribute__((aligned(64)));
+
+	pthread_mutex_t mutex_wakeup;
+	pthread_cond_t cond_wakeup;
+	flag_t sleeping;
+
+	struct {
+		uint32_t added;
+		uint32_t dropped_queue_full;
+		uint32_t dropped_oversized;
+		uint32_t max_decode_queue_depth;
+		uint32_t max_handle_queue_depth;
+		comm_pipeline_latency_t decode_latency; // From capture to decoded.
+		comm_pipeline_latency_t handle_latency; // From decoded to handled.
+	} stats;
+} comm_pipeline_worker_t;
+
+static comm_pipeline_worker_t *comm_pipeline_workers = NULL;
+static uint8_t comm_pipeline_workers_count = 0;
+static flag_t comm_pipeline_running = 0;
+static flag_t comm_pipeline_should_stop = 0;
+
+// Workers wake up the main thread by writing to this eventfd, which is watched by daemon-poll.
+static int comm_pipeline_eventfd = -1;
+static flag_t comm_pipeline_handler_wakeup_pending = 0;
+
+static uint64_t comm_pipeline_now(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static void comm_pipeline_latency_add(comm_pipeline_latency_t *latency, uint64_t from, uint64_t to) {
+	uint64_t diff = (to > from ? to-from : 0);
+
+	latency->count++;
+	latency->sum += diff;
+	if (diff > latency->max)
+		latency->max = diff;
+}
+
+static void comm_pipeline_latency_print(char *name, comm_pipeline_latency_t *latency) {
+	console_log("    %s latency: avg. %llu us, max. %llu us\n", name,
+		(unsigned long long)(latency->count > 0 ? latency->sum/latency->count/1000 : 0), (unsigned long long)(latency->max/1000));
+}
+
+flag_t comm_pipeline_is_running(void) {
+	return __atomic_load_n(&comm_pipeline_running, __ATOMIC_ACQUIRE);
+}
+
+void comm_pipeline_add(uint8_t *packet, uint16_t length) {
+	comm_pipeline_worker_t *worker;
+	comm_pipeline_entry_t *entry;
+	uint32_t src_addr = 0;
+	uint32_t write_pos;
+
+	if (length >= sizeof(struct ip))
+		src_addr = ((struct ip *)packet)->ip_src.s_addr;
+	worker = &comm_pipeline_workers[((src_addr * 2654435761u) >> 16) % comm_pipeline_workers_count];
+
+	if (length > COMM_PIPELINE_MAXPACKETSIZE) {
+		worker->stats.dropped_oversized++;
+		return;
+	}
+
+	write_pos = worker->write_pos;
+	if (write_pos - __atomic_load_n(&worker->handle_pos, __ATOMIC_ACQUIRE) > worker->mask) {
+		worker->stats.dropped_queue_full++;
+		return;
+	}
+
+	entry = &worker->entries[write_pos & worker->mask];
+	entry->captured_at = comm_pipeline_now();
+	entry->length = length;
+	memcpy(entry->packet.bytes, packet, length);
+	__atomic_store_n(&worker->write_pos, write_pos+1, __ATOMIC_SEQ_CST);
+	worker->stats.added++;
+
+	// Holding the mutex while signaling, so the signal can't get lost between the worker's
+	// queue check and its wait.
+	if (__atomic_load_n(&worker->sleeping, __ATOMIC_SEQ_CST)) {
+		pthread_mutex_lock(&worker->mutex_wakeup);
+		pthread_cond_signal(&worker->cond_wakeup);
+		pthread_mutex_unlock(&worker->mutex_wakeup);
+	}
+}
+
+static void comm_pipeline_wakeup_handler(void) {
+	uint64_t value = 1;
+
+	if (__atomic_exchange_n(&comm_pipeline_handler_wakeup_pending, 1, __ATOMIC_SEQ_CST))
+		return;
+
+	if (write(comm_pipeline_eventfd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		console_log("comm pipeline error: can't wake up the main thread: %s\n", strerror(errno));
+}
+
+static void comm_pipeline_worker_wait(comm_pipeline_worker_t *worker) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_nsec += COMM_PIPELINE_WORKER_WAKEUP_IN_MS*1000000L;
+	if (ts.tv_nsec >= 1000000000L) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&worker->mutex_wakeup);
+	__atomic_store_n(&worker->sleeping, 1, __ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&worker->write_pos, __ATOMIC_SEQ_CST) == worker->decode_pos &&
+		!__atomic_load_n(&comm_pipeline_should_stop, __ATOMIC_ACQUIRE)) {
+			pthread_cond_timedwait(&worker->cond_wakeup, &worker->mutex_wakeup, &ts);
+	}
+	__atomic_store_n(&worker->sleeping, 0, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&worker->mutex_wakeup);
+}
+
+static void *comm_pipeline_worker_thread_init(void *arg) {
+	comm_pipeline_worker_t *worker = (comm_pipeline_worker_t *)arg;
+	comm_pipeline_entry_t *entry;
+	uint32_t write_pos;
+	uint32_t decode_pos;
+
+	while (1) {
+		write_pos = __atomic_load_n(&worker->write_pos, __ATOMIC_ACQUIRE);
+		decode_pos = worker->decode_pos;
+		if (decode_pos == write_pos) {
+			if (__atomic_load_n(&comm_pipeline_should_stop, __ATOMIC_ACQUIRE))
+				break;
+			comm_pipeline_worker_wait(worker);
+			continue;
+		}
+
+		if (write_pos-decode_pos > worker->stats.max_decode_queue_depth)
+			worker->stats.max_decode_queue_depth = write_pos-decode_pos;
+
+		for (; decode_pos != write_pos; decode_pos++) {
+			entry = &worker->entries[decode_pos & worker->mask];
+			ipsc_decodepacket(&entry->packet.raw, entry->length, &entry->result);
+			entry->decoded_at = comm_pipeline_now();
+			comm_pipeline_latency_add(&worker->stats.decode_latency, entry->captured_at, entry->decoded_at);
+
+			// Publishing entries one by one, so the main thread can handle them while we decode the rest.
+			__atomic_store_n(&worker->decode_pos, decode_pos+1, __ATOMIC_SEQ_CST);
+		}
+		comm_pipeline_wakeup_handler();
+	}
+
+	pthread_exit((void*) 0);
+}
+
+static void comm_pipeline_eventfd_callback(int fd, short events, short revents, void *arg) {
+	uint64_t value;
+
+	// The queues are processed in comm_pipeline_process(), here we only clear the eventfd.
+	if (read(fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+		console_log("comm pipeline error: can't read eventfd: %s\n", strerror(errno));
+}
+
+// Handles the decoded packets on the main thread.
+void comm_pipeline_process(void) {
+	comm_pipeline_worker_t *worker;
+	comm_pipeline_entry_t *entry;
+	uint32_t decode_pos;
+	uint32_t handle_pos;
+	uint32_t handled;
+	uint8_t i;
+	flag_t more_waiting = 0;
+
+	if (!comm_pipeline_is_running())
+		return;
+
+	// Clearing the flag before checking the queues, so a worker which publishes packets after
+	// this point wakes us up again.
+	__atomic_store_n(&comm_pipeline_handler_wakeup_pending, 0, __ATOMIC_SEQ_CST);
+
+	for (i = 0; i < comm_pipeline_workers_count; i++) {
+		worker = &comm_pipeline_workers[i];
+		decode_pos = __atomic_load_n(&worker->decode_pos, __ATOMIC_SEQ_CST);
+		handle_pos = worker->handle_pos;
+		if (decode_pos-handle_pos > worker->stats.max_handle_queue_depth)
+			worker->stats.max_handle_queue_depth = decode_pos-handle_pos;
+
+		for (handled = 0; handle_pos != decode_pos && handled < COMM_PIPELINE_HANDLE_BATCH_SIZE; handled++, handle_pos++) {
+			entry = &worker->entries[handle_pos & worker->mask];
+			ipsc_handledecodedpacket(&entry->packet.raw, entry->length, &entry->result);
+			comm_pipeline_latency_add(&worker->stats.handle_latency, entry->decoded_at, comm_pipeline_now());
+
+			// Giving the entry back to the capture thread.
+			__atomic_store_n(&worker->handle_pos, handle_pos+1, __ATOMIC_RELEASE);
+		}
+		if (handle_pos != decode_pos)
+			more_waiting = 1;
+	}
+
+	// There are more packets waiting, we handle them in the next main loop pass.
+	if (more_waiting)
+		daemon_poll_setmaxtimeout(0);
+}
+
+void comm_pipeline_print_stats(void) {
+	comm_pipeline_worker_t *worker;
+	uint32_t write_pos;
+	uint32_t decode_pos;
+	uint32_t handle_pos;
+	uint8_t i;
+
+	if (!comm_pipeline_is_running()) {
+		console_log("comm pipeline: not running, packets are processed on the main thread\n");
+		return;
+	}
+
+	console_log("comm pipeline: %u decode workers, queue size: %u\n", comm_pipeline_workers_count, comm_pipeline_workers[0].mask+1);
+	for (i = 0; i < comm_pipeline_workers_count; i++) {
+		worker = &comm_pipeline_workers[i];
+		write_pos = __atomic_load_n(&worker->write_pos, __ATOMIC_RELAXED);
+		decode_pos = __atomic_load_n(&worker->decode_pos, __ATOMIC_RELAXED);
+		handle_pos = __atomic_load_n(&worker->handle_pos, __ATOMIC_RELAXED);
+
+		console_log("  worker #%u: packets: %u dropped: %u (queue full) %u (oversized)\n", i,
+			worker->stats.added, worker->stats.dropped_queue_full, worker->stats.dropped_oversized);
+		console_log("    decode queue: %u (max. %u) handle queue: %u (max. %u)\n",
+			write_pos-decode_pos, worker->stats.max_decode_queue_depth, decode_pos-handle_pos, worker->stats.max_handle_queue_depth);
+		comm_pipeline_latency_print("decode", &worker->stats.decode_latency);
+		comm_pipeline_latency_print("handle", &worker->stats.handle_latency);
+	}
+}
+
+// Starts the decode workers if they are enabled in the config. Returns 1 if the pipeline is running.
+flag_t comm_pipeline_init(void) {
+	pthread_attr_t attr;
+	comm_pipeline_worker_t *worker;
+	int workers_count;
+	int queuesize;
+	uint32_t ringsize = COMM_PIPELINE_MINQUEUESIZE;
+	uint8_t i;
+
+	workers_count = config_get_pipelinedecodeworkers();
+	if (workers_count <= 0) {
+		console_log("comm pipeline: disabled, packets are processed on the main thread\n");
+		return 0;
+	}
+	if (workers_count > COMM_PIPELINE_MAXWORKERS)
+		workers_count = COMM_PIPELINE_MAXWORKERS;
+
+	queuesize = config_get_pipelinequeuesize();
+	while (ringsize < (uint32_t)queuesize && ringsize < COMM_PIPELINE_MAXQUEUESIZE)
+		ringsize <<= 1;
+
+	comm_pipeline_workers = (comm_pipeline_worker_t *)calloc(workers_count, sizeof(comm_pipeline_worker_t));
+	if (comm_pipeline_workers == NULL) {
+		console_log("comm pipeline error: can't allocate memory for the workers\n");
+		return 0;
+	}
+	comm_pipeline_workers_count = workers_count;
+
+	for (i = 0; i < comm_pipeline_workers_count; i++) {
+		worker = &comm_pipeline_workers[i];
+		worker->index = i;
+		worker->mask = ringsize-1;
+		worker->entries = (comm_pipeline_entry_t *)calloc(ringsize, sizeof(comm_pipeline_entry_t));
+		if (worker->entries == NULL) {
+			console_log("comm pipeline error: can't allocate memory for the queue of worker #%u\n", i);
+			comm_pipeline_deinit();
+			return 0;
+		}
+		pthread_mutex_init(&worker->mutex_wakeup, NULL);
+		pthread_cond_init(&worker->cond_wakeup, NULL);
+	}
+
+	comm_pipeline_eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (comm_pipeline_eventfd < 0) {
+		console_log("comm pipeline error: can't create eventfd: %s\n", strerror(errno));
+		comm_pipeline_deinit();
+		return 0;
+	}
+	daemon_poll_addfd_callback(comm_pipeline_eventfd, POLLIN, comm_pipeline_eventfd_callback, NULL);
+
+	comm_pipeline_should_stop = 0;
+	comm_pipeline_handler_wakeup_pending = 0;
+
+	// Explicitly creating the threads as joinable to be compatible with other systems.
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	for (i = 0; i < comm_pipeline_workers_count; i++) {
+		worker = &comm_pipeline_workers[i];
+		if (pthread_create(&worker->thread, &attr, comm_pipeline_worker_thread_init, worker) != 0) {
+			console_log("comm pipeline error: can't start worker #%u\n", i);
+			pthread_attr_destroy(&attr);
+			comm_pipeline_deinit();
+			return 0;
+		}
+		worker->thread_started = 1;
+	}
+	pthread_attr_destroy(&attr);
+
+	__atomic_store_n(&comm_pipeline_running, 1, __ATOMIC_RELEASE);
+	console_log("comm pipeline: started %u decode workers, queue size: %u\n", comm_pipeline_workers_count, ringsize);
+	return 1;
+}
+
+// The capture thread has to be stopped before calling this. Packets still in the queues are dropped.
+void comm_pipeline_deinit(void) {
+	comm_pipeline_worker_t *worker;
+	void *status = NULL;
+	uint8_t i;
+
+	__atomic_store_n(&comm_pipeline_running, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&comm_pipeline_should_stop, 1, __ATOMIC_RELEASE);
+
+	for (i = 0; comm_pipeline_workers != NULL && i < comm_pipeline_workers_count; i++) {
+		worker = &comm_pipeline_workers[i];
+		if (worker->thread_started) {
+			pthread_mutex_lock(&worker->mutex_wakeup);
+			pthread_cond_signal(&worker->cond_wakeup);
+			pthread_mutex_unlock(&worker->mutex_wakeup);
+			pthread_join(worker->thread, &status);
+		}
+		if (worker->entries != NULL) {
+			pthread_mutex_destroy(&worker->mutex_wakeup);
+			pthread_cond_destroy(&worker->cond_wakeup);
+			free(worker->entries);
+		}
+	}
+	free(comm_pipeline_workers);
+	comm_pipeline_workers = NULL;
+	comm_pipeline_workers_count = 0;
+
+	if (comm_pipeline_eventfd >= 0) {
+		daemon_poll_removefd(comm_pipeline_eventfd);
+		close(comm_pipeline_eventfd);
+		comm_pipeline_eventfd = -1;
+	}
+}
@@ -0,0 +1,38 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef COMM_PIPELINE_H_
+#define COMM_PIPELINE_H_
+
+#include <libs/base/types.h>
+
+// Captured packets bigger than this are dropped by the pipeline. IPSC packets and heartbeats are much smaller.
+#define COMM_PIPELINE_MAXPACKETSIZE			512
+#define COMM_PIPELINE_MAXWORKERS			16
+// Max. number of packets handled from one worker's queue in one main loop pass.
+#define COMM_PIPELINE_HANDLE_BATCH_SIZE		256
+
+flag_t comm_pipeline_is_running(void);
+// Called by the capture thread for every captured packet.
+void comm_pipeline_add(uint8_t *packet, uint16_t length);
+void comm_pipeline_print_stats(void);
+
+void comm_pipeline_process(void);
+flag_t comm_pipeline_init(void);
+void comm_pipeline_deinit(void);
+
+#endif
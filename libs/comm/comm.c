@@ -22,10 +22,17 @@
 #include "snmp.h"
 #include "repeaters.h"
 #include "httpserver.h"
+#include "comm-mmap.h"
+#include "comm-localaddrs.h"
+#include "comm-hostset.h"
+#include "comm-pipeline.h"
+#include "ipscpacket.h"
 
+#include <libs/base/base.h>
 #include <libs/daemon/console.h>
 #include <libs/daemon/daemon-poll.h>
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 
 #include <pcap/pcap.h>
 #include <stdlib.h>
@@ -35,9 +42,40 @@
 #include <netdb.h>
 #include <ifaddrs.h>
 #include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
 
 static pcap_t *comm_pcap_handle = NULL;
 static pcap_t *comm_pcap_file_handle = NULL;
+static int comm_pcap_max_batch_size = 0; // Changed by comm_reload(), accessed atomically.
+// The capture filter is updated by the capture thread if it's running, and printed by the main thread.
+static pthread_mutex_t comm_capture_filter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char comm_capture_filter_str[COMM_CAPTURE_FILTER_MAX_LENGTH];
+static struct bpf_program comm_capture_filter = {0,};
+
+// If the comm pipeline is running, live capture runs on this thread.
+static pthread_t comm_capture_thread;
+static flag_t comm_capture_thread_running = 0;
+static flag_t comm_capture_thread_should_stop = 0;
+static flag_t comm_capture_filter_update_requested = 0;
+
+// The capture handle is only used by the thread which does the capturing (the capture thread if it's
+// running, the main thread otherwise), and that thread updates these stats. Other threads read them
+// with the mutex locked.
+typedef struct {
+	uint32_t packets_processed;
+	uint32_t batches;
+	uint32_t full_batches;
+	uint32_t max_batch_size_seen;
+	uint32_t last_received;
+	uint32_t last_dropped;
+	uint32_t last_ifdropped;
+	flag_t stats_valid; // 1 if the last_ counters have been read from the capture backend.
+	time_t last_checked_at;
+} comm_capture_stats_t;
+static pthread_mutex_t comm_capture_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static comm_capture_stats_t comm_capture_stats;
 
 struct __attribute__((packed)) linux_sll {
 	// Packet_* describing packet origins:
@@ -54,16 +92,11 @@ struct __attribute__((packed)) linux_sll {
 };
 
 flag_t comm_is_masteripaddr(struct in_addr *ip) {
-	struct in_addr *masterip;
-	flag_t result = 0;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	masterip = config_get_masteripaddr();
-	if (masterip == NULL)
+	if (config_snapshot == NULL || !config_snapshot->masteripaddr_valid)
 		return 0;
-	if (memcmp(masterip, ip, sizeof(struct in_addr)) == 0)
-		result = 1;
-	free(masterip);
-	return result;
+	return (config_snapshot->masteripaddr.s_addr == ip->s_addr);
 }
 
 flag_t comm_hostname_to_ip(char *hostname, struct in_addr *ipaddr) {
@@ -127,27 +160,7 @@ char *comm_get_our_ipaddr(void) {
 }
 
 flag_t comm_is_our_ipaddr(struct in_addr *ipaddr) {
-	struct ifaddrs *ifaddr = NULL;
-	struct ifaddrs *ifa = NULL;
-	struct sockaddr_in *addr = NULL;
-	int i;
-
-	if (ipaddr == NULL)
-		return 0;
-
-	getifaddrs(&ifaddr);
-	for (ifa = ifaddr, i = 0; ifa != NULL; ifa = ifa->ifa_next, i++) {
-		if (ifa->ifa_addr == NULL)
-			continue;
-
-		addr = (struct sockaddr_in *)ifa->ifa_addr;
-		if (memcmp(ipaddr, &addr->sin_addr, sizeof(struct in_addr)) == 0) {
-			freeifaddrs(ifaddr);
-			return 1;
-		}
-	}
-	freeifaddrs(ifaddr);
-	return 0;
+	return comm_localaddrs_contains(ipaddr);
 }
 
 // http://www.binarytides.com/raw-udp-sockets-c-linux/
@@ -236,7 +249,7 @@ void comm_pcapfile_open(char *filename) {
 		return;
 	}
 
-	pcap_dev = pcap_get_selectable_fd(comm_pcap_handle);
+	pcap_dev = pcap_get_selectable_fd(comm_pcap_file_handle);
 	if (pcap_dev == -1)
 		console_log("comm warning: can't add pcap file handle to the poll list\n");
 	else
@@ -269,50 +282,188 @@ static uint8_t *comm_get_ip_packet_from_pcap_packet(uint8_t *packet, pcap_t *pca
 	return packet;
 }
 
-static void comm_log_packet(uint8_t *packet, uint16_t length) {
-	int i;
-	loglevel_t loglevel = console_get_loglevel();
+void comm_log_packet(uint8_t *packet, uint16_t length) {
+	char hexstr[CONSOLE_INPUTBUFFERSIZE];
 
-	if (loglevel.flags.debug && loglevel.flags.comm_ip) {
-		console_log(LOGLEVEL_COMM_IP "comm ip packet: ");
-		for (i = 0; i < length; i++)
-			console_log(LOGLEVEL_COMM_IP "%.2x ", packet[i]);
-		console_log(LOGLEVEL_COMM_IP "\n");
-	}
+	if (!console_isloglevelenabled(LOGLEVEL_COMM_IP LOGLEVEL_DEBUG))
+		return;
+
+	// The whole packet is logged in one call, the hex dump is truncated to fit into the log line.
+	console_log(LOGLEVEL_COMM_IP "comm ip packet: %s\n", base_datatohexstr(packet, length, ' ', hexstr, sizeof(hexstr)-32));
 }
 
-void comm_process(void) {
+// Passes a live captured packet to the comm pipeline, or processes it if the pipeline is not running.
+void comm_process_captured_packet(uint8_t *packet, uint16_t length) {
+	comm_log_packet(packet, length);
+	if (comm_pipeline_is_running())
+		comm_pipeline_add(packet, length);
+	else
+		ipsc_processpacket((ipscpacket_raw_t *)packet, length);
+}
+
+static void comm_pcap_packet_handler(u_char *user, const struct pcap_pkthdr *pkthdr, const u_char *bytes) {
+	pcap_t *pcap_handle = (pcap_t *)user;
 	uint8_t *packet = NULL;
-	struct pcap_pkthdr pkthdr;
 	uint16_t ip_packet_length = 0;
+
+	console_log(LOGLEVEL_COMM_IP "comm got packet: %u bytes\n", pkthdr->len);
+	ip_packet_length = pkthdr->caplen;
+	packet = comm_get_ip_packet_from_pcap_packet((uint8_t *)bytes, pcap_handle, &ip_packet_length);
+	if (packet == NULL)
+		return;
+
+	// Packets read from a pcap file are processed on the main thread.
+	if (pcap_handle == comm_pcap_file_handle) {
+		comm_log_packet(packet, ip_packet_length);
+		ipsc_processpacket((ipscpacket_raw_t *)packet, ip_packet_length);
+	} else
+		comm_process_captured_packet(packet, ip_packet_length);
+}
+
+static int comm_get_max_batch_size(void) {
+	return __atomic_load_n(&comm_pcap_max_batch_size, __ATOMIC_RELAXED);
+}
+
+static void comm_update_batch_stats(int processed) {
+	int max_batch_size = comm_get_max_batch_size();
+	flag_t full_batch;
+
+	if (processed <= 0)
+		return;
+
+	full_batch = (max_batch_size > 0 && processed >= max_batch_size);
+
+	pthread_mutex_lock(&comm_capture_stats_mutex);
+	comm_capture_stats.packets_processed += processed;
+	comm_capture_stats.batches++;
+	if (processed > comm_capture_stats.max_batch_size_seen)
+		comm_capture_stats.max_batch_size_seen = processed;
+	if (full_batch)
+		comm_capture_stats.full_batches++;
+	pthread_mutex_unlock(&comm_capture_stats_mutex);
+
+	// There may be more packets waiting, we process them in the next main loop pass.
+	// The capture thread doesn't use daemon-poll, it checks the capture device again right away.
+	if (full_batch && !comm_capture_thread_running)
+		daemon_poll_setmaxtimeout(0);
+}
+
+// Processes max. comm_pcap_max_batch_size packets waiting in the capture buffer of the given handle.
+// Returns the number of processed packets, 0 if there were no packets, or -1 on error.
+static int comm_pcap_dispatch(pcap_t *pcap_handle) {
+	int processed;
+
+	processed = pcap_dispatch(pcap_handle, comm_get_max_batch_size(), comm_pcap_packet_handler, (u_char *)pcap_handle);
+	if (processed < 0) {
+		if (processed == -1)
+			console_log("comm error: packet capture error: %s\n", pcap_geterr(pcap_handle));
+		return -1;
+	}
+	comm_update_batch_stats(processed);
+	return processed;
+}
+
+// Gets the counters of the active capture backend. For the mmap backend, ifdropped is the number
+// of times the ring got full.
+static flag_t comm_get_capture_stats(uint32_t *received, uint32_t *dropped, uint32_t *ifdropped) {
+	struct pcap_stat ps;
+
+	if (comm_mmap_is_active())
+		return comm_mmap_get_stats(received, dropped, ifdropped);
+
+	if (comm_pcap_handle == NULL || pcap_stats(comm_pcap_handle, &ps) < 0)
+		return 0;
+
+	*received = ps.ps_recv;
+	*dropped = ps.ps_drop;
+	*ifdropped = ps.ps_ifdrop;
+	return 1;
+}
+
+// Reads the counters of the capture backend, and stores them to the capture stats. Only call this
+// from the thread which does the capturing.
+static void comm_check_capture_stats(flag_t force) {
+	uint32_t received;
+	uint32_t dropped;
+	uint32_t ifdropped;
+	uint32_t last_dropped;
+	uint32_t last_ifdropped;
+	time_t now = time(NULL);
+
+	pthread_mutex_lock(&comm_capture_stats_mutex);
+	if (!force && now-comm_capture_stats.last_checked_at < COMM_PCAP_STATS_CHECK_INTERVAL_IN_SEC) {
+		pthread_mutex_unlock(&comm_capture_stats_mutex);
+		return;
+	}
+	comm_capture_stats.last_checked_at = now;
+	pthread_mutex_unlock(&comm_capture_stats_mutex);
+
+	if (!comm_get_capture_stats(&received, &dropped, &ifdropped))
+		return;
+
+	pthread_mutex_lock(&comm_capture_stats_mutex);
+	last_dropped = comm_capture_stats.last_dropped;
+	last_ifdropped = comm_capture_stats.last_ifdropped;
+	comm_capture_stats.last_received = received;
+	comm_capture_stats.last_dropped = dropped;
+	comm_capture_stats.last_ifdropped = ifdropped;
+	comm_capture_stats.stats_valid = 1;
+	pthread_mutex_unlock(&comm_capture_stats_mutex);
+
+	if (dropped != last_dropped || ifdropped != last_ifdropped) {
+		console_log("comm warning: packet capture dropped %u packets, %s %u since last check\n",
+			dropped-last_dropped, comm_mmap_is_active() ? "ring full" : "interface dropped", ifdropped-last_ifdropped);
+	}
+}
+
+void comm_print_stats(void) {
+	comm_capture_stats_t stats;
+
+	// If the capture thread is running, it owns the capture handle, so we print the counters it got
+	// at its last stats check.
+	if (!comm_capture_thread_running)
+		comm_check_capture_stats(1);
+
+	pthread_mutex_lock(&comm_capture_stats_mutex);
+	memcpy(&stats, &comm_capture_stats, sizeof(comm_capture_stats_t));
+	pthread_mutex_unlock(&comm_capture_stats_mutex);
+
+	comm_localaddrs_print();
+	comm_hostset_print();
+	console_log("comm stats:\n");
+	console_log("  capture backend: %s\n", comm_mmap_is_active() ? "mmap" : "pcap");
+	console_log("  max. batch size: %d\n", comm_get_max_batch_size());
+	console_log("  packets processed: %u in %u batches (%u full batches, max. %u packets in a batch)\n",
+		stats.packets_processed, stats.batches, stats.full_batches, stats.max_batch_size_seen);
+
+	if (!stats.stats_valid)
+		console_log("  can't get capture stats\n");
+	else {
+		console_log("  captured: %u dropped: %u %s: %u (%lu seconds ago)\n", stats.last_received, stats.last_dropped,
+			comm_mmap_is_active() ? "ring full" : "interface dropped", stats.last_ifdropped, (unsigned long)(time(NULL)-stats.last_checked_at));
+	}
+	comm_pipeline_print_stats();
+}
+
+void comm_process(void) {
 	int pcap_dev = -1;
 
 	snmp_process();
-
-	if (comm_pcap_handle != NULL) {
-		packet = (uint8_t *)pcap_next(comm_pcap_handle, &pkthdr);
-		if (packet != NULL) {
-			console_log(LOGLEVEL_COMM_IP "comm got packet: %u bytes\n", pkthdr.len);
-			ip_packet_length = pkthdr.len;
-			packet = comm_get_ip_packet_from_pcap_packet(packet, comm_pcap_handle, &ip_packet_length);
-			if (packet) {
-				comm_log_packet(packet, ip_packet_length);
-				ipsc_processpacket((ipscpacket_raw_t *)packet, ip_packet_length);
-			}
-		}
+	comm_localaddrs_process();
+	comm_hostset_process();
+
+	if (comm_capture_thread_running)
+		comm_pipeline_process();
+	else if (comm_mmap_is_active()) {
+		comm_update_batch_stats(comm_mmap_process(comm_get_max_batch_size()));
+		comm_check_capture_stats(0);
+	} else if (comm_pcap_handle != NULL) {
+		comm_pcap_dispatch(comm_pcap_handle);
+		comm_check_capture_stats(0);
 	}
 
 	if (comm_pcap_file_handle != NULL) {
-		packet = (uint8_t *)pcap_next(comm_pcap_file_handle, &pkthdr);
-		if (packet != NULL) {
-			console_log(LOGLEVEL_COMM_IP "comm got packet: %u bytes\n", pkthdr.len);
-			ip_packet_length = pkthdr.len;
-			packet = comm_get_ip_packet_from_pcap_packet(packet, comm_pcap_file_handle, &ip_packet_length);
-			if (packet) {
-				comm_log_packet(packet, ip_packet_length);
-				ipsc_processpacket((ipscpacket_raw_t *)packet, ip_packet_length);
-			}
-		} else {
+		if (comm_pcap_dispatch(comm_pcap_file_handle) <= 0) {
 			console_log("comm: finished processing pcap file.\n");
 			pcap_dev = pcap_get_selectable_fd(comm_pcap_file_handle);
 			if (pcap_dev > -1)
@@ -330,27 +481,131 @@ void comm_process(void) {
 	httpserver_process();
 }
 
-flag_t comm_init(void) {
-	char *netdevname = NULL;
+static flag_t comm_capture_filter_append(char *str) {
+	if (strlen(comm_capture_filter_str)+strlen(str) >= sizeof(comm_capture_filter_str)) {
+		console_log("comm error: capture filter is too long\n");
+		return 0;
+	}
+	strcat(comm_capture_filter_str, str);
+	return 1;
+}
+
+// Generates the capture filter from the config. Only IPSC packets and heartbeats are let through
+// if capturefilteripsconly is set, optionally limited to the given UDP ports and hosts/subnets.
+static flag_t comm_generate_capture_filter(void) {
+	char *ports;
+	char *hosts;
+	char *tok;
+	char *endptr;
+	char expr[100];
+	long port;
+	flag_t result = 1;
+	flag_t first;
+	uint8_t heartbeat_magic[] = IPSC_HEARTBEAT_MAGIC;
+
+	snprintf(comm_capture_filter_str, sizeof(comm_capture_filter_str), COMM_CAPTURE_FILTER_BASE);
+
+	if (config_get_capturefilteripsconly()) {
+		// The UDP length field contains the length of the UDP header too.
+		snprintf(expr, sizeof(expr), " and (udp[4:2] = %u or udp[4:2] = %u or udp[%u:4] = 0x%.2x%.2x%.2x%.2x)",
+			IPSC_PACKET_SIZE1+8, IPSC_PACKET_SIZE2+8, 8+IPSC_HEARTBEAT_MAGIC_OFFSET,
+			heartbeat_magic[0], heartbeat_magic[1], heartbeat_magic[2], heartbeat_magic[3]);
+		result &= comm_capture_filter_append(expr);
+	}
+
+	ports = config_get_capturefilterports();
+	first = 1;
+	tok = strtok(ports, ",");
+	while (tok && result) {
+		port = strtol(tok, &endptr, 10);
+		if (*endptr != 0 || port <= 0 || port > 65535)
+			console_log("comm warning: invalid capture filter port %s\n", tok);
+		else {
+			snprintf(expr, sizeof(expr), "%sudp port %ld", first ? " and (" : " or ", port);
+			result &= comm_capture_filter_append(expr);
+			first = 0;
+		}
+		tok = strtok(NULL, ",");
+	}
+	if (!first)
+		result &= comm_capture_filter_append(")");
+	free(ports);
+
+	hosts = config_get_capturefilterhosts();
+	first = 1;
+	tok = strtok(hosts, ",");
+	while (tok && result) {
+		// Entries with a netmask are subnets, others are host names or IP addresses.
+		snprintf(expr, sizeof(expr), "%s%s %s", first ? " and (" : " or ", strchr(tok, '/') ? "net" : "host", tok);
+		result &= comm_capture_filter_append(expr);
+		first = 0;
+		tok = strtok(NULL, ",");
+	}
+	if (!first)
+		result &= comm_capture_filter_append(")");
+	free(hosts);
+
+	return result;
+}
+
+// Compiles the capture filter for the given handle to comm_capture_filter. If the generated filter
+// can't be used, falls back to the base filter.
+static flag_t comm_compile_capture_filter(pcap_t *pcap_handle) {
+	if (comm_capture_filter.bf_insns != NULL)
+		pcap_freecode(&comm_capture_filter);
+
+	if (comm_generate_capture_filter()) {
+		if (pcap_compile(pcap_handle, &comm_capture_filter, comm_capture_filter_str, 1, PCAP_NETMASK_UNKNOWN) == 0) {
+			console_log("comm: capture filter: %s\n", comm_capture_filter_str);
+			return 1;
+		}
+		console_log("comm error: can't compile capture filter \"%s\": %s\n", comm_capture_filter_str, pcap_geterr(pcap_handle));
+	}
+
+	snprintf(comm_capture_filter_str, sizeof(comm_capture_filter_str), COMM_CAPTURE_FILTER_BASE);
+	console_log("comm: falling back to capture filter: %s\n", comm_capture_filter_str);
+	if (pcap_compile(pcap_handle, &comm_capture_filter, comm_capture_filter_str, 1, PCAP_NETMASK_UNKNOWN) < 0) {
+		console_log("comm error: can't compile capture filter \"%s\": %s\n", comm_capture_filter_str, pcap_geterr(pcap_handle));
+		return 0;
+	}
+	return 1;
+}
+
+void comm_print_capture_filter(void) {
+	u_int i;
+
+	pthread_mutex_lock(&comm_capture_filter_mutex);
+	if (comm_capture_filter.bf_insns == NULL) {
+		pthread_mutex_unlock(&comm_capture_filter_mutex);
+		console_log("comm: no capture filter set\n");
+		return;
+	}
+
+	console_log("comm: capture filter: %s\n", comm_capture_filter_str);
+	console_log("  compiled to %u instructions:\n", comm_capture_filter.bf_len);
+	for (i = 0; i < comm_capture_filter.bf_len; i++)
+		console_log("  %s\n", bpf_image(&comm_capture_filter.bf_insns[i], i));
+	pthread_mutex_unlock(&comm_capture_filter_mutex);
+}
+
+static flag_t comm_pcap_init(char *netdevname) {
 	char pcap_errbuf[PCAP_ERRBUF_SIZE] = {0,};
-	struct bpf_program pcap_filter = {0,};
 	int pcap_dev = -1;
-	char *pcap_filter_str = "ip and udp";
 	int *datalinks = NULL;
 	int i;
 
-	netdevname = config_get_netdevicename();
-
 	console_log("comm: opening capture device %s, capture buffer size: %u\n", netdevname, BUFSIZ);
 
 	comm_pcap_handle = pcap_open_live(netdevname, BUFSIZ, 1, -1, pcap_errbuf);
 	if (comm_pcap_handle == NULL) {
 		console_log("comm error: couldn't open device %s: %s\n" , netdevname, pcap_errbuf);
-		free(netdevname);
 		return 0;
 	}
-	console_log("comm: dev %s ip addr is %s\n", netdevname, comm_get_our_ipaddr());
-	free(netdevname);
+
+	// We are only reading the capture buffer when poll() signals that it's readable, but dispatching
+	// should not block if a batch drains the buffer.
+	if (pcap_setnonblock(comm_pcap_handle, 1, pcap_errbuf) < 0)
+		console_log("comm warning: can't set capture to non-blocking mode: %s\n", pcap_errbuf);
 
 	i = pcap_list_datalinks(comm_pcap_handle, &datalinks);
 	if (i > 0) {
@@ -360,13 +615,13 @@ flag_t comm_init(void) {
 	pcap_free_datalinks(datalinks);
 	datalinks = NULL;
 
-	if (pcap_compile(comm_pcap_handle, &pcap_filter, pcap_filter_str, 1, PCAP_NETMASK_UNKNOWN) < 0) {
-		console_log("comm error: can't init packet capture: %s\n", pcap_geterr(comm_pcap_handle));
+	if (!comm_compile_capture_filter(comm_pcap_handle)) {
+		console_log("comm error: can't init packet capture\n");
 		return 0;
 	}
 
-	if (pcap_setfilter(comm_pcap_handle, &pcap_filter) < 0)
-		console_log("comm warning: can't set filter to \"%s\"\n", pcap_filter_str);
+	if (pcap_setfilter(comm_pcap_handle, &comm_capture_filter) < 0)
+		console_log("comm warning: can't set filter to \"%s\"\n", comm_capture_filter_str);
 
 	pcap_dev = pcap_get_selectable_fd(comm_pcap_handle);
 	if (pcap_dev == -1)
@@ -374,9 +629,181 @@ flag_t comm_init(void) {
 	else
 		daemon_poll_addfd_read(pcap_dev);
 
+	return 1;
+}
+
+// Compiles the capture filter and attaches it to the mmap capture socket.
+static flag_t comm_mmap_init_filter(void) {
+	pcap_t *pcap_dead_handle;
+	flag_t result;
+
+	// The mmap capture socket gives us packets starting with the IP header.
+	pcap_dead_handle = pcap_open_dead(DLT_RAW, COMM_MMAP_FRAME_SIZE);
+	if (pcap_dead_handle == NULL) {
+		console_log("comm error: can't init capture filter\n");
+		return 0;
+	}
+
+	result = comm_compile_capture_filter(pcap_dead_handle);
+	pcap_close(pcap_dead_handle);
+	if (!result)
+		return 0;
+
+	return comm_mmap_setfilter(comm_capture_filter.bf_insns, comm_capture_filter.bf_len);
+}
+
+// Only call this from the thread which does the capturing.
+static void comm_update_capture_filter(void) {
+	pthread_mutex_lock(&comm_capture_filter_mutex);
+	if (comm_mmap_is_active()) {
+		if (!comm_mmap_init_filter())
+			console_log("comm warning: can't set filter to \"%s\"\n", comm_capture_filter_str);
+	} else if (comm_pcap_handle != NULL && comm_compile_capture_filter(comm_pcap_handle)) {
+		if (pcap_setfilter(comm_pcap_handle, &comm_capture_filter) < 0)
+			console_log("comm warning: can't set filter to \"%s\"\n", comm_capture_filter_str);
+	}
+	pthread_mutex_unlock(&comm_capture_filter_mutex);
+}
+
+// Applies changed capture settings to the running capture. The new filter replaces the old one
+// on the capture socket in one step, so capturing is not stopped meanwhile.
+void comm_reload(void) {
+	int max_batch_size = config_get_pcapmaxbatchsize();
+
+	__atomic_store_n(&comm_pcap_max_batch_size, (max_batch_size < 0 ? 0 : max_batch_size), __ATOMIC_RELAXED);
+
+	// The capture handle is only used by the capture thread while it's running.
+	if (comm_capture_thread_running)
+		__atomic_store_n(&comm_capture_filter_update_requested, 1, __ATOMIC_RELEASE);
+	else
+		comm_update_capture_filter();
+}
+
+static int comm_get_capture_fd(void) {
+	if (comm_mmap_is_active())
+		return comm_mmap_get_fd();
+	if (comm_pcap_handle != NULL)
+		return pcap_get_selectable_fd(comm_pcap_handle);
+	return -1;
+}
+
+static void *comm_capture_thread_init(void *arg) {
+	struct pollfd pfd;
+
+	pfd.fd = comm_get_capture_fd();
+	pfd.events = POLLIN;
+
+	while (!__atomic_load_n(&comm_capture_thread_should_stop, __ATOMIC_ACQUIRE)) {
+		if (__atomic_exchange_n(&comm_capture_filter_update_requested, 0, __ATOMIC_ACQ_REL))
+			comm_update_capture_filter();
+
+		// Waking up periodically to check the stop flag.
+		pfd.revents = 0;
+		if (poll(&pfd, 1, COMM_CAPTURE_THREAD_POLL_TIMEOUT_IN_MS) > 0) {
+			if (comm_mmap_is_active())
+				comm_update_batch_stats(comm_mmap_process(comm_get_max_batch_size()));
+			else
+				comm_pcap_dispatch(comm_pcap_handle);
+		}
+
+		comm_check_capture_stats(0);
+	}
+
+	pthread_exit((void*) 0);
+}
+
+// Moves live capture to its own thread if the comm pipeline has been started.
+static void comm_capture_thread_start(void) {
+	pthread_attr_t attr;
+	int capture_fd;
+
+	if (!comm_pipeline_init())
+		return;
+
+	capture_fd = comm_get_capture_fd();
+	if (capture_fd < 0) {
+		console_log("comm error: can't get the capture fd, not using the pipeline\n");
+		comm_pipeline_deinit();
+		return;
+	}
+
+	// The main thread doesn't need to wake up for captured packets anymore.
+	daemon_poll_removefd(capture_fd);
+	comm_capture_thread_should_stop = 0;
+	comm_capture_filter_update_requested = 0;
+	comm_capture_thread_running = 1;
+
+	// Explicitly creating the thread as joinable to be compatible with other systems.
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	if (pthread_create(&comm_capture_thread, &attr, comm_capture_thread_init, NULL) != 0) {
+		console_log("comm error: can't start capture thread, not using the pipeline\n");
+		comm_capture_thread_running = 0;
+		comm_pipeline_deinit();
+		daemon_poll_addfd_read(capture_fd);
+	} else
+		console_log("comm: capture thread started\n");
+	pthread_attr_destroy(&attr);
+}
+
+static void comm_capture_thread_stop(void) {
+	void *status = NULL;
+
+	if (!comm_capture_thread_running)
+		return;
+
+	console_log("comm: waiting for capture thread to exit\n");
+	__atomic_store_n(&comm_capture_thread_should_stop, 1, __ATOMIC_RELEASE);
+	pthread_join(comm_capture_thread, &status);
+	comm_capture_thread_running = 0;
+	comm_pipeline_deinit();
+}
+
+flag_t comm_init(void) {
+	char *netdevname = NULL;
+	char *capturebackend = NULL;
+	flag_t result;
+
+	comm_pcap_max_batch_size = config_get_pcapmaxbatchsize();
+	if (comm_pcap_max_batch_size < 0)
+		comm_pcap_max_batch_size = 0;
+	console_log("comm: max. packet batch size: %d\n", comm_pcap_max_batch_size);
+	memset(&comm_capture_stats, 0, sizeof(comm_capture_stats));
+
+	comm_localaddrs_init();
+
+	netdevname = config_get_netdevicename();
+	capturebackend = config_get_capturebackend();
+
+	if (strcmp(capturebackend, "mmap") == 0) {
+		result = comm_mmap_init(netdevname);
+		if (result) {
+			// The filter is attached before capturing starts, so no unfiltered packets get to the ring.
+			if (!comm_mmap_init_filter())
+				console_log("comm warning: can't set filter to \"%s\"\n", comm_capture_filter_str);
+			result = comm_mmap_start();
+		}
+	} else {
+		if (strcmp(capturebackend, "pcap") != 0)
+			console_log("comm warning: unknown capture backend %s, using pcap\n", capturebackend);
+		result = comm_pcap_init(netdevname);
+	}
+	free(capturebackend);
+
+	if (!result) {
+		free(netdevname);
+		return 0;
+	}
+	console_log("comm: dev %s ip addr is %s\n", netdevname, comm_get_our_ipaddr());
+	free(netdevname);
+
 	snmp_init();
 	httpserver_init();
+	repeaters_init();
 	ipsc_init();
+	// Host sets are registered by the inits above.
+	comm_hostset_init();
+	comm_capture_thread_start();
 
 	return 1;
 }
@@ -384,6 +811,10 @@ flag_t comm_init(void) {
 void comm_deinit(void) {
 	int pcap_dev = -1;
 
+	comm_capture_thread_stop();
+	comm_mmap_deinit();
+	comm_localaddrs_deinit();
+
 	if (comm_pcap_handle != NULL) {
 		pcap_dev = pcap_get_selectable_fd(comm_pcap_handle);
 		if (pcap_dev > -1)
@@ -400,7 +831,12 @@ void comm_deinit(void) {
 		comm_pcap_file_handle = NULL;
 	}
 
+	if (comm_capture_filter.bf_insns != NULL)
+		pcap_freecode(&comm_capture_filter);
+
 	httpserver_deinit();
 	snmp_deinit();
 	repeaters_deinit();
+	ipsc_deinit();
+	comm_hostset_deinit();
 }
@@ -23,6 +23,10 @@
 #include <netinet/ip.h>
 #include <netinet/udp.h>
 
+#define COMM_CAPTURE_FILTER_BASE			"ip and udp"
+#define COMM_CAPTURE_FILTER_MAX_LENGTH		4096
+#define COMM_CAPTURE_THREAD_POLL_TIMEOUT_IN_MS	100
+
 flag_t comm_is_masteripaddr(struct in_addr *ip);
 flag_t comm_hostname_to_ip(char *hostname, struct in_addr *ipaddr);
 char *comm_get_ip_str(struct in_addr *ipaddr);
@@ -31,9 +35,15 @@ flag_t comm_is_our_ipaddr(struct in_addr *ipaddr);
 uint16_t comm_calcipheaderchecksum(struct ip *ipheader);
 uint16_t comm_calcudpchecksum(struct ip *ipheader, struct udphdr *udpheader);
 
+void comm_log_packet(uint8_t *packet, uint16_t length);
+void comm_process_captured_packet(uint8_t *packet, uint16_t length);
+
 void comm_pcapfile_open(char *filename);
+void comm_print_stats(void);
+void comm_print_capture_filter(void);
 
 void comm_process(void);
+void comm_reload(void);
 flag_t comm_init(void);
 void comm_deinit(void);
 
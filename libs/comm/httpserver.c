@@ -20,6 +20,7 @@
 #include "httpserver.h"
 
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/daemon/console.h>
 #include <libs/daemon/daemon-poll.h>
 #include <libs/voicestreams/voicestreams-mp3.h>
@@ -109,6 +110,19 @@ static uint16_t httpserver_calc_datatosendsize(struct lws *wsi, httpserver_clien
 	return datatosendsize;
 }
 
+// Called by daemon-poll for the libwebsockets fds which have events.
+static void httpserver_poll_callback(int fd, short events, short revents, void *arg) {
+	struct pollfd pfd;
+
+	if (httpserver_lws_context == NULL)
+		return;
+
+	pfd.fd = fd;
+	pfd.events = events; // libwebsockets only services the events which are also in the watched events.
+	pfd.revents = revents;
+	lws_service_fd(httpserver_lws_context, &pfd);
+}
+
 static int httpserver_http_callback(struct lws_context *context, struct lws *wsi,
 	enum lws_callback_reasons reason, void *user, void *in, size_t len)
 {
@@ -261,7 +275,7 @@ static int httpserver_http_callback(struct lws_context *context, struct lws *wsi
 			break;
 
 		case LWS_CALLBACK_ADD_POLL_FD:
-			daemon_poll_addfd(pa->fd, pa->events);
+			daemon_poll_addfd_callback(pa->fd, pa->events, httpserver_poll_callback, NULL);
 			break;
 
 		case LWS_CALLBACK_DEL_POLL_FD:
@@ -393,8 +407,9 @@ static struct lws_protocols lwsprotocols[] = {
 
 void httpserver_sendtoclients(voicestream_t *voicestream, uint8_t *buf, uint16_t bytestosend) {
 	httpserver_client_t *client = httpserver_clients;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (voicestream == NULL || buf == NULL || bytestosend == 0 || !config_get_httpserverenabled())
+	if (voicestream == NULL || buf == NULL || bytestosend == 0 || config_snapshot == NULL || !config_snapshot->httpserverenabled)
 		return;
 
 	// Looping through all clients and putting data into their buffers if the voicestream matches.
@@ -442,16 +457,15 @@ void httpserver_print_client_list(void) {
 }
 
 void httpserver_process(void) {
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 #ifdef MP3ENCODEVOICE
 	httpserver_client_t *client = httpserver_clients;
 	struct timeval currtime = {0,};
 	struct timeval difftime = {0,};
-#endif
 	int i;
-	int pfdcount;
-	struct pollfd *pfd;
+#endif
 
-	if (!config_get_httpserverenabled() || httpserver_lws_context == NULL)
+	if (config_snapshot == NULL || !config_snapshot->httpserverenabled || httpserver_lws_context == NULL)
 		return;
 
 #ifdef MP3ENCODEVOICE
@@ -470,11 +484,8 @@ void httpserver_process(void) {
 	}
 #endif
 
-	pfdcount = daemon_poll_getpfdcount();
-	pfd = daemon_poll_getpfd();
-
-	for (i = 0; i < pfdcount-1; i++)
-		lws_service_fd(httpserver_lws_context, &pfd[i]);
+	// Ready fds are serviced by httpserver_poll_callback(), here we only let libwebsockets handle its timeouts.
+	lws_service_fd(httpserver_lws_context, NULL);
 }
 
 void httpserver_init(void) {
@@ -0,0 +1,211 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "ipsc-tgfilter.h"
+
+#include <libs/daemon/console.h>
+#include <libs/config/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+// The allowedtalkgroups and ignoredtalkgroups config lists compiled into a bitmap of ignored talkgroups,
+// so checking a talkgroup is a single bit test.
+//
+// List entries are processed in order. An entry can be a talkgroup ID, a range (2160-2169), or "*" for
+// all talkgroups. Entries starting with "!" remove the given talkgroups from the list. A talkgroup is
+// ignored if it's on the ignored list, and not on the allowed list.
+
+static uint64_t *ipsc_tgfilter_bitmap = NULL; // NULL if no talkgroups are ignored.
+static uint32_t ipsc_tgfilter_ignored_count = 0;
+
+// Only call this from the main thread, see ipsc_tgfilter_rebuild().
+flag_t ipsc_tgfilter_isignored(dmr_id_t id) {
+	if (ipsc_tgfilter_bitmap == NULL || id > IPSC_TGFILTER_MAX_ID)
+		return 0;
+
+	return ((ipsc_tgfilter_bitmap[id >> 6] >> (id & 63)) & 1);
+}
+
+static void ipsc_tgfilter_set_range(uint64_t *bitmap, uint32_t from, uint32_t to, flag_t value) {
+	uint32_t from_word = from >> 6;
+	uint32_t to_word = to >> 6;
+	uint64_t from_mask = ~(uint64_t)0 << (from & 63);
+	uint64_t to_mask = ~(uint64_t)0 >> (63 - (to & 63));
+	uint32_t i;
+
+	if (from_word == to_word) {
+		if (value)
+			bitmap[from_word] |= (from_mask & to_mask);
+		else
+			bitmap[from_word] &= ~(from_mask & to_mask);
+		return;
+	}
+
+	if (value)
+		bitmap[from_word] |= from_mask;
+	else
+		bitmap[from_word] &= ~from_mask;
+
+	for (i = from_word+1; i < to_word; i++)
+		bitmap[i] = (value ? ~(uint64_t)0 : 0);
+
+	if (value)
+		bitmap[to_word] |= to_mask;
+	else
+		bitmap[to_word] &= ~to_mask;
+}
+
+static flag_t ipsc_tgfilter_parse_id(char *str, char **endptr, uint32_t *id) {
+	unsigned long value;
+
+	errno = 0;
+	value = strtoul(str, endptr, 10);
+	if (*endptr == str || errno != 0 || value > IPSC_TGFILTER_MAX_ID)
+		return 0;
+
+	*id = value;
+	return 1;
+}
+
+// Sets the bits of the talkgroups in the given comma separated list.
+// Returns 1 if the list is not empty.
+static flag_t ipsc_tgfilter_compile_list(char *listname, char *list, uint64_t *bitmap) {
+	char *tok;
+	char *saveptr = NULL;
+	char *endptr;
+	flag_t value;
+	flag_t notempty = 0;
+	uint32_t from;
+	uint32_t to;
+
+	for (tok = strtok_r(list, ",", &saveptr); tok != NULL; tok = strtok_r(NULL, ",", &saveptr)) {
+		value = 1;
+		if (*tok == '!') {
+			value = 0;
+			tok++;
+		}
+
+		if (strcmp(tok, "*") == 0) {
+			ipsc_tgfilter_set_range(bitmap, 0, IPSC_TGFILTER_MAX_ID, value);
+			notempty = 1;
+			continue;
+		}
+
+		if (!ipsc_tgfilter_parse_id(tok, &endptr, &from)) {
+			console_log("ipsc tgfilter warning: invalid %s entry %s\n", listname, tok);
+			continue;
+		}
+		to = from;
+		if (*endptr == '-') {
+			if (!ipsc_tgfilter_parse_id(endptr+1, &endptr, &to) || to < from) {
+				console_log("ipsc tgfilter warning: invalid %s range %s\n", listname, tok);
+				continue;
+			}
+		}
+		if (*endptr != 0) {
+			console_log("ipsc tgfilter warning: invalid %s entry %s\n", listname, tok);
+			continue;
+		}
+
+		ipsc_tgfilter_set_range(bitmap, from, to, value);
+		notempty = 1;
+	}
+	return notempty;
+}
+
+void ipsc_tgfilter_print(void) {
+	if (ipsc_tgfilter_bitmap == NULL)
+		console_log("ipsc tgfilter: no talkgroups are ignored\n");
+	else
+		console_log("ipsc tgfilter: %u talkgroups are ignored\n", ipsc_tgfilter_ignored_count);
+}
+
+// Compiles the talkgroup lists from the config to a new bitmap, and replaces the current one with it.
+// The current bitmap is kept if compiling fails.
+flag_t ipsc_tgfilter_rebuild(void) {
+	char *allowedtgs;
+	char *ignoredtgs;
+	uint64_t *ignored = NULL;
+	uint64_t *allowed = NULL;
+	uint64_t *old_bitmap;
+	uint32_t ignored_count = 0;
+	uint32_t i;
+	flag_t has_ignored;
+	flag_t has_allowed = 0;
+	flag_t result = 0;
+
+	allowedtgs = config_get_allowedtalkgroups();
+	ignoredtgs = config_get_ignoredtalkgroups();
+	if (allowedtgs == NULL || ignoredtgs == NULL) {
+		console_log("ipsc tgfilter error: can't get talkgroup lists from the config\n");
+		goto ipsc_tgfilter_rebuild_end;
+	}
+
+	ignored = (uint64_t *)calloc(IPSC_TGFILTER_BITMAP_WORDS, sizeof(uint64_t));
+	if (ignored == NULL) {
+		console_log("ipsc tgfilter error: can't allocate memory for the talkgroup bitmap\n");
+		goto ipsc_tgfilter_rebuild_end;
+	}
+	has_ignored = ipsc_tgfilter_compile_list("ignoredtalkgroups", ignoredtgs, ignored);
+
+	if (has_ignored) {
+		allowed = (uint64_t *)calloc(IPSC_TGFILTER_BITMAP_WORDS, sizeof(uint64_t));
+		if (allowed == NULL) {
+			console_log("ipsc tgfilter error: can't allocate memory for the talkgroup bitmap\n");
+			goto ipsc_tgfilter_rebuild_end;
+		}
+		has_allowed = ipsc_tgfilter_compile_list("allowedtalkgroups", allowedtgs, allowed);
+	}
+
+	for (i = 0; has_ignored && i < IPSC_TGFILTER_BITMAP_WORDS; i++) {
+		if (has_allowed)
+			ignored[i] &= ~allowed[i];
+		ignored_count += __builtin_popcountll(ignored[i]);
+	}
+
+	if (ignored_count == 0) {
+		free(ignored);
+		ignored = NULL;
+	}
+
+	// Lookups are done by the main thread when handling decoded packets, and rebuilds are done by the
+	// main thread on config reload, so no lookup can be using the old bitmap when it's freed.
+	old_bitmap = ipsc_tgfilter_bitmap;
+	ipsc_tgfilter_bitmap = ignored;
+	ipsc_tgfilter_ignored_count = ignored_count;
+	ignored = old_bitmap;
+	result = 1;
+
+	ipsc_tgfilter_print();
+
+ipsc_tgfilter_rebuild_end:
+	free(ignored);
+	free(allowed);
+	free(allowedtgs);
+	free(ignoredtgs);
+	return result;
+}
+
+void ipsc_tgfilter_deinit(void) {
+	free(ipsc_tgfilter_bitmap);
+	ipsc_tgfilter_bitmap = NULL;
+	ipsc_tgfilter_ignored_count = 0;
+}
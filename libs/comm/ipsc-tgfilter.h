@@ -0,0 +1,34 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef IPSC_TGFILTER_H_
+#define IPSC_TGFILTER_H_
+
+#include <libs/base/types.h>
+#include <libs/base/dmr.h>
+
+// DMR IDs are 24 bits long, so the bitmap has a bit for every possible talkgroup (2MB).
+#define IPSC_TGFILTER_MAX_ID			0xffffff
+#define IPSC_TGFILTER_BITMAP_WORDS		((IPSC_TGFILTER_MAX_ID+1)/64)
+
+flag_t ipsc_tgfilter_isignored(dmr_id_t id);
+void ipsc_tgfilter_print(void);
+
+flag_t ipsc_tgfilter_rebuild(void);
+void ipsc_tgfilter_deinit(void);
+
+#endif
@@ -0,0 +1,273 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "ipsc-trace.h"
+
+#include <libs/daemon/console.h>
+#include <libs/config/config.h>
+
+#include <pcap/pcap.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+// A fixed size ring of the last captured IPSC packets, so the traffic before an incident can be dumped
+// to a file with the ipsctrace console command, without running with debug logging enabled. Adding a
+// record is only a copy to the ring, the oldest record gets overwritten.
+//
+// Every slot has a sequence number which is odd while the record is being written, so a dump can check
+// if the record it copied was overwritten meanwhile.
+
+#define IPSC_TRACE_MAXRINGSIZE		(1 << 20)
+
+typedef struct {
+	uint32_t seq;
+	uint32_t pos; // The position of the record in the ring since startup.
+	ipsc_trace_record_t record;
+} ipsc_trace_slot_t;
+
+typedef void (*ipsc_trace_record_callback_t)(ipsc_trace_record_t *record, void *arg);
+
+static ipsc_trace_slot_t *ipsc_trace_ring = NULL;
+static uint32_t ipsc_trace_ring_mask = 0;
+static uint32_t ipsc_trace_added_count = 0;
+
+// Adds a record for a captured packet. Ipscpacket and repeater can be NULL if the packet has been dropped
+// before decoding.
+void ipsc_trace_add(struct ip *ip_packet, uint16_t length, ipscpacket_t *ipscpacket, repeater_t *repeater, ipsc_trace_result_t result) {
+	ipsc_trace_slot_t *slot;
+	ipsc_trace_record_t *record;
+	struct timeval tv;
+	uint32_t pos;
+	uint32_t seq;
+
+	if (ipsc_trace_ring == NULL)
+		return;
+
+	// Records are only added by the packet processing thread.
+	pos = ipsc_trace_added_count;
+	slot = &ipsc_trace_ring[pos & ipsc_trace_ring_mask];
+	record = &slot->record;
+
+	seq = slot->seq;
+	__atomic_store_n(&slot->seq, seq+1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->pos = pos;
+	gettimeofday(&tv, NULL);
+	record->timestamp_sec = tv.tv_sec;
+	record->timestamp_usec = tv.tv_usec;
+	if (length >= sizeof(struct ip)) {
+		record->src_ip = ip_packet->ip_src.s_addr;
+		record->dst_ip = ip_packet->ip_dst.s_addr;
+	} else
+		record->src_ip = record->dst_ip = 0;
+	record->repeater_id = (repeater != NULL ? repeater->id : 0);
+	if (ipscpacket != NULL) {
+		record->dst_id = ipscpacket->dst_id;
+		record->src_id = ipscpacket->src_id;
+		record->slot_type = ipscpacket->slot_type;
+		record->timeslot = ipscpacket->timeslot;
+		record->call_type = ipscpacket->call_type;
+		record->seq = ipscpacket->seq;
+	} else {
+		record->dst_id = record->src_id = 0;
+		record->slot_type = 0;
+		record->timeslot = record->call_type = record->seq = 0;
+	}
+	record->result = result;
+	if (length > IPSC_TRACE_MAXPACKETSIZE)
+		length = IPSC_TRACE_MAXPACKETSIZE;
+	record->packet_length = length;
+	memcpy(record->packet, ip_packet, length);
+
+	__atomic_store_n(&slot->seq, seq+2, __ATOMIC_RELEASE);
+	__atomic_store_n(&ipsc_trace_added_count, pos+1, __ATOMIC_RELEASE);
+}
+
+// Copies the record added at the given position. Returns 0 if it has been overwritten.
+static flag_t ipsc_trace_get_record(uint32_t pos, ipsc_trace_record_t *record) {
+	ipsc_trace_slot_t *slot = &ipsc_trace_ring[pos & ipsc_trace_ring_mask];
+	uint32_t seq;
+	flag_t result;
+
+	seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+	if (seq == 0 || (seq & 1)) // Not written yet, or being written.
+		return 0;
+
+	result = (slot->pos == pos);
+	memcpy(record, &slot->record, sizeof(ipsc_trace_record_t));
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return (result && __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq);
+}
+
+// Calls the callback for the records in the ring from the oldest to the newest.
+// Returns the number of records processed.
+static uint32_t ipsc_trace_foreach(ipsc_trace_record_callback_t callback, void *arg) {
+	ipsc_trace_record_t record;
+	uint32_t end;
+	uint32_t pos;
+	uint32_t count = 0;
+
+	if (ipsc_trace_ring == NULL)
+		return 0;
+
+	end = __atomic_load_n(&ipsc_trace_added_count, __ATOMIC_ACQUIRE);
+	// Positions wrap around, the records which are not in the ring are skipped by ipsc_trace_get_record().
+	for (pos = end-(ipsc_trace_ring_mask+1); pos != end; pos++) {
+		if (!ipsc_trace_get_record(pos, &record))
+			continue;
+
+		callback(&record, arg);
+		count++;
+	}
+	return count;
+}
+
+static void ipsc_trace_dump_pcap_record(ipsc_trace_record_t *record, void *arg) {
+	pcap_dumper_t *pcap_dumper = (pcap_dumper_t *)arg;
+	struct pcap_pkthdr pkthdr;
+
+	memset(&pkthdr, 0, sizeof(struct pcap_pkthdr));
+	pkthdr.ts.tv_sec = record->timestamp_sec;
+	pkthdr.ts.tv_usec = record->timestamp_usec;
+	pkthdr.caplen = record->packet_length;
+	pkthdr.len = record->packet_length;
+	pcap_dump((u_char *)pcap_dumper, &pkthdr, record->packet);
+}
+
+// Writes the captured packets of the trace to a pcap file, which can be opened with Wireshark.
+flag_t ipsc_trace_dump_pcap(char *filename) {
+	pcap_t *pcap_dead_handle;
+	pcap_dumper_t *pcap_dumper;
+	uint32_t count;
+
+	if (ipsc_trace_ring == NULL) {
+		console_log("ipsc trace error: tracing is disabled\n");
+		return 0;
+	}
+
+	// The stored packets start with the IP header.
+	pcap_dead_handle = pcap_open_dead(DLT_RAW, IPSC_TRACE_MAXPACKETSIZE);
+	if (pcap_dead_handle == NULL) {
+		console_log("ipsc trace error: can't init pcap handle\n");
+		return 0;
+	}
+
+	pcap_dumper = pcap_dump_open(pcap_dead_handle, filename);
+	if (pcap_dumper == NULL) {
+		console_log("ipsc trace error: can't open %s: %s\n", filename, pcap_geterr(pcap_dead_handle));
+		pcap_close(pcap_dead_handle);
+		return 0;
+	}
+
+	count = ipsc_trace_foreach(ipsc_trace_dump_pcap_record, pcap_dumper);
+
+	pcap_dump_close(pcap_dumper);
+	pcap_close(pcap_dead_handle);
+	console_log("ipsc trace: dumped %u packets to %s\n", count, filename);
+	return 1;
+}
+
+static void ipsc_trace_dump_bin_record(ipsc_trace_record_t *record, void *arg) {
+	fwrite(record, sizeof(ipsc_trace_record_t), 1, (FILE *)arg);
+}
+
+// Writes the trace records with the decoded fields to a binary file, see ipsc-trace.h for the format.
+flag_t ipsc_trace_dump_bin(char *filename) {
+	ipsc_trace_file_header_t header;
+	FILE *f;
+	flag_t result;
+
+	if (ipsc_trace_ring == NULL) {
+		console_log("ipsc trace error: tracing is disabled\n");
+		return 0;
+	}
+
+	f = fopen(filename, "wb");
+	if (f == NULL) {
+		console_log("ipsc trace error: can't open %s: %s\n", filename, strerror(errno));
+		return 0;
+	}
+
+	memset(&header, 0, sizeof(ipsc_trace_file_header_t));
+	memcpy(header.magic, IPSC_TRACE_FILE_MAGIC, sizeof(header.magic));
+	header.record_size = sizeof(ipsc_trace_record_t);
+	fwrite(&header, sizeof(ipsc_trace_file_header_t), 1, f);
+
+	// The record count is only known after the records have been written, so the header is written again.
+	header.record_count = ipsc_trace_foreach(ipsc_trace_dump_bin_record, f);
+	if (fseek(f, 0, SEEK_SET) == 0)
+		fwrite(&header, sizeof(ipsc_trace_file_header_t), 1, f);
+
+	result = (ferror(f) == 0);
+	if (fclose(f) != 0)
+		result = 0;
+
+	if (result)
+		console_log("ipsc trace: dumped %u records to %s\n", header.record_count, filename);
+	else
+		console_log("ipsc trace error: can't write %s\n", filename);
+	return result;
+}
+
+void ipsc_trace_print_stats(void) {
+	uint32_t added;
+
+	if (ipsc_trace_ring == NULL) {
+		console_log("ipsc trace: disabled\n");
+		return;
+	}
+
+	added = __atomic_load_n(&ipsc_trace_added_count, __ATOMIC_RELAXED);
+	console_log("ipsc trace: %u records in the ring (size %u), %u packets traced\n",
+		(added > ipsc_trace_ring_mask+1 ? ipsc_trace_ring_mask+1 : added), ipsc_trace_ring_mask+1, added);
+}
+
+void ipsc_trace_init(void) {
+	int tracesize = config_get_ipsctracesize();
+	uint32_t ringsize = 1;
+
+	if (tracesize <= 0) {
+		console_log("ipsc trace: disabled\n");
+		return;
+	}
+
+	while (ringsize < (uint32_t)tracesize && ringsize < IPSC_TRACE_MAXRINGSIZE)
+		ringsize <<= 1;
+
+	ipsc_trace_ring = (ipsc_trace_slot_t *)calloc(ringsize, sizeof(ipsc_trace_slot_t));
+	if (ipsc_trace_ring == NULL) {
+		console_log("ipsc trace error: can't allocate memory for the trace ring\n");
+		return;
+	}
+	ipsc_trace_ring_mask = ringsize-1;
+	ipsc_trace_added_count = 0;
+	console_log("ipsc trace: keeping the last %u packets\n", ringsize);
+}
+
+void ipsc_trace_deinit(void) {
+	free(ipsc_trace_ring);
+	ipsc_trace_ring = NULL;
+	ipsc_trace_ring_mask = 0;
+	ipsc_trace_added_count = 0;
+}
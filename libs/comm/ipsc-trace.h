@@ -0,0 +1,79 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef IPSC_TRACE_H_
+#define IPSC_TRACE_H_
+
+#include "ipscpacket.h"
+#include "repeaters.h"
+
+#include <libs/base/types.h>
+
+#include <netinet/ip.h>
+
+// Max. number of bytes stored from the captured IP packet.
+#define IPSC_TRACE_MAXPACKETSIZE				(20+8+IPSC_PACKET_SIZE2)
+
+// What happened to the packet. Packets which are dropped before decoding have 0 in the decoded fields.
+#define IPSC_TRACE_RESULT_HANDLED				0x00
+#define IPSC_TRACE_RESULT_DUPLICATE				0x01
+#define IPSC_TRACE_RESULT_TALKGROUP_IGNORED		0x02
+#define IPSC_TRACE_RESULT_CALL_ALREADY_RUNNING	0x04
+#define IPSC_TRACE_RESULT_LENGTH_ERROR			0x08 // Too short packet, or IP/UDP length mismatch.
+#define IPSC_TRACE_RESULT_CHECKSUM_ERROR		0x10 // IP header or UDP checksum mismatch.
+#define IPSC_TRACE_RESULT_NOT_DECODED			0x20 // Not an IPSC DMR packet (heartbeats are also not decoded).
+#define IPSC_TRACE_RESULT_HOST_IGNORED			0x40
+#define IPSC_TRACE_RESULT_FROM_US				0x80
+typedef uint8_t ipsc_trace_result_t;
+
+// Binary trace files start with this header, followed by the records from the oldest to the newest.
+// All fields are in host byte order, except the IP addresses and the packet bytes.
+#define IPSC_TRACE_FILE_MAGIC					"DMRSTRC1"
+
+typedef struct __attribute__((packed)) {
+	char magic[8];
+	uint32_t record_size;
+	uint32_t record_count;
+} ipsc_trace_file_header_t;
+
+typedef struct __attribute__((packed)) {
+	uint32_t timestamp_sec;
+	uint32_t timestamp_usec;
+	uint32_t src_ip;
+	uint32_t dst_ip;
+	uint32_t repeater_id;
+	uint32_t dst_id;
+	uint32_t src_id;
+	uint16_t slot_type;
+	uint8_t timeslot;
+	uint8_t call_type;
+	uint8_t seq;
+	ipsc_trace_result_t result;
+	uint16_t packet_length;
+	uint8_t packet[IPSC_TRACE_MAXPACKETSIZE];
+} ipsc_trace_record_t;
+
+void ipsc_trace_add(struct ip *ip_packet, uint16_t length, ipscpacket_t *ipscpacket, repeater_t *repeater, ipsc_trace_result_t result);
+
+flag_t ipsc_trace_dump_pcap(char *filename);
+flag_t ipsc_trace_dump_bin(char *filename);
+void ipsc_trace_print_stats(void);
+
+void ipsc_trace_init(void);
+void ipsc_trace_deinit(void);
+
+#endif
@@ -21,6 +21,9 @@
 #include "comm.h"
 #include "ipsc-handle.h"
 #include "snmp.h"
+#include "comm-hostset.h"
+#include "ipsc-tgfilter.h"
+#include "ipsc-trace.h"
 
 #include <libs/remotedb/remotedb.h>
 #include <libs/config/config.h>
@@ -31,117 +34,30 @@
 
 #define HEARTBEAT_PERIOD_IN_SEC 6
 
-static flag_t ipsc_isignoredip(struct in_addr *ipaddr) {
-	char *ignoredhosts = config_get_ignoredhosts();
-	char *tok = NULL;
-	struct in_addr ignoredaddr;
+static comm_hostset_t *ipsc_ignoredhosts = NULL;
 
-	if (ignoredhosts == NULL)
-		return 0;
-
-	tok = strtok(ignoredhosts, ",");
-	if (tok) {
-		do {
-			if (comm_hostname_to_ip(tok, &ignoredaddr)) {
-				if (memcmp(&ignoredaddr, ipaddr, sizeof(struct in_addr)) == 0) {
-					free(ignoredhosts);
-					return 1;
-				}
-			} else
-				console_log(LOGLEVEL_DEBUG "repeaters: can't resolve hostname %s\n", tok);
-
-			tok = strtok(NULL, ",");
-		} while (tok != NULL);
-	}
-	free(ignoredhosts);
-	return 0;
-}
-
-static flag_t ipsc_isignoredtalkgroup(dmr_id_t id) {
-	char *allowedtgs = config_get_allowedtalkgroups();
-	char *ignoredtgs = config_get_ignoredtalkgroups();
-	char *tok = NULL;
-	int tg;
-	char *endptr;
-
-	if (ignoredtgs == NULL)
-		return 0;
-	if (allowedtgs != NULL) {
-		tok = strtok(allowedtgs, ",");
-		if (tok) {
-			do {
-				if (*tok == '*') {
-					free(ignoredtgs);
-					free(allowedtgs);
-					return 0;
-				}
-
-				errno = 0;
-				tg = strtol(tok, &endptr, 10);
-				if (*endptr == 0 && errno == 0) {
-					if (tg == id) {
-						free(ignoredtgs);
-						free(allowedtgs);
-						return 0;
-					}
-				} else
-					console_log(LOGLEVEL_DEBUG "ipsc: invalid allowed talk group %s\n", tok);
-
-				tok = strtok(NULL, ",");
-			} while (tok != NULL);
-		}
-		free(allowedtgs);
-	}
-
-	if (ignoredtgs != NULL) {
-		tok = strtok(ignoredtgs, ",");
-		if (tok) {
-			do {
-				if (*tok == '*') {
-					free(ignoredtgs);
-					return 1;
-				}
-
-				errno = 0;
-				tg = strtol(tok, &endptr, 10);
-				if (*endptr == 0 && errno == 0) {
-					if (tg == id) {
-						free(ignoredtgs);
-						return 1;
-					}
-				} else
-					console_log(LOGLEVEL_DEBUG "ipsc: invalid ignored talk group %s\n", tok);
-
-				tok = strtok(NULL, ",");
-			} while (tok != NULL);
-		}
-		free(ignoredtgs);
-	}
-	return 0;
-}
-
-static void ipsc_examinepacket(struct ip *ip_packet, ipscpacket_t *ipscpacket, flag_t packet_from_us) {
+// Checks if the decoded packet should be handled, and sets the repeater and the trace result bits.
+static flag_t ipsc_examinepacket(struct ip *ip_packet, ipscpacket_t *ipscpacket, repeater_t **repeater, ipsc_trace_result_t *trace_result) {
 	flag_t talkgroup_ignored = 0;
 	flag_t duplicate_seqnum = 0;
 	flag_t call_already_running = 0;
-	repeater_t *repeater = NULL;
 	loglevel_t loglevel;
 
-	repeater = repeaters_add(&ip_packet->ip_src);
-	if (repeater == NULL)
-		return;
+	*repeater = repeaters_add(&ip_packet->ip_src);
+	if (*repeater == NULL)
+		return 0;
 
-	if (repeaters_is_call_running_on_other_repeater(repeater, ipscpacket->timeslot-1, ipscpacket->src_id))
+	if (repeaters_is_call_running_on_other_repeater(*repeater, ipscpacket->timeslot-1, ipscpacket->src_id))
 		call_already_running = 1;
 
-	if (ipscpacket->call_type == DMR_CALL_TYPE_GROUP && ipsc_isignoredtalkgroup(ipscpacket->dst_id))
+	if (ipscpacket->call_type == DMR_CALL_TYPE_GROUP && ipsc_tgfilter_isignored(ipscpacket->dst_id))
 		talkgroup_ignored = 1;
 
 	// IPSC syncs have seqnum 0 so we don't check their duplicateness.
-	if (ipscpacket->seq == repeater->slot[ipscpacket->timeslot-1].ipsc_last_received_seqnum && ipscpacket->slot_type != IPSCPACKET_SLOT_TYPE_IPSC_SYNC)
+	if (ipscpacket->seq == (*repeater)->slot[ipscpacket->timeslot-1].ipsc_last_received_seqnum && ipscpacket->slot_type != IPSCPACKET_SLOT_TYPE_IPSC_SYNC)
 		duplicate_seqnum = 1;
 	else
-		repeater->slot[ipscpacket->timeslot-1].ipsc_last_received_seqnum = ipscpacket->seq;
+		(*repeater)->slot[ipscpacket->timeslot-1].ipsc_last_received_seqnum = ipscpacket->seq;
 
 	loglevel = console_get_loglevel();
 	if (!loglevel.flags.comm_ip && !loglevel.flags.debug && !loglevel.flags.dmrlc && loglevel.flags.ipsc)
@@ -164,59 +80,119 @@ static void ipsc_examinepacket(struct ip *ip_packet, ipscpacket_t *ipscpacket, f
 		console_log(LOGLEVEL_IPSC " (call already running, ignored)");
 
 	console_log(LOGLEVEL_IPSC "\n");
-	if (!duplicate_seqnum && !talkgroup_ignored && !call_already_running)
-		ipsc_handle_by_slot_type(ip_packet, ipscpacket, repeater);
+
+	if (duplicate_seqnum)
+		*trace_result |= IPSC_TRACE_RESULT_DUPLICATE;
+	if (talkgroup_ignored)
+		*trace_result |= IPSC_TRACE_RESULT_TALKGROUP_IGNORED;
+	if (call_already_running)
+		*trace_result |= IPSC_TRACE_RESULT_CALL_ALREADY_RUNNING;
+
+	return (!duplicate_seqnum && !talkgroup_ignored && !call_already_running);
 }
 
-void ipsc_processpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length) {
+// Validates and decodes the captured packet to result. This doesn't use any state besides the packet,
+// so it can run on a comm pipeline decode worker thread.
+void ipsc_decodepacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length, ipsc_decoderesult_t *result) {
+	struct ip *ip_packet = (struct ip *)ipscpacket_raw->bytes;
+	struct udphdr *udp_packet = NULL;
+
+	memset(result, 0, sizeof(ipsc_decoderesult_t));
+
+	if (length < sizeof(struct ip))
+		return;
+	result->ip_header_length = ip_packet->ip_hl*4; // http://www.governmentsecurity.org/forum/topic/16447-calculate-ip-size/
+	if (length < result->ip_header_length+sizeof(struct udphdr))
+		return;
+	result->length_ok = 1;
+
+	result->ip_checksum_ok = (ip_packet->ip_sum == comm_calcipheaderchecksum(ip_packet));
+	if (!result->ip_checksum_ok)
+		return;
+
+	udp_packet = (struct udphdr *)(ipscpacket_raw->bytes + result->ip_header_length);
+	result->ip_length_ok = (ntohs(ip_packet->ip_len) == result->ip_header_length+ntohs(udp_packet->len));
+	if (!result->ip_length_ok)
+		return;
+
+	result->udp_length_ok = (length-result->ip_header_length == ntohs(udp_packet->len));
+	if (!result->udp_length_ok)
+		return;
+
+	result->udp_checksum_ok = (udp_packet->check == comm_calcudpchecksum(ip_packet, udp_packet));
+
+	// The packet_from_us parameter is not used by the decoder, so we don't need to look up our addresses here.
+	result->decoded = ipscpacket_decode(ip_packet, udp_packet, &result->ipscpacket, 0);
+	result->heartbeat = ipscpacket_heartbeat_decode(udp_packet);
+}
+
+// Handles a packet decoded by ipsc_decodepacket(). This has to be called from the main thread.
+// Every packet is added to the IPSC trace, the dropped ones with the reason in the trace result.
+void ipsc_handledecodedpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length, ipsc_decoderesult_t *result) {
 	struct ip *ip_packet = (struct ip *)ipscpacket_raw->bytes;
 	struct udphdr *udp_packet = NULL;
-	int ip_header_length = 0;
-	ipscpacket_t ipscpacket = {0,};
 	repeater_t *repeater = NULL;
 	flag_t packet_from_us = 0;
+	flag_t handle = 0;
+	ipsc_trace_result_t trace_result = IPSC_TRACE_RESULT_HANDLED;
 	loglevel_t loglevel = console_get_loglevel();
 
 	if (!loglevel.flags.ipsc && !loglevel.flags.debug && !loglevel.flags.dmrlc && loglevel.flags.comm_ip)
 		log_print_separator();
 
+	if (!result->length_ok) {
+		console_log(LOGLEVEL_COMM_IP "  packet too short (%u bytes), dropping\n", length);
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_LENGTH_ERROR);
+		return;
+	}
 	console_log(LOGLEVEL_COMM_IP "  src: %s\n", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 	console_log(LOGLEVEL_COMM_IP "  dst: %s\n", repeaters_get_display_string_for_ip(&ip_packet->ip_dst));
-	if (ipsc_isignoredip(&ip_packet->ip_src)) {
+	if (comm_hostset_contains(ipsc_ignoredhosts, &ip_packet->ip_src)) {
 		console_log(LOGLEVEL_COMM_IP "  src ip ignored, dropping\n");
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_HOST_IGNORED);
 		return;
 	}
-	ip_header_length = ip_packet->ip_hl*4; // http://www.governmentsecurity.org/forum/topic/16447-calculate-ip-size/
-	console_log(LOGLEVEL_COMM_IP "  ip header length: %u\n", ip_header_length);
-	if (ip_packet->ip_sum != comm_calcipheaderchecksum(ip_packet)) {
+	console_log(LOGLEVEL_COMM_IP "  ip header length: %u\n", result->ip_header_length);
+	if (!result->ip_checksum_ok) {
 		console_log(LOGLEVEL_COMM_IP "  ip checksum mismatch, dropping\n");
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_CHECKSUM_ERROR);
 		return;
 	}
 
-	udp_packet = (struct udphdr *)(ipscpacket_raw->bytes + ip_header_length);
-	if (ntohs(ip_packet->ip_len) != ip_header_length+ntohs(udp_packet->len)) {
-		console_log(LOGLEVEL_COMM_IP "  ip length (%u) and udp length (%u+%u) mismatch, dropping\n", ntohs(ip_packet->ip_len), ip_header_length+ntohs(udp_packet->len));
+	udp_packet = (struct udphdr *)(ipscpacket_raw->bytes + result->ip_header_length);
+	if (!result->ip_length_ok) {
+		console_log(LOGLEVEL_COMM_IP "  ip length (%u) and udp length (%u+%u) mismatch, dropping\n", ntohs(ip_packet->ip_len), result->ip_header_length, ntohs(udp_packet->len));
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_LENGTH_ERROR);
 		return;
 	}
 	console_log(LOGLEVEL_COMM_IP "  srcport: %u\n", ntohs(udp_packet->source));
 	console_log(LOGLEVEL_COMM_IP "  dstport: %u\n", ntohs(udp_packet->dest));
 	// Length in UDP header contains length of the UDP header too, so we are substracting it.
 	console_log(LOGLEVEL_COMM_IP "  length: %u\n", ntohs(udp_packet->len)-sizeof(struct udphdr));
-	if (length-ip_header_length != ntohs(udp_packet->len)) {
+	if (!result->udp_length_ok) {
 		console_log(LOGLEVEL_COMM_IP "  udp length not equal to received packet length, dropping\n");
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_LENGTH_ERROR);
 		return;
 	}
 
-	if (!comm_is_our_ipaddr(&ip_packet->ip_src) && udp_packet->check != comm_calcudpchecksum(ip_packet, udp_packet)) {
+	packet_from_us = comm_is_our_ipaddr(&ip_packet->ip_src);
+	if (packet_from_us)
+		trace_result |= IPSC_TRACE_RESULT_FROM_US;
+	if (!packet_from_us && !result->udp_checksum_ok) {
 		console_log(LOGLEVEL_COMM_IP "  udp checksum mismatch, dropping\n");
+		ipsc_trace_add(ip_packet, length, NULL, NULL, IPSC_TRACE_RESULT_CHECKSUM_ERROR);
 		return;
 	}
 
-	packet_from_us = comm_is_our_ipaddr(&ip_packet->ip_src);
-	if (ipscpacket_decode(ip_packet, udp_packet, &ipscpacket, packet_from_us))
-		ipsc_examinepacket(ip_packet, &ipscpacket, packet_from_us);
+	if (result->decoded) {
+		handle = ipsc_examinepacket(ip_packet, &result->ipscpacket, &repeater, &trace_result);
+		ipsc_trace_add(ip_packet, length, &result->ipscpacket, repeater, trace_result);
+		if (handle)
+			ipsc_handle_by_slot_type(ip_packet, &result->ipscpacket, repeater);
+	} else
+		ipsc_trace_add(ip_packet, length, NULL, NULL, trace_result | IPSC_TRACE_RESULT_NOT_DECODED);
 
-	if (ipscpacket_heartbeat_decode(udp_packet)) {
+	if (result->heartbeat) {
 		if (comm_is_our_ipaddr(&ip_packet->ip_dst)) {
 			console_log(LOGLEVEL_HEARTBEAT "ipsc [%s", repeaters_get_display_string_for_ip(&ip_packet->ip_src));
 			console_log(LOGLEVEL_HEARTBEAT "->%s]: got heartbeat\n", repeaters_get_display_string_for_ip(&ip_packet->ip_dst));
@@ -229,15 +205,34 @@ void ipsc_processpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length) {
 	}
 }
 
-void ipsc_init(void) {
+void ipsc_processpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length) {
+	ipsc_decoderesult_t result;
+
+	ipsc_decodepacket(ipscpacket_raw, length, &result);
+	ipsc_handledecodedpacket(ipscpacket_raw, length, &result);
+}
+
+// Adds the master's IP address from the config to the repeaters list. If the master has been changed,
+// the snmpignored flags are re-evaluated, so the old master gets queried again and the new one is ignored.
+void ipsc_add_master_repeater(void) {
 	struct in_addr *masterip;
-	repeater_t *repeater;
 
 	masterip = config_get_masteripaddr();
-	repeater = repeaters_add(masterip);
-	if (repeater == NULL)
-		console_log("ipsc init error: can't add the master's ip to the repeaters list\n");
-	else
-		repeater->snmpignored = 1;
+	if (repeaters_add(masterip) == NULL)
+		console_log("ipsc error: can't add the master's ip to the repeaters list\n");
 	free(masterip);
+
+	repeaters_update_snmpignored();
+}
+
+void ipsc_init(void) {
+	ipsc_ignoredhosts = comm_hostset_register("ignoredhosts", config_get_ignoredhosts, NULL);
+	ipsc_tgfilter_rebuild();
+	ipsc_trace_init();
+	ipsc_add_master_repeater();
+}
+
+void ipsc_deinit(void) {
+	ipsc_trace_deinit();
+	ipsc_tgfilter_deinit();
 }
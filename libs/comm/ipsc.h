@@ -24,7 +24,25 @@
 
 #include <netinet/udp.h>
 
+// The result of the checks and decoding which don't need the main thread's state.
+typedef struct {
+	uint16_t ip_header_length;
+	flag_t length_ok : 1;
+	flag_t ip_checksum_ok : 1;
+	flag_t ip_length_ok : 1;
+	flag_t udp_length_ok : 1;
+	flag_t udp_checksum_ok : 1;
+	flag_t decoded : 1;
+	flag_t heartbeat : 1;
+	ipscpacket_t ipscpacket;
+} ipsc_decoderesult_t;
+
+void ipsc_decodepacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length, ipsc_decoderesult_t *result);
+void ipsc_handledecodedpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length, ipsc_decoderesult_t *result);
 void ipsc_processpacket(ipscpacket_raw_t *ipscpacket_raw, uint16_t length);
+void ipsc_add_master_repeater(void);
+
 void ipsc_init(void);
+void ipsc_deinit(void);
 
 #endif
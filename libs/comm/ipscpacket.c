@@ -32,15 +32,13 @@
 #include <libs/dmrpacket/dmrpacket-slot-type.h>
 #include <libs/comm/comm.h>
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <arpa/inet.h>
 #include <string.h>
 
-#define IPSC_PACKET_SIZE1 72
-#define IPSC_PACKET_SIZE2 103
-
 char *ipscpacket_get_readable_slot_type(ipscpacket_slot_type_t slot_type) {
 	switch (slot_type) {
 		case IPSCPACKET_SLOT_TYPE_VOICE_LC_HEADER: return "voice lc header";
@@ -92,8 +90,12 @@ static void ipscpacket_swap_payload_bytes(ipscpacket_payload_t *payload) {
 flag_t ipscpacket_decode(struct ip *ippacket, struct udphdr *udppacket, ipscpacket_t *ipscpacket, flag_t packet_from_us) {
 	ipscpacket_payload_raw_t *ipscpacket_raw = (ipscpacket_payload_raw_t *)((uint8_t *)udppacket + sizeof(struct udphdr));
 	int ipscpacket_raw_length = 0;
-	int i;
 	loglevel_t loglevel;
+	char hexstr[IPSC_PACKET_SIZE2*3+1];
+	char bitstr[sizeof(dmrpacket_payload_bits_t)+1];
+	dmrpacket_payload_bits_t payload_bits;
+	char src_ip[INET_ADDRSTRLEN];
+	char dst_ip[INET_ADDRSTRLEN];
 
 	if (ippacket == NULL || udppacket == NULL || ipscpacket == NULL)
 		return 0;
@@ -112,11 +114,11 @@ flag_t ipscpacket_decode(struct ip *ippacket, struct udphdr *udppacket, ipscpack
 		if (!loglevel.flags.comm_ip && !loglevel.flags.dmrlc)
 			log_print_separator();
 
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "ipscpacket [%s", repeaters_get_display_string_for_ip(&ippacket->ip_src));
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "->%s]: decoding: ", repeaters_get_display_string_for_ip(&ippacket->ip_dst));
-		for (i = 0; i < ipscpacket_raw_length; i++)
-			console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "%.2x ", *((uint8_t *)ipscpacket_raw+i));
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "\n");
+		// This can run on a comm pipeline decode worker, so we don't look up the repeater names here.
+		inet_ntop(AF_INET, &ippacket->ip_src, src_ip, sizeof(src_ip));
+		inet_ntop(AF_INET, &ippacket->ip_dst, dst_ip, sizeof(dst_ip));
+		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "ipscpacket [%s->%s]: decoding: %s\n", src_ip, dst_ip,
+			base_datatohexstr((uint8_t *)ipscpacket_raw, ipscpacket_raw_length, ' ', hexstr, sizeof(hexstr)));
 	}
 
 /*	if (!packet_from_us && ipscpacket_raw->udp_source_port != udppacket->source && ipscpacket_raw->slot_type != IPSCPACKET_SLOT_TYPE_IPSC_SYNC) {
@@ -152,34 +154,27 @@ flag_t ipscpacket_decode(struct ip *ippacket, struct udphdr *udppacket, ipscpack
 	ipscpacket->src_id = ipscpacket_raw->src_id_raw3 << 16 | ipscpacket_raw->src_id_raw2 << 8 | ipscpacket_raw->src_id_raw1;
 	memcpy(ipscpacket->payload.bytes, ipscpacket_raw->payload.bytes, sizeof(ipscpacket_payload_t));
 	ipscpacket_swap_payload_bytes(&ipscpacket->payload);
-	base_bytestobits(ipscpacket->payload.bytes, sizeof(ipscpacket_payload_t)-1, ipscpacket->payload_bits.bits, sizeof(dmrpacket_payload_bits_t));
+	dmrpacket_packed_from_bytes(ipscpacket->payload.bytes, sizeof(ipscpacket_payload_t)-1, &ipscpacket->payload_packed_bits);
 
 	if (loglevel.flags.ipsc && loglevel.flags.debug) {
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  udp source port: %u\n", ntohs(ipscpacket_raw->udp_source_port));
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved1: 0x%.2x%.2x\n", ipscpacket_raw->reserved1[0], ipscpacket_raw->reserved1[1]);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  seq: %u\n", ipscpacket_raw->seq);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved2: 0x");
-		for (i = 0; i < sizeof(ipscpacket_raw->reserved2); i++)
-			console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "%.2x", ipscpacket_raw->reserved2[i]);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "\n");
+		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved2: 0x%s\n",
+			base_datatohexstr(ipscpacket_raw->reserved2, sizeof(ipscpacket_raw->reserved2), 0, hexstr, sizeof(hexstr)));
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  packet type: 0x%.2x\n", ipscpacket_raw->packet_type);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved3: 0x");
-		for (i = 0; i < sizeof(ipscpacket_raw->reserved3); i++)
-			console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "%.2x", ipscpacket_raw->reserved3[i]);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "\n");
+		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved3: 0x%s\n",
+			base_datatohexstr(ipscpacket_raw->reserved3, sizeof(ipscpacket_raw->reserved3), 0, hexstr, sizeof(hexstr)));
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  timeslot raw: 0x%.4x\n", ipscpacket_raw->timeslot_raw);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  slot type: 0x%.4x\n", ipscpacket_raw->slot_type);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  delimiter: 0x%.4x\n", ipscpacket_raw->delimiter);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  frame type: 0x%.4x\n", ipscpacket_raw->frame_type);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved4 0x%.2x%.2x\n", ipscpacket_raw->reserved4[0], ipscpacket_raw->reserved4[1]);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  payload (swapped): ");
-		for (i = 0; i < sizeof(ipscpacket_payload_t); i++)
-			console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "%.2x", ipscpacket->payload.bytes[i]);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "\n");
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  payload (bits): ");
-		for (i = 0; i < sizeof(dmrpacket_payload_bits_t); i++)
-			console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "%u", ipscpacket->payload_bits.bits[i]);
-		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "\n");
+		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  payload (swapped): %s\n",
+			base_datatohexstr(ipscpacket->payload.bytes, sizeof(ipscpacket_payload_t), 0, hexstr, sizeof(hexstr)));
+		dmrpacket_packed_to_bits(&ipscpacket->payload_packed_bits, 0, sizeof(dmrpacket_payload_bits_t), payload_bits.bits);
+		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  payload (bits): %s\n",
+			base_bitstostr(payload_bits.bits, sizeof(dmrpacket_payload_bits_t), bitstr, sizeof(bitstr)));
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved5: 0x%.2x%.2x\n", ipscpacket_raw->reserved5[0], ipscpacket_raw->reserved5[1]);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  call type: 0x%.2x\n", ipscpacket_raw->calltype);
 		console_log(LOGLEVEL_IPSC LOGLEVEL_DEBUG "  reserved6: 0x%.2x\n", ipscpacket_raw->reserved6);
@@ -193,12 +188,12 @@ flag_t ipscpacket_decode(struct ip *ippacket, struct udphdr *udppacket, ipscpack
 }
 
 flag_t ipscpacket_heartbeat_decode(struct udphdr *udppacket) {
-	static uint8_t heartbeat[] = { 0x00, 0x00, 0x00, 0x14 };
+	static uint8_t heartbeat[] = IPSC_HEARTBEAT_MAGIC;
 
 	if (udppacket == NULL)
 		return 0;
 
-	if (memcmp((uint8_t *)udppacket + sizeof(struct udphdr) + 5, heartbeat, sizeof(heartbeat)) == 0)
+	if (memcmp((uint8_t *)udppacket + sizeof(struct udphdr) + IPSC_HEARTBEAT_MAGIC_OFFSET, heartbeat, sizeof(heartbeat)) == 0)
 		return 1;
 	return 0;
 }
@@ -208,15 +203,14 @@ ipscpacket_raw_t *ipscpacket_construct_raw_packet(struct in_addr *dst_addr, ipsc
 	static ipscpacket_raw_t ipscpacket_raw;
 	struct iphdr *ip_packet = (struct iphdr *)ipscpacket_raw.bytes;
 	struct udphdr *udp_packet = (struct udphdr *)(ipscpacket_raw.bytes+20);
-	struct in_addr *master_ip_addr = config_get_masteripaddr();
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (master_ip_addr == NULL) {
+	if (config_snapshot == NULL || !config_snapshot->masteripaddr_valid) {
 		console_log("ipscpacket error: can't construct raw packet for sending as master ip address is not set in the config\n");
 		return NULL;
 	}
 
-	memcpy(&ip_packet->saddr, master_ip_addr, sizeof(struct in_addr));
-	free(master_ip_addr);
+	memcpy(&ip_packet->saddr, &config_snapshot->masteripaddr, sizeof(struct in_addr));
 	memcpy(&ip_packet->daddr, dst_addr, sizeof(struct in_addr));
 	ip_packet->ihl = 5;
 	ip_packet->version = 4;
@@ -27,6 +27,13 @@
 #include <netinet/ip.h>
 #include <netinet/udp.h>
 
+// Valid IPSC UDP payload sizes.
+#define IPSC_PACKET_SIZE1								72
+#define IPSC_PACKET_SIZE2								103
+// Heartbeat packets have these bytes at this offset of the UDP payload.
+#define IPSC_HEARTBEAT_MAGIC_OFFSET						5
+#define IPSC_HEARTBEAT_MAGIC							{ 0x00, 0x00, 0x00, 0x14 }
+
 #define IPSCPACKET_SLOT_TYPE_VOICE_LC_HEADER				0x1111
 #define IPSCPACKET_SLOT_TYPE_TERMINATOR_WITH_LC				0x2222
 #define IPSCPACKET_SLOT_TYPE_CSBK							0x3333
@@ -84,17 +91,10 @@ typedef struct {
 	dmr_id_t dst_id;
 	dmr_id_t src_id;
 	ipscpacket_payload_t payload;
-	dmrpacket_payload_bits_t payload_bits;
+	dmrpacket_payload_packed_bits_t payload_packed_bits;
 	uint8_t seq;
 } ipscpacket_t;
 
-typedef struct ipscrawpacketbuf_st {
-	ipscpacket_raw_t ipscpacket_raw;
-	flag_t nowait;
-
-	struct ipscrawpacketbuf_st *next;
-} ipscrawpacketbuf_t;
-
 char *ipscpacket_get_readable_slot_type(ipscpacket_slot_type_t slot_type);
 ipscpacket_slot_type_t ipscpacket_get_slot_type_for_data_type(dmrpacket_data_type_t data_type);
 
@@ -17,14 +17,19 @@
 
 #include DEFAULTCONFIG
 
+// To have sendmmsg() and struct mmsghdr definitions in sys/socket.h
+#define _GNU_SOURCE
+
 #include "repeaters.h"
 #include "comm.h"
 #include "snmp.h"
 #include "ipsc.h"
+#include "comm-hostset.h"
 
 #include <libs/daemon/console.h>
 #include <libs/daemon/daemon-poll.h>
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/remotedb/remotedb.h>
 #include <libs/base/dmr-handle.h>
 #include <libs/base/base.h>
@@ -39,8 +44,231 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
 
 static repeater_t *repeaters = NULL;
+static comm_hostset_t *repeaters_snmpignoredhosts = NULL;
+
+// Raw socket used for sending IPSC packets to the repeaters. We need to use a raw socket, because
+// if the master software is running, we can't bind to the source port to set it in our UDP packet.
+static int repeaters_tx_sockfd = -1;
+
+// IPSC packets are sent with IPSC_PACKET_SEND_INTERVAL_IN_MS pacing. This timer is armed to the
+// earliest due time of the repeaters having packets in their tx buffers, so the main loop sleeps until then.
+static int repeaters_tx_timerfd = -1;
+static uint64_t repeaters_tx_timer_armed_usec = 0; // 0 if the timer is not armed.
+
+// Packets due in the same repeaters_process() run are collected here, and sent with one sendmmsg() call.
+typedef struct {
+	repeater_t *repeater;
+	dmr_timeslot_t ts;
+	repeater_ipsc_tx_queue_entry_t *entry;
+} repeaters_tx_batch_entry_t;
+
+static repeaters_tx_batch_entry_t repeaters_tx_batch[REPEATERS_TX_BATCH_SIZE];
+static struct mmsghdr repeaters_tx_batch_msgs[REPEATERS_TX_BATCH_SIZE];
+static struct iovec repeaters_tx_batch_iovecs[REPEATERS_TX_BATCH_SIZE];
+static struct sockaddr_in repeaters_tx_batch_addrs[REPEATERS_TX_BATCH_SIZE];
+static uint16_t repeaters_tx_batch_count = 0;
+
+// Removes the packets of the given repeater from the tx batch, and moves the remaining ones forward.
+static void repeaters_tx_batch_remove_repeater(repeater_t *repeater) {
+	uint16_t i;
+	uint16_t kept = 0;
+
+	for (i = 0; i < repeaters_tx_batch_count; i++) {
+		if (repeaters_tx_batch[i].repeater == repeater)
+			continue;
+
+		if (kept != i) {
+			repeaters_tx_batch[kept] = repeaters_tx_batch[i];
+			repeaters_tx_batch_iovecs[kept] = repeaters_tx_batch_iovecs[i];
+			repeaters_tx_batch_addrs[kept] = repeaters_tx_batch_addrs[i];
+			repeaters_tx_batch_msgs[kept] = repeaters_tx_batch_msgs[i];
+			repeaters_tx_batch_msgs[kept].msg_hdr.msg_name = &repeaters_tx_batch_addrs[kept];
+			repeaters_tx_batch_msgs[kept].msg_hdr.msg_iov = &repeaters_tx_batch_iovecs[kept];
+		}
+		kept++;
+	}
+	repeaters_tx_batch_count = kept;
+}
+
+// The repeaters list is indexed by IP address (open addressing, linear probing), by callsign, and the
+// slots with a running call by (src_id, dst_id, call_type) and by (timeslot, src_id). This way the lookups
+// done for every packet don't have to walk the whole list.
+static repeater_t **repeaters_iphash = NULL;
+static uint32_t repeaters_iphash_size = 0;
+static uint32_t repeaters_iphash_count = 0;
+static repeater_t *repeaters_callsignhash[REPEATERS_CALLSIGNHASH_SIZE];
+static repeater_slot_t *repeaters_activecallhash[REPEATERS_ACTIVECALLHASH_SIZE];
+static repeater_slot_t *repeaters_activesrchash[REPEATERS_ACTIVECALLHASH_SIZE];
+
+static uint32_t repeaters_hash(uint32_t value) {
+	value *= 2654435761u;
+	return value ^ (value >> 16);
+}
+
+static uint32_t repeaters_iphash_home(struct in_addr *ipaddr) {
+	return repeaters_hash(ipaddr->s_addr) & (repeaters_iphash_size-1);
+}
+
+static void repeaters_iphash_insert(repeater_t *repeater) {
+	uint32_t i = repeaters_iphash_home(&repeater->ipaddr);
+
+	while (repeaters_iphash[i] != NULL)
+		i = (i+1) & (repeaters_iphash_size-1);
+	repeaters_iphash[i] = repeater;
+	repeaters_iphash_count++;
+}
+
+// Makes sure there's room for a new entry in the IP hash. The table is kept at most half full.
+static flag_t repeaters_iphash_reserve(void) {
+	repeater_t **old_table = repeaters_iphash;
+	uint32_t old_size = repeaters_iphash_size;
+	uint32_t new_size;
+	uint32_t i;
+
+	if ((repeaters_iphash_count+1)*2 <= repeaters_iphash_size)
+		return 1;
+
+	new_size = (old_size == 0 ? REPEATERS_IPHASH_MIN_SIZE : old_size*2);
+	repeaters_iphash = (repeater_t **)calloc(new_size, sizeof(repeater_t *));
+	if (repeaters_iphash == NULL) {
+		repeaters_iphash = old_table;
+		return 0;
+	}
+	repeaters_iphash_size = new_size;
+	repeaters_iphash_count = 0;
+
+	for (i = 0; i < old_size; i++) {
+		if (old_table[i] != NULL)
+			repeaters_iphash_insert(old_table[i]);
+	}
+	free(old_table);
+	return 1;
+}
+
+static void repeaters_iphash_remove(repeater_t *repeater) {
+	uint32_t i;
+	uint32_t j;
+	uint32_t home;
+
+	if (repeaters_iphash == NULL)
+		return;
+
+	i = repeaters_iphash_home(&repeater->ipaddr);
+	while (repeaters_iphash[i] != repeater) {
+		if (repeaters_iphash[i] == NULL)
+			return;
+		i = (i+1) & (repeaters_iphash_size-1);
+	}
+
+	// Shifting back the following entries of the probe sequence, so we don't need tombstones.
+	j = i;
+	while (1) {
+		j = (j+1) & (repeaters_iphash_size-1);
+		if (repeaters_iphash[j] == NULL)
+			break;
+
+		home = repeaters_iphash_home(&repeaters_iphash[j]->ipaddr);
+		// If the entry's home is cyclically in (i, j], it can stay where it is.
+		if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j))
+			continue;
+
+		repeaters_iphash[i] = repeaters_iphash[j];
+		i = j;
+	}
+	repeaters_iphash[i] = NULL;
+	repeaters_iphash_count--;
+}
+
+static uint32_t repeaters_callsign_hash(char *callsign) {
+	uint32_t hash = 5381;
+
+	while (*callsign)
+		hash = hash*33 + tolower(*callsign++);
+	return repeaters_hash(hash) & (REPEATERS_CALLSIGNHASH_SIZE-1);
+}
+
+static void repeaters_callsign_unindex(repeater_t *repeater) {
+	repeater_t **entry;
+
+	if (!repeater->callsign_indexed)
+		return;
+
+	for (entry = &repeaters_callsignhash[repeater->callsign_bucket]; *entry != NULL; entry = &(*entry)->callsign_next) {
+		if (*entry == repeater) {
+			*entry = repeater->callsign_next;
+			break;
+		}
+	}
+	repeater->callsign_next = NULL;
+	repeater->callsign_indexed = 0;
+}
+
+static void repeaters_callsign_index(repeater_t *repeater) {
+	repeaters_callsign_unindex(repeater);
+
+	if (repeater->callsign[0] == 0)
+		return;
+
+	repeater->callsign_bucket = repeaters_callsign_hash(repeater->callsign);
+	repeater->callsign_next = repeaters_callsignhash[repeater->callsign_bucket];
+	repeaters_callsignhash[repeater->callsign_bucket] = repeater;
+	repeater->callsign_indexed = 1;
+}
+
+static uint32_t repeaters_activecall_hash(dmr_id_t src_id, dmr_id_t dst_id, dmr_call_type_t call_type) {
+	// DMR IDs are 24 bits long.
+	return repeaters_hash(src_id ^ repeaters_hash(dst_id ^ ((uint32_t)call_type << 24))) & (REPEATERS_ACTIVECALLHASH_SIZE-1);
+}
+
+static uint32_t repeaters_activesrc_hash(dmr_timeslot_t ts, dmr_id_t src_id) {
+	return repeaters_hash(src_id ^ ((uint32_t)ts << 24)) & (REPEATERS_ACTIVECALLHASH_SIZE-1);
+}
+
+static void repeaters_slot_unindex(repeater_slot_t *slot) {
+	repeater_slot_t **entry;
+
+	if (!slot->active_call_indexed)
+		return;
+
+	for (entry = &repeaters_activecallhash[slot->active_call_bucket]; *entry != NULL; entry = &(*entry)->active_call_next) {
+		if (*entry == slot) {
+			*entry = slot->active_call_next;
+			break;
+		}
+	}
+	for (entry = &repeaters_activesrchash[slot->active_src_bucket]; *entry != NULL; entry = &(*entry)->active_src_next) {
+		if (*entry == slot) {
+			*entry = slot->active_src_next;
+			break;
+		}
+	}
+	slot->active_call_next = slot->active_src_next = NULL;
+	slot->active_call_indexed = 0;
+}
+
+// Updates the slot's active call index entries. Has to be called when the slot's state or call IDs change.
+static void repeaters_slot_index(repeater_slot_t *slot) {
+	repeaters_slot_unindex(slot);
+
+	if (slot->state == REPEATER_SLOT_STATE_IDLE)
+		return;
+
+	slot->active_call_bucket = repeaters_activecall_hash(slot->src_id, slot->dst_id, slot->call_type);
+	slot->active_call_next = repeaters_activecallhash[slot->active_call_bucket];
+	repeaters_activecallhash[slot->active_call_bucket] = slot;
+
+	slot->active_src_bucket = repeaters_activesrc_hash(slot->ts, slot->src_id);
+	slot->active_src_next = repeaters_activesrchash[slot->active_src_bucket];
+	repeaters_activesrchash[slot->active_src_bucket] = slot;
+
+	slot->active_call_indexed = 1;
+}
 
 static char *repeaters_get_readable_slot_state(repeater_slot_state_t state) {
 	switch (state) {
@@ -75,16 +303,17 @@ char *repeaters_get_display_string(repeater_t *repeater) {
 }
 
 repeater_t *repeaters_findbyip(struct in_addr *ipaddr) {
-	repeater_t *repeater = repeaters;
+	uint32_t i;
 
-	if (ipaddr == NULL)
+	if (ipaddr == NULL || repeaters_iphash == NULL)
 		return NULL;
 
-	while (repeater) {
-		if (memcmp(&repeater->ipaddr, ipaddr, sizeof(struct in_addr)) == 0)
-			return repeater;
+	i = repeaters_iphash_home(ipaddr);
+	while (repeaters_iphash[i] != NULL) {
+		if (repeaters_iphash[i]->ipaddr.s_addr == ipaddr->s_addr)
+			return repeaters_iphash[i];
 
-		repeater = repeater->next;
+		i = (i+1) & (repeaters_iphash_size-1);
 	}
 	return NULL;
 }
@@ -99,59 +328,29 @@ repeater_t *repeaters_findbyhost(char *host) {
 }
 
 repeater_t *repeaters_findbycallsign(char *callsign) {
-	repeater_t *repeater = repeaters;
+	repeater_t *repeater;
 
-	if (callsign == NULL)
+	if (callsign == NULL || callsign[0] == 0)
 		return NULL;
 
-	while (repeater) {
+	for (repeater = repeaters_callsignhash[repeaters_callsign_hash(callsign)]; repeater != NULL; repeater = repeater->callsign_next) {
 		if (strcasecmp(repeater->callsign, callsign) == 0)
 			return repeater;
-
-		repeater = repeater->next;
 	}
 	return NULL;
 }
 
 repeater_t *repeaters_get_active(dmr_id_t src_id, dmr_id_t dst_id, dmr_call_type_t call_type) {
-	repeater_t *repeater = repeaters;
+	repeater_slot_t *slot;
 
-	while (repeater) {
-		if ((repeater->slot[0].state != REPEATER_SLOT_STATE_IDLE && repeater->slot[0].src_id == src_id && repeater->slot[0].dst_id == dst_id && repeater->slot[0].call_type == call_type) ||
-			(repeater->slot[1].state != REPEATER_SLOT_STATE_IDLE && repeater->slot[1].src_id == src_id && repeater->slot[1].dst_id == dst_id && repeater->slot[1].call_type == call_type))
-				return repeater;
-
-		repeater = repeater->next;
+	for (slot = repeaters_activecallhash[repeaters_activecall_hash(src_id, dst_id, call_type)]; slot != NULL; slot = slot->active_call_next) {
+		if (slot->state != REPEATER_SLOT_STATE_IDLE && slot->src_id == src_id && slot->dst_id == dst_id && slot->call_type == call_type)
+			return slot->repeater;
 	}
 	return NULL;
 }
 
-static flag_t repeaters_issnmpignoredforip(struct in_addr *ipaddr) {
-	char *ignoredhosts = config_get_ignoredsnmprepeaterhosts();
-	char *tok = NULL;
-	struct in_addr ignoredaddr;
-
-	tok = strtok(ignoredhosts, ",");
-	if (tok) {
-		do {
-			if (comm_hostname_to_ip(tok, &ignoredaddr)) {
-				if (memcmp(&ignoredaddr, ipaddr, sizeof(struct in_addr)) == 0) {
-					free(ignoredhosts);
-					return 1;
-				}
-			} else
-				console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters: can't resolve hostname %s\n", tok);
-
-			tok = strtok(NULL, ",");
-		} while (tok != NULL);
-	}
-	free(ignoredhosts);
-	return 0;
-}
-
 static void repeaters_remove(repeater_t *repeater) {
-	ipscrawpacketbuf_t *pb_nextentry;
-
 	if (repeater == NULL)
 		return;
 
@@ -165,17 +364,18 @@ static void repeaters_remove(repeater_t *repeater) {
 	repeaters_free_echo_buf(repeater, 0);
 	repeaters_free_echo_buf(repeater, 1);
 
-	// Freeing up IPSC packet buffers for both slots.
-	while (repeater->slot[0].ipsc_tx_rawpacketbuf) {
-		pb_nextentry = repeater->slot[0].ipsc_tx_rawpacketbuf->next;
-		free(repeater->slot[0].ipsc_tx_rawpacketbuf);
-		repeater->slot[0].ipsc_tx_rawpacketbuf = pb_nextentry;
-	}
-	while (repeater->slot[1].ipsc_tx_rawpacketbuf) {
-		pb_nextentry = repeater->slot[1].ipsc_tx_rawpacketbuf->next;
-		free(repeater->slot[1].ipsc_tx_rawpacketbuf);
-		repeater->slot[1].ipsc_tx_rawpacketbuf = pb_nextentry;
-	}
+	repeaters_slot_unindex(&repeater->slot[0]);
+	repeaters_slot_unindex(&repeater->slot[1]);
+	repeaters_callsign_unindex(repeater);
+	repeaters_iphash_remove(repeater);
+
+	// Dropping the repeater's packets from the not yet sent tx batch, as their iovecs point into the
+	// tx buffers freed below.
+	repeaters_tx_batch_remove_repeater(repeater);
+
+	// Freeing up IPSC packet queues for both slots.
+	free(repeater->slot[0].ipsc_tx_queue.entries);
+	free(repeater->slot[1].ipsc_tx_queue.entries);
 
 	if (repeater->prev)
 		repeater->prev->next = repeater->next;
@@ -188,6 +388,27 @@ static void repeaters_remove(repeater_t *repeater) {
 	free(repeater);
 }
 
+// The master is never queried through SNMP.
+static flag_t repeaters_is_snmpignored(struct in_addr *ipaddr) {
+	return (comm_is_masteripaddr(ipaddr) || comm_hostset_contains(repeaters_snmpignoredhosts, ipaddr));
+}
+
+// Re-evaluates the snmpignored flag of all repeaters. Called when the ignored SNMP repeater host set
+// has been updated by the resolver, as repeaters may have been added before their host names were resolved.
+void repeaters_update_snmpignored(void) {
+	repeater_t *repeater;
+	flag_t snmpignored;
+
+	for (repeater = repeaters; repeater != NULL; repeater = repeater->next) {
+		snmpignored = repeaters_is_snmpignored(&repeater->ipaddr);
+		if (snmpignored == repeater->snmpignored)
+			continue;
+
+		repeater->snmpignored = snmpignored;
+		console_log(LOGLEVEL_REPEATERS "repeaters [%s]: snmp %s\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), snmpignored ? "ignored" : "not ignored anymore");
+	}
+}
+
 repeater_t *repeaters_add(struct in_addr *ipaddr) {
 	flag_t error = 0;
 	repeater_t *repeater = repeaters_findbyip(ipaddr);
@@ -196,12 +417,20 @@ repeater_t *repeaters_add(struct in_addr *ipaddr) {
 		return NULL;
 
 	if (repeater == NULL) {
+		if (!repeaters_iphash_reserve()) {
+			console_log("repeaters [%s]: can't add new repeater, not enough memory for the ip hash\n", comm_get_ip_str(ipaddr));
+			return NULL;
+		}
+
 		repeater = (repeater_t *)calloc(sizeof(repeater_t), 1);
 		if (repeater == NULL) {
 			console_log("repeaters [%s]: can't add new repeater, not enough memory\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
 			return NULL;
 		}
 		memcpy(&repeater->ipaddr, ipaddr, sizeof(struct in_addr));
+		repeater->slot[0].repeater = repeater->slot[1].repeater = repeater;
+		repeater->slot[0].ts = 0;
+		repeater->slot[1].ts = 1;
 
 		// Expecting 8 rows of variable length BPTC coded embedded LC data.
 		// It will contain 77 data bits (without the Hamming (16,11) checksums
@@ -220,8 +449,7 @@ repeater_t *repeaters_add(struct in_addr *ipaddr) {
 			return NULL;
 		}
 
-		if (repeaters_issnmpignoredforip(ipaddr))
-			repeater->snmpignored = 1;
+		repeater->snmpignored = repeaters_is_snmpignored(ipaddr);
 
 		repeater->slot[0].voicestream = voicestreams_get_stream_for_repeater(ipaddr, 1);
 #ifdef AMBEDECODEVOICE
@@ -236,6 +464,7 @@ repeater_t *repeaters_add(struct in_addr *ipaddr) {
 			repeater->next = repeaters;
 		}
 		repeaters = repeater;
+		repeaters_iphash_insert(repeater);
 
 		console_log("repeaters [%s]: added, snmp ignored: %u ts1 stream: %s ts2 stream: %s\n",
 			repeaters_get_display_string_for_ip(&repeater->ipaddr), repeater->snmpignored,
@@ -285,6 +514,7 @@ void repeaters_state_change(repeater_t *repeater, dmr_timeslot_t timeslot, repea
 		repeaters_get_display_string_for_ip(&repeater->ipaddr), timeslot+1, repeaters_get_readable_slot_state(repeater->slot[timeslot].state),
 		repeaters_get_readable_slot_state(new_state));
 	repeater->slot[timeslot].state = new_state;
+	repeaters_slot_index(&repeater->slot[timeslot]);
 
 	if (repeater->auto_rssi_update_enabled_at != 0 &&
 		repeater->slot[0].state != REPEATER_SLOT_STATE_VOICE_CALL_RUNNING &&
@@ -294,65 +524,281 @@ void repeaters_state_change(repeater_t *repeater, dmr_timeslot_t timeslot, repea
 	}
 }
 
+void repeaters_set_call(repeater_t *repeater, dmr_timeslot_t timeslot, dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
+	repeater->slot[timeslot].call_type = call_type;
+	repeater->slot[timeslot].dst_id = dst_id;
+	repeater->slot[timeslot].src_id = src_id;
+	repeaters_slot_index(&repeater->slot[timeslot]);
+}
+
+void repeaters_set_callsign(repeater_t *repeater, char *callsign) {
+	int i;
+
+	for (i = 0; callsign[i] && i < sizeof(repeater->callsign)-1; i++) {
+		repeater->callsign[i] = callsign[i];
+		repeater->callsign_lowercase[i] = tolower(callsign[i]);
+	}
+	repeater->callsign[i] = 0;
+	repeater->callsign_lowercase[i] = 0;
+	repeaters_callsign_index(repeater);
+}
+
+static uint64_t repeaters_get_monotonic_usec(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000+ts.tv_nsec/1000;
+}
+
+static flag_t repeaters_has_ipsc_tx_packets(repeater_t *repeater) {
+	return (repeater->slot[0].ipsc_tx_queue.count > 0 || repeater->slot[1].ipsc_tx_queue.count > 0);
+}
+
+static repeater_ipsc_tx_queue_entry_t *repeaters_ipsc_tx_queue_first(repeater_ipsc_tx_queue_t *queue) {
+	if (queue->count == 0)
+		return NULL;
+
+	return &queue->entries[queue->head];
+}
+
+static void repeaters_ipsc_tx_queue_remove_first(repeater_ipsc_tx_queue_t *queue) {
+	if (queue->count == 0)
+		return;
+
+	queue->head = (queue->head+1) % queue->size;
+	queue->count--;
+}
+
+// Doubles the size of the queue, unwrapping the entries to the start of the new array. The tx batch
+// may point to the first entry of the queue, so it's moved to the new array.
+static flag_t repeaters_ipsc_tx_queue_grow(repeater_t *repeater, dmr_timeslot_t ts) {
+	repeater_ipsc_tx_queue_t *queue = &repeater->slot[ts].ipsc_tx_queue;
+	repeater_ipsc_tx_queue_entry_t *entries;
+	uint32_t size;
+	uint32_t first_part;
+	uint32_t index;
+	uint16_t i;
+
+	if (queue->size > UINT32_MAX/2/sizeof(repeater_ipsc_tx_queue_entry_t))
+		return 0;
+
+	size = queue->size*2;
+	entries = (repeater_ipsc_tx_queue_entry_t *)malloc(size*sizeof(repeater_ipsc_tx_queue_entry_t));
+	if (entries == NULL)
+		return 0;
+
+	first_part = min(queue->count, queue->size-queue->head);
+	memcpy(entries, &queue->entries[queue->head], first_part*sizeof(repeater_ipsc_tx_queue_entry_t));
+	memcpy(&entries[first_part], queue->entries, (queue->count-first_part)*sizeof(repeater_ipsc_tx_queue_entry_t));
+
+	for (i = 0; i < repeaters_tx_batch_count; i++) {
+		if (repeaters_tx_batch[i].repeater != repeater || repeaters_tx_batch[i].ts != ts)
+			continue;
+
+		index = (repeaters_tx_batch[i].entry-queue->entries+queue->size-queue->head) % queue->size;
+		repeaters_tx_batch[i].entry = &entries[index];
+		repeaters_tx_batch_iovecs[i].iov_base = entries[index].ipscpacket_raw.bytes;
+	}
+
+	free(queue->entries);
+	queue->entries = entries;
+	queue->size = size;
+	queue->head = 0;
+
+	console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: ts%u ipsc packet queue grown to %u entries\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), ts+1, size);
+	return 1;
+}
+
+static flag_t repeaters_ipsc_tx_queue_add(repeater_t *repeater, dmr_timeslot_t ts, ipscpacket_raw_t *ipscpacket_raw, flag_t nowait) {
+	repeater_ipsc_tx_queue_t *queue = &repeater->slot[ts].ipsc_tx_queue;
+	repeater_ipsc_tx_queue_entry_t *entry;
+	int size;
+
+	if (queue->entries == NULL) {
+		size = config_get_ipsctxqueuesize();
+		if (size < 1)
+			size = 1;
+
+		queue->entries = (repeater_ipsc_tx_queue_entry_t *)malloc(size*sizeof(repeater_ipsc_tx_queue_entry_t));
+		if (queue->entries == NULL) {
+			console_log(LOGLEVEL_REPEATERS "repeaters [%s] error: couldn't allocate memory for the ts%u ipsc packet queue\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), ts+1);
+			return 0;
+		}
+		queue->size = size;
+		queue->head = queue->count = 0;
+	}
+
+	// Long echo or AMBE file playbacks are queued at once, so the queue grows to fit them.
+	if (queue->count == queue->size && !repeaters_ipsc_tx_queue_grow(repeater, ts)) {
+		queue->overflows++;
+		console_log(LOGLEVEL_REPEATERS "repeaters [%s] error: ts%u ipsc packet queue is full and can't grow, dropping packet\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), ts+1);
+		return 0;
+	}
+
+	entry = &queue->entries[(queue->head+queue->count) % queue->size];
+	memcpy(&entry->ipscpacket_raw, ipscpacket_raw, sizeof(ipscpacket_raw_t));
+	entry->nowait = nowait;
+	queue->count++;
+	if (queue->count > queue->high_water_mark)
+		queue->high_water_mark = queue->count;
+
+	return 1;
+}
+
+// Makes sure the main loop wakes up at the given time to send IPSC packets.
+static void repeaters_tx_timer_arm(uint64_t due_usec) {
+	struct itimerspec its;
+	uint64_t now;
+
+	if (repeaters_tx_timerfd < 0) {
+		// No timer, falling back to the poll timeout.
+		now = repeaters_get_monotonic_usec();
+		daemon_poll_setmaxtimeout(due_usec > now ? (due_usec-now+999)/1000 : 0);
+		return;
+	}
+
+	if (repeaters_tx_timer_armed_usec != 0 && repeaters_tx_timer_armed_usec <= due_usec)
+		return;
+
+	// A zero it_value would disarm the timer.
+	if (due_usec == 0)
+		due_usec = 1;
+
+	memset(&its, 0, sizeof(struct itimerspec));
+	its.it_value.tv_sec = due_usec/1000000;
+	its.it_value.tv_nsec = (due_usec%1000000)*1000;
+	if (timerfd_settime(repeaters_tx_timerfd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+		console_log(LOGLEVEL_REPEATERS "repeaters error: can't arm tx timer: %s\n", strerror(errno));
+		daemon_poll_setmaxtimeout(0);
+		return;
+	}
+	repeaters_tx_timer_armed_usec = due_usec;
+}
+
 void repeaters_add_to_ipsc_packet_buffer(repeater_t *repeater, dmr_timeslot_t ts, ipscpacket_raw_t *ipscpacket_raw, flag_t nowait) {
-	ipscrawpacketbuf_t *newpbentry;
-	ipscrawpacketbuf_t *pbentry;
+	flag_t was_idle;
+	uint64_t now;
 
 	if (repeater == NULL || ipscpacket_raw == NULL)
 		return;
 
 	console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: adding entry to ts%u ipsc packet buffer\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), ts+1);
 
-	newpbentry = (ipscrawpacketbuf_t *)calloc(1, sizeof(ipscrawpacketbuf_t));
-	if (newpbentry == NULL) {
-		console_log(LOGLEVEL_REPEATERS "repeaters [%s] error: couldn't allocate memory for new ipsc packet buffer entry\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
+	was_idle = !repeaters_has_ipsc_tx_packets(repeater);
+	if (!repeaters_ipsc_tx_queue_add(repeater, ts, ipscpacket_raw, nowait))
 		return;
+
+	// If the repeater was idle, its due time is in the past, so we start pacing from now.
+	if (was_idle) {
+		now = repeaters_get_monotonic_usec();
+		if (repeater->ipsc_tx_next_due_usec < now)
+			repeater->ipsc_tx_next_due_usec = now;
 	}
 
-	memcpy(&newpbentry->ipscpacket_raw, ipscpacket_raw, sizeof(ipscpacket_raw_t));
-	newpbentry->nowait = nowait;
+	repeaters_tx_timer_arm(repeater->ipsc_tx_next_due_usec);
+}
+
+static flag_t repeaters_tx_socket_open(void) {
+	if (repeaters_tx_sockfd >= 0)
+		return 1;
+
+	if ((repeaters_tx_sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW)) == -1) {
+		console_log(LOGLEVEL_REPEATERS "repeaters error: can't create raw socket for sending ipsc packets: %s\n", strerror(errno));
+		return 0;
+	}
+	return 1;
+}
+
+// Adds the first packet of the given slot's tx buffer to the tx batch. The packet stays in the
+// tx buffer until it's sent by repeaters_tx_batch_flush().
+static void repeaters_tx_batch_add(repeater_t *repeater, dmr_timeslot_t ts) {
+	repeaters_tx_batch_entry_t *batch_entry;
+	struct sockaddr_in *sin;
+
+	if (repeaters_tx_batch_count == REPEATERS_TX_BATCH_SIZE)
+		return;
+
+	batch_entry = &repeaters_tx_batch[repeaters_tx_batch_count];
+	batch_entry->repeater = repeater;
+	batch_entry->ts = ts;
+	batch_entry->entry = repeaters_ipsc_tx_queue_first(&repeater->slot[ts].ipsc_tx_queue);
+
+	sin = &repeaters_tx_batch_addrs[repeaters_tx_batch_count];
+	memset(sin, 0, sizeof(struct sockaddr_in));
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(62006);
+	memcpy(&sin->sin_addr, &repeater->ipaddr, sizeof(struct in_addr));
 
-	pbentry = repeater->slot[ts].ipsc_tx_rawpacketbuf;
-	if (pbentry == NULL)
-		repeater->slot[ts].ipsc_tx_rawpacketbuf = newpbentry;
-	else {
-		// Searching for the last element in the packet buffer.
-		while (pbentry->next)
-			pbentry = pbentry->next;
-		pbentry->next = newpbentry;
+	repeaters_tx_batch_iovecs[repeaters_tx_batch_count].iov_base = batch_entry->entry->ipscpacket_raw.bytes;
+	repeaters_tx_batch_iovecs[repeaters_tx_batch_count].iov_len = sizeof(ipscpacket_raw_t);
+
+	memset(&repeaters_tx_batch_msgs[repeaters_tx_batch_count], 0, sizeof(struct mmsghdr));
+	repeaters_tx_batch_msgs[repeaters_tx_batch_count].msg_hdr.msg_name = sin;
+	repeaters_tx_batch_msgs[repeaters_tx_batch_count].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	repeaters_tx_batch_msgs[repeaters_tx_batch_count].msg_hdr.msg_iov = &repeaters_tx_batch_iovecs[repeaters_tx_batch_count];
+	repeaters_tx_batch_msgs[repeaters_tx_batch_count].msg_hdr.msg_iovlen = 1;
+
+	repeaters_tx_batch_count++;
+}
+
+static void repeaters_tx_batch_sent(repeaters_tx_batch_entry_t *batch_entry, int error) {
+	repeater_t *repeater = batch_entry->repeater;
+	dmr_timeslot_t ts = batch_entry->ts;
+
+	if (error) {
+		repeater->ipsc_tx_send_errors++;
+		repeater->ipsc_tx_last_errno = error;
+		console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: can't send udp packet: %s\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), strerror(error));
+		return;
 	}
 
-	daemon_poll_setmaxtimeout(0);
+	repeater->ipsc_tx_packets_sent++;
+	if (repeaters_ipsc_tx_queue_first(&repeater->slot[ts].ipsc_tx_queue) != batch_entry->entry)
+		return;
+
+	// Sending the packet to our IPSC processing loop too.
+	//ipsc_processpacket(&batch_entry->entry->ipscpacket_raw, sizeof(ipscpacket_raw_t));
+
+	repeaters_ipsc_tx_queue_remove_first(&repeater->slot[ts].ipsc_tx_queue);
+
+	if (repeater->slot[ts].ipsc_tx_queue.count == 0)
+		console_log(LOGLEVEL_REPEATERS "repeaters [%s]: tx packet buffer got empty\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
 }
 
-// Sends given raw IPSC packet to the given repeater.
-static flag_t repeaters_send_raw_ipsc_packet(repeater_t *repeater, ipscpacket_raw_t *ipscpacket_raw) {
-	struct sockaddr_in sin;
-	int sockfd;
+// Sends all packets in the tx batch.
+static void repeaters_tx_batch_flush(void) {
+	uint16_t sent = 0;
+	int result;
+	int i;
 
-	if (repeater == NULL || ipscpacket_raw == NULL)
-		return 0;
+	if (repeaters_tx_batch_count == 0)
+		return;
 
-	// Need to use raw socket here, because if the master software is running,
-	// we can't bind to the source port to set it in our UDP packet.
-	if ((sockfd = socket(AF_INET, SOCK_RAW, IPPROTO_RAW)) == -1) {
-		console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: can't create raw socket for sending an udp packet\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
-		return 0;
+	if (!repeaters_tx_socket_open()) {
+		for (i = 0; i < repeaters_tx_batch_count; i++)
+			repeaters_tx_batch_sent(&repeaters_tx_batch[i], errno);
+		repeaters_tx_batch_count = 0;
+		return;
 	}
 
-	memset(&sin, 0, sizeof(struct sockaddr_in));
-	sin.sin_family = AF_INET;
-	sin.sin_port = htons(62006);
-	memcpy(&sin.sin_addr, &repeater->ipaddr, sizeof(struct in_addr));
+	while (sent < repeaters_tx_batch_count) {
+		result = sendmmsg(repeaters_tx_sockfd, &repeaters_tx_batch_msgs[sent], repeaters_tx_batch_count-sent, MSG_DONTWAIT);
+		if (result <= 0) {
+			// The first packet failed, skipping it and trying again with the rest.
+			repeaters_tx_batch_sent(&repeaters_tx_batch[sent], (result < 0 ? errno : EAGAIN));
+			sent++;
+			continue;
+		}
 
-	errno = 0;
-	if (sendto(sockfd, ipscpacket_raw->bytes, sizeof(ipscpacket_raw_t), MSG_DONTWAIT, (struct sockaddr *)&sin, sizeof(struct sockaddr_in)) != sizeof(ipscpacket_raw_t)) {
-		console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: can't send udp packet: %s\n", repeaters_get_display_string_for_ip(&repeater->ipaddr), strerror(errno));
-		close(sockfd);
-		return 0;
+		for (i = 0; i < result; i++) {
+			if (repeaters_tx_batch_msgs[sent+i].msg_len == sizeof(ipscpacket_raw_t))
+				repeaters_tx_batch_sent(&repeaters_tx_batch[sent+i], 0);
+			else
+				repeaters_tx_batch_sent(&repeaters_tx_batch[sent+i], EMSGSIZE);
+		}
+		sent += result;
 	}
-	close(sockfd);
-	return 1;
+	repeaters_tx_batch_count = 0;
 }
 
 void repeaters_send_ipsc_sync(repeater_t *repeater, dmr_timeslot_t ts, dmr_call_type_t calltype, dmr_id_t dstid, dmr_id_t srcid) {
@@ -511,7 +957,7 @@ void repeaters_store_voice_frame_to_echo_buf(repeater_t *repeater, ipscpacket_t
 	console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: storing ts%u voice frame to echo buf\n", repeaters_get_display_string_for_ip(&repeater->ipaddr),
 		ipscpacket->timeslot);
 
-	voice_bits = dmrpacket_extract_voice_bits(&ipscpacket->payload_bits);
+	voice_bits = dmrpacket_extract_voice_bits_from_packed(&ipscpacket->payload_packed_bits);
 	base_bitstobytes(voice_bits->raw.bits, sizeof(dmrpacket_payload_voice_bits_t), new_echo_buf_entry->voice_bytes.bytes, sizeof(dmrpacket_payload_voice_bits_t)/8);
 	new_echo_buf_entry->next = NULL;
 
@@ -635,7 +1081,6 @@ void repeaters_send_data_packet(repeater_t *repeater, dmr_timeslot_t ts, flag_t
 	}
 
 	free(data_blocks);
-	daemon_poll_setmaxtimeout(0);
 }
 
 void repeaters_send_broadcast_data_packet(dmrpacket_data_packet_t *data_packet) {
@@ -662,69 +1107,69 @@ flag_t repeaters_is_there_a_call_not_for_us_or_by_us(repeater_t *repeater, dmr_t
 }
 
 flag_t repeaters_is_call_running_on_other_repeater(repeater_t *current_repeater, dmr_timeslot_t ts, dmr_id_t srcid) {
-	repeater_t *repeater = repeaters;
+	repeater_slot_t *slot;
 
-	while (repeater) {
-		if (repeater != current_repeater && repeater->slot[ts].state != REPEATER_SLOT_STATE_IDLE && repeater->slot[ts].src_id == srcid)
-				return 1;
-
-		repeater = repeater->next;
+	for (slot = repeaters_activesrchash[repeaters_activesrc_hash(ts, srcid)]; slot != NULL; slot = slot->active_src_next) {
+		if (slot->repeater != current_repeater && slot->ts == ts && slot->state != REPEATER_SLOT_STATE_IDLE && slot->src_id == srcid)
+			return 1;
 	}
 	return 0;
 }
 
-static void repeaters_process_ipsc_tx_rawpacketbuf(repeater_t *repeater) {
-	struct timeval currtime = {0,};
-	struct timeval difftime = {0,};
-	ipscrawpacketbuf_t *ipsc_tx_rawpacketbuf_entry_to_send;
+// Moves the repeater's due time forward with one send interval. If we fell behind by more than
+// an interval, pacing restarts from now instead of sending the missed frames back to back.
+static void repeaters_ipsc_tx_advance_due_time(repeater_t *repeater, uint64_t now) {
+	repeater->ipsc_tx_next_due_usec += IPSC_PACKET_SEND_INTERVAL_IN_MS*1000;
+	if (repeater->ipsc_tx_next_due_usec <= now)
+		repeater->ipsc_tx_next_due_usec = now+IPSC_PACKET_SEND_INTERVAL_IN_MS*1000;
+}
+
+static void repeaters_process_ipsc_tx_queue(repeater_t *repeater, uint64_t now) {
+	repeater_ipsc_tx_queue_entry_t *entry;
 	dmr_timeslot_t ts;
 	flag_t nowait = 0;
+	uint32_t late_usec;
 
-	if (repeater == NULL)
+	if (repeater == NULL || !repeaters_has_ipsc_tx_packets(repeater))
 		return;
 
-	if (repeater->slot[0].ipsc_tx_rawpacketbuf != NULL || repeater->slot[1].ipsc_tx_rawpacketbuf != NULL)
-		daemon_poll_setmaxtimeout(0);
+	if (now < repeater->ipsc_tx_next_due_usec)
+		return;
 
 	if (repeater->last_ipsc_packet_sent_from_slot == 1)
 		ts = 0;
 	else
 		ts = 1;
 
-	gettimeofday(&currtime, NULL);
-	timersub(&currtime, &repeater->last_ipsc_packet_sent_time, &difftime);
-	if (difftime.tv_sec*1000+difftime.tv_usec/1000 < IPSC_PACKET_SEND_INTERVAL_IN_MS)
-		return;
-
-	if (repeater->slot[ts].ipsc_tx_rawpacketbuf != NULL && repeater->slot[ts].ipsc_tx_rawpacketbuf->nowait)
+	entry = repeaters_ipsc_tx_queue_first(&repeater->slot[ts].ipsc_tx_queue);
+	if (entry != NULL && entry->nowait)
 		nowait = 1;
 
 	if (nowait == 0)
 		repeater->last_ipsc_packet_sent_from_slot = ts;
 
-	if (repeater->slot[ts].ipsc_tx_rawpacketbuf == NULL) {
-		gettimeofday(&repeater->last_ipsc_packet_sent_time, NULL);
+	if (entry == NULL) {
+		repeaters_ipsc_tx_advance_due_time(repeater, now);
 		return;
 	}
 
-	if (repeaters_is_there_a_call_not_for_us_or_by_us(repeater, ts))
+	// Trying again in the next interval, instead of polling the slot state continuously.
+	if (repeaters_is_there_a_call_not_for_us_or_by_us(repeater, ts)) {
+		repeaters_ipsc_tx_advance_due_time(repeater, now);
 		return;
-
-	ipsc_tx_rawpacketbuf_entry_to_send = repeater->slot[ts].ipsc_tx_rawpacketbuf;
+	}
 
 	console_log(LOGLEVEL_REPEATERS "repeaters [%s]: sending ipsc packet from tx buffer\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
-	if (repeaters_send_raw_ipsc_packet(repeater, &ipsc_tx_rawpacketbuf_entry_to_send->ipscpacket_raw)) {
-		// Sending the packet to our IPSC processing loop too.
-		//ipsc_processpacket(&ipsc_tx_rawpacketbuf_entry_to_send->ipscpacket_raw, sizeof(ipscpacket_raw_t));
-
-		// Shifting the buffer.
-		repeater->slot[ts].ipsc_tx_rawpacketbuf = repeater->slot[ts].ipsc_tx_rawpacketbuf->next;
-		free(ipsc_tx_rawpacketbuf_entry_to_send);
+	repeaters_tx_batch_add(repeater, ts);
+	if (nowait == 0) {
+		late_usec = now-repeater->ipsc_tx_next_due_usec;
+		repeater->ipsc_tx_paced_count++;
+		repeater->ipsc_tx_late_usec_sum += late_usec;
+		if (late_usec > repeater->ipsc_tx_late_usec_max)
+			repeater->ipsc_tx_late_usec_max = late_usec;
+
+		repeaters_ipsc_tx_advance_due_time(repeater, now);
 	}
-	if (nowait == 0)
-		gettimeofday(&repeater->last_ipsc_packet_sent_time, NULL);
-	if (repeater->slot[ts].ipsc_tx_rawpacketbuf == NULL)
-		console_log(LOGLEVEL_REPEATERS "repeaters [%s]: tx packet buffer got empty\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
 }
 
 void repeaters_process(void) {
@@ -732,14 +1177,31 @@ void repeaters_process(void) {
 	repeater_t *repeater_to_remove;
 	struct timeval currtime = {0,};
 	struct timeval difftime = {0,};
+	uint64_t expirations;
+	uint64_t now;
+	uint64_t next_due_usec = 0;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
+
+	if (config_snapshot == NULL)
+		return;
+
+	if (repeaters_tx_timerfd >= 0 && daemon_poll_isfdreadable(repeaters_tx_timerfd)) {
+		if (read(repeaters_tx_timerfd, &expirations, sizeof(expirations)) > 0)
+			repeaters_tx_timer_armed_usec = 0;
+	}
+	now = repeaters_get_monotonic_usec();
+	if (repeaters_tx_timer_armed_usec != 0 && repeaters_tx_timer_armed_usec <= now)
+		repeaters_tx_timer_armed_usec = 0;
 
 	while (repeater) {
 		if (repeater->slot[0].state != REPEATER_SLOT_STATE_IDLE || repeater->slot[1].state != REPEATER_SLOT_STATE_IDLE)
 			daemon_poll_setmaxtimeout(IPSC_PACKET_SEND_INTERVAL_IN_MS);
 
-		repeaters_process_ipsc_tx_rawpacketbuf(repeater);
+		repeaters_process_ipsc_tx_queue(repeater, now);
+		if (repeaters_has_ipsc_tx_packets(repeater) && (next_due_usec == 0 || repeater->ipsc_tx_next_due_usec < next_due_usec))
+			next_due_usec = repeater->ipsc_tx_next_due_usec;
 
-		if (!comm_is_masteripaddr(&repeater->ipaddr) && time(NULL)-repeater->last_active_time > config_get_repeaterinactivetimeoutinsec()) {
+		if (!comm_is_masteripaddr(&repeater->ipaddr) && time(NULL)-repeater->last_active_time > config_snapshot->repeaterinactivetimeoutinsec) {
 			console_log(LOGLEVEL_REPEATERS "repeaters [%s]: timed out\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
 			repeater_to_remove = repeater;
 			repeater = repeater->next;
@@ -747,37 +1209,112 @@ void repeaters_process(void) {
 			continue;
 		}
 
-		if (!repeater->snmpignored && config_get_repeaterinfoupdateinsec() > 0 && time(NULL)-repeater->last_repeaterinfo_request_time > config_get_repeaterinfoupdateinsec()) {
+		if (!repeater->snmpignored && config_snapshot->repeaterinfoupdateinsec > 0 && time(NULL)-repeater->last_repeaterinfo_request_time > config_snapshot->repeaterinfoupdateinsec) {
 			console_log(LOGLEVEL_REPEATERS LOGLEVEL_DEBUG "repeaters [%s]: sending snmp info update request\n", repeaters_get_display_string_for_ip(&repeater->ipaddr));
 			snmp_start_read_repeaterinfo(comm_get_ip_str(&repeater->ipaddr));
 			repeater->last_repeaterinfo_request_time = time(NULL);
 		}
 
-		if (repeater->slot[0].state == REPEATER_SLOT_STATE_VOICE_CALL_RUNNING && time(NULL)-repeater->slot[0].last_call_or_data_packet_received_at > config_get_calltimeoutinsec())
+		if (repeater->slot[0].state == REPEATER_SLOT_STATE_VOICE_CALL_RUNNING && time(NULL)-repeater->slot[0].last_call_or_data_packet_received_at > config_snapshot->calltimeoutinsec)
 			dmr_handle_voice_call_timeout(repeater, 0);
 
-		if (repeater->slot[1].state == REPEATER_SLOT_STATE_VOICE_CALL_RUNNING && time(NULL)-repeater->slot[1].last_call_or_data_packet_received_at > config_get_calltimeoutinsec())
+		if (repeater->slot[1].state == REPEATER_SLOT_STATE_VOICE_CALL_RUNNING && time(NULL)-repeater->slot[1].last_call_or_data_packet_received_at > config_snapshot->calltimeoutinsec)
 			dmr_handle_voice_call_timeout(repeater, 1);
 
 		if (repeater->auto_rssi_update_enabled_at > 0 && repeater->auto_rssi_update_enabled_at <= time(NULL)) {
-			if (config_get_rssiupdateduringcallinmsec() > 0) {
+			if (config_snapshot->rssiupdateduringcallinmsec > 0) {
 				gettimeofday(&currtime, NULL);
 				timersub(&currtime, &repeater->last_rssi_request_time, &difftime);
-				if (difftime.tv_sec*1000+difftime.tv_usec/1000 > config_get_rssiupdateduringcallinmsec()) {
+				if (difftime.tv_sec*1000+difftime.tv_usec/1000 > config_snapshot->rssiupdateduringcallinmsec) {
 					snmp_start_read_repeaterstatus(comm_get_ip_str(&repeater->ipaddr));
 					repeater->last_rssi_request_time = currtime;
 				}
 			}
 		}
 
-		if (repeater->slot[0].state == REPEATER_SLOT_STATE_DATA_CALL_RUNNING && time(NULL)-repeater->slot[0].last_call_or_data_packet_received_at > config_get_datatimeoutinsec())
+		if (repeater->slot[0].state == REPEATER_SLOT_STATE_DATA_CALL_RUNNING && time(NULL)-repeater->slot[0].last_call_or_data_packet_received_at > config_snapshot->datatimeoutinsec)
 			dmr_handle_data_call_timeout(repeater, 0);
 
-		if (repeater->slot[1].state == REPEATER_SLOT_STATE_DATA_CALL_RUNNING && time(NULL)-repeater->slot[1].last_call_or_data_packet_received_at > config_get_datatimeoutinsec())
+		if (repeater->slot[1].state == REPEATER_SLOT_STATE_DATA_CALL_RUNNING && time(NULL)-repeater->slot[1].last_call_or_data_packet_received_at > config_snapshot->datatimeoutinsec)
 			dmr_handle_data_call_timeout(repeater, 1);
 
 		repeater = repeater->next;
 	}
+
+	repeaters_tx_batch_flush();
+
+	if (next_due_usec != 0)
+		repeaters_tx_timer_arm(next_due_usec);
+}
+
+void repeaters_print_tx_stats(void) {
+	repeater_t *repeater = repeaters;
+
+	if (repeaters == NULL) {
+		console_log("no repeaters found yet\n");
+		return;
+	}
+
+	console_log("repeater ipsc tx stats:\n");
+	console_log("               ip  callsign       sent     errors  avg late us  max late us  ts1/ts2 queued  ts1/ts2 max queued  ts1/ts2 overflows  last error\n");
+	while (repeater) {
+		console_log("  %15s %9s %10u %10u  %11u  %11u  %6u / %-6u  %8u / %-8u  %7u / %-7u  %s\n",
+			comm_get_ip_str(&repeater->ipaddr),
+			repeater->callsign,
+			repeater->ipsc_tx_packets_sent,
+			repeater->ipsc_tx_send_errors,
+			repeater->ipsc_tx_paced_count ? (uint32_t)(repeater->ipsc_tx_late_usec_sum/repeater->ipsc_tx_paced_count) : 0,
+			repeater->ipsc_tx_late_usec_max,
+			repeater->slot[0].ipsc_tx_queue.count, repeater->slot[1].ipsc_tx_queue.count,
+			repeater->slot[0].ipsc_tx_queue.high_water_mark, repeater->slot[1].ipsc_tx_queue.high_water_mark,
+			repeater->slot[0].ipsc_tx_queue.overflows, repeater->slot[1].ipsc_tx_queue.overflows,
+			repeater->ipsc_tx_send_errors ? strerror(repeater->ipsc_tx_last_errno) : "-");
+
+		repeater = repeater->next;
+	}
+}
+
+void repeaters_print_link_stats(void) {
+	repeater_t *repeater = repeaters;
+	uint8_t i;
+
+	if (repeaters == NULL) {
+		console_log("no repeaters found yet\n");
+		return;
+	}
+
+	console_log("repeater link quality stats:\n");
+	console_log("                                  slot type                                  emb\n");
+	console_log("               ip  callsign ts    received  corrected bits  uncorrectable    received   corrected  uncorrectable\n");
+	while (repeater) {
+		for (i = 0; i < 2; i++) {
+			console_log("  %15s %9s  %u  %10u  %14u  %13u  %10u  %10u  %13u\n",
+				comm_get_ip_str(&repeater->ipaddr),
+				repeater->callsign,
+				i+1,
+				repeater->slot[i].slot_type_received,
+				repeater->slot[i].slot_type_corrected_bits,
+				repeater->slot[i].slot_type_uncorrectable,
+				repeater->slot[i].emb_received,
+				repeater->slot[i].emb_corrected,
+				repeater->slot[i].emb_uncorrectable);
+		}
+
+		repeater = repeater->next;
+	}
+}
+
+void repeaters_init(void) {
+	console_log("repeaters: init\n");
+
+	repeaters_snmpignoredhosts = comm_hostset_register("ignoredsnmprepeaterhosts", config_get_ignoredsnmprepeaterhosts, repeaters_update_snmpignored);
+	repeaters_tx_socket_open();
+
+	repeaters_tx_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (repeaters_tx_timerfd < 0)
+		console_log("repeaters error: can't create tx timer, falling back to poll timeouts: %s\n", strerror(errno));
+	else
+		daemon_poll_addfd_read(repeaters_tx_timerfd);
 }
 
 void repeaters_deinit(void) {
@@ -785,4 +1322,20 @@ void repeaters_deinit(void) {
 
 	while (repeaters != NULL)
 		repeaters_remove(repeaters);
+
+	free(repeaters_iphash);
+	repeaters_iphash = NULL;
+	repeaters_iphash_size = repeaters_iphash_count = 0;
+
+	if (repeaters_tx_sockfd >= 0) {
+		close(repeaters_tx_sockfd);
+		repeaters_tx_sockfd = -1;
+	}
+
+	if (repeaters_tx_timerfd >= 0) {
+		daemon_poll_removefd(repeaters_tx_timerfd);
+		close(repeaters_tx_timerfd);
+		repeaters_tx_timerfd = -1;
+		repeaters_tx_timer_armed_usec = 0;
+	}
 }
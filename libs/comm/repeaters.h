@@ -34,13 +34,39 @@
 #define REPEATER_SLOT_STATE_DATA_CALL_RUNNING		2
 typedef uint8_t repeater_slot_state_t;
 
+// These must be powers of 2.
+#define REPEATERS_IPHASH_MIN_SIZE					64
+#define REPEATERS_CALLSIGNHASH_SIZE					256
+#define REPEATERS_ACTIVECALLHASH_SIZE				256
+
+// Maximum number of IPSC packets sent with one sendmmsg() call.
+#define REPEATERS_TX_BATCH_SIZE						64
+
+struct repeater_st;
+
+typedef struct {
+	ipscpacket_raw_t ipscpacket_raw;
+	flag_t nowait;
+} repeater_ipsc_tx_queue_entry_t;
+
+// Ring of IPSC packets waiting to be sent. Entries are allocated on the first enqueue, and the ring
+// doubles its size when it gets full.
+typedef struct {
+	repeater_ipsc_tx_queue_entry_t *entries;
+	uint32_t size;
+	uint32_t head; // Index of the first entry.
+	uint32_t count;
+	uint32_t high_water_mark;
+	uint32_t overflows; // Packets dropped because the ring couldn't grow.
+} repeater_ipsc_tx_queue_t;
+
 typedef struct repeater_echo_buf_st {
 	dmrpacket_payload_voice_bytes_t voice_bytes;
 
 	struct repeater_echo_buf_st *next;
 } repeater_echo_buf_t;
 
-typedef struct {
+typedef struct repeater_slot_st {
 	repeater_slot_state_t state;
 	int rssi;
 	int avg_rssi;
@@ -62,7 +88,7 @@ typedef struct {
 	uint8_t ipsc_last_received_seqnum;
 
 	// These variables are used for sending IPSC packets to the repeater.
-	ipscrawpacketbuf_t *ipsc_tx_rawpacketbuf;
+	repeater_ipsc_tx_queue_t ipsc_tx_queue;
 	uint8_t ipsc_tx_seqnum;
 	uint8_t ipsc_tx_voice_frame_num;
 	vbptc_16_11_t ipsc_tx_emb_sig_lc_vbptc_storage;
@@ -74,6 +100,23 @@ typedef struct {
 
 	repeater_echo_buf_t *echo_buf_first_entry;
 	repeater_echo_buf_t *echo_buf_last_entry;
+
+	// Link quality statistics.
+	uint32_t slot_type_received;
+	uint32_t slot_type_corrected_bits; // Bit errors corrected by the Golay(20,8) decoder.
+	uint32_t slot_type_uncorrectable;
+	uint32_t emb_received;
+	uint32_t emb_corrected; // EMB words with bit errors corrected by the QR(16,7) decoder.
+	uint32_t emb_uncorrectable;
+
+	// Active call index entries. The slot is in the indexes while its state is not idle.
+	struct repeater_st *repeater;
+	dmr_timeslot_t ts;
+	flag_t active_call_indexed;
+	uint32_t active_call_bucket;
+	uint32_t active_src_bucket;
+	struct repeater_slot_st *active_call_next; // Next slot in the same (src_id, dst_id, call_type) bucket.
+	struct repeater_slot_st *active_src_next; // Next slot in the same (timeslot, src_id) bucket.
 } repeater_slot_t;
 
 typedef struct repeater_st {
@@ -83,7 +126,7 @@ typedef struct repeater_st {
 	time_t last_repeaterinfo_request_time;
 	struct timeval last_rssi_request_time;
 	dmr_timeslot_t last_ipsc_packet_sent_from_slot;
-	struct timeval last_ipsc_packet_sent_time;
+	uint64_t ipsc_tx_next_due_usec; // CLOCK_MONOTONIC time when the next IPSC packet can be sent.
 	dmr_id_t id;
 	char type[25];
 	char fwversion[25];
@@ -99,6 +142,18 @@ typedef struct repeater_st {
 	repeater_slot_t slot[2];
 	time_t auto_rssi_update_enabled_at;
 
+	uint32_t ipsc_tx_packets_sent;
+	uint32_t ipsc_tx_send_errors;
+	int ipsc_tx_last_errno;
+	// Pacing statistics: how late paced packets were sent compared to their due time.
+	uint32_t ipsc_tx_paced_count;
+	uint64_t ipsc_tx_late_usec_sum;
+	uint32_t ipsc_tx_late_usec_max;
+
+	flag_t callsign_indexed;
+	uint32_t callsign_bucket;
+	struct repeater_st *callsign_next; // Next repeater in the same callsign index bucket.
+
 	struct repeater_st *next;
 	struct repeater_st *prev;
 } repeater_t;
@@ -113,9 +168,14 @@ repeater_t *repeaters_findbyhost(char *host);
 repeater_t *repeaters_findbycallsign(char *callsign);
 repeater_t *repeaters_get_active(dmr_id_t src_id, dmr_id_t dst_id, dmr_call_type_t call_type);
 repeater_t *repeaters_add(struct in_addr *ipaddr);
+void repeaters_update_snmpignored(void);
 void repeaters_list(void);
+void repeaters_print_tx_stats(void);
+void repeaters_print_link_stats(void);
 
 void repeaters_state_change(repeater_t *repeater, dmr_timeslot_t timeslot, repeater_slot_state_t new_state);
+void repeaters_set_call(repeater_t *repeater, dmr_timeslot_t timeslot, dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id);
+void repeaters_set_callsign(repeater_t *repeater, char *callsign);
 void repeaters_add_to_ipsc_packet_buffer(repeater_t *repeater, dmr_timeslot_t ts, ipscpacket_raw_t *ipscpacket_raw, flag_t nowait);
 
 void repeaters_send_ipsc_sync(repeater_t *repeater, dmr_timeslot_t ts, dmr_call_type_t calltype, dmr_id_t dstid, dmr_id_t srcid);
@@ -135,6 +195,7 @@ flag_t repeaters_is_there_a_call_not_for_us_or_by_us(repeater_t *repeater, dmr_t
 flag_t repeaters_is_call_running_on_other_repeater(repeater_t *current_repeater, dmr_timeslot_t ts, dmr_id_t srcid);
 
 void repeaters_process(void);
+void repeaters_init(void);
 void repeaters_deinit(void);
 
 #endif
@@ -0,0 +1,140 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "config-reload.h"
+#include "config.h"
+#include "config-snapshot.h"
+#include "config-voicestreams.h"
+#include "config-aprsobjs.h"
+
+#include <libs/daemon/console.h>
+#include <libs/daemon/console-logfile.h>
+#include <libs/comm/comm.h>
+#include <libs/comm/comm-hostset.h>
+#include <libs/comm/ipsc.h>
+#include <libs/comm/ipsc-tgfilter.h>
+#include <libs/voicestreams/voicestreams.h>
+#include <libs/aprs/aprs.h>
+
+#include <string.h>
+#include <signal.h>
+
+// Reloading the config file compares the previous and the new config snapshot, and only rebuilds
+// the lookup tables of the subsystems which are affected by the changed settings. Everything runs
+// in the main loop, and the rebuilt tables are swapped in one step, so packet processing doesn't see
+// a half-built table. Host name resolving is done by the host set resolver thread.
+
+extern volatile sig_atomic_t base_sighup_received;
+
+static flag_t config_reload_str_changed(const char *old_value, const char *new_value) {
+	if (old_value == NULL || new_value == NULL)
+		return (old_value != new_value);
+
+	return (strcmp(old_value, new_value) != 0);
+}
+
+#define CONFIG_RELOAD_INT_CHANGED(field)	(old_snapshot->field != new_snapshot->field)
+#define CONFIG_RELOAD_STR_CHANGED(field)	config_reload_str_changed(old_snapshot->field, new_snapshot->field)
+
+// Settings which are only read on startup.
+static void config_reload_check_restart_needed(const config_snapshot_t *old_snapshot, const config_snapshot_t *new_snapshot) {
+	if (CONFIG_RELOAD_STR_CHANGED(pidfilename))
+		console_log("config warning: pidfile change needs a restart\n");
+	if (CONFIG_RELOAD_STR_CHANGED(daemonctlfile))
+		console_log("config warning: daemonctlfile change needs a restart\n");
+	if (CONFIG_RELOAD_STR_CHANGED(ttyconsoledev) || CONFIG_RELOAD_INT_CHANGED(ttyconsoleenabled) || CONFIG_RELOAD_INT_CHANGED(ttyconsolebaudrate))
+		console_log("config warning: tty console changes need a restart\n");
+	if (CONFIG_RELOAD_STR_CHANGED(netdevicename) || CONFIG_RELOAD_STR_CHANGED(capturebackend))
+		console_log("config warning: capture device or backend change needs a restart\n");
+	if (CONFIG_RELOAD_INT_CHANGED(mmapblocksize) || CONFIG_RELOAD_INT_CHANGED(mmapblockcount) || CONFIG_RELOAD_INT_CHANGED(mmapblockretiretimeoutinms))
+		console_log("config warning: mmap capture ring changes need a restart\n");
+	if (CONFIG_RELOAD_INT_CHANGED(pipelinedecodeworkers) || CONFIG_RELOAD_INT_CHANGED(pipelinequeuesize))
+		console_log("config warning: comm pipeline changes need a restart\n");
+	if (CONFIG_RELOAD_INT_CHANGED(ipsctracesize))
+		console_log("config warning: ipsc trace size change needs a restart\n");
+	if (CONFIG_RELOAD_INT_CHANGED(logqueuesize))
+		console_log("config warning: log queue size change needs a restart\n");
+	if (CONFIG_RELOAD_INT_CHANGED(httpserverenabled) || CONFIG_RELOAD_INT_CHANGED(httpserverport))
+		console_log("config warning: http server changes need a restart\n");
+	if (CONFIG_RELOAD_STR_CHANGED(aprsserverhost) && (old_snapshot->aprsserverhost == NULL || old_snapshot->aprsserverhost[0] == 0))
+		console_log("config warning: enabling aprs needs a restart\n");
+}
+
+// Reloads the config file, and applies the changes to the running subsystems.
+flag_t config_reload(void) {
+	const config_snapshot_t *old_snapshot = config_snapshot_get();
+	const config_snapshot_t *new_snapshot;
+	loglevel_t loglevel;
+
+	console_log("config: reloading\n");
+
+	if (!config_init(NULL)) {
+		console_log("config error: can't reload config file, keeping the current config\n");
+		return 0;
+	}
+	config_voicestreams_init();
+	config_aprsobjs_init();
+
+	new_snapshot = config_snapshot_get();
+	if (old_snapshot == NULL || new_snapshot == NULL || old_snapshot == new_snapshot) {
+		console_log("config error: can't compare the reloaded config\n");
+		return 0;
+	}
+
+	if (CONFIG_RELOAD_INT_CHANGED(loglevel)) {
+		loglevel.raw = new_snapshot->loglevel;
+		console_set_loglevel(&loglevel);
+	}
+
+	// The log file is always reopened, so it can be moved away before sending a SIGHUP (as logrotate does).
+	console_logfile_reopen();
+
+	if (CONFIG_RELOAD_INT_CHANGED(capturefilteripsconly) || CONFIG_RELOAD_STR_CHANGED(capturefilterports) ||
+		CONFIG_RELOAD_STR_CHANGED(capturefilterhosts) || CONFIG_RELOAD_INT_CHANGED(pcapmaxbatchsize))
+			comm_reload();
+
+	if (CONFIG_RELOAD_STR_CHANGED(ignoredhosts) || CONFIG_RELOAD_STR_CHANGED(ignoredsnmprepeaterhosts) ||
+		CONFIG_RELOAD_INT_CHANGED(hostsresolvettlinsec))
+			comm_hostset_reload();
+
+	if (CONFIG_RELOAD_STR_CHANGED(allowedtalkgroups) || CONFIG_RELOAD_STR_CHANGED(ignoredtalkgroups))
+		ipsc_tgfilter_rebuild();
+
+	if (new_snapshot->masteripaddr_valid && (!old_snapshot->masteripaddr_valid || CONFIG_RELOAD_INT_CHANGED(masteripaddr.s_addr)))
+		ipsc_add_master_repeater();
+
+	// These are in their own config sections which are not in the snapshot, so they are always
+	// reloaded. Voice streams are updated in place, as calls and HTTP clients may reference them.
+	voicestreams_reload();
+	aprs_reload_objs();
+
+	config_reload_check_restart_needed(old_snapshot, new_snapshot);
+
+	console_log("config: reloaded\n");
+	return 1;
+}
+
+void config_reload_process(void) {
+	if (!base_sighup_received)
+		return;
+
+	base_sighup_received = 0;
+	console_log("config: SIGHUP received\n");
+	config_reload();
+}
@@ -0,0 +1,271 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "config-snapshot.h"
+#include "config.h"
+
+#include <libs/daemon/console.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+// Readers load the current snapshot pointer without locking. Publishing a new snapshot swaps the
+// pointer, and the old snapshot is put on the retired list instead of freeing it, as a reader in
+// another thread may still use it.
+//
+// Every reader thread stores the generation of the current snapshot in its epoch slot when it passes
+// a quiescent point (a point where it doesn't use any snapshot). After that it can only get the same
+// or a newer snapshot. config_snapshot_process() runs at the main thread's quiescent point, and frees
+// the retired snapshots which were replaced before the epoch of every reader.
+
+typedef struct {
+	flag_t registered;
+	uint32_t epoch;
+} config_snapshot_reader_t;
+
+static config_snapshot_t *config_snapshot_current = NULL;
+static config_snapshot_t *config_snapshot_retired = NULL;
+static pthread_mutex_t config_snapshot_publish_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t config_snapshot_generation = 0;
+static config_snapshot_reader_t config_snapshot_readers[CONFIG_SNAPSHOT_MAXREADERS];
+
+const config_snapshot_t *config_snapshot_get(void) {
+	return __atomic_load_n(&config_snapshot_current, __ATOMIC_ACQUIRE);
+}
+
+static void config_snapshot_free(config_snapshot_t *snapshot) {
+	if (snapshot == NULL)
+		return;
+
+	free(snapshot->logfilename);
+	free(snapshot->pidfilename);
+	free(snapshot->daemonctlfile);
+	free(snapshot->ttyconsoledev);
+	free(snapshot->netdevicename);
+	free(snapshot->capturebackend);
+	free(snapshot->capturefilterports);
+	free(snapshot->capturefilterhosts);
+	free(snapshot->ignoredsnmprepeaterhosts);
+	free(snapshot->ignoredhosts);
+	free(snapshot->allowedtalkgroups);
+	free(snapshot->ignoredtalkgroups);
+	free(snapshot->remotedbhost);
+	free(snapshot->remotedbuser);
+	free(snapshot->remotedbpass);
+	free(snapshot->remotedbname);
+	free(snapshot->remotedbtableprefix);
+	free(snapshot->userdbtablename);
+	free(snapshot->callsignbookdbtablename);
+	free(snapshot->aprsserverhost);
+	free(snapshot->aprsservercallsign);
+	free(snapshot->aprsposdescription);
+	free(snapshot);
+}
+
+static config_snapshot_t *config_snapshot_build(void) {
+	config_snapshot_t *snapshot;
+	struct in_addr *masteripaddr;
+
+	snapshot = (config_snapshot_t *)calloc(1, sizeof(config_snapshot_t));
+	if (snapshot == NULL)
+		return NULL;
+
+	snapshot->loglevel = config_get_loglevel();
+	snapshot->logfilename = config_get_logfilename();
+	snapshot->logfilemaxsizeinkb = config_get_logfilemaxsizeinkb();
+	snapshot->logfilerotateperiodinsec = config_get_logfilerotateperiodinsec();
+	snapshot->logfilerotatecount = config_get_logfilerotatecount();
+	snapshot->logqueuesize = config_get_logqueuesize();
+	snapshot->pidfilename = config_get_pidfilename();
+	snapshot->daemonctlfile = config_get_daemonctlfile();
+	snapshot->ttyconsoledev = config_get_ttyconsoledev();
+	snapshot->ttyconsoleenabled = config_get_ttyconsoleenabled();
+	snapshot->ttyconsolebaudrate = config_get_ttyconsolebaudrate();
+	snapshot->netdevicename = config_get_netdevicename();
+	snapshot->pcapmaxbatchsize = config_get_pcapmaxbatchsize();
+	snapshot->pipelinedecodeworkers = config_get_pipelinedecodeworkers();
+	snapshot->pipelinequeuesize = config_get_pipelinequeuesize();
+	snapshot->capturebackend = config_get_capturebackend();
+	snapshot->mmapblocksize = config_get_mmapblocksize();
+	snapshot->mmapblockcount = config_get_mmapblockcount();
+	snapshot->mmapblockretiretimeoutinms = config_get_mmapblockretiretimeoutinms();
+	snapshot->capturefilteripsconly = config_get_capturefilteripsconly();
+	snapshot->capturefilterports = config_get_capturefilterports();
+	snapshot->capturefilterhosts = config_get_capturefilterhosts();
+	snapshot->repeaterinfoupdateinsec = config_get_repeaterinfoupdateinsec();
+	snapshot->repeaterinactivetimeoutinsec = config_get_repeaterinactivetimeoutinsec();
+	snapshot->ipsctxqueuesize = config_get_ipsctxqueuesize();
+	snapshot->ipsctracesize = config_get_ipsctracesize();
+	snapshot->rssiupdateduringcallinmsec = config_get_rssiupdateduringcallinmsec();
+	snapshot->calltimeoutinsec = config_get_calltimeoutinsec();
+	snapshot->datatimeoutinsec = config_get_datatimeoutinsec();
+	snapshot->ignoredsnmprepeaterhosts = config_get_ignoredsnmprepeaterhosts();
+	snapshot->ignoredhosts = config_get_ignoredhosts();
+	snapshot->hostsresolvettlinsec = config_get_hostsresolvettlinsec();
+	snapshot->allowedtalkgroups = config_get_allowedtalkgroups();
+	snapshot->ignoredtalkgroups = config_get_ignoredtalkgroups();
+	snapshot->remotedbhost = config_get_remotedbhost();
+	snapshot->remotedbuser = config_get_remotedbuser();
+	snapshot->remotedbpass = config_get_remotedbpass();
+	snapshot->remotedbname = config_get_remotedbname();
+	snapshot->remotedbtableprefix = config_get_remotedbtableprefix();
+	snapshot->userdbtablename = config_get_userdbtablename();
+	snapshot->callsignbookdbtablename = config_get_callsignbookdbtablename();
+	snapshot->remotedbreconnecttrytimeoutinsec = config_get_remotedbreconnecttrytimeoutinsec();
+	snapshot->remotedbmaintenanceperiodinsec = config_get_remotedbmaintenanceperiodinsec();
+	snapshot->remotedbdeleteolderthansec = config_get_remotedbdeleteolderthansec();
+	snapshot->remotedbuserlistdlperiodinsec = config_get_remotedbuserlistdlperiodinsec();
+	snapshot->remotedbmsgqueuepollintervalinsec = config_get_remotedbmsgqueuepollintervalinsec();
+	snapshot->updatestatstableenabled = (config_get_updatestatstableenabled() != 0);
+	snapshot->httpserverenabled = (config_get_httpserverenabled() != 0);
+	snapshot->httpserverport = config_get_httpserverport();
+	snapshot->smssendmaxretrycount = config_get_smssendmaxretrycount();
+	snapshot->mindatapacketsendretryintervalinsec = config_get_mindatapacketsendretryintervalinsec();
+	snapshot->datapacketsendmaxretrycount = config_get_datapacketsendmaxretrycount();
+	snapshot->smsretransmittimeoutinsec = config_get_smsretransmittimeoutinsec();
+	snapshot->aprsserverhost = config_get_aprsserverhost();
+	snapshot->aprsserverport = config_get_aprsserverport();
+	snapshot->aprsservercallsign = config_get_aprsservercallsign();
+	snapshot->aprsserverpasscode = config_get_aprsserverpasscode();
+	snapshot->aprsposdescription = config_get_aprsposdescription();
+	snapshot->smsretransmitenabled = config_get_smsretransmitenabled();
+
+	// The master IP address is resolved only once here, instead of at every lookup.
+	masteripaddr = config_get_masteripaddr();
+	if (masteripaddr != NULL) {
+		memcpy(&snapshot->masteripaddr, masteripaddr, sizeof(struct in_addr));
+		snapshot->masteripaddr_valid = 1;
+		free(masteripaddr);
+	}
+
+	return snapshot;
+}
+
+// Builds a new snapshot from the current config, and makes it the current one.
+flag_t config_snapshot_publish(void) {
+	config_snapshot_t *snapshot;
+	config_snapshot_t *old_snapshot;
+
+	snapshot = config_snapshot_build();
+	if (snapshot == NULL) {
+		console_log("config error: can't allocate memory for the config snapshot\n");
+		return 0;
+	}
+
+	pthread_mutex_lock(&config_snapshot_publish_mutex);
+	snapshot->generation = ++config_snapshot_generation;
+	old_snapshot = __atomic_exchange_n(&config_snapshot_current, snapshot, __ATOMIC_ACQ_REL);
+	if (old_snapshot != NULL) {
+		old_snapshot->retired_at = snapshot->generation;
+		old_snapshot->next_retired = config_snapshot_retired;
+		config_snapshot_retired = old_snapshot;
+	}
+	pthread_mutex_unlock(&config_snapshot_publish_mutex);
+	return 1;
+}
+
+static uint32_t config_snapshot_get_current_generation(void) {
+	const config_snapshot_t *snapshot = config_snapshot_get();
+
+	return (snapshot != NULL ? snapshot->generation : 0);
+}
+
+int config_snapshot_reader_register(void) {
+	int i;
+
+	pthread_mutex_lock(&config_snapshot_publish_mutex);
+	for (i = 0; i < CONFIG_SNAPSHOT_MAXREADERS; i++) {
+		if (!config_snapshot_readers[i].registered) {
+			__atomic_store_n(&config_snapshot_readers[i].epoch, config_snapshot_get_current_generation(), __ATOMIC_SEQ_CST);
+			config_snapshot_readers[i].registered = 1;
+			pthread_mutex_unlock(&config_snapshot_publish_mutex);
+			return i;
+		}
+	}
+	pthread_mutex_unlock(&config_snapshot_publish_mutex);
+
+	console_log("config error: can't register config snapshot reader, max. %u readers are supported\n", CONFIG_SNAPSHOT_MAXREADERS);
+	return -1;
+}
+
+void config_snapshot_reader_quiescent(int reader_id) {
+	if (reader_id < 0 || reader_id >= CONFIG_SNAPSHOT_MAXREADERS)
+		return;
+
+	__atomic_store_n(&config_snapshot_readers[reader_id].epoch, config_snapshot_get_current_generation(), __ATOMIC_SEQ_CST);
+}
+
+void config_snapshot_reader_unregister(int reader_id) {
+	if (reader_id < 0 || reader_id >= CONFIG_SNAPSHOT_MAXREADERS)
+		return;
+
+	pthread_mutex_lock(&config_snapshot_publish_mutex);
+	config_snapshot_readers[reader_id].registered = 0;
+	pthread_mutex_unlock(&config_snapshot_publish_mutex);
+}
+
+// Frees the retired snapshots which are not used by any reader anymore. This has to be called from the
+// main loop, when the main thread doesn't use a snapshot.
+void config_snapshot_process(void) {
+	config_snapshot_t **snapshot;
+	config_snapshot_t *retired_snapshot;
+	uint32_t min_epoch = UINT32_MAX;
+	uint32_t epoch;
+	int i;
+
+	pthread_mutex_lock(&config_snapshot_publish_mutex);
+	if (config_snapshot_retired == NULL) {
+		pthread_mutex_unlock(&config_snapshot_publish_mutex);
+		return;
+	}
+
+	for (i = 0; i < CONFIG_SNAPSHOT_MAXREADERS; i++) {
+		if (!config_snapshot_readers[i].registered)
+			continue;
+
+		epoch = __atomic_load_n(&config_snapshot_readers[i].epoch, __ATOMIC_SEQ_CST);
+		if (epoch < min_epoch)
+			min_epoch = epoch;
+	}
+
+	snapshot = &config_snapshot_retired;
+	while (*snapshot != NULL) {
+		if ((*snapshot)->retired_at <= min_epoch) {
+			retired_snapshot = *snapshot;
+			*snapshot = retired_snapshot->next_retired;
+			config_snapshot_free(retired_snapshot);
+		} else
+			snapshot = &(*snapshot)->next_retired;
+	}
+	pthread_mutex_unlock(&config_snapshot_publish_mutex);
+}
+
+void config_snapshot_deinit(void) {
+	config_snapshot_t *snapshot;
+
+	pthread_mutex_lock(&config_snapshot_publish_mutex);
+	config_snapshot_free(__atomic_exchange_n(&config_snapshot_current, NULL, __ATOMIC_ACQ_REL));
+	while (config_snapshot_retired != NULL) {
+		snapshot = config_snapshot_retired->next_retired;
+		config_snapshot_free(config_snapshot_retired);
+		config_snapshot_retired = snapshot;
+	}
+	pthread_mutex_unlock(&config_snapshot_publish_mutex);
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef CONFIG_SNAPSHOT_H_
+#define CONFIG_SNAPSHOT_H_
+
+#include <libs/base/types.h>
+
+#include <netinet/in.h>
+
+// A parsed, read-only copy of the main config section. Hot paths use this instead of the
+// config_get_*() functions, so they don't need to take the config mutex and query the key file.
+typedef struct config_snapshot_st {
+	uint32_t generation;
+
+	int loglevel;
+	char *logfilename;
+	int logfilemaxsizeinkb;
+	int logfilerotateperiodinsec;
+	int logfilerotatecount;
+	int logqueuesize;
+	char *pidfilename;
+	char *daemonctlfile;
+	char *ttyconsoledev;
+	flag_t ttyconsoleenabled;
+	int ttyconsolebaudrate;
+	char *netdevicename;
+	int pcapmaxbatchsize;
+	int pipelinedecodeworkers;
+	int pipelinequeuesize;
+	char *capturebackend;
+	int mmapblocksize;
+	int mmapblockcount;
+	int mmapblockretiretimeoutinms;
+	flag_t capturefilteripsconly;
+	char *capturefilterports;
+	char *capturefilterhosts;
+	int repeaterinfoupdateinsec;
+	int repeaterinactivetimeoutinsec;
+	int ipsctxqueuesize;
+	int ipsctracesize;
+	int rssiupdateduringcallinmsec;
+	int calltimeoutinsec;
+	int datatimeoutinsec;
+	char *ignoredsnmprepeaterhosts;
+	char *ignoredhosts;
+	int hostsresolvettlinsec;
+	char *allowedtalkgroups;
+	char *ignoredtalkgroups;
+	char *remotedbhost;
+	char *remotedbuser;
+	char *remotedbpass;
+	char *remotedbname;
+	char *remotedbtableprefix;
+	char *userdbtablename;
+	char *callsignbookdbtablename;
+	int remotedbreconnecttrytimeoutinsec;
+	int remotedbmaintenanceperiodinsec;
+	int remotedbdeleteolderthansec;
+	int remotedbuserlistdlperiodinsec;
+	int remotedbmsgqueuepollintervalinsec;
+	flag_t updatestatstableenabled;
+	flag_t httpserverenabled;
+	int httpserverport;
+	flag_t masteripaddr_valid;
+	struct in_addr masteripaddr;
+	int smssendmaxretrycount;
+	int mindatapacketsendretryintervalinsec;
+	int datapacketsendmaxretrycount;
+	int smsretransmittimeoutinsec;
+	char *aprsserverhost;
+	int aprsserverport;
+	char *aprsservercallsign;
+	int aprsserverpasscode;
+	char *aprsposdescription;
+	flag_t smsretransmitenabled;
+
+	uint32_t retired_at; // The generation of the snapshot which replaced this one.
+	struct config_snapshot_st *next_retired;
+} config_snapshot_t;
+
+// Max. number of threads besides the main thread which can read snapshots.
+#define CONFIG_SNAPSHOT_MAXREADERS		8
+
+// Returns the current snapshot, or NULL if the config is not loaded yet. The main thread can use the
+// returned snapshot until the end of the current main loop pass, other threads until they call
+// config_snapshot_reader_quiescent().
+const config_snapshot_t *config_snapshot_get(void);
+flag_t config_snapshot_publish(void);
+
+// Threads other than the main thread have to register before reading snapshots, and call
+// config_snapshot_reader_quiescent() in every loop pass, when they don't use a snapshot.
+// Returns the reader id, or -1 on error.
+int config_snapshot_reader_register(void);
+void config_snapshot_reader_quiescent(int reader_id);
+void config_snapshot_reader_unregister(int reader_id);
+
+void config_snapshot_process(void);
+void config_snapshot_deinit(void);
+
+#endif
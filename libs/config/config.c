@@ -19,6 +19,7 @@
 
 #include "config.h"
 #include "config-voicestreams.h"
+#include "config-snapshot.h"
 
 #include <libs/base/types.h>
 #include <libs/daemon/daemon.h>
@@ -95,6 +96,7 @@ void config_set_loglevel(loglevel_t *loglevel) {
 	pthread_mutex_lock(&config_mutex);
 	g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, "loglevel", loglevel->raw);
 	pthread_mutex_unlock(&config_mutex);
+	config_snapshot_publish();
 	config_writeconfigfile();
 }
 
@@ -133,6 +135,74 @@ char *config_get_logfilename(void) {
 	return value;
 }
 
+int config_get_logfilemaxsizeinkb(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "logfilemaxsizeinkb";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 0;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_logfilerotateperiodinsec(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "logfilerotateperiodinsec";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 0;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_logfilerotatecount(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "logfilerotatecount";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 5;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_logqueuesize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "logqueuesize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 1024;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
 char *config_get_pidfilename(void) {
 	GError *error = NULL;
 	char *value = NULL;
@@ -239,6 +309,179 @@ char *config_get_netdevicename(void) {
 	return value;
 }
 
+int config_get_pcapmaxbatchsize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "pcapmaxbatchsize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 64;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_pipelinedecodeworkers(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "pipelinedecodeworkers";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 0;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_pipelinequeuesize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "pipelinequeuesize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 1024;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+char *config_get_capturebackend(void) {
+	GError *error = NULL;
+	char *value = NULL;
+	char *key = "capturebackend";
+	char *defaultvalue = NULL;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = "pcap";
+	value = g_key_file_get_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error || value == NULL) {
+		value = strdup(defaultvalue);
+		if (value)
+			g_key_file_set_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_mmapblocksize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "mmapblocksize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 262144;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_mmapblockcount(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "mmapblockcount";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 64;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_mmapblockretiretimeoutinms(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "mmapblockretiretimeoutinms";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 10;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+flag_t config_get_capturefilteripsconly(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "capturefilteripsconly";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 1;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return (value != 0 ? 1 : 0);
+}
+
+char *config_get_capturefilterports(void) {
+	GError *error = NULL;
+	char *value = NULL;
+	char *key = "capturefilterports";
+	char *defaultvalue = NULL;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = "";
+	value = g_key_file_get_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error || value == NULL) {
+		value = strdup(defaultvalue);
+		if (value)
+			g_key_file_set_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+char *config_get_capturefilterhosts(void) {
+	GError *error = NULL;
+	char *value = NULL;
+	char *key = "capturefilterhosts";
+	char *defaultvalue = NULL;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = "";
+	value = g_key_file_get_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error || value == NULL) {
+		value = strdup(defaultvalue);
+		if (value)
+			g_key_file_set_string(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
 int config_get_repeaterinfoupdateinsec(void) {
 	GError *error = NULL;
 	int value = 0;
@@ -273,6 +516,40 @@ int config_get_repeaterinactivetimeoutinsec(void) {
 	return value;
 }
 
+int config_get_ipsctxqueuesize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "ipsctxqueuesize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 1024;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
+int config_get_ipsctracesize(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "ipsctracesize";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 4096;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
 int config_get_rssiupdateduringcallinmsec(void) {
 	GError *error = NULL;
 	int value = 0;
@@ -360,6 +637,23 @@ char *config_get_ignoredhosts(void) {
 	return value;
 }
 
+int config_get_hostsresolvettlinsec(void) {
+	GError *error = NULL;
+	int value = 0;
+	char *key = "hostsresolvettlinsec";
+	int defaultvalue;
+
+	pthread_mutex_lock(&config_mutex);
+	defaultvalue = 300;
+	value = g_key_file_get_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, &error);
+	if (error) {
+		value = defaultvalue;
+		g_key_file_set_integer(keyfile, CONFIG_MAIN_SECTION_NAME, key, value);
+	}
+	pthread_mutex_unlock(&config_mutex);
+	return value;
+}
+
 char *config_get_allowedtalkgroups(void) {
 	GError *error = NULL;
 	char *value = NULL;
@@ -858,10 +1152,10 @@ flag_t config_get_smsretransmitenabled(void) {
 	return (value != 0 ? 1 : 0);
 }
 
-void config_init(char *configfilename) {
+flag_t config_init(char *configfilename) {
 	GError *error = NULL;
-	char *tmp_str;
-	struct in_addr *tmp_addr;
+	GKeyFile *newkeyfile;
+	GKeyFile *oldkeyfile;
 
 	console_log("config: init\n");
 
@@ -874,94 +1168,48 @@ void config_init(char *configfilename) {
 		f = fopen(config_configfilename, "w");
 		if (!f) {
 			console_log("config error: can't save, file is not writable\n");
-			return;
+			return 0;
 		}
 		fputs("[main]\n", f);
 	}
 	fclose(f);
 
-	if (keyfile != NULL) {
-		g_key_file_free(keyfile);
-		keyfile = NULL;
-	}
-
-	keyfile = g_key_file_new();
+	newkeyfile = g_key_file_new();
 
 	flags = G_KEY_FILE_KEEP_COMMENTS | G_KEY_FILE_KEEP_TRANSLATIONS;
-	if (!g_key_file_load_from_file(keyfile, config_configfilename, flags, &error)) {
+	if (!g_key_file_load_from_file(newkeyfile, config_configfilename, flags, &error)) {
 		console_log("config: error loading file\n");
-		g_key_file_free(keyfile);
-		keyfile = NULL;
+		g_error_free(error);
+		g_key_file_free(newkeyfile);
+		newkeyfile = NULL;
+
+		// If this is a reload, we keep using the currently loaded config.
+		if (keyfile != NULL)
+			return 0;
 	}
 
+	// Other threads may read the config, so the key file is replaced under the mutex.
+	pthread_mutex_lock(&config_mutex);
+	oldkeyfile = keyfile;
+	keyfile = newkeyfile;
+	pthread_mutex_unlock(&config_mutex);
+
+	if (oldkeyfile != NULL)
+		g_key_file_free(oldkeyfile);
+
 	// We read everything, a default value will be set for non-existent keys in the config file.
-	config_get_loglevel();
-	tmp_str = config_get_logfilename();
-	free(tmp_str);
-	tmp_str = config_get_pidfilename();
-	free(tmp_str);
-	tmp_str = config_get_daemonctlfile();
-	free(tmp_str);
-	tmp_str = config_get_ttyconsoledev();
-	free(tmp_str);
-	config_get_ttyconsoleenabled();
-	config_get_ttyconsolebaudrate();
-	tmp_str = config_get_netdevicename();
-	free(tmp_str);
-	config_get_repeaterinfoupdateinsec();
-	config_get_repeaterinactivetimeoutinsec();
-	config_get_rssiupdateduringcallinmsec();
-	config_get_calltimeoutinsec();
-	config_get_datatimeoutinsec();
-	tmp_str = config_get_ignoredsnmprepeaterhosts();
-	free(tmp_str);
-	tmp_str = config_get_ignoredhosts();
-	free(tmp_str);
-	tmp_str = config_get_allowedtalkgroups();
-	free(tmp_str);
-	tmp_str = config_get_ignoredtalkgroups();
-	free(tmp_str);
-	tmp_str = config_get_remotedbhost();
-	free(tmp_str);
-	tmp_str = config_get_remotedbuser();
-	free(tmp_str);
-	tmp_str = config_get_remotedbpass();
-	free(tmp_str);
-	tmp_str = config_get_remotedbname();
-	free(tmp_str);
-	tmp_str = config_get_remotedbtableprefix();
-	free(tmp_str);
-	tmp_str = config_get_userdbtablename();
-	free(tmp_str);
-	config_get_remotedbreconnecttrytimeoutinsec();
-	config_get_remotedbdeleteolderthansec();
-	config_get_remotedbuserlistdlperiodinsec();
-	config_get_remotedbmaintenanceperiodinsec();
-	config_get_remotedbmsgqueuepollintervalinsec();
-	config_get_updatestatstableenabled();
-	config_get_httpserverenabled();
-	config_get_httpserverport();
-	tmp_addr = config_get_masteripaddr();
-	free(tmp_addr);
-	config_get_mindatapacketsendretryintervalinsec();
-	config_get_datapacketsendmaxretrycount();
-	config_get_smsretransmittimeoutinsec();
-	tmp_str = config_get_aprsserverhost();
-	free(tmp_str);
-	config_get_aprsserverport();
-	tmp_str = config_get_aprsservercallsign();
-	free(tmp_str);
-	config_get_aprsserverpasscode();
-	tmp_str = config_get_aprsposdescription();
-	free(tmp_str);
-	config_get_smsretransmitenabled();
+	// The values read are published as the new config snapshot.
+	config_snapshot_publish();
 
 	config_writeconfigfile();
+	return 1;
 }
 
 void config_deinit(void) {
 	console_log("config: deinit\n");
 
+	config_snapshot_deinit();
+
 	if (keyfile != NULL) {
 		g_key_file_free(keyfile);
 		keyfile = NULL;
@@ -35,19 +35,36 @@ void config_set_loglevel(loglevel_t *loglevel);
 int config_get_loglevel(void);
 
 char *config_get_logfilename(void);
+int config_get_logfilemaxsizeinkb(void);
+int config_get_logfilerotateperiodinsec(void);
+int config_get_logfilerotatecount(void);
+int config_get_logqueuesize(void);
 char *config_get_pidfilename(void);
 char *config_get_daemonctlfile(void);
 char *config_get_ttyconsoledev(void);
 flag_t config_get_ttyconsoleenabled(void);
 int config_get_ttyconsolebaudrate(void);
 char *config_get_netdevicename(void);
+int config_get_pcapmaxbatchsize(void);
+int config_get_pipelinedecodeworkers(void);
+int config_get_pipelinequeuesize(void);
+char *config_get_capturebackend(void);
+int config_get_mmapblocksize(void);
+int config_get_mmapblockcount(void);
+int config_get_mmapblockretiretimeoutinms(void);
+flag_t config_get_capturefilteripsconly(void);
+char *config_get_capturefilterports(void);
+char *config_get_capturefilterhosts(void);
 int config_get_repeaterinfoupdateinsec(void);
 int config_get_repeaterinactivetimeoutinsec(void);
+int config_get_ipsctxqueuesize(void);
+int config_get_ipsctracesize(void);
 int config_get_rssiupdateduringcallinmsec(void);
 int config_get_calltimeoutinsec(void);
 int config_get_datatimeoutinsec(void);
 char *config_get_ignoredsnmprepeaterhosts(void);
 char *config_get_ignoredhosts(void);
+int config_get_hostsresolvettlinsec(void);
 char *config_get_ignoredtalkgroups(void);
 char *config_get_allowedtalkgroups(void);
 char *config_get_remotedbhost(void);
@@ -78,8 +95,8 @@ int config_get_aprsserverpasscode(void);
 char *config_get_aprsposdescription(void);
 flag_t config_get_smsretransmitenabled(void);
 
-// If NULL is given, reloads the current config file.
-void config_init(char *configfilename);
+// If NULL is given, reloads the current config file. Returns 0 if the file can't be loaded.
+flag_t config_init(char *configfilename);
 void config_deinit(void);
 
 #endif
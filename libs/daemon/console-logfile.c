@@ -0,0 +1,426 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#include DEFAULTCONFIG
+
+#include "console-logfile.h"
+#include "console.h"
+
+#include <libs/config/config.h>
+
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+// Log lines are passed to the writer thread through a bounded multi-producer single-consumer ring,
+// so logging doesn't open, write and close the log file on the packet processing thread. Producers
+// never block: if the ring is full, the line is dropped and counted. The writer thread keeps the log
+// file open, and writes the queued lines in batches with writev().
+//
+// Every entry has a sequence number. The entry at ring position pos can be filled in if its sequence
+// number is pos, and it can be written out by the writer thread if its sequence number is pos+1.
+// After writing it out, the writer thread sets it to pos+ringsize, so it's free for the next round.
+
+#define CONSOLE_LOGFILE_MAXQUEUESIZE	65536
+#define CONSOLE_LOGFILE_WAKEUPINMS		100
+
+typedef struct {
+	uint32_t seq;
+	uint16_t length;
+	char line[CONSOLE_LOGFILE_MAXLINESIZE];
+} console_logfile_entry_t;
+
+static console_logfile_entry_t *console_logfile_ring = NULL;
+static uint32_t console_logfile_ring_mask = 0;
+static uint32_t console_logfile_enqueue_pos = 0;
+static uint32_t console_logfile_dequeue_pos = 0;
+
+static pthread_t console_logfile_thread;
+static flag_t console_logfile_thread_running = 0;
+static flag_t console_logfile_thread_should_stop = 0;
+static flag_t console_logfile_reopen_requested = 0;
+static pthread_mutex_t console_logfile_mutex_wakeup = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t console_logfile_cond_wakeup;
+
+// These are only used by the writer thread.
+static int console_logfile_fd = -1;
+static char *console_logfile_name = NULL;
+static off_t console_logfile_size = 0;
+static off_t console_logfile_maxsize = 0;
+static int console_logfile_rotateperiod = 0;
+static int console_logfile_rotatecount = 0;
+static time_t console_logfile_next_rotate_time = 0;
+static time_t console_logfile_last_open_try_time = 0;
+static flag_t console_logfile_open_failed = 0;
+static uint32_t console_logfile_dropped_reported = 0;
+
+static struct {
+	uint32_t lines_written;
+	uint32_t lines_dropped;
+	uint32_t write_errors;
+	uint32_t rotations;
+} console_logfile_stats;
+
+// Used if the writer thread is not running (before console_init(), after console_deinit(), or if the
+// queue is disabled in the config). This can be called from any thread, so it doesn't use the config
+// snapshot.
+static void console_logfile_write_direct(char *line, int linelen) {
+	char *logfilename;
+	int fd;
+
+	logfilename = config_get_logfilename();
+	if (logfilename == NULL)
+		return;
+	fd = open(logfilename, O_CREAT | O_APPEND | O_WRONLY, 0664);
+	free(logfilename);
+
+	if (fd < 0)
+		return;
+
+	if (write(fd, line, linelen) != linelen)
+		__atomic_add_fetch(&console_logfile_stats.write_errors, 1, __ATOMIC_RELAXED);
+	else
+		__atomic_add_fetch(&console_logfile_stats.lines_written, 1, __ATOMIC_RELAXED);
+	close(fd);
+}
+
+void console_logfile_add(char *line, int linelen) {
+	console_logfile_entry_t *entry;
+	uint32_t pos;
+	uint32_t seq;
+	int32_t diff;
+
+	if (line == NULL || linelen <= 0)
+		return;
+
+	if (linelen > CONSOLE_LOGFILE_MAXLINESIZE)
+		linelen = CONSOLE_LOGFILE_MAXLINESIZE;
+
+	if (!__atomic_load_n(&console_logfile_thread_running, __ATOMIC_ACQUIRE)) {
+		console_logfile_write_direct(line, linelen);
+		return;
+	}
+
+	pos = __atomic_load_n(&console_logfile_enqueue_pos, __ATOMIC_RELAXED);
+	while (1) {
+		entry = &console_logfile_ring[pos & console_logfile_ring_mask];
+		seq = __atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE);
+		diff = (int32_t)(seq - pos);
+
+		if (diff == 0) {
+			// Trying to reserve this entry, pos gets updated if another producer was faster.
+			if (__atomic_compare_exchange_n(&console_logfile_enqueue_pos, &pos, pos+1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) { // The writer thread has not written out this entry yet, so the ring is full.
+			__atomic_add_fetch(&console_logfile_stats.lines_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		} else
+			pos = __atomic_load_n(&console_logfile_enqueue_pos, __ATOMIC_RELAXED);
+	}
+
+	memcpy(entry->line, line, linelen);
+	entry->line[linelen-1] = '\n';
+	entry->length = linelen;
+	__atomic_store_n(&entry->seq, pos+1, __ATOMIC_RELEASE);
+
+	// The writer thread wakes up periodically, we only wake it up early if the ring is getting full.
+	if (pos+1 - __atomic_load_n(&console_logfile_dequeue_pos, __ATOMIC_RELAXED) >= (console_logfile_ring_mask+1)/4)
+		pthread_cond_signal(&console_logfile_cond_wakeup);
+}
+
+void console_logfile_reopen(void) {
+	if (!__atomic_load_n(&console_logfile_thread_running, __ATOMIC_ACQUIRE))
+		return;
+
+	__atomic_store_n(&console_logfile_reopen_requested, 1, __ATOMIC_RELEASE);
+	pthread_cond_signal(&console_logfile_cond_wakeup);
+}
+
+void console_logfile_print_stats(void) {
+	console_log("logfile stats:\n");
+	if (__atomic_load_n(&console_logfile_thread_running, __ATOMIC_ACQUIRE)) {
+		console_log("  writer thread running, queue size: %u, queued lines: %u\n", console_logfile_ring_mask+1,
+			__atomic_load_n(&console_logfile_enqueue_pos, __ATOMIC_RELAXED) - __atomic_load_n(&console_logfile_dequeue_pos, __ATOMIC_RELAXED));
+	} else
+		console_log("  writer thread not running, lines are written directly\n");
+	console_log("  lines written: %u dropped: %u write errors: %u rotations: %u\n",
+		__atomic_load_n(&console_logfile_stats.lines_written, __ATOMIC_RELAXED),
+		__atomic_load_n(&console_logfile_stats.lines_dropped, __ATOMIC_RELAXED),
+		__atomic_load_n(&console_logfile_stats.write_errors, __ATOMIC_RELAXED),
+		__atomic_load_n(&console_logfile_stats.rotations, __ATOMIC_RELAXED));
+}
+
+static void console_logfile_close(void) {
+	if (console_logfile_fd >= 0)
+		close(console_logfile_fd);
+	console_logfile_fd = -1;
+}
+
+// (Re)opens the log file, and reads the rotation settings from the config.
+static void console_logfile_open(void) {
+	struct stat st;
+	time_t now = time(NULL);
+
+	console_logfile_close();
+	console_logfile_last_open_try_time = now;
+
+	free(console_logfile_name);
+	console_logfile_name = config_get_logfilename();
+	console_logfile_maxsize = (off_t)config_get_logfilemaxsizeinkb()*1024;
+	console_logfile_rotateperiod = config_get_logfilerotateperiodinsec();
+	console_logfile_rotatecount = config_get_logfilerotatecount();
+
+	if (console_logfile_name == NULL)
+		return;
+
+	console_logfile_fd = open(console_logfile_name, O_CREAT | O_APPEND | O_WRONLY, 0664);
+	if (console_logfile_fd < 0) {
+		// Logging only the first failure, as this log message goes to the same file.
+		if (!console_logfile_open_failed)
+			console_log("console logfile error: can't open %s: %s\n", console_logfile_name, strerror(errno));
+		console_logfile_open_failed = 1;
+		return;
+	}
+	console_logfile_open_failed = 0;
+
+	if (fstat(console_logfile_fd, &st) == 0)
+		console_logfile_size = st.st_size;
+	else
+		console_logfile_size = 0;
+
+	// Time based rotation happens on period boundaries, so a daily rotation happens at midnight UTC.
+	if (console_logfile_rotateperiod > 0)
+		console_logfile_next_rotate_time = (now / console_logfile_rotateperiod + 1) * console_logfile_rotateperiod;
+	else
+		console_logfile_next_rotate_time = 0;
+}
+
+// Renames logfile.N to logfile.N+1 for every kept file (the oldest one gets overwritten),
+// the current file to logfile.1, and opens a new log file.
+static void console_logfile_rotate(void) {
+	char oldname[255];
+	char newname[255];
+	int i;
+
+	if (console_logfile_name == NULL)
+		return;
+
+	console_logfile_close();
+
+	if (console_logfile_rotatecount > 0) {
+		for (i = console_logfile_rotatecount-1; i > 0; i--) {
+			snprintf(oldname, sizeof(oldname), "%s.%d", console_logfile_name, i);
+			snprintf(newname, sizeof(newname), "%s.%d", console_logfile_name, i+1);
+			rename(oldname, newname); // Older files may not exist yet, so errors are ignored.
+		}
+		snprintf(newname, sizeof(newname), "%s.1", console_logfile_name);
+		rename(console_logfile_name, newname);
+	} else
+		unlink(console_logfile_name);
+
+	__atomic_add_fetch(&console_logfile_stats.rotations, 1, __ATOMIC_RELAXED);
+	console_logfile_open();
+}
+
+// Writes out the queued lines in batches. Only one thread can call this at a time.
+static void console_logfile_write_queued(void) {
+	struct iovec iov[CONSOLE_LOGFILE_MAXBATCHSIZE];
+	console_logfile_entry_t *entry;
+	uint32_t pos = console_logfile_dequeue_pos;
+	ssize_t written;
+	size_t batchbytes;
+	int count;
+	int i;
+
+	while (1) {
+		batchbytes = 0;
+		for (count = 0; count < CONSOLE_LOGFILE_MAXBATCHSIZE; count++) {
+			entry = &console_logfile_ring[(pos+count) & console_logfile_ring_mask];
+			if (__atomic_load_n(&entry->seq, __ATOMIC_ACQUIRE) != pos+count+1)
+				break;
+
+			iov[count].iov_base = entry->line;
+			iov[count].iov_len = entry->length;
+			batchbytes += entry->length;
+		}
+		if (count == 0)
+			return;
+
+		if (console_logfile_fd >= 0) {
+			written = writev(console_logfile_fd, iov, count);
+			if (written > 0)
+				console_logfile_size += written;
+			if (written < 0 || (size_t)written != batchbytes)
+				__atomic_add_fetch(&console_logfile_stats.write_errors, count, __ATOMIC_RELAXED);
+			else
+				__atomic_add_fetch(&console_logfile_stats.lines_written, count, __ATOMIC_RELAXED);
+		} else
+			__atomic_add_fetch(&console_logfile_stats.write_errors, count, __ATOMIC_RELAXED);
+
+		// Releasing the written entries for the producers.
+		for (i = 0; i < count; i++) {
+			entry = &console_logfile_ring[(pos+i) & console_logfile_ring_mask];
+			__atomic_store_n(&entry->seq, pos+i+console_logfile_ring_mask+1, __ATOMIC_RELEASE);
+		}
+		pos += count;
+		__atomic_store_n(&console_logfile_dequeue_pos, pos, __ATOMIC_RELEASE);
+
+		if (console_logfile_maxsize > 0 && console_logfile_size >= console_logfile_maxsize)
+			console_logfile_rotate();
+	}
+}
+
+// Writes a line about the dropped lines since the last call, so gaps in the log can be noticed.
+static void console_logfile_write_dropped(void) {
+	char line[CONSOLE_LOGFILE_MAXLINESIZE];
+	uint32_t dropped = __atomic_load_n(&console_logfile_stats.lines_dropped, __ATOMIC_RELAXED);
+	struct tm currtm;
+	time_t rawtime;
+	int linelen;
+
+	if (dropped == console_logfile_dropped_reported || console_logfile_fd < 0)
+		return;
+
+	time(&rawtime);
+	gmtime_r(&rawtime, &currtm);
+	linelen = snprintf(line, sizeof(line), "[%.4d/%.2d/%.2d %.2d:%.2d:%.2d] console logfile: log queue full, %u lines dropped\n",
+		currtm.tm_year + 1900, currtm.tm_mon+1, currtm.tm_mday, currtm.tm_hour, currtm.tm_min, currtm.tm_sec,
+		dropped - console_logfile_dropped_reported);
+	console_logfile_dropped_reported = dropped;
+
+	if (write(console_logfile_fd, line, linelen) == linelen)
+		console_logfile_size += linelen;
+}
+
+static void *console_logfile_thread_init(void *arg) {
+	struct timespec ts;
+	flag_t should_stop;
+	time_t now;
+
+	console_logfile_open();
+
+	while (1) {
+		// Checking the stop flag before writing, so the lines queued before stopping are written out.
+		should_stop = __atomic_load_n(&console_logfile_thread_should_stop, __ATOMIC_ACQUIRE);
+
+		now = time(NULL);
+		if (__atomic_exchange_n(&console_logfile_reopen_requested, 0, __ATOMIC_ACQ_REL))
+			console_logfile_open();
+		else if (console_logfile_fd < 0 && now != console_logfile_last_open_try_time)
+			console_logfile_open();
+		else if (console_logfile_next_rotate_time > 0 && now >= console_logfile_next_rotate_time)
+			console_logfile_rotate();
+
+		console_logfile_write_queued();
+		console_logfile_write_dropped();
+
+		if (should_stop)
+			break;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += CONSOLE_LOGFILE_WAKEUPINMS*1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+
+		pthread_mutex_lock(&console_logfile_mutex_wakeup);
+		pthread_cond_timedwait(&console_logfile_cond_wakeup, &console_logfile_mutex_wakeup, &ts);
+		pthread_mutex_unlock(&console_logfile_mutex_wakeup);
+	}
+
+	pthread_exit((void*) 0);
+}
+
+void console_logfile_init(void) {
+	pthread_attr_t attr;
+	int queuesize;
+	uint32_t ringsize = 1;
+	uint32_t i;
+
+	queuesize = config_get_logqueuesize();
+	if (queuesize <= 0) {
+		console_log("console logfile: log queue disabled, writing log file directly\n");
+		return;
+	}
+
+	while (ringsize < (uint32_t)queuesize && ringsize < CONSOLE_LOGFILE_MAXQUEUESIZE)
+		ringsize <<= 1;
+
+	console_logfile_ring = (console_logfile_entry_t *)malloc(ringsize * sizeof(console_logfile_entry_t));
+	if (console_logfile_ring == NULL) {
+		console_log("console logfile error: can't allocate memory for the log queue, writing log file directly\n");
+		return;
+	}
+	for (i = 0; i < ringsize; i++)
+		console_logfile_ring[i].seq = i;
+	console_logfile_ring_mask = ringsize-1;
+	console_logfile_enqueue_pos = 0;
+	console_logfile_dequeue_pos = 0;
+	console_logfile_dropped_reported = __atomic_load_n(&console_logfile_stats.lines_dropped, __ATOMIC_RELAXED);
+	console_logfile_thread_should_stop = 0;
+	console_logfile_reopen_requested = 0;
+
+	pthread_cond_init(&console_logfile_cond_wakeup, NULL);
+
+	// Explicitly creating the thread as joinable to be compatible with other systems.
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+	if (pthread_create(&console_logfile_thread, &attr, console_logfile_thread_init, NULL) != 0) {
+		console_log("console logfile error: can't start writer thread, writing log file directly\n");
+		pthread_attr_destroy(&attr);
+		pthread_cond_destroy(&console_logfile_cond_wakeup);
+		free(console_logfile_ring);
+		console_logfile_ring = NULL;
+		return;
+	}
+	pthread_attr_destroy(&attr);
+
+	__atomic_store_n(&console_logfile_thread_running, 1, __ATOMIC_RELEASE);
+	console_log("console logfile: writer thread started, queue size: %u\n", ringsize);
+}
+
+// This is called after the other threads have been stopped, so only this thread adds lines.
+void console_logfile_deinit(void) {
+	void *status = NULL;
+
+	if (!__atomic_load_n(&console_logfile_thread_running, __ATOMIC_ACQUIRE))
+		return;
+
+	__atomic_store_n(&console_logfile_thread_should_stop, 1, __ATOMIC_RELEASE);
+	pthread_cond_signal(&console_logfile_cond_wakeup);
+	pthread_join(console_logfile_thread, &status);
+
+	// From now on lines are written directly. Writing out the lines the thread may have missed.
+	__atomic_store_n(&console_logfile_thread_running, 0, __ATOMIC_RELEASE);
+	console_logfile_write_queued();
+	console_logfile_write_dropped();
+	console_logfile_close();
+
+	pthread_cond_destroy(&console_logfile_cond_wakeup);
+	free(console_logfile_ring);
+	console_logfile_ring = NULL;
+	free(console_logfile_name);
+	console_logfile_name = NULL;
+}
@@ -0,0 +1,39 @@
+/*
+ * This file is part of dmrshark.
+ *
+ * dmrshark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * dmrshark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
+**/
+
+#ifndef CONSOLE_LOGFILE_H_
+#define CONSOLE_LOGFILE_H_
+
+#include <libs/base/types.h>
+
+// Max. length of a log file line, including the timestamp and the line feed.
+#define CONSOLE_LOGFILE_MAXLINESIZE		288
+// Max. number of lines written with one writev() call.
+#define CONSOLE_LOGFILE_MAXBATCHSIZE	64
+
+// Adds the given line to the log file write queue. The line should end with a line feed.
+// If the writer thread is not running, the line is written to the log file directly.
+void console_logfile_add(char *line, int linelen);
+
+// Makes the writer thread close and reopen the log file, for example after it has been moved away.
+void console_logfile_reopen(void);
+void console_logfile_print_stats(void);
+
+void console_logfile_init(void);
+void console_logfile_deinit(void);
+
+#endif
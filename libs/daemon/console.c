@@ -18,6 +18,7 @@
 #include DEFAULTCONFIG
 
 #include "console.h"
+#include "console-logfile.h"
 #include "daemon.h"
 #include "daemon-poll.h"
 #include "daemon-consoleclient.h"
@@ -39,7 +40,7 @@
 #define CONSOLELOGBUFFERSIZE	CONSOLE_INPUTBUFFERSIZE
 #define CONSOLE_NEWLINECHAR		'\n'
 
-static loglevel_t loglevel = { .raw = 0xff };
+loglevel_t console_loglevel = { .raw = 0xff };
 static char console_buffer[CONSOLE_INPUTBUFFERSIZE] = {0,};
 static uint16_t console_buffer_pos = 0;
 static struct termios console_termios_save = {0,};
@@ -47,11 +48,11 @@ static flag_t console_termios_saved = 0;
 static pthread_mutex_t console_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 loglevel_t console_get_loglevel(void) {
-	return loglevel;
+	return console_loglevel;
 }
 
 void console_set_loglevel(loglevel_t *new_loglevel) {
-	loglevel = *new_loglevel;
+	console_loglevel = *new_loglevel;
 }
 
 char *console_get_buffer(void) {
@@ -124,12 +125,11 @@ void console_rxbuf_add(char inputchar, flag_t vt100supported) {
 void console_addtologfile(char *msg, int msglen) {
 	static char linebuf[255] = {0,};
 	static int linebufpos = 0;
-	char timestamp[23] = {0,};
+	char line[CONSOLE_LOGFILE_MAXLINESIZE];
+	int linelen;
 	int i;
-	struct tm *currtm;
+	struct tm currtm;
 	time_t rawtime;
-	int logfile;
-	char *logfilename = NULL;
 
 	for (i = 0; i < msglen; i++) {
 		if (msg[i] == 27) { // Skipping VT100 terminal codes
@@ -148,27 +148,13 @@ void console_addtologfile(char *msg, int msglen) {
 			continue;
 		if (msg[i] == '\n' || linebufpos == sizeof(linebuf)) {
 			time(&rawtime);
-			currtm = gmtime(&rawtime);
-			snprintf(timestamp, sizeof(timestamp), "[%.4d/%.2d/%.2d %.2d:%.2d:%.2d]", currtm->tm_year + 1900, currtm->tm_mon+1, currtm->tm_mday, currtm->tm_hour, currtm->tm_min, currtm->tm_sec);
-
-			logfilename = config_get_logfilename();
-			logfile = open(logfilename, O_CREAT | O_APPEND | O_WRONLY, 0664);
-			free(logfilename);
-			if (logfile >= 0) {
-				// Adding a space if we don't have an empty line.
-				if (linebufpos > 0) {
-					timestamp[sizeof(timestamp)-2] = ' ';
-					timestamp[sizeof(timestamp)-1] = 0;
-					write(logfile, timestamp, sizeof(timestamp)-1);
-				} else
-					write(logfile, timestamp, sizeof(timestamp)-2);
-
-				write(logfile, linebuf, linebufpos);
-				write(logfile, "\n", 1);
-
-				//fsync(logfile);
-				close(logfile);
-			}
+			gmtime_r(&rawtime, &currtm);
+			// Adding a space after the timestamp if we don't have an empty line.
+			linelen = snprintf(line, sizeof(line), "[%.4d/%.2d/%.2d %.2d:%.2d:%.2d]%s%.*s\n", currtm.tm_year + 1900, currtm.tm_mon+1,
+				currtm.tm_mday, currtm.tm_hour, currtm.tm_min, currtm.tm_sec, (linebufpos > 0 ? " " : ""), linebufpos, linebuf);
+			if (linelen > (int)sizeof(line)-1)
+				linelen = sizeof(line)-1;
+			console_logfile_add(line, linelen);
 
 			linebufpos = 0;
 			continue;
@@ -178,61 +164,16 @@ void console_addtologfile(char *msg, int msglen) {
 	}
 }
 
-static flag_t console_isallowedtodisplay(char loglevel_char) {
-	switch (loglevel_char) {
-		case LOGLEVEL_DEBUG_VAL: return loglevel.flags.debug;
-		case LOGLEVEL_IPSC_VAL: return loglevel.flags.ipsc;
-		case LOGLEVEL_COMM_IP_VAL: return loglevel.flags.comm_ip;
-		case LOGLEVEL_DMR_VAL: return loglevel.flags.dmr;
-		case LOGLEVEL_DMRLC_VAL: return loglevel.flags.dmrlc;
-		case LOGLEVEL_DMRDATA_VAL: return loglevel.flags.dmrdata;
-		case LOGLEVEL_SNMP_VAL: return loglevel.flags.snmp;
-		case LOGLEVEL_REPEATERS_VAL: return loglevel.flags.repeaters;
-		case LOGLEVEL_HEARTBEAT_VAL: return loglevel.flags.heartbeat;
-		case LOGLEVEL_REMOTEDB_VAL: return loglevel.flags.remotedb;
-		case LOGLEVEL_VOICESTREAMS_VAL: return loglevel.flags.voicestreams;
-		case LOGLEVEL_CODING_VAL: return loglevel.flags.coding;
-		case LOGLEVEL_HTTPSERVER_VAL: return loglevel.flags.httpserver;
-		case LOGLEVEL_DATAQ_VAL: return loglevel.flags.dataq;
-		case LOGLEVEL_APRS_VAL: return loglevel.flags.aprs;
-		default: return 1;
-	}
-}
-
-static flag_t console_isloglevelchar(char loglevel_char) {
-	switch (loglevel_char) {
-		case LOGLEVEL_DEBUG_VAL:
-		case LOGLEVEL_IPSC_VAL:
-		case LOGLEVEL_COMM_IP_VAL:
-		case LOGLEVEL_DMR_VAL:
-		case LOGLEVEL_DMRLC_VAL:
-		case LOGLEVEL_DMRDATA_VAL:
-		case LOGLEVEL_SNMP_VAL:
-		case LOGLEVEL_REPEATERS_VAL:
-		case LOGLEVEL_HEARTBEAT_VAL:
-		case LOGLEVEL_REMOTEDB_VAL:
-		case LOGLEVEL_VOICESTREAMS_VAL:
-		case LOGLEVEL_CODING_VAL:
-		case LOGLEVEL_HTTPSERVER_VAL:
-		case LOGLEVEL_DATAQ_VAL:
-		case LOGLEVEL_APRS_VAL:
-			return 1;
-		default: return 0;
-	}
-}
-
 static int8_t console_loglevel_match(const char *format) {
-    uint8_t first_non_format_char_pos;
-    uint8_t i;
+	int8_t first_non_format_char_pos;
+
+	if (!console_isloglevelenabled(format))
+		return -1;
 
 	first_non_format_char_pos = 0;
-	while (console_isloglevelchar(format[first_non_format_char_pos]))
+	while (console_loglevel_char_to_mask(format[first_non_format_char_pos]) != 0)
 		first_non_format_char_pos++;
 
-	for (i = 0; i < first_non_format_char_pos; i++) {
-		if (!console_isallowedtodisplay(format[i]))
-			return -1;
-	}
 	return first_non_format_char_pos;
 }
 
@@ -250,7 +191,8 @@ static void console_log_display(const char *text, va_list argptr) {
 	}
 }
 
-void console_log(const char *format, ...) {
+// The name is in parentheses, so it's not replaced by the console_log() macro.
+void (console_log)(const char *format, ...) {
 	va_list argptr;
 	int8_t first_non_format_char_pos;
 
@@ -298,7 +240,7 @@ void console_init(void) {
 
 	console_log("console: init\n");
 
-	loglevel.raw = config_get_loglevel();
+	console_loglevel.raw = config_get_loglevel();
 
 	if (!daemon_is_daemonize()) {
 		setvbuf(stdin, NULL, _IONBF, 0);
@@ -313,6 +255,9 @@ void console_init(void) {
 	}
 
 	daemon_poll_addfd_read(STDIN_FILENO);
+
+	if (daemon_is_consoleserver())
+		console_logfile_init();
 }
 
 void console_deinit(void) {
@@ -323,5 +268,6 @@ void console_deinit(void) {
 		if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &console_termios_save) < 0)
 			console_log("console error: can't restore console settings\n");
 	}
+	console_logfile_deinit();
 	pthread_mutex_destroy(&console_mutex);
 }
@@ -53,8 +53,25 @@
 #define LOGLEVEL_APRS				"\x11"
 #define LOGLEVEL_APRS_VAL			0x11
 
+// Masks of the loglevel flags in loglevel_t.raw, in the order of the flags.
+#define LOGLEVEL_DEBUG_MASK			(1 << 0)
+#define LOGLEVEL_IPSC_MASK			(1 << 1)
+#define LOGLEVEL_COMM_IP_MASK		(1 << 2)
+#define LOGLEVEL_DMR_MASK			(1 << 3)
+#define LOGLEVEL_DMRLC_MASK			(1 << 4)
+#define LOGLEVEL_DMRDATA_MASK		(1 << 5)
+#define LOGLEVEL_SNMP_MASK			(1 << 6)
+#define LOGLEVEL_REPEATERS_MASK		(1 << 7)
+#define LOGLEVEL_HEARTBEAT_MASK		(1 << 8)
+#define LOGLEVEL_REMOTEDB_MASK		(1 << 9)
+#define LOGLEVEL_VOICESTREAMS_MASK	(1 << 10)
+#define LOGLEVEL_CODING_MASK		(1 << 11)
+#define LOGLEVEL_HTTPSERVER_MASK	(1 << 12)
+#define LOGLEVEL_DATAQ_MASK			(1 << 13)
+#define LOGLEVEL_APRS_MASK			(1 << 14)
+
 // Don't forget to add new loglevels to the log command handler in command.c,
-// and to the loglevel display list in log.c!
+// to console_loglevel_char_to_mask() below, and to the loglevel display list in log.c!
 typedef union __attribute__((packed)) {
 	struct __attribute__((packed)) {
 		uint16_t debug			: 1;
@@ -76,6 +93,46 @@ typedef union __attribute__((packed)) {
 	uint16_t raw;
 } loglevel_t;
 
+extern loglevel_t console_loglevel;
+
+static inline uint16_t console_loglevel_char_to_mask(char loglevel_char) {
+	switch (loglevel_char) {
+		case LOGLEVEL_DEBUG_VAL: return LOGLEVEL_DEBUG_MASK;
+		case LOGLEVEL_IPSC_VAL: return LOGLEVEL_IPSC_MASK;
+		case LOGLEVEL_COMM_IP_VAL: return LOGLEVEL_COMM_IP_MASK;
+		case LOGLEVEL_DMR_VAL: return LOGLEVEL_DMR_MASK;
+		case LOGLEVEL_DMRLC_VAL: return LOGLEVEL_DMRLC_MASK;
+		case LOGLEVEL_DMRDATA_VAL: return LOGLEVEL_DMRDATA_MASK;
+		case LOGLEVEL_SNMP_VAL: return LOGLEVEL_SNMP_MASK;
+		case LOGLEVEL_REPEATERS_VAL: return LOGLEVEL_REPEATERS_MASK;
+		case LOGLEVEL_HEARTBEAT_VAL: return LOGLEVEL_HEARTBEAT_MASK;
+		case LOGLEVEL_REMOTEDB_VAL: return LOGLEVEL_REMOTEDB_MASK;
+		case LOGLEVEL_VOICESTREAMS_VAL: return LOGLEVEL_VOICESTREAMS_MASK;
+		case LOGLEVEL_CODING_VAL: return LOGLEVEL_CODING_MASK;
+		case LOGLEVEL_HTTPSERVER_VAL: return LOGLEVEL_HTTPSERVER_MASK;
+		case LOGLEVEL_DATAQ_VAL: return LOGLEVEL_DATAQ_MASK;
+		case LOGLEVEL_APRS_VAL: return LOGLEVEL_APRS_MASK;
+		default: return 0;
+	}
+}
+
+// Returns 1 if all loglevels at the start of the given format string are enabled.
+// If NODEBUGLOG is defined, messages with the debug loglevel are never displayed. As the format
+// is usually a string literal, the compiler can remove these calls entirely.
+static inline flag_t console_isloglevelenabled(const char *format) {
+	uint16_t mask;
+
+	for (; (mask = console_loglevel_char_to_mask(*format)) != 0; format++) {
+#ifdef NODEBUGLOG
+		if (mask == LOGLEVEL_DEBUG_MASK)
+			return 0;
+#endif
+		if ((console_loglevel.raw & mask) == 0)
+			return 0;
+	}
+	return 1;
+}
+
 loglevel_t console_get_loglevel(void);
 void console_set_loglevel(loglevel_t *new_loglevel);
 char *console_get_buffer(void);
@@ -85,6 +142,9 @@ void console_rxbuf_add(char inputchar, flag_t vt100supported);
 
 void console_addtologfile(char *msg, int msglen);
 void console_log(const char *format, ...);
+// The loglevel is checked before the arguments are evaluated and console_log() is called,
+// so disabled log messages don't cost more than a few bit tests.
+#define console_log(format, ...) (console_isloglevelenabled(format) ? console_log(format, ##__VA_ARGS__) : (void)0)
 void console_log_va_list(const char *loglevel, const char *format, va_list argptr);
 
 void console_process(void);
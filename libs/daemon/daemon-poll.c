@@ -15,58 +15,144 @@
  * along with dmrshark.  If not, see <http://www.gnu.org/licenses/>.
 **/
 
+#include DEFAULTCONFIG
+
 #include "daemon-poll.h"
+#include "console.h"
 
+#include <sys/epoll.h>
 #include <stdlib.h>
 #include <stdio.h>
-
-static struct pollfd *pfd = NULL; // This stores the watched file descriptors as pollfd structures.
-static int pfdcount = 0; // How much pollfd structures we store.
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Watched file descriptors are stored in a table indexed by the fd, so lookups don't need a search.
+// Only the fds returned by epoll_wait() are looked at after a poll, the others are not touched.
+//
+// All fds are level-triggered, as callers don't necessarily drain them (for example packet capture
+// processes max. a batch of packets in one main loop pass).
+
+typedef struct {
+	short events;
+	short revents; // Only valid if revents_generation is the current poll generation.
+	unsigned int revents_generation;
+	daemon_poll_callback_t callback;
+	void *callback_arg;
+	char watched;
+} daemon_poll_fd_t;
+
+static int epollfd = -1;
+static daemon_poll_fd_t *fds = NULL; // Indexed by the file descriptor.
+static int fdssize = 0;
+static int watchedcount = 0;
+static unsigned int generation = 0;
+static struct epoll_event readyevents[DAEMON_POLL_MAX_EVENTS]; // The ready list of the last poll.
+static int readycount = 0;
 static int polltimeout = 0;
 
-static int daemon_poll_pfdrealloc(int count) {
-	struct pollfd *newpfd;
+static uint32_t daemon_poll_events_to_epoll(short events) {
+	uint32_t epollevents = 0;
+
+	if (events & POLLIN)
+		epollevents |= EPOLLIN;
+	if (events & POLLPRI)
+		epollevents |= EPOLLPRI;
+	if (events & POLLOUT)
+		epollevents |= EPOLLOUT;
+	return epollevents;
+}
+
+static short daemon_poll_epoll_to_events(uint32_t epollevents) {
+	short events = 0;
+
+	if (epollevents & EPOLLIN)
+		events |= POLLIN;
+	if (epollevents & EPOLLPRI)
+		events |= POLLPRI;
+	if (epollevents & EPOLLOUT)
+		events |= POLLOUT;
+	if (epollevents & EPOLLERR)
+		events |= POLLERR;
+	if (epollevents & EPOLLHUP)
+		events |= POLLHUP;
+	return events;
+}
+
+static daemon_poll_fd_t *daemon_poll_getwatchedfd(int fd) {
+	if (fd < 0 || fd >= fdssize || !fds[fd].watched)
+		return NULL;
+
+	return &fds[fd];
+}
+
+static int daemon_poll_fdsrealloc(int fd) {
+	daemon_poll_fd_t *newfds;
+	int newsize;
 
-	if (count <= 0) {
-		free(pfd);
-		pfd = NULL;
+	if (fd < fdssize)
 		return 1;
-	}
 
-	newpfd = (struct pollfd *)realloc(pfd, sizeof(struct pollfd) * count);
-	if (!newpfd)
+	newsize = (fdssize > 0 ? fdssize : 64);
+	while (newsize <= fd)
+		newsize *= 2;
+
+	newfds = (daemon_poll_fd_t *)realloc(fds, sizeof(daemon_poll_fd_t) * newsize);
+	if (!newfds)
 		return 0;
 
-	pfd = newpfd;
+	memset(newfds+fdssize, 0, sizeof(daemon_poll_fd_t) * (newsize-fdssize));
+	fds = newfds;
+	fdssize = newsize;
 	return 1;
 }
 
-static int daemon_poll_getpfdindex(int fd) {
-	int i;
+static void daemon_poll_epollctl(int fd, int op, short events) {
+	struct epoll_event ev;
 
-	for (i = 0; i < pfdcount; i++) {
-		if (pfd[i].fd == fd)
-			return i;
-	}
-	return -1;
-}
+	memset(&ev, 0, sizeof(struct epoll_event));
+	ev.events = daemon_poll_events_to_epoll(events);
+	ev.data.fd = fd;
 
-void daemon_poll_addfd(int fd, short events) {
-	int i = daemon_poll_getpfdindex(fd);
+	if (epoll_ctl(epollfd, op, fd, &ev) == 0)
+		return;
 
-	if (i >= 0) { // If we already watch the fd, we update the watched events
-		pfd[i].events |= events;
-		pfd[i].revents = 0;
+	// The fd may have been closed and reopened without removing it first.
+	if (op == EPOLL_CTL_MOD && errno == ENOENT)
+		epoll_ctl(epollfd, EPOLL_CTL_ADD, fd, &ev);
+	else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+		epoll_ctl(epollfd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void daemon_poll_addfd_callback(int fd, short events, daemon_poll_callback_t callback, void *arg) {
+	daemon_poll_fd_t *pfd = daemon_poll_getwatchedfd(fd);
+
+	if (pfd) { // If we already watch the fd, we update the watched events
+		pfd->events |= events;
+		pfd->revents_generation = 0;
+		if (callback) {
+			pfd->callback = callback;
+			pfd->callback_arg = arg;
+		}
+		daemon_poll_epollctl(fd, EPOLL_CTL_MOD, pfd->events);
 		return;
 	}
 
-	if (!daemon_poll_pfdrealloc(pfdcount+1))
+	if (fd < 0 || epollfd < 0 || !daemon_poll_fdsrealloc(fd))
 		return;
 
-	pfd[pfdcount].fd = fd;
-	pfd[pfdcount].events = events;
-	pfd[pfdcount].revents = 0;
-	pfdcount++;
+	pfd = &fds[fd];
+	memset(pfd, 0, sizeof(daemon_poll_fd_t));
+	pfd->events = events;
+	pfd->callback = callback;
+	pfd->callback_arg = arg;
+	pfd->watched = 1;
+	watchedcount++;
+	daemon_poll_epollctl(fd, EPOLL_CTL_ADD, events);
+}
+
+void daemon_poll_addfd(int fd, short events) {
+	daemon_poll_addfd_callback(fd, events, NULL, NULL);
 }
 
 void daemon_poll_addfd_read(int fd) {
@@ -82,36 +168,24 @@ void daemon_poll_addfd_readwrite(int fd) {
 }
 
 void daemon_poll_changefd(int fd, short events) {
-	int i = daemon_poll_getpfdindex(fd);
+	daemon_poll_fd_t *pfd = daemon_poll_getwatchedfd(fd);
 
-	if (i >= 0) {
-		pfd[i].events = events;
-//		pfd[i].revents = 0;
+	if (pfd) {
+		pfd->events = events;
+		daemon_poll_epollctl(fd, EPOLL_CTL_MOD, events);
 	}
 }
 
 void daemon_poll_removefd(int fd) {
-	int i, found = 0;
+	daemon_poll_fd_t *pfd = daemon_poll_getwatchedfd(fd);
 
-	if (pfdcount <= 0)
+	if (!pfd)
 		return;
 
-	// Searching for the fd
-	for (i = 0; i < pfdcount-1; i++) {
-		if (pfd[i].fd == fd)
-			found = 1;
-		// If the item was found, we shift the other ones to the left
-		if (found)
-			pfd[i] = pfd[i+1];
-	}
-
-	if (pfd[pfdcount-1].fd == fd)
-		found = 1;
-
-	if (found) {
-		pfdcount--;
-		daemon_poll_pfdrealloc(pfdcount);
-	}
+	// This fails if the fd is already closed, but then the kernel has already removed it.
+	epoll_ctl(epollfd, EPOLL_CTL_DEL, fd, NULL);
+	memset(pfd, 0, sizeof(daemon_poll_fd_t));
+	watchedcount--;
 }
 
 void daemon_poll_setmaxtimeout(int timeout) {
@@ -119,46 +193,85 @@ void daemon_poll_setmaxtimeout(int timeout) {
 		polltimeout = timeout;
 }
 
-int daemon_poll_isfdreadable(int fd) {
-	int i = daemon_poll_getpfdindex(fd);
+static short daemon_poll_getrevents(int fd) {
+	daemon_poll_fd_t *pfd = daemon_poll_getwatchedfd(fd);
 
-	if (i < 0)
+	if (!pfd || pfd->revents_generation != generation)
 		return 0;
 
-	return ((pfd[i].revents & POLLIN) > 0);
+	return pfd->revents;
+}
+
+int daemon_poll_isfdreadable(int fd) {
+	return ((daemon_poll_getrevents(fd) & POLLIN) > 0);
 }
 
 int daemon_poll_isfdwritable(int fd) {
-	int i = daemon_poll_getpfdindex(fd);
+	return ((daemon_poll_getrevents(fd) & POLLOUT) > 0);
+}
 
-	if (i < 0)
-		return 0;
+void daemon_poll_process(void) {
+	daemon_poll_fd_t *pfd;
+	int i;
+	int fd;
+
+	generation++;
+	// Generation 0 means no events, so we skip it when the counter wraps around.
+	if (generation == 0)
+		generation++;
+
+	readycount = 0;
+	if (epollfd >= 0) {
+		readycount = epoll_wait(epollfd, readyevents, DAEMON_POLL_MAX_EVENTS, polltimeout);
+		if (readycount < 0)
+			readycount = 0;
+	}
 
-	return ((pfd[i].revents & POLLOUT) > 0);
-}
+	for (i = 0; i < readycount; i++) {
+		pfd = daemon_poll_getwatchedfd(readyevents[i].data.fd);
+		if (!pfd)
+			continue;
 
-struct pollfd *daemon_poll_getpfd(void) {
-	return pfd;
-}
+		pfd->revents = daemon_poll_epoll_to_events(readyevents[i].events);
+		pfd->revents_generation = generation;
+	}
 
-int daemon_poll_getpfdcount(void) {
-	return pfdcount;
-}
+	// Calling the callbacks of the ready fds. A callback may remove or add fds, so we look up the
+	// fd again for every entry.
+	for (i = 0; i < readycount; i++) {
+		fd = readyevents[i].data.fd;
+		pfd = daemon_poll_getwatchedfd(fd);
+		if (!pfd || !pfd->callback || pfd->revents_generation != generation)
+			continue;
 
-void daemon_poll_process(void) {
-	poll(pfd, pfdcount, polltimeout);
+		pfd->callback(fd, pfd->events, pfd->revents, pfd->callback_arg);
+	}
 
 	// Setting a default poll timeout, this can be overridden once at a time by daemon_poll_setmaxtimeout()
 	polltimeout = 1000;
 }
 
-void daemon_poll_init(void) {
-	pfdcount = 0;
+flag_t daemon_poll_init(void) {
+	watchedcount = 0;
+	readycount = 0;
+
+	epollfd = epoll_create1(EPOLL_CLOEXEC);
+	if (epollfd < 0) {
+		console_log("daemon-poll error: can't create epoll fd: %s\n", strerror(errno));
+		return 0;
+	}
+	return 1;
 }
 
 void daemon_poll_deinit(void) {
-	if (pfd)
-		free(pfd);
-	pfd = NULL;
-	pfdcount = 0;
+	if (epollfd >= 0)
+		close(epollfd);
+	epollfd = -1;
+
+	if (fds)
+		free(fds);
+	fds = NULL;
+	fdssize = 0;
+	watchedcount = 0;
+	readycount = 0;
 }
@@ -18,8 +18,18 @@
 #ifndef DAEMON_POLL_H_
 #define DAEMON_POLL_H_
 
+#include <libs/base/types.h>
+
 #include <sys/poll.h>
 
+// Max. number of ready file descriptors returned by one epoll_wait() call. If there are more,
+// they will be returned by the next call.
+#define DAEMON_POLL_MAX_EVENTS			64
+
+// Called from daemon_poll_process() if events happen on the watched file descriptor.
+// Events contains the watched, revents the happened events as poll() event flags.
+typedef void (*daemon_poll_callback_t)(int fd, short events, short revents, void *arg);
+
 // This function adds the given file descriptor to the watched file descriptor list.
 // Events represents the events we need to watch on this fd (see "man poll").
 void daemon_poll_addfd(int fd, short events);
@@ -27,6 +37,8 @@ void daemon_poll_addfd(int fd, short events);
 void daemon_poll_addfd_read(int fd);
 void daemon_poll_addfd_write(int fd);
 void daemon_poll_addfd_readwrite(int fd);
+// Same as daemon_poll_addfd(), but the given callback will be called when events happen on the fd.
+void daemon_poll_addfd_callback(int fd, short events, daemon_poll_callback_t callback, void *arg);
 void daemon_poll_changefd(int fd, short events);
 // This function removes the given file descriptor from the watched file descriptor list.
 void daemon_poll_removefd(int fd);
@@ -38,11 +50,9 @@ void daemon_poll_setmaxtimeout(int timeout);
 int daemon_poll_isfdreadable(int fd);
 int daemon_poll_isfdwritable(int fd);
 
-struct pollfd *daemon_poll_getpfd(void);
-int daemon_poll_getpfdcount(void);
-
 void daemon_poll_process(void);
-void daemon_poll_init(void);
+// Returns 0 if the epoll fd can't be created, the daemon can't run without it.
+flag_t daemon_poll_init(void);
 void daemon_poll_deinit(void);
 
 #endif
@@ -36,6 +36,7 @@
 #include <string.h>
 
 extern volatile base_flags_t base_flags;
+extern volatile sig_atomic_t base_sighup_received;
 
 static flag_t daemon_daemonize = 1;
 // Storing these flags separately, as printing to the console can happen before daemon_init().
@@ -79,6 +80,9 @@ static void daemon_sighandler(int signal) {
 			base_flags.sigterm_received = 1;
 			base_flags.sigexit = 1;
 			break;
+		case SIGHUP: // The config will be reloaded by the main loop.
+			base_sighup_received = 1;
+			break;
 	}
 }
 
@@ -204,7 +208,10 @@ flag_t daemon_init(flag_t daemonize, flag_t consoleclient) {
 		}
 	}
 
-	daemon_poll_init();
+	if (!daemon_poll_init()) {
+		free(daemonctlfile);
+		return DAEMON_INIT_RESULT_POLL_ERROR;
+	}
 
 	if (daemon_daemonize) {
 		console_log("daemon: forking to the background\n");
@@ -243,7 +250,7 @@ flag_t daemon_init(flag_t daemonize, flag_t consoleclient) {
 	daemon_consoleclient = consoleclient;
 	daemon_consoleserver = !consoleclient;
 
-	signal(SIGHUP, SIG_IGN);
+	signal(SIGHUP, daemon_sighandler);
 	signal(SIGINT, daemon_sighandler);
 	signal(SIGTERM, daemon_sighandler);
 	signal(SIGPIPE, SIG_IGN);
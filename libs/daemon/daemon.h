@@ -24,6 +24,7 @@
 #define DAEMON_INIT_RESULT_FORKED_PARENTEXIT	1
 #define DAEMON_INIT_RESULT_FORK_ERROR			2
 #define DAEMON_INIT_RESULT_CONSOLECLIENT_ERROR	3
+#define DAEMON_INIT_RESULT_POLL_ERROR			4
 typedef uint8_t daemon_init_result_t;
 
 flag_t daemon_is_consoleclient(void);
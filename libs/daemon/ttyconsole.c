@@ -23,6 +23,7 @@
 #include "daemon-consoleserver.h"
 
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 
 #include <unistd.h>
 #include <stdlib.h>
@@ -60,8 +61,9 @@ void ttyconsole_print(const char *format, ...) {
 void ttyconsole_process(void) {
 	char buf[CONSOLE_INPUTBUFFERSIZE];
 	int j, r;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (config_get_ttyconsoleenabled() && daemon_poll_isfdreadable(ttyconsole.fd)) {
+	if (config_snapshot != NULL && config_snapshot->ttyconsoleenabled && daemon_poll_isfdreadable(ttyconsole.fd)) {
 		r = read(ttyconsole.fd, buf, sizeof(buf));
 		daemon_consoleserver_sendbroadcast(buf, r);
 		for (j = 0; j < r; j++)
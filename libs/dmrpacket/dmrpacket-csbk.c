@@ -38,9 +38,7 @@ static char *dmrpacket_csbk_get_readable_csbko(dmrpacket_csbko_t csbko) {
 }
 
 // See DMR AI. spec. page 67. and DMR services spec. page 53.
-dmrpacket_csbk_t *dmrpacket_csbk_decode(bptc_196_96_data_bits_t *data_bits) {
-	static dmrpacket_csbk_t csbk;
-	uint8_t i;
+dmrpacket_csbk_t *dmrpacket_csbk_decode_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_csbk_t *csbk) {
 	uint16_t calculated_crc = 0;
 	uint16_t crc;
 	uint8_t bytes[12];
@@ -52,8 +50,7 @@ dmrpacket_csbk_t *dmrpacket_csbk_decode(bptc_196_96_data_bits_t *data_bits) {
 
 	base_bitstobytes(data_bits->bits, sizeof(bptc_196_96_data_bits_t), bytes, sizeof(bytes));
 
-	for (i = 0; i < 10; i++)
-		crc_calc_crc16_ccitt(&calculated_crc, bytes[i]);
+	crc_calc_crc16_ccitt_bytes(&calculated_crc, bytes, 10);
 	crc_calc_crc16_ccitt_finish(&calculated_crc);
 
 	// Inverting according to the inversion polynomial.
@@ -75,57 +72,61 @@ dmrpacket_csbk_t *dmrpacket_csbk_decode(bptc_196_96_data_bits_t *data_bits) {
 		return NULL;
 	}
 
-	csbk.last_block = (bytes[0] & 0b10000000) > 0;
-	console_log(LOGLEVEL_DMRLC "    last block: %u\n", csbk.last_block);
-	csbk.dst_id = bytes[4] << 16 | bytes[5] << 8 | bytes[6];
-	console_log(LOGLEVEL_DMRLC "    dst id: %u\n", csbk.dst_id);
-	csbk.src_id = bytes[7] << 16 | bytes[8] << 8 | bytes[9];
-	console_log(LOGLEVEL_DMRLC "    src id: %u\n", csbk.src_id);
+	csbk->last_block = (bytes[0] & 0b10000000) > 0;
+	console_log(LOGLEVEL_DMRLC "    last block: %u\n", csbk->last_block);
+	csbk->dst_id = bytes[4] << 16 | bytes[5] << 8 | bytes[6];
+	console_log(LOGLEVEL_DMRLC "    dst id: %u\n", csbk->dst_id);
+	csbk->src_id = bytes[7] << 16 | bytes[8] << 8 | bytes[9];
+	console_log(LOGLEVEL_DMRLC "    src id: %u\n", csbk->src_id);
 
-	csbk.csbko = bytes[0] & 0b111111;
-	console_log(LOGLEVEL_DMRLC "    csbko: %s (%.2x)\n", dmrpacket_csbk_get_readable_csbko(csbk.csbko), csbk.csbko);
-	switch (csbk.csbko) {
+	csbk->csbko = bytes[0] & 0b111111;
+	console_log(LOGLEVEL_DMRLC "    csbko: %s (%.2x)\n", dmrpacket_csbk_get_readable_csbko(csbk->csbko), csbk->csbko);
+	switch (csbk->csbko) {
 		case DMRPACKET_CSBKO_BS_OUTBOUND_ACTIVATION: // No important params to parse.
 			break;
 		case DMRPACKET_CSBKO_UNIT_TO_UNIT_VOICE_SERVICE_REQUEST:
-			csbk.data.unit_to_unit_voice_service_request.service_options = bytes[2];
-			console_log(LOGLEVEL_DMRLC "      service options: 0x%.2x\n", csbk.data.unit_to_unit_voice_service_request.service_options);
+			csbk->data.unit_to_unit_voice_service_request.service_options = bytes[2];
+			console_log(LOGLEVEL_DMRLC "      service options: 0x%.2x\n", csbk->data.unit_to_unit_voice_service_request.service_options);
 			break;
 		case DMRPACKET_CSBKO_UNIT_TO_UNIT_VOICE_SERVICE_ANSWER_RESPONSE:
-			csbk.data.unit_to_unit_voice_service_answer_response.service_options = bytes[2];
-			console_log(LOGLEVEL_DMRLC "      service options: 0x%.2x\n", csbk.data.unit_to_unit_voice_service_answer_response.service_options);
-			csbk.data.unit_to_unit_voice_service_answer_response.answer_response = bytes[3];
-			console_log(LOGLEVEL_DMRLC "      answer response: 0x%.2x\n", csbk.data.unit_to_unit_voice_service_answer_response.answer_response);
+			csbk->data.unit_to_unit_voice_service_answer_response.service_options = bytes[2];
+			console_log(LOGLEVEL_DMRLC "      service options: 0x%.2x\n", csbk->data.unit_to_unit_voice_service_answer_response.service_options);
+			csbk->data.unit_to_unit_voice_service_answer_response.answer_response = bytes[3];
+			console_log(LOGLEVEL_DMRLC "      answer response: 0x%.2x\n", csbk->data.unit_to_unit_voice_service_answer_response.answer_response);
 			break;
 		case DMRPACKET_CSBKO_NEGATIVE_ACKNOWLEDGE_RESPONSE:
-			csbk.data.negative_acknowledge_response.source_type = ((bytes[2] & 0b01000000) > 0);
-			console_log(LOGLEVEL_DMRLC "      source type: %u", csbk.data.negative_acknowledge_response.source_type);
-			csbk.data.negative_acknowledge_response.service_type = bytes[2] & 0b111111;
-			console_log(LOGLEVEL_DMRLC "      service type: 0x%.2x\n", csbk.data.negative_acknowledge_response.service_type);
-			csbk.data.negative_acknowledge_response.reason_code = bytes[3];
-			console_log(LOGLEVEL_DMRLC "      reason code: 0x%.2x\n", csbk.data.negative_acknowledge_response.reason_code);
+			csbk->data.negative_acknowledge_response.source_type = ((bytes[2] & 0b01000000) > 0);
+			console_log(LOGLEVEL_DMRLC "      source type: %u", csbk->data.negative_acknowledge_response.source_type);
+			csbk->data.negative_acknowledge_response.service_type = bytes[2] & 0b111111;
+			console_log(LOGLEVEL_DMRLC "      service type: 0x%.2x\n", csbk->data.negative_acknowledge_response.service_type);
+			csbk->data.negative_acknowledge_response.reason_code = bytes[3];
+			console_log(LOGLEVEL_DMRLC "      reason code: 0x%.2x\n", csbk->data.negative_acknowledge_response.reason_code);
 			break;
 		case DMRPACKET_CSBKO_PREAMBLE:
-			csbk.data.preamble.data_follows = ((bytes[2] & 0b10000000) > 0);
-			console_log(LOGLEVEL_DMRLC "      data follows: %u\n", csbk.data.preamble.data_follows);
-			csbk.data.preamble.dst_is_group = ((bytes[2] & 0b01000000) > 0);
-			console_log(LOGLEVEL_DMRLC "      dst is group: %u\n", csbk.data.preamble.dst_is_group);
-			csbk.data.preamble.csbk_blocks_to_follow = bytes[3];
-			console_log(LOGLEVEL_DMRLC "      blocks to follow: %u\n", csbk.data.preamble.csbk_blocks_to_follow);
+			csbk->data.preamble.data_follows = ((bytes[2] & 0b10000000) > 0);
+			console_log(LOGLEVEL_DMRLC "      data follows: %u\n", csbk->data.preamble.data_follows);
+			csbk->data.preamble.dst_is_group = ((bytes[2] & 0b01000000) > 0);
+			console_log(LOGLEVEL_DMRLC "      dst is group: %u\n", csbk->data.preamble.dst_is_group);
+			csbk->data.preamble.csbk_blocks_to_follow = bytes[3];
+			console_log(LOGLEVEL_DMRLC "      blocks to follow: %u\n", csbk->data.preamble.csbk_blocks_to_follow);
 			break;
 		default:
 			console_log(LOGLEVEL_DMRLC "      unknown csbko\n");
 			return NULL;
 	}
 
-	return &csbk;
+	return csbk;
 }
 
-bptc_196_96_data_bits_t *dmrpacket_csbk_construct(dmrpacket_csbk_t *csbk) {
-	static bptc_196_96_data_bits_t data_bits;
+dmrpacket_csbk_t *dmrpacket_csbk_decode(bptc_196_96_data_bits_t *data_bits) {
+	static dmrpacket_csbk_t csbk;
+
+	return dmrpacket_csbk_decode_r(data_bits, &csbk);
+}
+
+bptc_196_96_data_bits_t *dmrpacket_csbk_construct_r(dmrpacket_csbk_t *csbk, bptc_196_96_data_bits_t *data_bits) {
 	uint8_t data_bytes[sizeof(bptc_196_96_data_bits_t)/8] = {0,};
 	uint16_t calculated_crc = 0;
-	uint8_t i;
 
 	data_bytes[0] = (csbk->last_block & 0x01) << 7;
 
@@ -166,8 +167,7 @@ bptc_196_96_data_bits_t *dmrpacket_csbk_construct(dmrpacket_csbk_t *csbk) {
 	data_bytes[8] = (csbk->src_id & 0x00ff00) >> 8;
 	data_bytes[9] = (csbk->src_id & 0x0000ff);
 
-	for (i = 0; i < 10; i++)
-		crc_calc_crc16_ccitt(&calculated_crc, data_bytes[i]);
+	crc_calc_crc16_ccitt_bytes(&calculated_crc, data_bytes, 10);
 	crc_calc_crc16_ccitt_finish(&calculated_crc);
 
 	// Inverting according to the inversion polynomial.
@@ -178,6 +178,12 @@ bptc_196_96_data_bits_t *dmrpacket_csbk_construct(dmrpacket_csbk_t *csbk) {
 	data_bytes[10] = (calculated_crc & 0xff00) >> 8;
 	data_bytes[11] = calculated_crc & 0xff;
 
-	base_bytestobits(data_bytes, sizeof(data_bytes), data_bits.bits, sizeof(bptc_196_96_data_bits_t));
-	return &data_bits;
+	base_bytestobits(data_bytes, sizeof(data_bytes), data_bits->bits, sizeof(bptc_196_96_data_bits_t));
+	return data_bits;
+}
+
+bptc_196_96_data_bits_t *dmrpacket_csbk_construct(dmrpacket_csbk_t *csbk) {
+	static bptc_196_96_data_bits_t data_bits;
+
+	return dmrpacket_csbk_construct_r(csbk, &data_bits);
 }
@@ -58,6 +58,8 @@ typedef struct {
 } dmrpacket_csbk_t;
 
 dmrpacket_csbk_t *dmrpacket_csbk_decode(bptc_196_96_data_bits_t *data_bits);
+dmrpacket_csbk_t *dmrpacket_csbk_decode_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_csbk_t *csbk);
 bptc_196_96_data_bits_t *dmrpacket_csbk_construct(dmrpacket_csbk_t *csbk);
+bptc_196_96_data_bits_t *dmrpacket_csbk_construct_r(dmrpacket_csbk_t *csbk, bptc_196_96_data_bits_t *data_bits);
 
 #endif
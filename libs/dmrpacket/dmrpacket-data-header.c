@@ -116,7 +116,6 @@ static char *dmrpacket_data_header_get_readable_udt_format(dmrpacket_data_header
 }
 
 static uint16_t dmrpacket_data_header_crc_calc(uint8_t data_bytes[12]) {
-	uint8_t i;
 	// In true CRC16-CCITT, initial CRC value should be 0xffff, but DMR spec. uses 0.
 	// See DMR AI spec. page 139.
 	uint16_t crcval = 0;
@@ -124,8 +123,7 @@ static uint16_t dmrpacket_data_header_crc_calc(uint8_t data_bytes[12]) {
 	if (data_bytes == NULL)
 		return 0;
 
-	for (i = 0; i < 10; i++)
-		crc_calc_crc16_ccitt(&crcval, data_bytes[i]);
+	crc_calc_crc16_ccitt_bytes(&crcval, data_bytes, 10);
 	crc_calc_crc16_ccitt_finish(&crcval);
 
 	// Inverting according to the inversion polynomial.
@@ -136,137 +134,142 @@ static uint16_t dmrpacket_data_header_crc_calc(uint8_t data_bytes[12]) {
 	return crcval;
 }
 
-dmrpacket_data_header_t *dmrpacket_data_header_decode(bptc_196_96_data_bits_t *data_bits, flag_t proprietary_header) {
-	static dmrpacket_data_header_t header;
+dmrpacket_data_header_t *dmrpacket_data_header_decode_r(bptc_196_96_data_bits_t *data_bits, flag_t proprietary_header, dmrpacket_data_header_t *header) {
 	uint8_t data_bytes[sizeof(bptc_196_96_data_bits_t)/8];
 
 	if (data_bits == NULL)
 		return NULL;
 
 	base_bitstobytes(data_bits->bits, sizeof(bptc_196_96_data_bits_t), data_bytes, sizeof(data_bytes));
-	memset(&header, 0, sizeof(dmrpacket_data_header_t));
+	memset(header, 0, sizeof(dmrpacket_data_header_t));
 
 	// The CRC field is common for all data header packet formats.
-	header.common.crc =	data_bytes[10] << 8 | data_bytes[11];
+	header->common.crc =	data_bytes[10] << 8 | data_bytes[11];
 
-	if (dmrpacket_data_header_crc_calc(data_bytes) != header.common.crc) {
+	if (dmrpacket_data_header_crc_calc(data_bytes) != header->common.crc) {
 		console_log(LOGLEVEL_DMRDATA "dmrpacket data error: header crc mismatch\n");
 		return NULL;
 	}
 
 	if (proprietary_header) {
 		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "dmrpacket data: decoding proprietary header\n");
-		header.common.service_access_point = (data_bytes[0] & 0b11110000) >> 4;
-		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  service access point: %.2x (%s)\n", header.common.service_access_point, dmrpacket_data_header_get_readable_sap(header.common.service_access_point));
-		header.common.data_packet_format = data_bytes[0] & 0b1111;
-		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  data packet format: %.2x (%s)\n", header.common.data_packet_format, dmrpacket_data_header_get_readable_dpf(header.common.data_packet_format));
-		header.proprietary.manufacturer_id = data_bytes[1];
-		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  manufacturer id: %.2x\n", header.proprietary.manufacturer_id);
-		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  crc: %.4x\n", header.common.crc);
-		return &header;
+		header->common.service_access_point = (data_bytes[0] & 0b11110000) >> 4;
+		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  service access point: %.2x (%s)\n", header->common.service_access_point, dmrpacket_data_header_get_readable_sap(header->common.service_access_point));
+		header->common.data_packet_format = data_bytes[0] & 0b1111;
+		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  data packet format: %.2x (%s)\n", header->common.data_packet_format, dmrpacket_data_header_get_readable_dpf(header->common.data_packet_format));
+		header->proprietary.manufacturer_id = data_bytes[1];
+		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  manufacturer id: %.2x\n", header->proprietary.manufacturer_id);
+		console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  crc: %.4x\n", header->common.crc);
+		return header;
 	}
 
 	// These fields are common for each data packet format.
-	header.common.data_packet_format = data_bytes[0] & 0b1111;
+	header->common.data_packet_format = data_bytes[0] & 0b1111;
 	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "dmrpacket data:\n");
-	console_log(LOGLEVEL_DMRDATA "  data packet format: %s\n", dmrpacket_data_header_get_readable_dpf(header.common.data_packet_format));
-
-	header.common.dst_is_a_group = ((data_bytes[0] & 0b10000000) > 0);
-	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dst is a group: %u\n", header.common.dst_is_a_group);
-	header.common.response_requested = ((data_bytes[0] & 0b01000000) > 0);
-	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  response requested: %u\n", header.common.response_requested);
-	header.common.service_access_point = (data_bytes[1] & 0b11110000) >> 4;
-	console_log(LOGLEVEL_DMRDATA "  service access point: %.2x (%s)\n", header.common.service_access_point, dmrpacket_data_header_get_readable_sap(header.common.service_access_point));
-	header.common.dst_llid = data_bytes[2] << 16 | data_bytes[3] << 8 | data_bytes[4];
-	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dst llid: %u\n", header.common.dst_llid);
-	header.common.src_llid = data_bytes[5] << 16 | data_bytes[6] << 8 | data_bytes[7];
-	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  src llid: %u\n", header.common.src_llid);
-
-	switch (header.common.data_packet_format) {
+	console_log(LOGLEVEL_DMRDATA "  data packet format: %s\n", dmrpacket_data_header_get_readable_dpf(header->common.data_packet_format));
+
+	header->common.dst_is_a_group = ((data_bytes[0] & 0b10000000) > 0);
+	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dst is a group: %u\n", header->common.dst_is_a_group);
+	header->common.response_requested = ((data_bytes[0] & 0b01000000) > 0);
+	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  response requested: %u\n", header->common.response_requested);
+	header->common.service_access_point = (data_bytes[1] & 0b11110000) >> 4;
+	console_log(LOGLEVEL_DMRDATA "  service access point: %.2x (%s)\n", header->common.service_access_point, dmrpacket_data_header_get_readable_sap(header->common.service_access_point));
+	header->common.dst_llid = data_bytes[2] << 16 | data_bytes[3] << 8 | data_bytes[4];
+	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dst llid: %u\n", header->common.dst_llid);
+	header->common.src_llid = data_bytes[5] << 16 | data_bytes[6] << 8 | data_bytes[7];
+	console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  src llid: %u\n", header->common.src_llid);
+
+	switch (header->common.data_packet_format) {
 		case DMRPACKET_DATA_HEADER_DPF_UNCONFIRMED_DATA:
-			header.unconfirmed_data.pad_octet_count = (data_bytes[0] & 0b10000) | (data_bytes[1] & 0b01111);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad octet count: %u\n", header.unconfirmed_data.pad_octet_count);
-			header.unconfirmed_data.full_message = ((data_bytes[8] & 0b10000000) > 0);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header.unconfirmed_data.full_message);
-			header.unconfirmed_data.blocks_to_follow = data_bytes[8] & 0b01111111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header.unconfirmed_data.blocks_to_follow);
-			header.unconfirmed_data.fragmentseqnum = data_bytes[9] & 0b1111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  fragment seqnum: %u\n", header.unconfirmed_data.fragmentseqnum);
+			header->unconfirmed_data.pad_octet_count = (data_bytes[0] & 0b10000) | (data_bytes[1] & 0b01111);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad octet count: %u\n", header->unconfirmed_data.pad_octet_count);
+			header->unconfirmed_data.full_message = ((data_bytes[8] & 0b10000000) > 0);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header->unconfirmed_data.full_message);
+			header->unconfirmed_data.blocks_to_follow = data_bytes[8] & 0b01111111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header->unconfirmed_data.blocks_to_follow);
+			header->unconfirmed_data.fragmentseqnum = data_bytes[9] & 0b1111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  fragment seqnum: %u\n", header->unconfirmed_data.fragmentseqnum);
 			break;
 		case DMRPACKET_DATA_HEADER_DPF_CONFIRMED_DATA:
-			header.confirmed_data.pad_octet_count = (data_bytes[0] & 0b10000) | (data_bytes[1] & 0b01111);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad octet count: %u\n", header.confirmed_data.pad_octet_count);
-			header.confirmed_data.full_message = ((data_bytes[8] & 0b10000000) > 0);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header.confirmed_data.full_message);
-			header.confirmed_data.blocks_to_follow = data_bytes[8] & 0b01111111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header.confirmed_data.blocks_to_follow);
-			header.confirmed_data.resync = ((data_bytes[9] & 0b10000000) > 0);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header.confirmed_data.resync);
-			header.confirmed_data.fragmentseqnum = data_bytes[9] & 0b1111;
+			header->confirmed_data.pad_octet_count = (data_bytes[0] & 0b10000) | (data_bytes[1] & 0b01111);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad octet count: %u\n", header->confirmed_data.pad_octet_count);
+			header->confirmed_data.full_message = ((data_bytes[8] & 0b10000000) > 0);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header->confirmed_data.full_message);
+			header->confirmed_data.blocks_to_follow = data_bytes[8] & 0b01111111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header->confirmed_data.blocks_to_follow);
+			header->confirmed_data.resync = ((data_bytes[9] & 0b10000000) > 0);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header->confirmed_data.resync);
+			header->confirmed_data.fragmentseqnum = data_bytes[9] & 0b1111;
 			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  fragment seqnum: ");
-			if (header.confirmed_data.fragmentseqnum & 0b1000)
-				console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "last fragment (%u)\n", header.confirmed_data.fragmentseqnum);
+			if (header->confirmed_data.fragmentseqnum & 0b1000)
+				console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "last fragment (%u)\n", header->confirmed_data.fragmentseqnum);
 			else
-				console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "%u\n", header.confirmed_data.fragmentseqnum);
-			header.confirmed_data.sendseqnum = (data_bytes[9] & 0b01110000) >> 4;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  send seqnum: %u\n", header.confirmed_data.sendseqnum);
+				console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "%u\n", header->confirmed_data.fragmentseqnum);
+			header->confirmed_data.sendseqnum = (data_bytes[9] & 0b01110000) >> 4;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  send seqnum: %u\n", header->confirmed_data.sendseqnum);
 			break;
 		case DMRPACKET_DATA_HEADER_DPF_RESPONSE:
-			header.response.blocks_to_follow = data_bytes[8] & 0b01111111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header.response.blocks_to_follow);
-			header.response.class =	(data_bytes[9] & 0b11000000) >> 6;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  class: %.2x\n", header.response.class);
-			header.response.type = (data_bytes[9] & 0b00111000) >> 3;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  type: %.2x\n", header.response.type);
-			header.response.status = data_bytes[9] & 0b111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  status: %.2x\n", header.response.status);
+			header->response.blocks_to_follow = data_bytes[8] & 0b01111111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  blocks to follow: %u\n", header->response.blocks_to_follow);
+			header->response.class =	(data_bytes[9] & 0b11000000) >> 6;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  class: %.2x\n", header->response.class);
+			header->response.type = (data_bytes[9] & 0b00111000) >> 3;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  type: %.2x\n", header->response.type);
+			header->response.status = data_bytes[9] & 0b111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  status: %.2x\n", header->response.status);
 			break;
 		case DMRPACKET_DATA_HEADER_DPF_PROPRIETARY_DATA: // This is handled at the beginning of this function.
-			return &header;
+			return header;
 		case DMRPACKET_DATA_HEADER_DPF_SHORT_DATA_RAW:
-			header.short_data_raw.appended_blocks = (data_bytes[0] & 0b00110000) | (data_bytes[1] & 0b1111);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header.short_data_raw.appended_blocks);
-			header.short_data_raw.source_port = (data_bytes[8] & 0b11100000) >> 5;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  source port: %u\n", header.short_data_raw.source_port);
-			header.short_data_raw.destination_port = (data_bytes[8] & 0b11100) >> 2;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  destination port: %u\n", header.short_data_raw.destination_port);
-			header.short_data_raw.resync =  (data_bytes[8] & 0b10) > 0;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header.short_data_raw.resync);
-			header.short_data_raw.full_message = (data_bytes[8] & 0b1) > 0;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header.short_data_raw.full_message);
-			header.short_data_raw.bit_padding = data_bytes[9];
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  bit padding: %u\n", header.short_data_raw.bit_padding);
+			header->short_data_raw.appended_blocks = (data_bytes[0] & 0b00110000) | (data_bytes[1] & 0b1111);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header->short_data_raw.appended_blocks);
+			header->short_data_raw.source_port = (data_bytes[8] & 0b11100000) >> 5;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  source port: %u\n", header->short_data_raw.source_port);
+			header->short_data_raw.destination_port = (data_bytes[8] & 0b11100) >> 2;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  destination port: %u\n", header->short_data_raw.destination_port);
+			header->short_data_raw.resync =  (data_bytes[8] & 0b10) > 0;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header->short_data_raw.resync);
+			header->short_data_raw.full_message = (data_bytes[8] & 0b1) > 0;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header->short_data_raw.full_message);
+			header->short_data_raw.bit_padding = data_bytes[9];
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  bit padding: %u\n", header->short_data_raw.bit_padding);
 			break;
 		case DMRPACKET_DATA_HEADER_DPF_SHORT_DATA_DEFINED:
-			header.short_data_defined.appended_blocks = (data_bytes[0] & 0b00110000) | (data_bytes[1] & 0b1111);
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header.short_data_defined.appended_blocks);
-			header.short_data_defined.dd_format = (data_bytes[8] & 0b11111100) >> 2;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dd format: %.2x (%s)\n", header.short_data_defined.dd_format, dmrpacket_data_header_get_readable_dd_format(header.short_data_defined.dd_format));
-			header.short_data_defined.resync = (data_bytes[8] & 0b10) > 0;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header.short_data_defined.resync);
-			header.short_data_defined.full_message = (data_bytes[8] & 0b1) > 0;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header.short_data_defined.full_message);
-			header.short_data_defined.bit_padding =	data_bytes[9];
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  bit padding: %u\n", header.short_data_defined.bit_padding);
+			header->short_data_defined.appended_blocks = (data_bytes[0] & 0b00110000) | (data_bytes[1] & 0b1111);
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header->short_data_defined.appended_blocks);
+			header->short_data_defined.dd_format = (data_bytes[8] & 0b11111100) >> 2;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  dd format: %.2x (%s)\n", header->short_data_defined.dd_format, dmrpacket_data_header_get_readable_dd_format(header->short_data_defined.dd_format));
+			header->short_data_defined.resync = (data_bytes[8] & 0b10) > 0;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  resync: %u\n", header->short_data_defined.resync);
+			header->short_data_defined.full_message = (data_bytes[8] & 0b1) > 0;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  full message: %u\n", header->short_data_defined.full_message);
+			header->short_data_defined.bit_padding =	data_bytes[9];
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  bit padding: %u\n", header->short_data_defined.bit_padding);
 			break;
 		case DMRPACKET_DATA_HEADER_DPF_UDT:
-			header.udt.format =	data_bytes[1] & 0b1111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  udt format: %.2x (%s)\n", header.udt.format, dmrpacket_data_header_get_readable_udt_format(header.udt.format));
-			header.udt.pad_nibble =	(data_bytes[8] & 0b11111000) >> 3;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad nibble: %u\n", header.udt.pad_nibble);
-			header.udt.appended_blocks = data_bytes[8] & 0b11;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header.udt.appended_blocks);
-			header.udt.supplementary_flag = (data_bytes[9] & 0b10000000) > 0;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  supplementary flag: %u\n", header.udt.supplementary_flag);
-			header.udt.opcode = data_bytes[9] & 0b00111111;
-			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  opcode: %u\n", header.udt.opcode);
+			header->udt.format =	data_bytes[1] & 0b1111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  udt format: %.2x (%s)\n", header->udt.format, dmrpacket_data_header_get_readable_udt_format(header->udt.format));
+			header->udt.pad_nibble =	(data_bytes[8] & 0b11111000) >> 3;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  pad nibble: %u\n", header->udt.pad_nibble);
+			header->udt.appended_blocks = data_bytes[8] & 0b11;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  appended blocks: %u\n", header->udt.appended_blocks);
+			header->udt.supplementary_flag = (data_bytes[9] & 0b10000000) > 0;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  supplementary flag: %u\n", header->udt.supplementary_flag);
+			header->udt.opcode = data_bytes[9] & 0b00111111;
+			console_log(LOGLEVEL_DMRDATA LOGLEVEL_DEBUG "  opcode: %u\n", header->udt.opcode);
 			break;
 		default:
 			console_log(LOGLEVEL_DMRDATA "dmrpacket data error: unknown header data packet format\n");
 			return NULL;
 	}
 
-	return &header;
+	return header;
+}
+
+dmrpacket_data_header_t *dmrpacket_data_header_decode(bptc_196_96_data_bits_t *data_bits, flag_t proprietary_header) {
+	static dmrpacket_data_header_t header;
+
+	return dmrpacket_data_header_decode_r(data_bits, proprietary_header, &header);
 }
 
 // Determines the response type from the data response header.
@@ -305,8 +308,7 @@ dmrpacket_data_header_responsetype_t dmrpacket_data_header_decode_response(dmrpa
 	return DMRPACKET_DATA_HEADER_RESPONSETYPE_ILLEGAL_FORMAT;
 }
 
-bptc_196_96_data_bits_t *dmrpacket_data_header_construct(dmrpacket_data_header_t *header, flag_t proprietary_header) {
-	static bptc_196_96_data_bits_t data_bits;
+bptc_196_96_data_bits_t *dmrpacket_data_header_construct_r(dmrpacket_data_header_t *header, flag_t proprietary_header, bptc_196_96_data_bits_t *data_bits) {
 	uint8_t data_bytes[sizeof(bptc_196_96_data_bits_t)/8] = {0,};
 	uint16_t crcval;
 
@@ -389,6 +391,12 @@ bptc_196_96_data_bits_t *dmrpacket_data_header_construct(dmrpacket_data_header_t
 	data_bytes[10] = (crcval & 0xff00) >> 8;
 	data_bytes[11] = crcval & 0xff;
 
-	base_bytestobits(data_bytes, sizeof(data_bytes), data_bits.bits, sizeof(bptc_196_96_data_bits_t));
-	return &data_bits;
+	base_bytestobits(data_bytes, sizeof(data_bytes), data_bits->bits, sizeof(bptc_196_96_data_bits_t));
+	return data_bits;
+}
+
+bptc_196_96_data_bits_t *dmrpacket_data_header_construct(dmrpacket_data_header_t *header, flag_t proprietary_header) {
+	static bptc_196_96_data_bits_t data_bits;
+
+	return dmrpacket_data_header_construct_r(header, proprietary_header, &data_bits);
 }
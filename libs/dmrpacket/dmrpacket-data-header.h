@@ -169,7 +169,9 @@ char *dmrpacket_data_header_get_readable_response_type(dmrpacket_data_header_res
 char *dmrpacket_data_header_get_readable_dd_format(dmrpacket_data_header_dd_format_t dd_format);
 
 dmrpacket_data_header_t *dmrpacket_data_header_decode(bptc_196_96_data_bits_t *data_bits, flag_t proprietary_header);
+dmrpacket_data_header_t *dmrpacket_data_header_decode_r(bptc_196_96_data_bits_t *data_bits, flag_t proprietary_header, dmrpacket_data_header_t *header);
 dmrpacket_data_header_responsetype_t dmrpacket_data_header_decode_response(dmrpacket_data_header_t *header);
 bptc_196_96_data_bits_t *dmrpacket_data_header_construct(dmrpacket_data_header_t *data_header, flag_t proprietary_header);
+bptc_196_96_data_bits_t *dmrpacket_data_header_construct_r(dmrpacket_data_header_t *header, flag_t proprietary_header, bptc_196_96_data_bits_t *data_bits);
 
 #endif
@@ -18,6 +18,7 @@
 #include DEFAULTCONFIG
 
 #include "dmrpacket-emb.h"
+#include "dmrpacket.h"
 
 #include <libs/base/base.h>
 #include <libs/daemon/console.h>
@@ -48,8 +49,7 @@ flag_t dmrpacket_emb_is_null_fragment(dmrpacket_emb_signalling_lc_fragment_bits_
 	return is_null;
 }
 
-dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_deinterleave(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
-	static dmrpacket_emb_signalling_lc_bits_t deinterleaved_lc;
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_deinterleave_r(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits, dmrpacket_emb_signalling_lc_bits_t *deinterleaved_lc) {
 	flag_t *bits = (flag_t *)emb_signalling_lc_bits;
 	uint8_t i;
 	uint8_t j;
@@ -60,21 +60,26 @@ dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_deinterleave(dmr
 	for (i = 0, j = 0; i < sizeof(dmrpacket_emb_signalling_lc_bits_t); i++) {
 		switch (i) {
 			// See DMR AI. spec. page 124. for the structure of the embedded LC packet.
-			case 32: deinterleaved_lc.checksum[0] = bits[i]; break;
-			case 43: deinterleaved_lc.checksum[1] = bits[i]; break;
-			case 54: deinterleaved_lc.checksum[2] = bits[i]; break;
-			case 65: deinterleaved_lc.checksum[3] = bits[i]; break;
-			case 76: deinterleaved_lc.checksum[4] = bits[i]; break;
-			default: deinterleaved_lc.bits[j++] = bits[i]; break;
+			case 32: deinterleaved_lc->checksum[0] = bits[i]; break;
+			case 43: deinterleaved_lc->checksum[1] = bits[i]; break;
+			case 54: deinterleaved_lc->checksum[2] = bits[i]; break;
+			case 65: deinterleaved_lc->checksum[3] = bits[i]; break;
+			case 76: deinterleaved_lc->checksum[4] = bits[i]; break;
+			default: deinterleaved_lc->bits[j++] = bits[i]; break;
 		}
 	}
 
-	return &deinterleaved_lc;
+	return deinterleaved_lc;
 }
 
-dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_interleave(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
-	static dmrpacket_emb_signalling_lc_bits_t interleaved_lc;
-	flag_t *bits = (flag_t *)&interleaved_lc;
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_deinterleave(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
+	static dmrpacket_emb_signalling_lc_bits_t deinterleaved_lc;
+
+	return dmrpacket_emb_signalling_lc_deinterleave_r(emb_signalling_lc_bits, &deinterleaved_lc);
+}
+
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_interleave_r(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits, dmrpacket_emb_signalling_lc_bits_t *interleaved_lc) {
+	flag_t *bits = (flag_t *)interleaved_lc;
 	uint8_t i;
 	uint8_t j;
 
@@ -93,7 +98,13 @@ dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_interleave(dmrpa
 		}
 	}
 
-	return &interleaved_lc;
+	return interleaved_lc;
+}
+
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_emb_signalling_lc_interleave(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
+	static dmrpacket_emb_signalling_lc_bits_t interleaved_lc;
+
+	return dmrpacket_emb_signalling_lc_interleave_r(emb_signalling_lc_bits, &interleaved_lc);
 }
 
 flag_t dmrpacket_emb_check_checksum(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
@@ -122,54 +133,66 @@ flag_t dmrpacket_emb_check_checksum(dmrpacket_emb_signalling_lc_bits_t *emb_sign
 	return (checksum_calculated == checksum_received);
 }
 
-dmrpacket_emb_signalling_lc_fragment_bits_t *dmrpacket_emb_signalling_lc_fragment_extract_from_sync(dmrpacket_sync_bits_t *sync_bits) {
-	static dmrpacket_emb_signalling_lc_fragment_bits_t emb_signalling_lc_fragment_bits;
-
+dmrpacket_emb_signalling_lc_fragment_bits_t *dmrpacket_emb_signalling_lc_fragment_extract_from_sync_r(dmrpacket_sync_bits_t *sync_bits, dmrpacket_emb_signalling_lc_fragment_bits_t *emb_signalling_lc_fragment_bits) {
 	if (sync_bits == NULL)
 		return NULL;
 
-	memcpy(emb_signalling_lc_fragment_bits.bits, &sync_bits->bits[8], 32);
+	memcpy(emb_signalling_lc_fragment_bits->bits, &sync_bits->bits[8], 32);
 
-	return &emb_signalling_lc_fragment_bits;
+	return emb_signalling_lc_fragment_bits;
 }
 
-dmrpacket_emb_bits_t *dmrpacket_emb_extract_from_sync(dmrpacket_sync_bits_t *sync_bits) {
-	static dmrpacket_emb_bits_t emb_bits;
+dmrpacket_emb_signalling_lc_fragment_bits_t *dmrpacket_emb_signalling_lc_fragment_extract_from_sync(dmrpacket_sync_bits_t *sync_bits) {
+	static dmrpacket_emb_signalling_lc_fragment_bits_t emb_signalling_lc_fragment_bits;
+
+	return dmrpacket_emb_signalling_lc_fragment_extract_from_sync_r(sync_bits, &emb_signalling_lc_fragment_bits);
+}
 
+dmrpacket_emb_bits_t *dmrpacket_emb_extract_from_sync_r(dmrpacket_sync_bits_t *sync_bits, dmrpacket_emb_bits_t *emb_bits) {
 	if (sync_bits == NULL)
 		return NULL;
 
-	memcpy(emb_bits.bits, sync_bits->bits, sizeof(dmrpacket_emb_bits_t)/2);
-	memcpy(emb_bits.bits+8, sync_bits->bits+sizeof(dmrpacket_emb_bits_t)/2+sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t), sizeof(dmrpacket_emb_bits_t)/2);
+	memcpy(emb_bits->bits, sync_bits->bits, sizeof(dmrpacket_emb_bits_t)/2);
+	memcpy(emb_bits->bits+8, sync_bits->bits+sizeof(dmrpacket_emb_bits_t)/2+sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t), sizeof(dmrpacket_emb_bits_t)/2);
 
-	return &emb_bits;
+	return emb_bits;
 }
 
-dmrpacket_emb_t *dmrpacket_emb_decode(dmrpacket_emb_bits_t *emb_bits) {
-	static dmrpacket_emb_t emb;
+dmrpacket_emb_bits_t *dmrpacket_emb_extract_from_sync(dmrpacket_sync_bits_t *sync_bits) {
+	static dmrpacket_emb_bits_t emb_bits;
 
+	return dmrpacket_emb_extract_from_sync_r(sync_bits, &emb_bits);
+}
+
+dmrpacket_emb_t *dmrpacket_emb_decode_r(dmrpacket_emb_bits_t *emb_bits, dmrpacket_emb_t *emb) {
 	if (emb_bits == NULL)
 		return NULL;
 
 	console_log(LOGLEVEL_DMRLC "  decoding emb:\n");
 
-	if (!quadres_16_7_check((quadres_16_7_codeword_t *)emb_bits->bits)) {
+	if (!quadres_16_7_check_and_repair((quadres_16_7_codeword_t *)emb_bits->bits, &emb->corrected_bits)) {
 		console_log(LOGLEVEL_DMRLC "    checksum error\n");
 		return NULL;
 	}
-	console_log(LOGLEVEL_DMRLC "    checksum ok\n");
+	console_log(LOGLEVEL_DMRLC "    checksum ok, corrected bits: %u\n", emb->corrected_bits);
 
 	if (emb_bits->bits[4] != 0) {
 		console_log(LOGLEVEL_DMRLC "    error: pi is not 0\n");
 		return NULL;
 	}
 
-	emb.cc = emb_bits->bits[0] << 3 | emb_bits->bits[1] << 2 | emb_bits->bits[2] << 1 | emb_bits->bits[3];
-	console_log(LOGLEVEL_DMRLC "    cc: %u\n", emb.cc);
-	emb.lcss = emb_bits->bits[5] << 1 | emb_bits->bits[6];
-	console_log(LOGLEVEL_DMRLC "    lcss: %u (%s)\n", emb.lcss, dmrpacket_emb_get_readable_lcss(emb.lcss));
+	emb->cc = emb_bits->bits[0] << 3 | emb_bits->bits[1] << 2 | emb_bits->bits[2] << 1 | emb_bits->bits[3];
+	console_log(LOGLEVEL_DMRLC "    cc: %u\n", emb->cc);
+	emb->lcss = emb_bits->bits[5] << 1 | emb_bits->bits[6];
+	console_log(LOGLEVEL_DMRLC "    lcss: %u (%s)\n", emb->lcss, dmrpacket_emb_get_readable_lcss(emb->lcss));
+
+	return emb;
+}
+
+dmrpacket_emb_t *dmrpacket_emb_decode(dmrpacket_emb_bits_t *emb_bits) {
+	static dmrpacket_emb_t emb;
 
-	return &emb;
+	return dmrpacket_emb_decode_r(emb_bits, &emb);
 }
 
 void dmrpacket_emb_insert_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_emb_bits_t *emb_bits) {
@@ -181,23 +204,71 @@ void dmrpacket_emb_insert_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket
 		emb_bits->bits+sizeof(dmrpacket_emb_bits_t)/2, sizeof(dmrpacket_emb_bits_t)/2);
 }
 
-dmrpacket_emb_bits_t *dmrpacket_emb_construct_bits(dmr_emb_lcss_t lcss) {
-	static dmrpacket_emb_bits_t emb_bits;
-	quadres_16_7_parity_bits_t *parity;
+dmrpacket_emb_bits_t *dmrpacket_emb_construct_bits_r(dmr_emb_lcss_t lcss, dmrpacket_emb_bits_t *emb_bits) {
+	quadres_16_7_parity_bits_t parity;
 	uint8_t data_byte;
 
 	data_byte = 0b00010000 | lcss << 1; // CC = 1
-	base_bytetobits(data_byte, emb_bits.bits);
-	parity = quadres_16_7_get_parity_bits(emb_bits.bits);
-	emb_bits.bits[7] = parity->bits[0];
-	emb_bits.bits[8] = parity->bits[1];
-	emb_bits.bits[9] = parity->bits[2];
-	emb_bits.bits[10] = parity->bits[3];
-	emb_bits.bits[11] = parity->bits[4];
-	emb_bits.bits[12] = parity->bits[5];
-	emb_bits.bits[13] = parity->bits[6];
-	emb_bits.bits[14] = parity->bits[7];
-	emb_bits.bits[15] = parity->bits[8];
-
-	return &emb_bits;
+	base_bytetobits(data_byte, emb_bits->bits);
+	quadres_16_7_get_parity_bits_r(emb_bits->bits, &parity);
+	emb_bits->bits[7] = parity.bits[0];
+	emb_bits->bits[8] = parity.bits[1];
+	emb_bits->bits[9] = parity.bits[2];
+	emb_bits->bits[10] = parity.bits[3];
+	emb_bits->bits[11] = parity.bits[4];
+	emb_bits->bits[12] = parity.bits[5];
+	emb_bits->bits[13] = parity.bits[6];
+	emb_bits->bits[14] = parity.bits[7];
+	emb_bits->bits[15] = parity.bits[8];
+
+	return emb_bits;
+}
+
+dmrpacket_emb_bits_t *dmrpacket_emb_construct_bits(dmr_emb_lcss_t lcss) {
+	static dmrpacket_emb_bits_t emb_bits;
+
+	return dmrpacket_emb_construct_bits_r(lcss, &emb_bits);
+}
+
+// Returns the 16 emb bits of the packed payload (the first and last 8 bits of the sync field).
+uint16_t dmrpacket_emb_extract_word(dmrpacket_payload_packed_bits_t *packed_bits) {
+	uint16_t pos = sizeof(dmrpacket_payload_voice_bits_t)/2;
+
+	return dmrpacket_packed_get_bits(packed_bits, pos, 8) << 8 |
+		dmrpacket_packed_get_bits(packed_bits, pos+sizeof(dmrpacket_emb_bits_t)/2+sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t), 8);
+}
+
+// Returns the 32 bit embedded signalling lc fragment between the emb bits of the packed payload.
+uint32_t dmrpacket_emb_signalling_lc_fragment_extract_word(dmrpacket_payload_packed_bits_t *packed_bits) {
+	return dmrpacket_packed_get_bits(packed_bits, sizeof(dmrpacket_payload_voice_bits_t)/2+sizeof(dmrpacket_emb_bits_t)/2,
+		sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t));
+}
+
+dmrpacket_emb_signalling_lc_fragment_bits_t *dmrpacket_emb_signalling_lc_fragment_extract_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, dmrpacket_emb_signalling_lc_fragment_bits_t *emb_signalling_lc_fragment_bits) {
+	dmrpacket_packed_to_bits(packed_bits, sizeof(dmrpacket_payload_voice_bits_t)/2+sizeof(dmrpacket_emb_bits_t)/2,
+		sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t), emb_signalling_lc_fragment_bits->bits);
+
+	return emb_signalling_lc_fragment_bits;
+}
+
+dmrpacket_emb_t *dmrpacket_emb_decode_word_r(uint16_t emb_word, dmrpacket_emb_t *emb) {
+	console_log(LOGLEVEL_DMRLC "  decoding emb:\n");
+
+	if (!quadres_16_7_check_and_repair_word(&emb_word, &emb->corrected_bits)) {
+		console_log(LOGLEVEL_DMRLC "    checksum error\n");
+		return NULL;
+	}
+	console_log(LOGLEVEL_DMRLC "    checksum ok, corrected bits: %u\n", emb->corrected_bits);
+
+	if (emb_word & (1 << 11)) {
+		console_log(LOGLEVEL_DMRLC "    error: pi is not 0\n");
+		return NULL;
+	}
+
+	emb->cc = emb_word >> 12;
+	console_log(LOGLEVEL_DMRLC "    cc: %u\n", emb->cc);
+	emb->lcss = (emb_word >> 9) & 0b11;
+	console_log(LOGLEVEL_DMRLC "    lcss: %u (%s)\n", emb->lcss, dmrpacket_emb_get_readable_lcss(emb->lcss));
+
+	return emb;
 }
@@ -27,9 +27,7 @@
 #include <string.h>
 
 // See DMR services spec. page 52.
-static dmrpacket_lc_t *dmrpacket_lc_decode(uint8_t bytes[9]) {
-	static dmrpacket_lc_t lc;
-
+static dmrpacket_lc_t *dmrpacket_lc_decode(uint8_t bytes[9], dmrpacket_lc_t *lc) {
 	if (bytes == NULL)
 		return NULL;
 
@@ -39,11 +37,11 @@ static dmrpacket_lc_t *dmrpacket_lc_decode(uint8_t bytes[9]) {
 	}
 
 	switch (bytes[0] & 0b111111) {
-		case 0b11: lc.call_type = DMR_CALL_TYPE_PRIVATE; break;
-		case 0b00: lc.call_type = DMR_CALL_TYPE_GROUP; break;
+		case 0b11: lc->call_type = DMR_CALL_TYPE_PRIVATE; break;
+		case 0b00: lc->call_type = DMR_CALL_TYPE_GROUP; break;
 		default: console_log(LOGLEVEL_DMRLC "    error: invalid flco\n"); return NULL;
 	}
-	console_log(LOGLEVEL_DMRLC "    call type from flco: %s\n", dmr_get_readable_call_type(lc.call_type));
+	console_log(LOGLEVEL_DMRLC "    call type from flco: %s\n", dmr_get_readable_call_type(lc->call_type));
 
 	if (bytes[1] != 0) {
 		console_log(LOGLEVEL_DMRLC "    error: feature set id is not 0\n");
@@ -52,17 +50,15 @@ static dmrpacket_lc_t *dmrpacket_lc_decode(uint8_t bytes[9]) {
 
 	console_log(LOGLEVEL_DMRLC "    service options: 0x%.2x\n", bytes[2]);
 
-	lc.dst_id = bytes[3] << 16 | bytes[4] << 8 | bytes[5];
-	console_log(LOGLEVEL_DMRLC "    dst id: %u\n", lc.dst_id);
-	lc.src_id = bytes[6] << 16 | bytes[7] << 8 | bytes[8];
-	console_log(LOGLEVEL_DMRLC "    src id: %u\n", lc.src_id);
-	return &lc;
+	lc->dst_id = bytes[3] << 16 | bytes[4] << 8 | bytes[5];
+	console_log(LOGLEVEL_DMRLC "    dst id: %u\n", lc->dst_id);
+	lc->src_id = bytes[6] << 16 | bytes[7] << 8 | bytes[8];
+	console_log(LOGLEVEL_DMRLC "    src id: %u\n", lc->src_id);
+	return lc;
 }
 
-static uint8_t *dmrpacket_lc_construct_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
-	static uint8_t bytes[12];
-
-	memset(bytes, 0, sizeof(bytes));
+static void dmrpacket_lc_construct_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, uint8_t bytes[12]) {
+	memset(bytes, 0, 12);
 
 	if (call_type == DMR_CALL_TYPE_PRIVATE)
 		bytes[0] = 0b11;
@@ -72,11 +68,9 @@ static uint8_t *dmrpacket_lc_construct_lc(dmr_call_type_t call_type, dmr_id_t ds
 	bytes[6] = (src_id & 0xff0000) >> 16;
 	bytes[7] = (src_id & 0x00ff00) >> 8;
 	bytes[8] = (src_id & 0x0000ff);
-
-	return bytes;
 }
 
-dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc(dmrpacket_emb_signalling_lc_bits_t *deinterleaved_emb_signalling_lc_bits) {
+dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc_r(dmrpacket_emb_signalling_lc_bits_t *deinterleaved_emb_signalling_lc_bits, dmrpacket_lc_t *lc) {
 	uint8_t bytes[9];
 
 	if (deinterleaved_emb_signalling_lc_bits == NULL)
@@ -87,7 +81,13 @@ dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc(dmrpacket_emb_signalling_l
 
 	base_bitstobytes(deinterleaved_emb_signalling_lc_bits->bits, 72, bytes, sizeof(bytes));
 
-	return dmrpacket_lc_decode(bytes);
+	return dmrpacket_lc_decode(bytes, lc);
+}
+
+dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc(dmrpacket_emb_signalling_lc_bits_t *deinterleaved_emb_signalling_lc_bits) {
+	static dmrpacket_lc_t lc;
+
+	return dmrpacket_lc_decode_emb_signalling_lc_r(deinterleaved_emb_signalling_lc_bits, &lc);
 }
 
 void dmrpacket_lc_insert_emb_signalling_lc_fragment_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_emb_signalling_lc_fragment_bits_t *emb_signalling_lc_fragment_bits) {
@@ -97,29 +97,34 @@ void dmrpacket_lc_insert_emb_signalling_lc_fragment_bits(dmrpacket_payload_bits_
 	memcpy(payload_bits->bits+sizeof(dmrpacket_payload_voice_bits_t)/2+sizeof(dmrpacket_emb_bits_t)/2, emb_signalling_lc_fragment_bits->bits, sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t));
 }
 
-dmrpacket_emb_signalling_lc_bits_t *dmrpacket_lc_construct_emb_signalling_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
-	static dmrpacket_emb_signalling_lc_bits_t data_bits;
-	uint8_t *bytes;
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_lc_construct_emb_signalling_lc_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, dmrpacket_emb_signalling_lc_bits_t *data_bits) {
+	uint8_t bytes[12];
 	uint16_t checksum = 0;
 	uint8_t i;
 
-	bytes = dmrpacket_lc_construct_lc(call_type, dst_id, src_id);
+	dmrpacket_lc_construct_lc(call_type, dst_id, src_id, bytes);
 
 	for (i = 0; i < 9; i++)
 		checksum += bytes[i];
 	checksum %= 31; // See DMR AI spec. page. 142.
 
-	data_bits.checksum[0] = (checksum >> 4) & 0x01;
-	data_bits.checksum[1] = (checksum >> 3) & 0x01;
-	data_bits.checksum[2] = (checksum >> 2) & 0x01;
-	data_bits.checksum[3] = (checksum >> 1) & 0x01;
-	data_bits.checksum[4] = checksum & 0x01;
+	data_bits->checksum[0] = (checksum >> 4) & 0x01;
+	data_bits->checksum[1] = (checksum >> 3) & 0x01;
+	data_bits->checksum[2] = (checksum >> 2) & 0x01;
+	data_bits->checksum[3] = (checksum >> 1) & 0x01;
+	data_bits->checksum[4] = checksum & 0x01;
 
-	base_bytestobits(bytes, 9, data_bits.bits, sizeof(dmrpacket_emb_signalling_lc_bits_t));
-	return &data_bits;
+	base_bytestobits(bytes, 9, data_bits->bits, sizeof(dmrpacket_emb_signalling_lc_bits_t));
+	return data_bits;
 }
 
-static dmrpacket_lc_t *dmrpacket_lc_decode_full_lc(uint8_t bytes[12]) {
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_lc_construct_emb_signalling_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
+	static dmrpacket_emb_signalling_lc_bits_t data_bits;
+
+	return dmrpacket_lc_construct_emb_signalling_lc_r(call_type, dst_id, src_id, &data_bits);
+}
+
+static dmrpacket_lc_t *dmrpacket_lc_decode_full_lc(uint8_t bytes[12], dmrpacket_lc_t *lc) {
 	rs_12_9_poly_t syndrome;
 	uint8_t errors_found;
 	rs_12_9_correct_errors_result_t result = RS_12_9_CORRECT_ERRORS_RESULT_NO_ERRORS_FOUND;
@@ -137,17 +142,17 @@ static dmrpacket_lc_t *dmrpacket_lc_decode_full_lc(uint8_t bytes[12]) {
 		default:
 		case RS_12_9_CORRECT_ERRORS_RESULT_NO_ERRORS_FOUND:
 			console_log(LOGLEVEL_DMRLC "ok)\n");
-			return dmrpacket_lc_decode(bytes);
+			return dmrpacket_lc_decode(bytes, lc);
 		case RS_12_9_CORRECT_ERRORS_RESULT_ERRORS_CORRECTED:
 			console_log(LOGLEVEL_DMRLC "%u byte errors found and corrected)\n", errors_found);
-			return dmrpacket_lc_decode(bytes);
+			return dmrpacket_lc_decode(bytes, lc);
 		case RS_12_9_CORRECT_ERRORS_RESULT_ERRORS_CANT_BE_CORRECTED:
 			console_log(LOGLEVEL_DMRLC "%u byte errors found - can't correct)\n", errors_found);
 			return NULL;
 	}
 }
 
-dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header(bptc_196_96_data_bits_t *data_bits) {
+dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_lc_t *lc) {
 	uint8_t bytes[12];
 
 	if (data_bits == NULL)
@@ -162,10 +167,16 @@ dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header(bptc_196_96_data_bits_t *dat
 	bytes[10] ^= 0x96;
 	bytes[11] ^= 0x96;
 
-	return dmrpacket_lc_decode_full_lc(bytes);
+	return dmrpacket_lc_decode_full_lc(bytes, lc);
 }
 
-dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_data_bits_t *data_bits) {
+dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header(bptc_196_96_data_bits_t *data_bits) {
+	static dmrpacket_lc_t lc;
+
+	return dmrpacket_lc_decode_voice_lc_header_r(data_bits, &lc);
+}
+
+dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_lc_t *lc) {
 	uint8_t bytes[12];
 
 	if (data_bits == NULL)
@@ -180,51 +191,64 @@ dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_data_bits_t *
 	bytes[10] ^= 0x99;
 	bytes[11] ^= 0x99;
 
-	return dmrpacket_lc_decode_full_lc(bytes);
+	return dmrpacket_lc_decode_full_lc(bytes, lc);
 }
 
-static uint8_t *dmrpacket_lc_construct_full_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
-	uint8_t *bytes;
-	rs_12_9_checksum_t *checksum;
+dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_data_bits_t *data_bits) {
+	static dmrpacket_lc_t lc;
 
-	bytes = dmrpacket_lc_construct_lc(call_type, dst_id, src_id);
+	return dmrpacket_lc_decode_terminator_with_lc_r(data_bits, &lc);
+}
 
-	checksum = rs_12_9_calc_checksum((rs_12_9_codeword_t *)bytes);
-	bytes[9] = checksum->bytes[0];
-	bytes[10] = checksum->bytes[1];
-	bytes[11] = checksum->bytes[2];
+static void dmrpacket_lc_construct_full_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, uint8_t bytes[12]) {
+	rs_12_9_checksum_t checksum;
 
-	return bytes;
+	dmrpacket_lc_construct_lc(call_type, dst_id, src_id, bytes);
+
+	rs_12_9_calc_checksum_r((rs_12_9_codeword_t *)bytes, &checksum);
+	bytes[9] = checksum.bytes[0];
+	bytes[10] = checksum.bytes[1];
+	bytes[11] = checksum.bytes[2];
 }
 
-bptc_196_96_data_bits_t *dmrpacket_lc_construct_voice_lc_header(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
-	static bptc_196_96_data_bits_t data_bits;
-	uint8_t *bytes;
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_voice_lc_header_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, bptc_196_96_data_bits_t *data_bits) {
+	uint8_t bytes[12];
 
-	bytes = dmrpacket_lc_construct_full_lc(call_type, dst_id, src_id);
+	dmrpacket_lc_construct_full_lc(call_type, dst_id, src_id, bytes);
 
 	// Applying CRC mask to the checksum. See DMR AI. spec. page 143.
 	bytes[9] ^= 0x96;
 	bytes[10] ^= 0x96;
 	bytes[11] ^= 0x96;
 
-	base_bytestobits(bytes, 12, data_bits.bits, sizeof(bptc_196_96_data_bits_t));
+	base_bytestobits(bytes, 12, data_bits->bits, sizeof(bptc_196_96_data_bits_t));
 
-	return &data_bits;
+	return data_bits;
 }
 
-bptc_196_96_data_bits_t *dmrpacket_lc_construct_terminator_with_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_voice_lc_header(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
 	static bptc_196_96_data_bits_t data_bits;
-	uint8_t *bytes;
 
-	bytes = dmrpacket_lc_construct_full_lc(call_type, dst_id, src_id);
+	return dmrpacket_lc_construct_voice_lc_header_r(call_type, dst_id, src_id, &data_bits);
+}
+
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_terminator_with_lc_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, bptc_196_96_data_bits_t *data_bits) {
+	uint8_t bytes[12];
+
+	dmrpacket_lc_construct_full_lc(call_type, dst_id, src_id, bytes);
 
 	// Applying CRC mask to the checksum. See DMR AI. spec. page 143.
 	bytes[9] ^= 0x99;
 	bytes[10] ^= 0x99;
 	bytes[11] ^= 0x99;
 
-	base_bytestobits(bytes, 12, data_bits.bits, sizeof(bptc_196_96_data_bits_t));
+	base_bytestobits(bytes, 12, data_bits->bits, sizeof(bptc_196_96_data_bits_t));
+
+	return data_bits;
+}
+
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_terminator_with_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id) {
+	static bptc_196_96_data_bits_t data_bits;
 
-	return &data_bits;
+	return dmrpacket_lc_construct_terminator_with_lc_r(call_type, dst_id, src_id, &data_bits);
 }
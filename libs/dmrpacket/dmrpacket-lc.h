@@ -31,13 +31,19 @@ typedef struct {
 } dmrpacket_lc_t;
 
 dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc(dmrpacket_emb_signalling_lc_bits_t *deinterleaved_emb_signalling_lc_bits);
+dmrpacket_lc_t *dmrpacket_lc_decode_emb_signalling_lc_r(dmrpacket_emb_signalling_lc_bits_t *deinterleaved_emb_signalling_lc_bits, dmrpacket_lc_t *lc);
 void dmrpacket_lc_insert_emb_signalling_lc_fragment_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_emb_signalling_lc_fragment_bits_t *emb_signalling_lc_fragment_bits);
 dmrpacket_emb_signalling_lc_bits_t *dmrpacket_lc_construct_emb_signalling_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id);
+dmrpacket_emb_signalling_lc_bits_t *dmrpacket_lc_construct_emb_signalling_lc_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, dmrpacket_emb_signalling_lc_bits_t *data_bits);
 
 dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header(bptc_196_96_data_bits_t *data_bits);
+dmrpacket_lc_t *dmrpacket_lc_decode_voice_lc_header_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_lc_t *lc);
 dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc(bptc_196_96_data_bits_t *data_bits);
+dmrpacket_lc_t *dmrpacket_lc_decode_terminator_with_lc_r(bptc_196_96_data_bits_t *data_bits, dmrpacket_lc_t *lc);
 
 bptc_196_96_data_bits_t *dmrpacket_lc_construct_voice_lc_header(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id);
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_voice_lc_header_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, bptc_196_96_data_bits_t *data_bits);
 bptc_196_96_data_bits_t *dmrpacket_lc_construct_terminator_with_lc(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id);
+bptc_196_96_data_bits_t *dmrpacket_lc_construct_terminator_with_lc_r(dmr_call_type_t call_type, dmr_id_t dst_id, dmr_id_t src_id, bptc_196_96_data_bits_t *data_bits);
 
 #endif
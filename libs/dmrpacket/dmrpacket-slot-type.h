@@ -31,11 +31,17 @@ typedef struct {
 typedef struct {
 	dmr_color_code_t cc;
 	dmrpacket_data_type_t data_type;
+	uint8_t corrected_bits; // Number of bit errors corrected by the Golay(20,8) decoder.
 } dmrpacket_slot_type_t;
 
 dmrpacket_slot_type_bits_t *dmrpacket_slot_type_extract_bits(dmrpacket_payload_bits_t *payload_bits);
+dmrpacket_slot_type_bits_t *dmrpacket_slot_type_extract_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_slot_type_bits_t *slot_type_bits);
 void dmrpacket_slot_type_insert_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_slot_type_bits_t *slot_type_bits);
 dmrpacket_slot_type_bits_t *dmrpacket_slot_type_construct_bits(dmr_color_code_t cc, dmrpacket_data_type_t data_type);
+dmrpacket_slot_type_bits_t *dmrpacket_slot_type_construct_bits_r(dmr_color_code_t cc, dmrpacket_data_type_t data_type, dmrpacket_slot_type_bits_t *slot_type_bits);
 dmrpacket_slot_type_t *dmrpacket_slot_type_decode(dmrpacket_slot_type_bits_t *slot_type_bits);
+uint32_t dmrpacket_slot_type_extract_word(dmrpacket_payload_packed_bits_t *packed_bits);
+dmrpacket_slot_type_t *dmrpacket_slot_type_decode_word_r(uint32_t slot_type_word, dmrpacket_slot_type_t *slot_type);
+dmrpacket_slot_type_t *dmrpacket_slot_type_decode_r(dmrpacket_slot_type_bits_t *slot_type_bits, dmrpacket_slot_type_t *slot_type);
 
 #endif
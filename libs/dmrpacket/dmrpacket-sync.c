@@ -19,6 +19,7 @@
 
 #include "dmrpacket-sync.h"
 #include "dmrpacket-slot-type.h"
+#include "dmrpacket.h"
 
 #include <libs/base/base.h>
 
@@ -36,16 +37,36 @@ static uint8_t dmrpacket_sync_pattern_direct_data_ts1[6] = { 0xF7, 0xFD, 0xD5, 0
 static uint8_t dmrpacket_sync_pattern_direct_voice_ts2[6] = { 0x7D, 0xFF, 0xD5, 0xF5, 0x5D, 0x5F };
 static uint8_t dmrpacket_sync_pattern_direct_data_ts2[6] = { 0xD7, 0x55, 0x7F, 0x5F, 0xF7, 0xF5 };
 
-// Extracts the sync field of the payload (leaves out info and slot type parts).
-dmrpacket_sync_bits_t *dmrpacket_sync_extract_bits(dmrpacket_payload_bits_t *payload_bits) {
-	static dmrpacket_sync_bits_t sync_bits;
+// The same patterns as 48 bit words, for matching the sync field of a packed payload.
+static struct {
+	uint64_t pattern;
+	dmrpacket_sync_pattern_type_t type;
+} dmrpacket_sync_pattern_words[] = {
+	{ 0x755fd7df75f7, DMRPACKET_SYNC_PATTERN_TYPE_BS_SOURCED_VOICE },
+	{ 0xdff57d75df5d, DMRPACKET_SYNC_PATTERN_TYPE_BS_SOURCED_DATA },
+	{ 0x7f7d5dd57dfd, DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_VOICE },
+	{ 0xd5d7f77fd757, DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_DATA },
+	{ 0x77d55f7dfd77, DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_RC },
+	{ 0x5d577f7757ff, DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_VOICE_TS1 },
+	{ 0xf7fdd5ddfd55, DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_DATA_TS1 },
+	{ 0x7dffd5f55d5f, DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_VOICE_TS2 },
+	{ 0xd7557f5ff7f5, DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_DATA_TS2 }
+};
 
+// Extracts the sync field of the payload (leaves out info and slot type parts).
+dmrpacket_sync_bits_t *dmrpacket_sync_extract_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_sync_bits_t *sync_bits) {
 	if (payload_bits == NULL)
 		return NULL;
 
-	memcpy(&sync_bits.bits, payload_bits->bits+sizeof(dmrpacket_payload_info_bits_t)/2+sizeof(dmrpacket_slot_type_bits_t)/2, sizeof(sync_bits.bits));
+	memcpy(sync_bits->bits, payload_bits->bits+sizeof(dmrpacket_payload_info_bits_t)/2+sizeof(dmrpacket_slot_type_bits_t)/2, sizeof(sync_bits->bits));
+
+	return sync_bits;
+}
+
+dmrpacket_sync_bits_t *dmrpacket_sync_extract_bits(dmrpacket_payload_bits_t *payload_bits) {
+	static dmrpacket_sync_bits_t sync_bits;
 
-	return &sync_bits;
+	return dmrpacket_sync_extract_bits_r(payload_bits, &sync_bits);
 }
 
 void dmrpacket_sync_insert_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_sync_bits_t *sync_bits) {
@@ -55,52 +76,56 @@ void dmrpacket_sync_insert_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacke
 	memcpy(payload_bits->bits+sizeof(dmrpacket_payload_info_bits_t)/2+sizeof(dmrpacket_slot_type_bits_t)/2, sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 }
 
-dmrpacket_sync_bits_t *dmrpacket_sync_construct_bits(dmrpacket_sync_pattern_type_t sync_pattern_type) {
-	static dmrpacket_sync_bits_t sync_bits;
-
+dmrpacket_sync_bits_t *dmrpacket_sync_construct_bits_r(dmrpacket_sync_pattern_type_t sync_pattern_type, dmrpacket_sync_bits_t *sync_bits) {
 	switch (sync_pattern_type) {
 		case DMRPACKET_SYNC_PATTERN_TYPE_BS_SOURCED_VOICE:
 			base_bytestobits(dmrpacket_sync_pattern_bs_sourced_voice, sizeof(dmrpacket_sync_pattern_bs_sourced_voice),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_BS_SOURCED_DATA:
 			base_bytestobits(dmrpacket_sync_pattern_bs_sourced_data, sizeof(dmrpacket_sync_pattern_bs_sourced_data),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_VOICE:
 			base_bytestobits(dmrpacket_sync_pattern_ms_sourced_voice, sizeof(dmrpacket_sync_pattern_ms_sourced_voice),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_DATA:
 			base_bytestobits(dmrpacket_sync_pattern_ms_sourced_data, sizeof(dmrpacket_sync_pattern_ms_sourced_data),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_MS_SOURCED_RC:
 			base_bytestobits(dmrpacket_sync_pattern_ms_sourced_rc, sizeof(dmrpacket_sync_pattern_ms_sourced_rc),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_VOICE_TS1:
 			base_bytestobits(dmrpacket_sync_pattern_direct_voice_ts1, sizeof(dmrpacket_sync_pattern_direct_voice_ts1),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_DATA_TS1:
 			base_bytestobits(dmrpacket_sync_pattern_direct_data_ts1, sizeof(dmrpacket_sync_pattern_direct_data_ts1),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_VOICE_TS2:
 			base_bytestobits(dmrpacket_sync_pattern_direct_voice_ts2, sizeof(dmrpacket_sync_pattern_direct_voice_ts2),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		case DMRPACKET_SYNC_PATTERN_TYPE_DIRECT_DATA_TS2:
 			base_bytestobits(dmrpacket_sync_pattern_direct_data_ts2, sizeof(dmrpacket_sync_pattern_direct_data_ts2),
-				sync_bits.bits, sizeof(dmrpacket_sync_bits_t));
+				sync_bits->bits, sizeof(dmrpacket_sync_bits_t));
 			break;
 		default:
-			memset(sync_bits.bits, 0, sizeof(dmrpacket_sync_bits_t));
+			memset(sync_bits->bits, 0, sizeof(dmrpacket_sync_bits_t));
 			break;
 	}
 
-	return &sync_bits;
+	return sync_bits;
+}
+
+dmrpacket_sync_bits_t *dmrpacket_sync_construct_bits(dmrpacket_sync_pattern_type_t sync_pattern_type) {
+	static dmrpacket_sync_bits_t sync_bits;
+
+	return dmrpacket_sync_construct_bits_r(sync_pattern_type, &sync_bits);
 }
 
 char *dmrpacket_sync_get_readable_sync_pattern_type(dmrpacket_sync_pattern_type_t sync_pattern_type) {
@@ -145,3 +170,18 @@ dmrpacket_sync_pattern_type_t dmrpacket_sync_get_sync_pattern_type(dmrpacket_syn
 	else
 		return DMRPACKET_SYNC_PATTERN_TYPE_UNKNOWN;
 }
+
+// Returns the 48 bit sync field of the packed payload.
+uint64_t dmrpacket_sync_extract_word(dmrpacket_payload_packed_bits_t *packed_bits) {
+	return dmrpacket_packed_get_bits(packed_bits, sizeof(dmrpacket_payload_info_bits_t)/2+sizeof(dmrpacket_slot_type_bits_t)/2, 48);
+}
+
+dmrpacket_sync_pattern_type_t dmrpacket_sync_get_sync_pattern_type_word(uint64_t sync_word) {
+	uint8_t i;
+
+	for (i = 0; i < sizeof(dmrpacket_sync_pattern_words)/sizeof(dmrpacket_sync_pattern_words[0]); i++) {
+		if (dmrpacket_sync_pattern_words[i].pattern == sync_word)
+			return dmrpacket_sync_pattern_words[i].type;
+	}
+	return DMRPACKET_SYNC_PATTERN_TYPE_UNKNOWN;
+}
@@ -24,6 +24,12 @@ typedef struct {
 	flag_t bits[98+10+48+10+98]; // See DMR AI spec. page 85.
 } dmrpacket_payload_bits_t;
 
+// The same payload packed into 64 bit words. Payload bit 0 is the MSB of words[0], so a field of the
+// payload can be read with a shift and a mask instead of touching one byte per bit.
+typedef struct {
+	uint64_t words[(sizeof(dmrpacket_payload_bits_t)+63)/64];
+} dmrpacket_payload_packed_bits_t;
+
 typedef struct {
 	flag_t bits[98*2];
 } dmrpacket_payload_info_bits_t;
@@ -25,16 +25,37 @@
 #include <string.h>
 
 // Extracts the info part of the payload (leaves out slot type and sync parts).
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_info_bits_t *info_bits) {
+	if (payload_bits == NULL)
+		return NULL;
+
+	memcpy(info_bits->bits, payload_bits->bits, sizeof(info_bits->bits)/2);
+	memcpy(&info_bits->bits[sizeof(info_bits->bits)/2], payload_bits->bits+98+10+48+10, sizeof(info_bits->bits)/2);
+
+	return info_bits;
+}
+
 dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits(dmrpacket_payload_bits_t *payload_bits) {
 	static dmrpacket_payload_info_bits_t info_bits;
 
-	if (payload_bits == NULL)
+	return dmrpacket_extract_info_bits_r(payload_bits, &info_bits);
+}
+
+// Same as dmrpacket_extract_info_bits_r(), but unpacks only the info part of the packed payload.
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, dmrpacket_payload_info_bits_t *info_bits) {
+	if (packed_bits == NULL)
 		return NULL;
 
-	memcpy(&info_bits.bits, payload_bits->bits, sizeof(info_bits.bits)/2);
-	memcpy(&info_bits.bits[sizeof(info_bits.bits)/2], payload_bits->bits+98+10+48+10, sizeof(info_bits.bits)/2);
+	dmrpacket_packed_to_bits(packed_bits, 0, sizeof(info_bits->bits)/2, info_bits->bits);
+	dmrpacket_packed_to_bits(packed_bits, 98+10+48+10, sizeof(info_bits->bits)/2, &info_bits->bits[sizeof(info_bits->bits)/2]);
+
+	return info_bits;
+}
+
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_from_packed(dmrpacket_payload_packed_bits_t *packed_bits) {
+	static dmrpacket_payload_info_bits_t info_bits;
 
-	return &info_bits;
+	return dmrpacket_extract_info_bits_from_packed_r(packed_bits, &info_bits);
 }
 
 void dmrpacket_insert_info_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_info_bits_t *info_bits) {
@@ -45,16 +66,37 @@ void dmrpacket_insert_info_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacke
 	memcpy(payload_bits->bits+98+10+48+10, &info_bits->bits[sizeof(dmrpacket_payload_info_bits_t)/2], sizeof(dmrpacket_payload_info_bits_t)/2);
 }
 
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_voice_bits_t *voice_bits) {
+	if (payload_bits == NULL)
+		return NULL;
+
+	memcpy(voice_bits->raw.bits, payload_bits->bits, sizeof(dmrpacket_payload_voice_bits_t)/2);
+	memcpy(&voice_bits->raw.bits[sizeof(dmrpacket_payload_voice_bits_t)/2], payload_bits->bits+108+48, sizeof(dmrpacket_payload_voice_bits_t)/2);
+
+	return voice_bits;
+}
+
 dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits(dmrpacket_payload_bits_t *payload_bits) {
 	static dmrpacket_payload_voice_bits_t voice_bits;
 
-	if (payload_bits == NULL)
+	return dmrpacket_extract_voice_bits_r(payload_bits, &voice_bits);
+}
+
+// Same as dmrpacket_extract_voice_bits_r(), but unpacks only the voice part of the packed payload.
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, dmrpacket_payload_voice_bits_t *voice_bits) {
+	if (packed_bits == NULL)
 		return NULL;
 
-	memcpy(voice_bits.raw.bits, payload_bits->bits, sizeof(dmrpacket_payload_voice_bits_t)/2);
-	memcpy(&voice_bits.raw.bits[sizeof(dmrpacket_payload_voice_bits_t)/2], payload_bits->bits+108+48, sizeof(dmrpacket_payload_voice_bits_t)/2);
+	dmrpacket_packed_to_bits(packed_bits, 0, sizeof(dmrpacket_payload_voice_bits_t)/2, voice_bits->raw.bits);
+	dmrpacket_packed_to_bits(packed_bits, 108+48, sizeof(dmrpacket_payload_voice_bits_t)/2, &voice_bits->raw.bits[sizeof(dmrpacket_payload_voice_bits_t)/2]);
+
+	return voice_bits;
+}
+
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_from_packed(dmrpacket_payload_packed_bits_t *packed_bits) {
+	static dmrpacket_payload_voice_bits_t voice_bits;
 
-	return &voice_bits;
+	return dmrpacket_extract_voice_bits_from_packed_r(packed_bits, &voice_bits);
 }
 
 void dmrpacket_insert_voice_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_voice_bits_t *voice_bits) {
@@ -64,3 +106,20 @@ void dmrpacket_insert_voice_bits(dmrpacket_payload_bits_t *payload_bits, dmrpack
 	memcpy(payload_bits->bits, voice_bits->raw.bits, sizeof(dmrpacket_payload_voice_bits_t)/2);
 	memcpy(payload_bits->bits+108+48, &voice_bits->raw.bits[sizeof(dmrpacket_payload_voice_bits_t)/2], sizeof(dmrpacket_payload_voice_bits_t)/2);
 }
+
+void dmrpacket_packed_from_bytes(uint8_t *bytes, uint16_t bytes_length, dmrpacket_payload_packed_bits_t *packed_bits) {
+	uint16_t i;
+
+	memset(packed_bits, 0, sizeof(dmrpacket_payload_packed_bits_t));
+	for (i = 0; i < bytes_length && i < sizeof(packed_bits->words); i++)
+		packed_bits->words[i >> 3] |= (uint64_t)bytes[i] << (56-(i & 7)*8);
+}
+
+// Unpacks count payload bits starting at the given bit position to one flag per bit, for the
+// functions which need the unpacked form.
+void dmrpacket_packed_to_bits(dmrpacket_payload_packed_bits_t *packed_bits, uint16_t from, uint16_t count, flag_t *bits) {
+	uint16_t i;
+
+	for (i = 0; i < count; i++)
+		bits[i] = dmrpacket_packed_get_bit(packed_bits, from+i);
+}
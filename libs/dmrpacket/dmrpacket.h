@@ -22,10 +22,42 @@
 
 #include <libs/base/dmr.h>
 
+// Like in libs/coding, the _r variants of the extract, decode and construct functions put their
+// result into the caller's buffer instead of a static one, so they are reentrant.
+
 dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits(dmrpacket_payload_bits_t *payload_bits);
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_info_bits_t *info_bits);
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_from_packed(dmrpacket_payload_packed_bits_t *packed_bits);
+dmrpacket_payload_info_bits_t *dmrpacket_extract_info_bits_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, dmrpacket_payload_info_bits_t *info_bits);
 void dmrpacket_insert_info_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_info_bits_t *info_bits);
 
 dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits(dmrpacket_payload_bits_t *payload_bits);
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_r(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_voice_bits_t *voice_bits);
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_from_packed(dmrpacket_payload_packed_bits_t *packed_bits);
+dmrpacket_payload_voice_bits_t *dmrpacket_extract_voice_bits_from_packed_r(dmrpacket_payload_packed_bits_t *packed_bits, dmrpacket_payload_voice_bits_t *voice_bits);
 void dmrpacket_insert_voice_bits(dmrpacket_payload_bits_t *payload_bits, dmrpacket_payload_voice_bits_t *voice_bits);
 
+// Returns count (1-64) payload bits starting at the given bit position, the first bit is the MSB of the result.
+static inline uint64_t dmrpacket_packed_get_bits(dmrpacket_payload_packed_bits_t *packed_bits, uint16_t from, uint8_t count) {
+	uint16_t word = from >> 6;
+	uint8_t offset = from & 63;
+	uint64_t value = packed_bits->words[word] << offset;
+
+	if (offset+count > 64)
+		value |= packed_bits->words[word+1] >> (64-offset);
+	return value >> (64-count);
+}
+
+static inline flag_t dmrpacket_packed_get_bit(dmrpacket_payload_packed_bits_t *packed_bits, uint16_t pos) {
+	return (packed_bits->words[pos >> 6] >> (63-(pos & 63))) & 1;
+}
+
+// Returns the number of differing bits in the given words.
+static inline uint8_t dmrpacket_packed_get_distance(uint64_t a, uint64_t b) {
+	return __builtin_popcountll(a ^ b);
+}
+
+void dmrpacket_packed_from_bytes(uint8_t *bytes, uint16_t bytes_length, dmrpacket_payload_packed_bits_t *packed_bits);
+void dmrpacket_packed_to_bits(dmrpacket_payload_packed_bits_t *packed_bits, uint16_t from, uint16_t count, flag_t *bits);
+
 #endif
@@ -22,6 +22,7 @@
 #include "callsignbookdb.h"
 
 #include <libs/config/config.h>
+#include <libs/config/config-snapshot.h>
 #include <libs/comm/comm.h>
 #include <libs/base/smstxbuf.h>
 
@@ -223,8 +224,9 @@ void remotedb_update_stats_callend(repeater_t *repeater, dmr_timeslot_t ts) {
 	char *tableprefix = NULL;
 	char query[REMOTEDB_MAXQUERYSIZE] = {0,};
 	int talktime;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (repeater == NULL || !config_get_updatestatstableenabled() || ts > 1 || ts < 0)
+	if (repeater == NULL || config_snapshot == NULL || !config_snapshot->updatestatstableenabled || ts > 1 || ts < 0)
 		return;
 
 	talktime = repeater->slot[ts].call_ended_at-repeater->slot[ts].call_started_at;
@@ -417,11 +419,12 @@ static void remotedb_thread_process(void) {
 	static flag_t userdb_dl_ok = 0;
 	static flag_t callsignbookdb_dl_ok = 0;
 	char *callsignbookdbtablename;
+	const config_snapshot_t *config_snapshot = config_snapshot_get();
 
-	if (remotedb_conn == NULL)
+	if (remotedb_conn == NULL || config_snapshot == NULL)
 		return;
 
-	if (time(NULL)-lastconnecttriedat > config_get_remotedbreconnecttrytimeoutinsec()) {
+	if (time(NULL)-lastconnecttriedat > config_snapshot->remotedbreconnecttrytimeoutinsec) {
 		pthread_mutex_lock(&remotedb_mutex_remotedb_conn);
 		if (mysql_ping(remotedb_conn) != 0)
 			remotedb_thread_connect();
@@ -429,24 +432,24 @@ static void remotedb_thread_process(void) {
 		lastconnecttriedat = time(NULL);
 	}
 
-	if (config_get_remotedbmaintenanceperiodinsec() > 0 && time(NULL)-lastmaintenanceat > config_get_remotedbmaintenanceperiodinsec()) {
+	if (config_snapshot->remotedbmaintenanceperiodinsec > 0 && time(NULL)-lastmaintenanceat > config_snapshot->remotedbmaintenanceperiodinsec) {
 		remotedb_maintain();
 		lastmaintenanceat = time(NULL);
 	}
 
-	if (time(NULL)-lastrepeaterlistmaintenanceat > config_get_repeaterinactivetimeoutinsec()) {
+	if (time(NULL)-lastrepeaterlistmaintenanceat > config_snapshot->repeaterinactivetimeoutinsec) {
 		remotedb_maintain_repeaterlist();
 		lastrepeaterlistmaintenanceat = time(NULL);
 	}
 
-	if (config_get_remotedbmsgqueuepollintervalinsec() && time(NULL)-lastremotedbmsgqueuepollat > config_get_remotedbmsgqueuepollintervalinsec()) {
+	if (config_snapshot->remotedbmsgqueuepollintervalinsec && time(NULL)-lastremotedbmsgqueuepollat > config_snapshot->remotedbmsgqueuepollintervalinsec) {
 		remotedb_thread_msgqueue_poll();
 		lastremotedbmsgqueuepollat = time(NULL);
 	}
 
 	// If user list db download was unsuccessful, we retry it every minute.
-	if (config_get_remotedbuserlistdlperiodinsec()) {
-		if (time(NULL)-lastuserlistqueryat > config_get_remotedbuserlistdlperiodinsec() || (!userdb_dl_ok && time(NULL)-lastuserlistqueryat > 60)) {
+	if (config_snapshot->remotedbuserlistdlperiodinsec) {
+		if (time(NULL)-lastuserlistqueryat > config_snapshot->remotedbuserlistdlperiodinsec || (!userdb_dl_ok && time(NULL)-lastuserlistqueryat > 60)) {
 			pthread_mutex_lock(&remotedb_mutex_remotedb_conn);
 			userdb_dl_ok = userdb_reload(remotedb_conn);
 			pthread_mutex_unlock(&remotedb_mutex_remotedb_conn);
@@ -487,6 +490,7 @@ static void *remotedb_thread_init(void *arg) {
 	int i;
 	unsigned int opt;
 	struct timespec ts;
+	int config_snapshot_reader_id = config_snapshot_reader_register();
 
 	remotedb_thread_should_stop = 0;
 
@@ -519,6 +523,7 @@ static void *remotedb_thread_init(void *arg) {
 			pthread_mutex_unlock(&remotedb_mutex_thread_should_stop);
 
 			remotedb_thread_process();
+			config_snapshot_reader_quiescent(config_snapshot_reader_id);
 
 			// If we don't have other queries in the buffer, we wait for a condition for the given timeout.
 			clock_gettime(CLOCK_REALTIME, &ts);
@@ -541,6 +546,7 @@ static void *remotedb_thread_init(void *arg) {
 	pthread_mutex_destroy(&remotedb_mutex_wakeup);
 	pthread_cond_destroy(&remotedb_cond_wakeup);
 
+	config_snapshot_reader_unregister(config_snapshot_reader_id);
 	pthread_exit((void*) 0);
 }
 
@@ -296,7 +296,7 @@ void voicestreams_processpacket(ipscpacket_t *ipscpacket, repeater_t *repeater)
 
 	console_log(LOGLEVEL_VOICESTREAMS "voicestreams [%s]: processing packet from %s\n", voicestream->name, repeaters_get_display_string((repeater_t *)voicestream->currently_streaming_repeater));
 
-	voice_bits = dmrpacket_extract_voice_bits(&ipscpacket->payload_bits);
+	voice_bits = dmrpacket_extract_voice_bits_from_packed(&ipscpacket->payload_packed_bits);
 	base_bitstobytes(voice_bits->raw.bits, sizeof(dmrpacket_payload_voice_bits_t), voice_bytes, sizeof(voice_bytes));
 
 	if (voicestream->savetorawambefile)
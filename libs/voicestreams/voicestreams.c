@@ -139,10 +139,110 @@ void voicestreams_printlist(void) {
 	}
 }
 
+// Reads the settings of the given stream from the config.
+static void voicestreams_load_config(voicestream_t *vs) {
+	free(vs->repeaterhosts);
+	free(vs->savefiledir);
+	free(vs->playrawfileatcallstart);
+	free(vs->playrawfileatcallend);
+
+	vs->enabled = config_voicestreams_get_enabled(vs->name);
+	vs->repeaterhosts = config_voicestreams_get_repeaterhosts(vs->name);
+	vs->savefiledir = config_voicestreams_get_savefiledir(vs->name);
+	vs->savetorawambefile = config_voicestreams_get_savetorawambefile(vs->name);
+	vs->savedecodedtorawfile = config_voicestreams_get_savedecodedtorawfile(vs->name);
+	vs->savedecodedtomp3file = config_voicestreams_get_savedecodedtomp3file(vs->name);
+	vs->minmp3bitrate = config_voicestreams_get_minmp3bitrate(vs->name);
+	vs->mp3bitrate = config_voicestreams_get_mp3bitrate(vs->name);
+	vs->mp3quality = config_voicestreams_get_mp3quality(vs->name);
+	vs->mp3vbr = config_voicestreams_get_mp3vbr(vs->name);
+	vs->timeslot = config_voicestreams_get_timeslot(vs->name);
+	vs->decodequality = config_voicestreams_get_decodequality(vs->name);
+	vs->playrawfileatcallstart = config_voicestreams_get_playrawfileatcallstart(vs->name);
+	vs->rawfileatcallstartgain = config_voicestreams_get_rawfileatcallstartgain(vs->name);
+	vs->playrawfileatcallend = config_voicestreams_get_playrawfileatcallend(vs->name);
+	vs->rawfileatcallendgain = config_voicestreams_get_rawfileatcallendgain(vs->name);
+	vs->rmsminsamplevalue = config_voicestreams_get_rmsminsamplevalue(vs->name);
+}
+
+static voicestream_t *voicestreams_add(char *name) {
+	voicestream_t *new_vs;
+
+	console_log("  initializing %s...\n", name);
+	new_vs = (voicestream_t *)calloc(sizeof(voicestream_t), 1);
+	if (!new_vs) {
+		console_log("    warning: couldn't allocate memory\n");
+		return NULL;
+	}
+
+	new_vs->name = strdup(name);
+	if (!new_vs->name) {
+		console_log("    warning: couldn't allocate memory\n");
+		free(new_vs);
+		return NULL;
+	}
+	voicestreams_load_config(new_vs);
+
+	new_vs->rms_vol = new_vs->avg_rms_vol = VOICESTREAMS_INVALID_RMS_VALUE;
+
+#if defined(AMBEDECODEVOICE) && defined(MP3ENCODEVOICE)
+	voicestreams_mp3_init(new_vs);
+#endif
+
+	new_vs->next = voicestreams;
+	voicestreams = new_vs;
+	return new_vs;
+}
+
+// Updates the voice streams from the reloaded config. Streams are not freed, as calls and HTTP
+// clients may reference them, so streams removed from the config are only disabled.
+void voicestreams_reload(void) {
+	char **streamnames = config_voicestreams_get_streamnames();
+	char **streamnames_i;
+	voicestream_t *vs;
+#if defined(AMBEDECODEVOICE) && defined(MP3ENCODEVOICE)
+	uint8_t minmp3bitrate;
+	uint8_t mp3bitrate;
+	uint8_t mp3quality;
+	flag_t mp3vbr;
+#endif
+
+	console_log("voicestreams: reloading\n");
+
+	for (vs = voicestreams; vs != NULL; vs = vs->next)
+		vs->enabled = 0;
+
+	for (streamnames_i = streamnames; streamnames_i != NULL && *streamnames_i != NULL; streamnames_i++) {
+		vs = voicestreams_get_stream_by_name(*streamnames_i);
+		if (vs == NULL) {
+			voicestreams_add(*streamnames_i);
+			continue;
+		}
+
+#if defined(AMBEDECODEVOICE) && defined(MP3ENCODEVOICE)
+		minmp3bitrate = vs->minmp3bitrate;
+		mp3bitrate = vs->mp3bitrate;
+		mp3quality = vs->mp3quality;
+		mp3vbr = vs->mp3vbr;
+#endif
+		voicestreams_load_config(vs);
+#if defined(AMBEDECODEVOICE) && defined(MP3ENCODEVOICE)
+		// The encoder has to be reinitialized only if its settings have been changed.
+		if (minmp3bitrate != vs->minmp3bitrate || mp3bitrate != vs->mp3bitrate || mp3quality != vs->mp3quality || mp3vbr != vs->mp3vbr) {
+			console_log("  reinitializing mp3 encoder of %s...\n", vs->name);
+			voicestreams_mp3_deinit(vs);
+			voicestreams_mp3_init(vs);
+		}
+#endif
+	}
+
+	if (streamnames != NULL)
+		config_voicestreams_free_streamnames(streamnames);
+}
+
 void voicestreams_init(void) {
 	char **streamnames = config_voicestreams_get_streamnames();
 	char **streamnames_i = streamnames;
-	voicestream_t *new_vs;
 #ifdef AMBEDECODEVOICE
 	char mbeversion[25];
 #endif
@@ -154,46 +254,7 @@ void voicestreams_init(void) {
 	}
 
 	while (*streamnames_i != NULL) {
-		console_log("  initializing %s...\n", *streamnames_i);
-		new_vs = (voicestream_t *)calloc(sizeof(voicestream_t), 1);
-		if (!new_vs) {
-			console_log("    warning: couldn't allocate memory\n");
-			continue;
-		}
-
-		new_vs->name = strdup(*streamnames_i);
-		if (!new_vs->name) {
-			console_log("    warning: couldn't allocate memory\n");
-			free(new_vs);
-			continue;
-		}
-		new_vs->enabled = config_voicestreams_get_enabled(new_vs->name);
-		new_vs->repeaterhosts = config_voicestreams_get_repeaterhosts(new_vs->name);
-		new_vs->savefiledir = config_voicestreams_get_savefiledir(new_vs->name);
-		new_vs->savetorawambefile = config_voicestreams_get_savetorawambefile(new_vs->name);
-		new_vs->savedecodedtorawfile = config_voicestreams_get_savedecodedtorawfile(new_vs->name);
-		new_vs->savedecodedtomp3file = config_voicestreams_get_savedecodedtomp3file(new_vs->name);
-		new_vs->minmp3bitrate = config_voicestreams_get_minmp3bitrate(new_vs->name);
-		new_vs->mp3bitrate = config_voicestreams_get_mp3bitrate(new_vs->name);
-		new_vs->mp3quality = config_voicestreams_get_mp3quality(new_vs->name);
-		new_vs->mp3vbr = config_voicestreams_get_mp3vbr(new_vs->name);
-		new_vs->timeslot = config_voicestreams_get_timeslot(new_vs->name);
-		new_vs->decodequality = config_voicestreams_get_decodequality(new_vs->name);
-		new_vs->playrawfileatcallstart = config_voicestreams_get_playrawfileatcallstart(new_vs->name);
-		new_vs->rawfileatcallstartgain = config_voicestreams_get_rawfileatcallstartgain(new_vs->name);
-		new_vs->playrawfileatcallend = config_voicestreams_get_playrawfileatcallend(new_vs->name);
-		new_vs->rawfileatcallendgain = config_voicestreams_get_rawfileatcallendgain(new_vs->name);
-		new_vs->rmsminsamplevalue = config_voicestreams_get_rmsminsamplevalue(new_vs->name);
-
-		new_vs->rms_vol = new_vs->avg_rms_vol = VOICESTREAMS_INVALID_RMS_VALUE;
-
-#if defined(AMBEDECODEVOICE) && defined(MP3ENCODEVOICE)
-		voicestreams_mp3_init(new_vs);
-#endif
-
-		new_vs->next = voicestreams;
-		voicestreams = new_vs;
-
+		voicestreams_add(*streamnames_i);
 		streamnames_i++;
 	}
 	config_voicestreams_free_streamnames(streamnames);
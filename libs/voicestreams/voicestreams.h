@@ -100,6 +100,7 @@ voicestream_t *voicestreams_get_stream_by_name(char *name);
 
 void voicestreams_printlist(void);
 
+void voicestreams_reload(void);
 void voicestreams_init(void);
 void voicestreams_deinit(void);
 
@@ -0,0 +1,215 @@
+// Compares the syndrome table based BPTC(196,96) check and repair with the previous implementation,
+// which checked each row and column bit by bit and searched the error vector in the generator matrix.
+// Both are run on CSBK, data header and voice LC header bursts with 0, 1, 2 and 3 bit errors, and
+// the repaired bits and results must be the same. The matrix based check and repair, which works
+// on row words only, must extract the same data bits.
+
+#include DEFAULTCONFIG
+
+#include <libs/coding/bptc-196-96.h>
+#include <libs/coding/crc.h>
+#include <libs/dmrpacket/dmrpacket-csbk.h>
+#include <libs/dmrpacket/dmrpacket-data-header.h>
+#include <libs/dmrpacket/dmrpacket-lc.h>
+#include <libs/dmrpacket/dmrpacket-emb.h>
+#include <libs/base/dmr.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BURSTS_PER_TYPE		4000
+#define ROUNDS				50
+
+// These are not used by the benchmark, only needed for linking.
+char *dmr_get_readable_call_type(dmr_call_type_t call_type) {
+	return "";
+}
+
+flag_t dmrpacket_emb_check_checksum(dmrpacket_emb_signalling_lc_bits_t *emb_signalling_lc_bits) {
+	return 0;
+}
+
+static flag_t ref_hamming_15_11_3_errorcheck(flag_t *d, flag_t ev[4]) {
+	ev[0] = (d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8]) ^ d[11];
+	ev[1] = (d[1] ^ d[2] ^ d[3] ^ d[4] ^ d[6] ^ d[8] ^ d[9]) ^ d[12];
+	ev[2] = (d[2] ^ d[3] ^ d[4] ^ d[5] ^ d[7] ^ d[9] ^ d[10]) ^ d[13];
+	ev[3] = (d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7] ^ d[10]) ^ d[14];
+	return (ev[0] == 0 && ev[1] == 0 && ev[2] == 0 && ev[3] == 0);
+}
+
+static flag_t ref_hamming_13_9_3_errorcheck(flag_t *d, flag_t ev[4]) {
+	ev[0] = (d[0] ^ d[1] ^ d[3] ^ d[5] ^ d[6]) ^ d[9];
+	ev[1] = (d[0] ^ d[1] ^ d[2] ^ d[4] ^ d[6] ^ d[7]) ^ d[10];
+	ev[2] = (d[0] ^ d[1] ^ d[2] ^ d[3] ^ d[5] ^ d[7] ^ d[8]) ^ d[11];
+	ev[3] = (d[0] ^ d[2] ^ d[4] ^ d[5] ^ d[8]) ^ d[12];
+	return (ev[0] == 0 && ev[1] == 0 && ev[2] == 0 && ev[3] == 0);
+}
+
+static int ref_find_error_position(flag_t *generator_matrix, uint8_t rows, flag_t ev[4]) {
+	uint8_t row;
+
+	for (row = 0; row < rows; row++) {
+		if (generator_matrix[row*4] == ev[0] && generator_matrix[row*4+1] == ev[1] &&
+			generator_matrix[row*4+2] == ev[2] && generator_matrix[row*4+3] == ev[3])
+				return row;
+	}
+	return -1;
+}
+
+// The previous implementation. Row 3 of the Hamming(13,9) generator matrix is 1010 here, the old
+// table had 0111 there, which is a duplicate of row 2.
+static flag_t ref_check_and_repair(flag_t deinterleaved_bits[196]) {
+	static flag_t hamming_15_11_generator_matrix[] = {
+		1, 0, 0, 1,  1, 1, 0, 1,  1, 1, 1, 1,  1, 1, 1, 0,  0, 1, 1, 1,  1, 0, 1, 0,
+		0, 1, 0, 1,  1, 0, 1, 1,  1, 1, 0, 0,  0, 1, 1, 0,  0, 0, 1, 1,
+		1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1
+	};
+	static flag_t hamming_13_9_generator_matrix[] = {
+		1, 1, 1, 1,  1, 1, 1, 0,  0, 1, 1, 1,  1, 0, 1, 0,  0, 1, 0, 1,  1, 0, 1, 1,
+		1, 1, 0, 0,  0, 1, 1, 0,  0, 0, 1, 1,
+		1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1
+	};
+	flag_t column_bits[13];
+	flag_t ev[4];
+	uint8_t row, col;
+	int wrongbitnr;
+	flag_t result = 1;
+
+	for (col = 0; col < 15; col++) {
+		for (row = 0; row < 13; row++)
+			column_bits[row] = deinterleaved_bits[col+row*15+1];
+
+		if (!ref_hamming_13_9_3_errorcheck(column_bits, ev)) {
+			wrongbitnr = ref_find_error_position(hamming_13_9_generator_matrix, 13, ev);
+			if (wrongbitnr < 0)
+				result = 0;
+			else
+				deinterleaved_bits[col+wrongbitnr*15+1] = !deinterleaved_bits[col+wrongbitnr*15+1];
+		}
+	}
+
+	for (row = 0; row < 9; row++) {
+		if (!ref_hamming_15_11_3_errorcheck(&deinterleaved_bits[row*15+1], ev)) {
+			wrongbitnr = ref_find_error_position(hamming_15_11_generator_matrix, 15, ev);
+			if (wrongbitnr < 0)
+				result = 0;
+			else
+				deinterleaved_bits[row*15+wrongbitnr+1] = !deinterleaved_bits[row*15+wrongbitnr+1];
+		}
+	}
+
+	return result;
+}
+
+static double get_time_in_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static void generate_bursts(char *name, bptc_196_96_data_bits_t *data_bits, dmrpacket_payload_info_bits_t *bursts) {
+	dmrpacket_payload_info_bits_t burst;
+	int i, j;
+
+	bptc_196_96_generate_r(data_bits, &burst);
+	for (i = 0; i < BURSTS_PER_TYPE; i++) {
+		memcpy(&bursts[i], &burst, sizeof(dmrpacket_payload_info_bits_t));
+		// Bit 0 is R(3), it's not covered by the code.
+		for (j = 0; j < i % 4; j++)
+			bursts[i].bits[1 + rand() % 195] ^= 1;
+	}
+}
+
+static int run(char *name, dmrpacket_payload_info_bits_t *bursts) {
+	static dmrpacket_payload_info_bits_t ref_bursts[BURSTS_PER_TYPE];
+	static dmrpacket_payload_info_bits_t new_bursts[BURSTS_PER_TYPE];
+	static bptc_196_96_matrix_t matrices[BURSTS_PER_TYPE];
+	flag_t ref_results[BURSTS_PER_TYPE];
+	flag_t new_results[BURSTS_PER_TYPE];
+	flag_t matrix_results[BURSTS_PER_TYPE];
+	bptc_196_96_data_bits_t ref_data_bits;
+	bptc_196_96_data_bits_t matrix_data_bits;
+	double start, ref_time, new_time, matrix_time;
+	int i, round;
+	int mismatches = 0;
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		memcpy(ref_bursts, bursts, sizeof(ref_bursts));
+		for (i = 0; i < BURSTS_PER_TYPE; i++)
+			ref_results[i] = ref_check_and_repair(ref_bursts[i].bits);
+	}
+	ref_time = get_time_in_ns()-start;
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		memcpy(new_bursts, bursts, sizeof(new_bursts));
+		for (i = 0; i < BURSTS_PER_TYPE; i++)
+			new_results[i] = bptc_196_96_check_and_repair(new_bursts[i].bits);
+	}
+	new_time = get_time_in_ns()-start;
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < BURSTS_PER_TYPE; i++) {
+			bptc_196_96_matrix_from_bits_r(bursts[i].bits, &matrices[i]);
+			matrix_results[i] = bptc_196_96_check_and_repair_matrix(&matrices[i]);
+		}
+	}
+	matrix_time = get_time_in_ns()-start;
+
+	for (i = 0; i < BURSTS_PER_TYPE; i++) {
+		if (ref_results[i] != new_results[i] || memcmp(&ref_bursts[i], &new_bursts[i], sizeof(dmrpacket_payload_info_bits_t)) != 0)
+			mismatches++;
+
+		bptc_196_96_extractdata_r(ref_bursts[i].bits, &ref_data_bits);
+		bptc_196_96_extractdata_from_matrix_r(&matrices[i], &matrix_data_bits);
+		if (ref_results[i] != matrix_results[i] || memcmp(&ref_data_bits, &matrix_data_bits, sizeof(bptc_196_96_data_bits_t)) != 0)
+			mismatches++;
+	}
+
+	printf("%-16s old: %7.1f ns/burst  new: %7.1f ns/burst  matrix: %7.1f ns/burst  speedup: %.1fx  mismatches: %d\n", name,
+		ref_time/(ROUNDS*BURSTS_PER_TYPE), new_time/(ROUNDS*BURSTS_PER_TYPE), matrix_time/(ROUNDS*BURSTS_PER_TYPE), ref_time/new_time, mismatches);
+	return mismatches;
+}
+
+int main(void) {
+	static dmrpacket_payload_info_bits_t bursts[BURSTS_PER_TYPE];
+	bptc_196_96_data_bits_t data_bits;
+	dmrpacket_csbk_t csbk;
+	dmrpacket_data_header_t data_header;
+	int mismatches = 0;
+
+	srand(1);
+	bptc_196_96_init();
+	crc_init();
+
+	memset(&csbk, 0, sizeof(dmrpacket_csbk_t));
+	csbk.last_block = 1;
+	csbk.csbko = DMRPACKET_CSBKO_PREAMBLE;
+	csbk.data.preamble.data_follows = 1;
+	csbk.data.preamble.csbk_blocks_to_follow = 4;
+	csbk.dst_id = 2161005;
+	csbk.src_id = 2167005;
+	generate_bursts("csbk", dmrpacket_csbk_construct_r(&csbk, &data_bits), bursts);
+	mismatches += run("csbk", bursts);
+
+	memset(&data_header, 0, sizeof(dmrpacket_data_header_t));
+	data_header.common.response_requested = 1;
+	data_header.common.dst_llid = 2161005;
+	data_header.common.src_llid = 2167005;
+	data_header.common.data_packet_format = DMRPACKET_DATA_HEADER_DPF_CONFIRMED_DATA;
+	data_header.common.service_access_point = DMRPACKET_DATA_HEADER_SAP_IP_BASED_PACKET_DATA;
+	data_header.confirmed_data.full_message = 1;
+	data_header.confirmed_data.blocks_to_follow = 3;
+	generate_bursts("data header", dmrpacket_data_header_construct_r(&data_header, 0, &data_bits), bursts);
+	mismatches += run("data header", bursts);
+
+	generate_bursts("voice lc header", dmrpacket_lc_construct_voice_lc_header_r(DMR_CALL_TYPE_GROUP, 9, 2161005, &data_bits), bursts);
+	mismatches += run("voice lc header", bursts);
+
+	return (mismatches != 0);
+}
@@ -0,0 +1,47 @@
+// Stubs of the daemon console and base functions used by the coding and dmrpacket libs, so the
+// standalone tests can be linked without the rest of dmrshark. Logging is disabled.
+
+#include DEFAULTCONFIG
+
+#include <libs/daemon/console.h>
+#include <libs/base/base.h>
+
+loglevel_t console_loglevel;
+
+#undef console_log
+void console_log(const char *format, ...) {
+}
+
+loglevel_t console_get_loglevel(void) {
+	return console_loglevel;
+}
+
+void base_bytetobits(uint8_t byte, flag_t *bits) {
+	uint8_t i;
+
+	for (i = 0; i < 8; i++)
+		bits[i] = (byte >> (7-i)) & 1;
+}
+
+void base_bytestobits(uint8_t *bytes, uint16_t bytes_length, flag_t *bits, uint16_t bits_length) {
+	uint16_t i;
+
+	for (i = 0; i < bytes_length && i < bits_length/8; i++)
+		base_bytetobits(bytes[i], &bits[i*8]);
+}
+
+uint8_t base_bitstobyte(flag_t bits[8]) {
+	uint8_t i;
+	uint8_t val = 0;
+
+	for (i = 0; i < 8; i++)
+		val |= (bits[i] != 0) << (7-i);
+	return val;
+}
+
+void base_bitstobytes(flag_t *bits, uint16_t bits_length, uint8_t *bytes, uint16_t bytes_length) {
+	uint16_t i;
+
+	for (i = 0; i < bits_length/8 && i < bytes_length; i++)
+		bytes[i] = base_bitstobyte(&bits[i*8]);
+}
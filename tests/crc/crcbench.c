@@ -0,0 +1,282 @@
+// Compares the table based CRC16-CCITT, CRC9 and CRC32 calculation with the previous bit by bit shift
+// register implementation. Both are run with random data of all lengths up to the max. fragment size,
+// and with random initial CRC values. The results must be the same. Then the speed of the
+// implementations is measured with the data sizes used for CSBKs/data headers, confirmed data blocks
+// and data fragments.
+
+#include DEFAULTCONFIG
+
+#include <libs/coding/crc.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DATA_LENGTH		1500
+#define ROUNDS				20000
+
+static void ref_calc_crc16_ccitt(uint16_t *crc, uint8_t in) {
+	uint8_t v = 0x80;
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < 8; i++) {
+		xor_flag = ((*crc) & 0x8000) > 0;
+		(*crc) <<= 1;
+		if (in & v)
+			(*crc)++;
+		if (xor_flag)
+			(*crc) ^= 0x1021;
+		v >>= 1;
+	}
+}
+
+static void ref_calc_crc16_ccitt_finish(uint16_t *crc) {
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++) {
+		xor_flag = ((*crc) & 0x8000) > 0;
+		(*crc) <<= 1;
+		if (xor_flag)
+			(*crc) ^= 0x1021;
+	}
+}
+
+static void ref_calc_crc9(uint16_t *crc, uint8_t in, uint8_t in_bitscount) {
+	uint8_t v = 0x80;
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < 8-in_bitscount; i++)
+		v >>= 1;
+	for (i = 0; i < 8; i++) {
+		xor_flag = ((*crc) & 0x0100) > 0;
+		(*crc) <<= 1;
+		*crc &= 0x01ff;
+		if (in & v)
+			(*crc)++;
+		if (xor_flag)
+			(*crc) ^= 0x59;
+		v >>= 1;
+	}
+}
+
+static void ref_calc_crc9_finish(uint16_t *crc, uint8_t out_bitscount) {
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < out_bitscount; i++) {
+		xor_flag = ((*crc) & 0x0100) > 0;
+		(*crc) <<= 1;
+		*crc &= 0x01ff;
+		if (xor_flag)
+			(*crc) ^= 0x59;
+	}
+}
+
+static void ref_calc_crc32(uint32_t *crc, uint8_t in) {
+	uint8_t v = 0x80;
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < 8; i++) {
+		xor_flag = ((*crc) & 0x80000000) > 0;
+		(*crc) <<= 1;
+		if (in & v)
+			(*crc)++;
+		if (xor_flag)
+			(*crc) ^= 0x04c11db7;
+		v >>= 1;
+	}
+}
+
+static void ref_calc_crc32_finish(uint32_t *crc) {
+	flag_t xor_flag;
+	uint8_t i;
+
+	for (i = 0; i < 32; i++) {
+		xor_flag = ((*crc) & 0x80000000) > 0;
+		(*crc) <<= 1;
+		if (xor_flag)
+			(*crc) ^= 0x04c11db7;
+	}
+}
+
+static double get_time_in_ns(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec*1e9 + ts.tv_nsec;
+}
+
+static int test_vectors(void) {
+	static uint8_t data[MAX_DATA_LENGTH];
+	uint16_t length, i;
+	uint8_t bitscount, out_bitscount;
+	uint16_t ref_crc16, new_crc16, new_crc16_bytes;
+	uint16_t ref_crc9, new_crc9, new_crc9_bytes;
+	uint32_t ref_crc32, new_crc32, new_crc32_bytes, ref_crc32_le16, new_crc32_le16;
+	int mismatches = 0;
+	int tests = 0;
+
+	// Known check value of "123456789" with CRC16-CCITT poly and 0 initial value (CRC-16/XMODEM).
+	new_crc16 = 0;
+	crc_calc_crc16_ccitt_bytes(&new_crc16, (uint8_t *)"123456789", 9);
+	crc_calc_crc16_ccitt_finish(&new_crc16);
+	if (new_crc16 != 0x31c3) {
+		printf("crc16-ccitt check value mismatch: %.4x\n", new_crc16);
+		mismatches++;
+	}
+
+	for (length = 0; length <= MAX_DATA_LENGTH; length++) {
+		for (i = 0; i < length; i++)
+			data[i] = rand();
+
+		ref_crc16 = new_crc16 = new_crc16_bytes = rand();
+		ref_crc32 = new_crc32 = new_crc32_bytes = (uint32_t)rand() << 16 ^ rand();
+		ref_crc32_le16 = new_crc32_le16 = ref_crc32;
+		for (i = 0; i < length; i++) {
+			ref_calc_crc16_ccitt(&ref_crc16, data[i]);
+			crc_calc_crc16_ccitt(&new_crc16, data[i]);
+			ref_calc_crc32(&ref_crc32, data[i]);
+			crc_calc_crc32(&new_crc32, data[i]);
+			if (i % 2 == 1) {
+				ref_calc_crc32(&ref_crc32_le16, data[i]);
+				ref_calc_crc32(&ref_crc32_le16, data[i-1]);
+			}
+		}
+		crc_calc_crc16_ccitt_bytes(&new_crc16_bytes, data, length);
+		crc_calc_crc32_bytes(&new_crc32_bytes, data, length);
+		crc_calc_crc32_le16_bytes(&new_crc32_le16, data, length & ~1);
+		ref_calc_crc16_ccitt_finish(&ref_crc16);
+		crc_calc_crc16_ccitt_finish(&new_crc16);
+		crc_calc_crc16_ccitt_finish(&new_crc16_bytes);
+		ref_calc_crc32_finish(&ref_crc32);
+		crc_calc_crc32_finish(&new_crc32);
+		crc_calc_crc32_finish(&new_crc32_bytes);
+		ref_calc_crc32_finish(&ref_crc32_le16);
+		crc_calc_crc32_finish(&new_crc32_le16);
+
+		tests++;
+		if (ref_crc16 != new_crc16 || ref_crc16 != new_crc16_bytes) {
+			printf("crc16-ccitt mismatch at length %u: %.4x %.4x %.4x\n", length, ref_crc16, new_crc16, new_crc16_bytes);
+			mismatches++;
+		}
+		if (ref_crc32 != new_crc32 || ref_crc32 != new_crc32_bytes || ref_crc32_le16 != new_crc32_le16) {
+			printf("crc32 mismatch at length %u\n", length);
+			mismatches++;
+		}
+
+		// CRC9 with all input and output bit counts, as with the confirmed data block serial numbers.
+		for (bitscount = 0; bitscount <= 8; bitscount++) {
+			for (out_bitscount = 0; out_bitscount <= 17; out_bitscount++) {
+				if (length > 64 && out_bitscount != 8)
+					continue;
+
+				ref_crc9 = new_crc9 = new_crc9_bytes = rand() & 0x1ff;
+				for (i = 0; i < length; i++) {
+					ref_calc_crc9(&ref_crc9, data[i], 8);
+					crc_calc_crc9(&new_crc9, data[i], 8);
+				}
+				crc_calc_crc9_bytes(&new_crc9_bytes, data, length);
+				ref_calc_crc9(&ref_crc9, data[0], bitscount);
+				crc_calc_crc9(&new_crc9, data[0], bitscount);
+				crc_calc_crc9(&new_crc9_bytes, data[0], bitscount);
+				ref_calc_crc9_finish(&ref_crc9, out_bitscount);
+				crc_calc_crc9_finish(&new_crc9, out_bitscount);
+				crc_calc_crc9_finish(&new_crc9_bytes, out_bitscount);
+
+				tests++;
+				if (ref_crc9 != new_crc9 || ref_crc9 != new_crc9_bytes) {
+					printf("crc9 mismatch at length %u, bits %u/%u: %.4x %.4x\n", length, bitscount, out_bitscount, ref_crc9, new_crc9);
+					mismatches++;
+				}
+			}
+		}
+	}
+
+	printf("test vectors: %d, mismatches: %d\n", tests, mismatches);
+	return mismatches;
+}
+
+static void bench(uint16_t length) {
+	static uint8_t data[MAX_DATA_LENGTH];
+	double start, ref_time, new_time;
+	uint16_t ref_crc16 = 0, new_crc16 = 0;
+	uint16_t ref_crc9 = 0, new_crc9 = 0;
+	uint32_t ref_crc32 = 0, new_crc32 = 0;
+	int i, round;
+	volatile uint32_t sink;
+
+	for (i = 0; i < length; i++)
+		data[i] = rand();
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < length; i++)
+			ref_calc_crc16_ccitt(&ref_crc16, data[i]);
+		ref_calc_crc16_ccitt_finish(&ref_crc16);
+	}
+	ref_time = get_time_in_ns()-start;
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		crc_calc_crc16_ccitt_bytes(&new_crc16, data, length);
+		crc_calc_crc16_ccitt_finish(&new_crc16);
+	}
+	new_time = get_time_in_ns()-start;
+	printf("crc16-ccitt %4u bytes  old: %8.1f ns  new: %7.1f ns  speedup: %5.1fx\n", length,
+		ref_time/ROUNDS, new_time/ROUNDS, ref_time/new_time);
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < length; i++)
+			ref_calc_crc9(&ref_crc9, data[i], 8);
+		ref_calc_crc9_finish(&ref_crc9, 8);
+	}
+	ref_time = get_time_in_ns()-start;
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		crc_calc_crc9_bytes(&new_crc9, data, length);
+		crc_calc_crc9_finish(&new_crc9, 8);
+	}
+	new_time = get_time_in_ns()-start;
+	printf("crc9        %4u bytes  old: %8.1f ns  new: %7.1f ns  speedup: %5.1fx\n", length,
+		ref_time/ROUNDS, new_time/ROUNDS, ref_time/new_time);
+
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < length; i++)
+			ref_calc_crc32(&ref_crc32, data[i]);
+		ref_calc_crc32_finish(&ref_crc32);
+	}
+	ref_time = get_time_in_ns()-start;
+	start = get_time_in_ns();
+	for (round = 0; round < ROUNDS; round++) {
+		crc_calc_crc32_bytes(&new_crc32, data, length);
+		crc_calc_crc32_finish(&new_crc32);
+	}
+	new_time = get_time_in_ns()-start;
+	printf("crc32       %4u bytes  old: %8.1f ns  new: %7.1f ns  speedup: %5.1fx\n", length,
+		ref_time/ROUNDS, new_time/ROUNDS, ref_time/new_time);
+
+	sink = ref_crc16 ^ new_crc16 ^ ref_crc9 ^ new_crc9 ^ ref_crc32 ^ new_crc32;
+	(void)sink;
+}
+
+int main(void) {
+	int mismatches;
+
+	srand(1);
+	crc_init();
+
+	mismatches = test_vectors();
+
+	bench(10);
+	bench(18);
+	bench(144);
+	bench(MAX_DATA_LENGTH);
+
+	return (mismatches != 0);
+}
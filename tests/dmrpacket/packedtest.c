@@ -0,0 +1,146 @@
+// Tests that the packed payload functions return the same bits as the unpacked (one flag per bit)
+// ones, with random payloads and with payloads where only one bit is set. The BPTC matrix deinterleaved
+// from the packed payload must match the one packed from the deinterleaved info bits.
+
+#include DEFAULTCONFIG
+
+#include <libs/dmrpacket/dmrpacket.h>
+#include <libs/dmrpacket/dmrpacket-sync.h>
+#include <libs/dmrpacket/dmrpacket-slot-type.h>
+#include <libs/dmrpacket/dmrpacket-emb.h>
+#include <libs/dmrpacket/dmrpacket-data.h>
+#include <libs/coding/bptc-196-96.h>
+#include <libs/comm/comm.h>
+#include <libs/base/base.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RANDOM_PAYLOAD_COUNT 100000
+
+// These are not used by the test, only needed for linking.
+uint16_t comm_calcipheaderchecksum(struct ip *ipheader) {
+	return 0;
+}
+
+uint16_t comm_calcudpchecksum(struct ip *ipheader, struct udphdr *udpheader) {
+	return 0;
+}
+
+char *dmrpacket_data_header_get_readable_dd_format(dmrpacket_data_header_dd_format_t dd_format) {
+	return "";
+}
+
+static unsigned int failures = 0;
+
+static uint64_t bitstoword(flag_t *bits, uint8_t count) {
+	uint64_t word = 0;
+	uint8_t i;
+
+	for (i = 0; i < count; i++)
+		word = word << 1 | bits[i];
+	return word;
+}
+
+static void fail(uint8_t *bytes, const char *what) {
+	uint8_t i;
+
+	printf("%s mismatch for payload ", what);
+	for (i = 0; i < 33; i++)
+		printf("%.2x", bytes[i]);
+	printf("\n");
+	failures++;
+}
+
+static void test(uint8_t *bytes) {
+	dmrpacket_payload_bits_t payload_bits;
+	dmrpacket_payload_bits_t unpacked_payload_bits;
+	dmrpacket_payload_packed_bits_t packed_bits;
+	dmrpacket_payload_info_bits_t info_bits;
+	dmrpacket_payload_info_bits_t packed_info_bits;
+	dmrpacket_payload_voice_bits_t voice_bits;
+	dmrpacket_payload_voice_bits_t packed_voice_bits;
+	dmrpacket_sync_bits_t sync_bits;
+	dmrpacket_slot_type_bits_t slot_type_bits;
+	dmrpacket_emb_bits_t emb_bits;
+	dmrpacket_emb_signalling_lc_fragment_bits_t fragment_bits;
+	dmrpacket_emb_signalling_lc_fragment_bits_t packed_fragment_bits;
+	dmrpacket_payload_info_bits_t deint_info_bits;
+	bptc_196_96_matrix_t matrix;
+	bptc_196_96_matrix_t packed_matrix;
+	uint16_t from;
+	uint8_t count;
+
+	base_bytestobits(bytes, 33, payload_bits.bits, sizeof(dmrpacket_payload_bits_t));
+	dmrpacket_packed_from_bytes(bytes, 33, &packed_bits);
+
+	dmrpacket_packed_to_bits(&packed_bits, 0, sizeof(dmrpacket_payload_bits_t), unpacked_payload_bits.bits);
+	if (memcmp(payload_bits.bits, unpacked_payload_bits.bits, sizeof(dmrpacket_payload_bits_t)) != 0)
+		fail(bytes, "payload");
+
+	for (from = 0; from < sizeof(dmrpacket_payload_bits_t); from += 7) {
+		for (count = 1; count <= 64 && from+count <= sizeof(dmrpacket_payload_bits_t); count += 9) {
+			if (dmrpacket_packed_get_bits(&packed_bits, from, count) != bitstoword(&payload_bits.bits[from], count))
+				fail(bytes, "get bits");
+		}
+	}
+
+	dmrpacket_extract_info_bits_r(&payload_bits, &info_bits);
+	dmrpacket_extract_info_bits_from_packed_r(&packed_bits, &packed_info_bits);
+	if (memcmp(info_bits.bits, packed_info_bits.bits, sizeof(dmrpacket_payload_info_bits_t)) != 0)
+		fail(bytes, "info bits");
+
+	dmrpacket_extract_voice_bits_r(&payload_bits, &voice_bits);
+	dmrpacket_extract_voice_bits_from_packed_r(&packed_bits, &packed_voice_bits);
+	if (memcmp(voice_bits.raw.bits, packed_voice_bits.raw.bits, sizeof(dmrpacket_payload_voice_bits_t)) != 0)
+		fail(bytes, "voice bits");
+
+	dmrpacket_sync_extract_bits_r(&payload_bits, &sync_bits);
+	if (dmrpacket_sync_extract_word(&packed_bits) != bitstoword(sync_bits.bits, sizeof(dmrpacket_sync_bits_t)))
+		fail(bytes, "sync word");
+
+	dmrpacket_slot_type_extract_bits_r(&payload_bits, &slot_type_bits);
+	if (dmrpacket_slot_type_extract_word(&packed_bits) != bitstoword(slot_type_bits.bits, sizeof(dmrpacket_slot_type_bits_t)))
+		fail(bytes, "slot type word");
+
+	dmrpacket_emb_extract_from_sync_r(&sync_bits, &emb_bits);
+	if (dmrpacket_emb_extract_word(&packed_bits) != bitstoword(emb_bits.bits, sizeof(dmrpacket_emb_bits_t)))
+		fail(bytes, "emb word");
+
+	dmrpacket_emb_signalling_lc_fragment_extract_from_sync_r(&sync_bits, &fragment_bits);
+	if (dmrpacket_emb_signalling_lc_fragment_extract_word(&packed_bits) != bitstoword(fragment_bits.bits, sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t)))
+		fail(bytes, "emb signalling lc fragment word");
+	dmrpacket_emb_signalling_lc_fragment_extract_from_packed_r(&packed_bits, &packed_fragment_bits);
+	if (memcmp(fragment_bits.bits, packed_fragment_bits.bits, sizeof(dmrpacket_emb_signalling_lc_fragment_bits_t)) != 0)
+		fail(bytes, "emb signalling lc fragment bits");
+
+	dmrpacket_data_bptc_deinterleave_r(&info_bits, &deint_info_bits);
+	bptc_196_96_matrix_from_bits_r(deint_info_bits.bits, &matrix);
+	dmrpacket_data_bptc_deinterleave_packed_r(&packed_bits, &packed_matrix);
+	if (memcmp(&matrix, &packed_matrix, sizeof(bptc_196_96_matrix_t)) != 0)
+		fail(bytes, "bptc matrix");
+}
+
+int main(void) {
+	uint8_t bytes[33];
+	unsigned int i;
+	uint8_t j;
+
+	srand(1);
+
+	for (i = 0; i < sizeof(dmrpacket_payload_bits_t); i++) {
+		memset(bytes, 0, sizeof(bytes));
+		bytes[i/8] = 0x80 >> (i % 8);
+		test(bytes);
+	}
+
+	for (i = 0; i < RANDOM_PAYLOAD_COUNT; i++) {
+		for (j = 0; j < sizeof(bytes); j++)
+			bytes[j] = rand();
+		test(bytes);
+	}
+
+	printf("%u single bit and %u random payloads tested, %u failures\n", (unsigned int)sizeof(dmrpacket_payload_bits_t), RANDOM_PAYLOAD_COUNT, failures);
+	return (failures != 0);
+}
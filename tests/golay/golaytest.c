@@ -0,0 +1,75 @@
+// Tests Golay(20,8) error correction with all possible data bytes and all error patterns with max. 4
+// bit errors. Max. 3 bit errors must be corrected, 4 bit errors must be detected as uncorrectable.
+
+#include DEFAULTCONFIG
+
+#include <libs/coding/golay-20-8.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned int failures = 0;
+static unsigned int tests[5] = {0,};
+
+static void test(uint8_t data, uint32_t error_pattern, uint8_t error_count) {
+	uint32_t codeword = (uint32_t)data << 12 | golay_20_8_get_parity_word(data);
+	uint32_t received = codeword ^ error_pattern;
+	flag_t bits[20];
+	uint8_t corrected_bits = 0xff;
+	uint8_t i;
+	flag_t result;
+
+	tests[error_count]++;
+	result = golay_20_8_check_and_repair_word(&received, &corrected_bits);
+	if (error_count <= 3) {
+		if (!result || received != codeword || corrected_bits != error_count) {
+			printf("data %.2x error pattern %.5x: not corrected (result %u, corrected bits %u)\n", data, error_pattern, result, corrected_bits);
+			failures++;
+		}
+	} else if (result) {
+		printf("data %.2x error pattern %.5x: 4 bit errors not detected\n", data, error_pattern);
+		failures++;
+	}
+
+	// Checking the bit array version with a part of the patterns.
+	if ((error_pattern & 0xff) != 0)
+		return;
+
+	received = codeword ^ error_pattern;
+	for (i = 0; i < 20; i++)
+		bits[i] = (received >> (19-i)) & 1;
+	result = golay_20_8_check_and_repair(bits, &corrected_bits);
+	for (i = 0, received = 0; i < 20; i++)
+		received = received << 1 | bits[i];
+	if (result != (error_count <= 3) || (result && received != codeword)) {
+		printf("data %.2x error pattern %.5x: bit array version failed\n", data, error_pattern);
+		failures++;
+	}
+}
+
+int main(void) {
+	uint16_t data;
+	uint8_t i, j, k, l;
+
+	golay_20_8_init();
+
+	for (data = 0; data < 256; data++) {
+		test(data, 0, 0);
+		for (i = 0; i < 20; i++) {
+			test(data, 1 << i, 1);
+			for (j = i+1; j < 20; j++) {
+				test(data, 1 << i | 1 << j, 2);
+				for (k = j+1; k < 20; k++) {
+					test(data, 1 << i | 1 << j | 1 << k, 3);
+					for (l = k+1; l < 20; l++)
+						test(data, 1 << i | 1 << j | 1 << k | 1 << l, 4);
+				}
+			}
+		}
+	}
+
+	for (i = 0; i < 5; i++)
+		printf("%u bit errors: %u codewords tested\n", i, tests[i]);
+	printf("%u failures\n", failures);
+	return (failures != 0);
+}
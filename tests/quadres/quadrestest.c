@@ -0,0 +1,69 @@
+// Tests QR(16,7) error correction with all possible data values and all error patterns with max. 3
+// bit errors. Max. 2 bit errors must be corrected, 3 bit errors must be detected as uncorrectable.
+
+#include DEFAULTCONFIG
+
+#include <libs/coding/quadres-16-7.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned int failures = 0;
+static unsigned int tests[4] = {0,};
+
+static void test(uint8_t data, uint16_t error_pattern, uint8_t error_count) {
+	uint16_t codeword = (uint16_t)data << 9 | quadres_16_7_get_parity_word(data);
+	uint16_t received = codeword ^ error_pattern;
+	quadres_16_7_codeword_t codeword_bits;
+	flag_t *bits = (flag_t *)&codeword_bits;
+	uint8_t corrected_bits = 0xff;
+	uint8_t i;
+	flag_t result;
+
+	tests[error_count]++;
+	result = quadres_16_7_check_and_repair_word(&received, &corrected_bits);
+	if (error_count <= 2) {
+		if (!result || received != codeword || corrected_bits != error_count) {
+			printf("data %.2x error pattern %.4x: not corrected (result %u, corrected bits %u)\n", data, error_pattern, result, corrected_bits);
+			failures++;
+		}
+	} else if (result) {
+		printf("data %.2x error pattern %.4x: 3 bit errors not detected\n", data, error_pattern);
+		failures++;
+	}
+
+	received = codeword ^ error_pattern;
+	for (i = 0; i < 16; i++)
+		bits[i] = (received >> (15-i)) & 1;
+	result = quadres_16_7_check_and_repair(&codeword_bits, &corrected_bits);
+	for (i = 0, received = 0; i < 16; i++)
+		received = received << 1 | bits[i];
+	if (result != (error_count <= 2) || (result && received != codeword)) {
+		printf("data %.2x error pattern %.4x: bit array version failed\n", data, error_pattern);
+		failures++;
+	}
+}
+
+int main(void) {
+	uint8_t data;
+	uint8_t i, j, k;
+
+	quadres_16_7_init();
+
+	for (data = 0; data < 128; data++) {
+		test(data, 0, 0);
+		for (i = 0; i < 16; i++) {
+			test(data, 1 << i, 1);
+			for (j = i+1; j < 16; j++) {
+				test(data, 1 << i | 1 << j, 2);
+				for (k = j+1; k < 16; k++)
+					test(data, 1 << i | 1 << j | 1 << k, 3);
+			}
+		}
+	}
+
+	for (i = 0; i < 4; i++)
+		printf("%u bit errors: %u codewords tested\n", i, tests[i]);
+	printf("%u failures\n", failures);
+	return (failures != 0);
+}
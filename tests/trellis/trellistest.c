@@ -0,0 +1,171 @@
+// Tests the 3/4 rate trellis Viterbi decoder. Random data blocks are encoded, then decoded without
+// errors and with 1-4 flipped info bits. Error free blocks must be decoded with 0 path metric and
+// single bit errors must be corrected. The path metric must never be more than the number of
+// flipped bits, as the transmitted path has that metric. The packed payload path must give the same
+// constellation points and data bytes as the unpacked one.
+
+#include DEFAULTCONFIG
+
+#include <libs/coding/trellis.h>
+#include <libs/dmrpacket/dmrpacket.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_COUNT		20000
+#define MAX_ERRORS		4
+
+static unsigned int failures = 0;
+
+static void encode(dmrpacket_data_binary_t *binary, dmrpacket_payload_info_bits_t *info_bits) {
+	trellis_tribits_t tribits;
+	trellis_constellationpoints_t constellationpoints;
+	trellis_dibits_t deinterleaved_dibits;
+	trellis_dibits_t dibits;
+
+	trellis_construct_tribits_r(binary, &tribits);
+	trellis_construct_constellationpoints_r(&tribits, &constellationpoints);
+	trellis_construct_deinterleaved_dibits_r(&constellationpoints, &deinterleaved_dibits);
+	trellis_interleave_dibits_r(&deinterleaved_dibits, &dibits);
+	trellis_construct_payload_info_bits_r(&dibits, info_bits);
+}
+
+// Puts the info bits to their places in a packed payload, the sync or emb field in the middle is left empty.
+static void pack_info_bits(dmrpacket_payload_info_bits_t *info_bits, dmrpacket_payload_packed_bits_t *packed_bits) {
+	uint16_t i;
+	uint16_t pos;
+
+	memset(packed_bits, 0, sizeof(dmrpacket_payload_packed_bits_t));
+	for (i = 0; i < sizeof(dmrpacket_payload_info_bits_t); i++) {
+		pos = (i < sizeof(dmrpacket_payload_info_bits_t)/2 ? i : i+10+48+10);
+		if (info_bits->bits[i])
+			packed_bits->words[pos >> 6] |= 1ULL << (63-(pos & 63));
+	}
+}
+
+// Checks the packed path against the unpacked one.
+static void check_packed(unsigned int block, dmrpacket_payload_info_bits_t *info_bits) {
+	dmrpacket_payload_packed_bits_t packed_bits;
+	trellis_dibits_t dibits;
+	trellis_dibits_t deinterleaved_dibits;
+	trellis_constellationpoints_t constellationpoints;
+	trellis_constellationpoints_t packed_constellationpoints;
+	trellis_tribits_t tribits;
+	dmrpacket_data_binary_t binary;
+	dmrpacket_data_block_bytes_t bytes;
+	uint16_t path_metric;
+	uint8_t i, j;
+	uint8_t byte;
+
+	trellis_extract_dibits_r(info_bits, &dibits);
+	trellis_deinterleave_dibits_r(&dibits, &deinterleaved_dibits);
+	trellis_getconstellationpoints_r(&deinterleaved_dibits, &constellationpoints);
+
+	pack_info_bits(info_bits, &packed_bits);
+	trellis_getconstellationpoints_from_packed_r(&packed_bits, &packed_constellationpoints);
+	if (memcmp(&constellationpoints, &packed_constellationpoints, sizeof(trellis_constellationpoints_t)) != 0) {
+		printf("block %u: packed constellation points mismatch\n", block);
+		failures++;
+	}
+
+	if (trellis_decode_tribits_r(&constellationpoints, &tribits, &path_metric) == NULL)
+		return;
+	trellis_extract_binary_r(&tribits, &binary);
+	trellis_extract_block_bytes_r(&tribits, &bytes);
+	for (i = 0; i < sizeof(trellis_tribits_t)*3/8; i++) {
+		for (j = 0, byte = 0; j < 8; j++)
+			byte = byte << 1 | binary.bits[i*8+j];
+		if (bytes.bytes[i] != byte) {
+			printf("block %u: block bytes mismatch at byte %u\n", block, i);
+			failures++;
+			break;
+		}
+	}
+}
+
+static flag_t decode(dmrpacket_payload_info_bits_t *info_bits, dmrpacket_data_binary_t *binary, uint16_t *path_metric) {
+	trellis_dibits_t dibits;
+	trellis_dibits_t deinterleaved_dibits;
+	trellis_constellationpoints_t constellationpoints;
+	trellis_tribits_t tribits;
+
+	trellis_extract_dibits_r(info_bits, &dibits);
+	trellis_deinterleave_dibits_r(&dibits, &deinterleaved_dibits);
+	trellis_getconstellationpoints_r(&deinterleaved_dibits, &constellationpoints);
+	if (trellis_decode_tribits_r(&constellationpoints, &tribits, path_metric) == NULL)
+		return 0;
+	trellis_extract_binary_r(&tribits, binary);
+	return 1;
+}
+
+int main(void) {
+	dmrpacket_data_binary_t binary;
+	dmrpacket_data_binary_t decoded_binary;
+	dmrpacket_payload_info_bits_t info_bits;
+	dmrpacket_payload_info_bits_t received_info_bits;
+	trellis_tribits_t tribits;
+	uint16_t path_metric;
+	unsigned int corrected[MAX_ERRORS+1] = {0,};
+	unsigned int i;
+	uint8_t errors;
+	uint8_t j;
+	uint8_t pos;
+
+	trellis_init();
+	srand(1);
+
+	if (trellis_decode_tribits_r(NULL, &tribits, &path_metric) != NULL) {
+		printf("decoding NULL constellation points didn't fail\n");
+		failures++;
+	}
+
+	for (i = 0; i < BLOCK_COUNT; i++) {
+		memset(&binary, 0, sizeof(dmrpacket_data_binary_t));
+		for (j = 0; j < sizeof(trellis_tribits_t)*3; j++)
+			binary.bits[j] = rand() & 1;
+		encode(&binary, &info_bits);
+
+		for (errors = 0; errors <= MAX_ERRORS; errors++) {
+			memcpy(&received_info_bits, &info_bits, sizeof(dmrpacket_payload_info_bits_t));
+			for (j = 0; j < errors; j++) {
+				// Choosing a different bit for each error.
+				do {
+					pos = rand() % sizeof(dmrpacket_payload_info_bits_t);
+				} while (received_info_bits.bits[pos] != info_bits.bits[pos]);
+				received_info_bits.bits[pos] = !received_info_bits.bits[pos];
+			}
+
+			check_packed(i, &received_info_bits);
+
+			memset(&decoded_binary, 0, sizeof(dmrpacket_data_binary_t));
+			if (!decode(&received_info_bits, &decoded_binary, &path_metric)) {
+				printf("block %u with %u errors: decode failed\n", i, errors);
+				failures++;
+				continue;
+			}
+
+			if (path_metric > errors) {
+				printf("block %u with %u errors: path metric is %u\n", i, errors, path_metric);
+				failures++;
+			}
+
+			if (memcmp(decoded_binary.bits, binary.bits, sizeof(trellis_tribits_t)*3) == 0)
+				corrected[errors]++;
+			else if (errors <= 1) {
+				printf("block %u with %u errors: not corrected\n", i, errors);
+				failures++;
+			}
+
+			if (errors == 0 && path_metric != 0) {
+				printf("block %u without errors: path metric is %u\n", i, path_metric);
+				failures++;
+			}
+		}
+	}
+
+	for (errors = 0; errors <= MAX_ERRORS; errors++)
+		printf("%u errors: %u/%u blocks corrected\n", errors, corrected[errors], BLOCK_COUNT);
+	printf("%u failures\n", failures);
+	return (failures != 0);
+}